@@ -49,81 +49,33 @@ static void value_search_callback(const char *token, size_t token_len, size_t to
     free(temp_token);
 }
 
-// Helper struct for nr_string_split callback to collect language tags
-typedef struct {
-    char **tags;
-    uint8_t count;
-    uint8_t capacity;
-} language_tags_collection_t;
-
-// Callback function for nr_string_split to collect language tags
-static void language_tag_collection_callback(const char *token, size_t token_len, size_t token_index, void *user_data) {
-    language_tags_collection_t *collection = (language_tags_collection_t *)user_data;
-
-    // Ignore q-value parts (e.g., ";q=0.9")
-    // Use memchr instead of strchr since token is not null-terminated
-    const char *semicolon_pos = memchr(token, ';', token_len);
-    size_t effective_len = (semicolon_pos != NULL) ? (size_t)(semicolon_pos - token) : token_len;
-
-    // Create a temporary buffer for the token to trim it
-    char *temp_token = (char*)malloc(effective_len + 1);
-    if (temp_token == NULL) {
-        // Handle allocation error
+void nr_parse_language_tags(const char *accept_language, nr_language_tags_t *language_tags) {
+    language_tags->num_tags = 0;
+    language_tags->parsed = true;
+    if (accept_language == NULL) {
         return;
     }
-    strncpy(temp_token, token, effective_len);
-    temp_token[effective_len] = '\0';
-    char *trimmed_token = nr_trim_whitespace(temp_token);
-
-    if (strlen(trimmed_token) > 0) {
-        if (collection->count >= collection->capacity) {
-            // Resize array if needed (simple realloc for now, could be more robust)
-            collection->capacity *= 2;
-            collection->tags = (char**)realloc(collection->tags, collection->capacity * sizeof(char*));
-            if (collection->tags == NULL) {
-                free(temp_token);
-                return; // Handle realloc error
-            }
-        }
-        collection->tags[collection->count++] = strdup(trimmed_token); // Duplicate to store
-    }
-    free(temp_token);
-}
-
-/**
- * @brief Extracts primary language tags from an Accept-Language header string.
- *        E.g., "en-US,en;q=0.9,fr;q=0.8" -> ["en-US", "en", "fr"]
- *
- * @param accept_language_header The full Accept-Language header string.
- * @param out_tags A pointer to an array of char* that will be allocated and populated.
- *                 The caller is responsible for freeing each string and the array itself.
- * @param out_count A pointer to a uint8_t that will store the number of extracted tags.
- */
-static void nr_extract_primary_language_tags(
-    const char *accept_language_header,
-    char ***out_tags,
-    uint8_t *out_count
-) {
-    *out_tags = NULL;
-    *out_count = 0;
 
-    if (accept_language_header == NULL || strlen(accept_language_header) == 0) {
-        return;
-    }
+    strncpy(language_tags->buffer, accept_language, NR_MAX_LANGUAGE_LEN);
+    language_tags->buffer[NR_MAX_LANGUAGE_LEN] = '\0';
 
-    language_tags_collection_t collection = {
-        .tags = (char**)malloc(sizeof(char*) * 4), // Initial capacity
-        .count = 0,
-        .capacity = 4
-    };
-    if (collection.tags == NULL) {
-        return; // Handle allocation error
+    char *token = language_tags->buffer;
+    while (token != NULL && language_tags->num_tags < NR_MAX_LANGUAGE_TAGS) {
+        char *next = strchr(token, ',');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        // Ignore q-value parts (e.g., ";q=0.9")
+        char *semicolon_pos = strchr(token, ';');
+        if (semicolon_pos != NULL) {
+            *semicolon_pos = '\0';
+        }
+        char *trimmed_token = nr_trim_whitespace(token);
+        if (*trimmed_token != '\0') {
+            language_tags->tags[language_tags->num_tags++] = trimmed_token;
+        }
+        token = next;
     }
-
-    nr_string_split(accept_language_header, strlen(accept_language_header), ",", language_tag_collection_callback, &collection);
-
-    *out_tags = collection.tags;
-    *out_count = collection.count;
 }
 
 /**
@@ -154,6 +106,17 @@ bool nanorouter_match_conditions(
     const nr_condition_item_t *conditions,
     uint8_t num_conditions,
     const nanorouter_request_context_t *request_context
+) {
+    nr_language_tags_t language_tags;
+    language_tags.parsed = false;
+    return nr_match_conditions_cached(conditions, num_conditions, request_context, &language_tags);
+}
+
+bool nr_match_conditions_cached(
+    const nr_condition_item_t *conditions,
+    uint8_t num_conditions,
+    const nanorouter_request_context_t *request_context,
+    nr_language_tags_t *language_tags
 ) {
     // If there are no conditions in the rule, it's always a match.
     if (num_conditions == 0) {
@@ -175,22 +138,15 @@ bool nanorouter_match_conditions(
             }
         } else if (strcasecmp(condition->key, "Language") == 0) {
             if (strlen(request_context->language) > 0) {
-                char **extracted_tags = NULL;
-                uint8_t num_extracted_tags = 0;
-                nr_extract_primary_language_tags(request_context->language, &extracted_tags, &num_extracted_tags);
-                
-                for (uint8_t j = 0; j < num_extracted_tags; j++) {
-                    if (nr_list_contains_value(condition->value, extracted_tags[j], true)) { // Use language-specific matching
+                if (!language_tags->parsed) {
+                    nr_parse_language_tags(request_context->language, language_tags);
+                }
+                for (uint8_t j = 0; j < language_tags->num_tags; j++) {
+                    if (nr_list_contains_value(condition->value, language_tags->tags[j], true)) { // Use language-specific matching
                         condition_met = true;
                         break;
                     }
                 }
-
-                // Free allocated memory for extracted tags
-                for (uint8_t j = 0; j < num_extracted_tags; j++) {
-                    free(extracted_tags[j]);
-                }
-                free(extracted_tags);
             }
         } else if (strcasecmp(condition->key, "Domain") == 0) {
             if (strlen(request_context->domain) > 0) {
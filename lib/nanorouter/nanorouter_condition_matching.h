@@ -17,8 +17,25 @@ typedef struct {
     char domain[NR_MAX_DOMAIN_LEN + 1];     /**< The domain of the incoming request. */
     char country[NR_MAX_COUNTRY_LEN + 1];   /**< The country code(s) from GeoIP data. */
     char language[NR_MAX_LANGUAGE_LEN + 1]; /**< The language code(s) from Accept-Language header. */
+    char scheme[NR_MAX_SCHEME_LEN + 1];     /**< "http" or "https"; empty when unknown, then host rules are skipped. */
 } nanorouter_request_context_t;
 
+// Every tag takes at least one character and a comma
+#define NR_MAX_LANGUAGE_TAGS        ((NR_MAX_LANGUAGE_LEN + 1) / 2)
+
+/**
+ * @brief The language tags of a request's Accept-Language value, split once.
+ *
+ * Splitting is deferred until a Language condition is evaluated; set parsed
+ * to false before the first use.
+ */
+typedef struct {
+    char buffer[NR_MAX_LANGUAGE_LEN + 1];       /**< Copy of the language value, cut into tags. */
+    const char *tags[NR_MAX_LANGUAGE_TAGS];     /**< Trimmed tags without q-values, in header order. */
+    uint8_t num_tags;                           /**< Number of entries in tags. */
+    bool parsed;                                /**< true once tags has been filled. */
+} nr_language_tags_t;
+
 /**
  * @brief Matches a set of conditions against the provided request context.
  *
@@ -38,6 +55,35 @@ bool nanorouter_match_conditions(
     const nanorouter_request_context_t *request_context
 );
 
+/**
+ * @brief Splits an Accept-Language value into its language tags.
+ *
+ * "en-US,en;q=0.9, fr;q=0.8" gives "en-US", "en" and "fr". Nothing is allocated.
+ *
+ * @param accept_language The language value from the request context. May be NULL.
+ * @param language_tags The tags to fill; parsed is set to true.
+ */
+void nr_parse_language_tags(const char *accept_language, nr_language_tags_t *language_tags);
+
+/**
+ * @brief Matches conditions like nanorouter_match_conditions, reusing the request's language tags.
+ *
+ * The language value is split on the first Language condition and the tags are
+ * kept in language_tags, so later rules of the same request do not split it again.
+ *
+ * @param conditions An array of nr_condition_item_t from a redirect rule.
+ * @param num_conditions The number of conditions in the array.
+ * @param request_context The current request's domain, country, and language. If NULL, conditions cannot be met.
+ * @param language_tags The request's tags, filled on first use (parsed must start out false).
+ * @return true if all conditions are met or if there are no conditions, false otherwise.
+ */
+bool nr_match_conditions_cached(
+    const nr_condition_item_t *conditions,
+    uint8_t num_conditions,
+    const nanorouter_request_context_t *request_context,
+    nr_language_tags_t *language_tags
+);
+
 /**
  * @brief Performs language-specific matching: checks if the rule is a prefix of the context tag.
  *        E.g., rule "en" matches context "en-US".
@@ -7,6 +7,12 @@
  */
 #define NR_MAX_DOMAIN_LEN           128
 
+/**
+ * @brief Maximum length for the scheme string ("http" or "https") in the
+ *        request context.
+ */
+#define NR_MAX_SCHEME_LEN           8
+
 /**
  * @brief Maximum length for the country code string(s) in the request context.
  *        Used for GeoIP-based condition matching. Can handle comma-separated
@@ -87,4 +93,46 @@
  */
 #define NR_REDIRECT_MAX_URL_LEN     128
 
+/**
+ * @brief Maximum number of path segments a request URL is split into when
+ *        using an indexed redirect engine. Deeper URLs fall back to a
+ *        rule-by-rule scan.
+ */
+#define NR_MAX_PATH_SEGMENTS        32
+
+/**
+ * @brief Maximum number of states NR_REDIRECT_ENGINE_DFA may build. Rule sets
+ *        that need more (many overlapping placeholders) fail to compile and
+ *        stay on the linear engine.
+ */
+#define NR_REDIRECT_DFA_MAX_STATES  4096
+
+/**
+ * @brief Maximum number of literal chunks and placeholders a redirect
+ *        to_route is compiled into. Rules whose to_route needs more are
+ *        rejected when they are added.
+ */
+#define NR_MAX_TEMPLATE_PARTS       32
+
+/**
+ * @brief Maximum number of rules nanorouter_redirect_rule_list_resolve_rewrites
+ *        follows after a 200 rewrite. Longer chains are left to be followed
+ *        at request time.
+ */
+#define NR_MAX_REWRITE_HOPS         8
+
+/**
+ * @brief Number of requests nanorouter_process_redirect_batch splits and
+ *        matches together. Each one takes up to 2 KiB of scratch, allocated
+ *        once per batch call.
+ */
+#define NR_REDIRECT_BATCH_SIZE      8
+
+/**
+ * @brief Maximum length of a decision cache key: the request URL plus its
+ *        domain, country, language and scheme. Longer requests bypass the
+ *        cache.
+ */
+#define NR_DECISION_CACHE_KEY_LEN   256
+
 #endif // NANOROUTER_CONFIG_H
@@ -0,0 +1,244 @@
+#include "nanorouter_decision_cache.h"
+#include <stdatomic.h> // For atomic_uint and the fences
+#include <stdlib.h> // For calloc, free
+#include <string.h> // For memcpy, memcmp
+
+// Entries and counter stripes are padded to a cache line so threads working on neighbours don't share one
+#define NR_DECISION_CACHE_LINE      64
+#define NR_DECISION_CACHE_STRIPES   16
+
+// Header of one entry; the key bytes and then the value bytes follow it.
+typedef struct {
+    atomic_uint seq;            // Odd while a writer is filling the entry
+    uint32_t generation;        // Rule list generation of the decision, 0 if the entry is empty
+    uint32_t hash;
+    uint16_t key_len;
+    uint16_t value_len;
+    bool applied;
+} nr_decision_entry_t;
+
+// Lookup counters, striped by key hash so hot keys on different threads rarely bump the same line.
+typedef struct {
+    atomic_uint hits;
+    atomic_uint misses;             // Kept apart from hits so each lookup bumps a single counter
+    char padding[NR_DECISION_CACHE_LINE - 2 * sizeof(atomic_uint)];
+} nr_decision_stripe_t;
+
+struct nr_decision_cache_t {
+    char *entries;
+    size_t stride;              // Bytes per entry, a multiple of NR_DECISION_CACHE_LINE
+    size_t mask;                // Number of entries - 1
+    size_t max_value_len;
+    char padding[NR_DECISION_CACHE_LINE];       // Keeps the fields above off the counters' lines
+    nr_decision_stripe_t stripes[NR_DECISION_CACHE_STRIPES];
+};
+
+static atomic_uint nr_decision_generation;
+
+uint32_t nr_decision_cache_next_generation(void) {
+    uint32_t generation = atomic_fetch_add_explicit(&nr_decision_generation, 1, memory_order_relaxed) + 1;
+    if (generation == 0) {
+        // 0 marks empty entries; skip it when the counter wraps
+        generation = atomic_fetch_add_explicit(&nr_decision_generation, 1, memory_order_relaxed) + 1;
+    }
+    return generation;
+}
+
+// Hashes a key four bytes at a time. Keys run to dozens of bytes and are hashed on
+// every request, where nr_hash_bytes' multiply per byte would cost more than the rest of a hit.
+static uint32_t nr_decision_key_hash(const char *data, size_t len) {
+    uint32_t hash = 2166136261u ^ (uint32_t)len;
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, 4);
+        hash = (hash ^ word) * 0x9e3779b1u;
+        hash ^= hash >> 15;
+    }
+    for (; i < len; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+    }
+    // Final avalanche, so the low bits that pick the entry depend on every byte
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Appends a context field and its terminating NUL, if it fits. Fields are a few bytes
+// long, so a plain loop beats strlen and memcpy calls here.
+static bool nr_decision_key_append(nr_decision_key_t *key, size_t *pos, const char *field) {
+    size_t p = *pos;
+    do {
+        if (p >= NR_DECISION_CACHE_KEY_LEN) {
+            return false;
+        }
+        key->bytes[p++] = *field;
+    } while (*field++ != '\0');
+    *pos = p;
+    return true;
+}
+
+bool nr_decision_key_init(nr_decision_key_t *key, const char *url, size_t url_len, const nanorouter_request_context_t *context) {
+    if (key == NULL || url == NULL || url_len + 2 > NR_DECISION_CACHE_KEY_LEN) {
+        return false;
+    }
+
+    // The URL goes first with its length, so a URL can't run into the fields after it
+    key->bytes[0] = (char)(url_len & 0xff);
+    key->bytes[1] = (char)(url_len >> 8);
+    memcpy(key->bytes + 2, url, url_len);
+    size_t pos = url_len + 2;
+    if (context != NULL) {
+        if (!nr_decision_key_append(key, &pos, context->domain) ||
+            !nr_decision_key_append(key, &pos, context->country) ||
+            !nr_decision_key_append(key, &pos, context->language) ||
+            !nr_decision_key_append(key, &pos, context->scheme)) {
+            return false;
+        }
+    } else {
+        // Same as a context with every field empty, which it behaves like
+        for (int i = 0; i < 4; i++) {
+            if (!nr_decision_key_append(key, &pos, "")) {
+                return false;
+            }
+        }
+    }
+    key->len = (uint16_t)pos;
+    key->hash = nr_decision_key_hash(key->bytes, pos);
+    return true;
+}
+
+nr_decision_cache_t* nr_decision_cache_create(size_t num_entries, size_t max_value_len) {
+    if (num_entries == 0 || max_value_len > UINT16_MAX) {
+        return NULL;
+    }
+    size_t capacity = 1;
+    while (capacity < num_entries) {
+        capacity *= 2;
+    }
+
+    nr_decision_cache_t *cache = (nr_decision_cache_t*) calloc(1, sizeof(nr_decision_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    size_t stride = sizeof(nr_decision_entry_t) + NR_DECISION_CACHE_KEY_LEN + max_value_len;
+    cache->stride = (stride + NR_DECISION_CACHE_LINE - 1) / NR_DECISION_CACHE_LINE * NR_DECISION_CACHE_LINE;
+    cache->mask = capacity - 1;
+    cache->max_value_len = max_value_len;
+    cache->entries = (char*) calloc(capacity, cache->stride);
+    if (cache->entries == NULL) {
+        free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void nr_decision_cache_free(nr_decision_cache_t *cache) {
+    if (cache == NULL) {
+        return;
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+static nr_decision_entry_t* nr_decision_cache_entry(const nr_decision_cache_t *cache, uint32_t hash) {
+    return (nr_decision_entry_t*)(cache->entries + (hash & cache->mask) * cache->stride);
+}
+
+// Seqlock read of the key's entry: copy everything out, then check no writer started in the
+// meantime. A torn copy is possible while a writer runs, but it is thrown away by the second check.
+static bool nr_decision_cache_read(const nr_decision_cache_t *cache, const nr_decision_key_t *key, uint32_t generation,
+                                   void *value, size_t *value_len, bool *applied) {
+    nr_decision_entry_t *entry = nr_decision_cache_entry(cache, key->hash);
+    unsigned seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+    if (seq & 1) {
+        return false;
+    }
+    if (generation == 0 || entry->generation != generation || entry->hash != key->hash || entry->key_len != key->len) {
+        return false;
+    }
+    const char *stored_key = (const char*)(entry + 1);
+    if (memcmp(stored_key, key->bytes, key->len) != 0) {
+        return false;
+    }
+    size_t stored_len = entry->value_len;
+    if (stored_len > *value_len) {
+        return false;
+    }
+    memcpy(value, stored_key + NR_DECISION_CACHE_KEY_LEN, stored_len);
+    bool stored_applied = entry->applied;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&entry->seq, memory_order_relaxed) != seq) {
+        return false;
+    }
+
+    *value_len = stored_len;
+    *applied = stored_applied;
+    return true;
+}
+
+bool nr_decision_cache_lookup(nr_decision_cache_t *cache, const nr_decision_key_t *key, uint32_t generation,
+                              void *value, size_t *value_len, bool *applied) {
+    if (cache == NULL || key == NULL || value_len == NULL || applied == NULL || (value == NULL && *value_len > 0)) {
+        return false;
+    }
+    nr_decision_stripe_t *stripe = &cache->stripes[key->hash % NR_DECISION_CACHE_STRIPES];
+    if (nr_decision_cache_read(cache, key, generation, value, value_len, applied)) {
+        atomic_fetch_add_explicit(&stripe->hits, 1, memory_order_relaxed);
+        return true;
+    }
+    atomic_fetch_add_explicit(&stripe->misses, 1, memory_order_relaxed);
+    return false;
+}
+
+void nr_decision_cache_store(nr_decision_cache_t *cache, const nr_decision_key_t *key, uint32_t generation,
+                             const void *value, size_t value_len, bool applied) {
+    if (cache == NULL || key == NULL || generation == 0 || value_len > cache->max_value_len || (value == NULL && value_len > 0)) {
+        return;
+    }
+
+    // Claim the entry by making its sequence odd; if another writer holds it, drop this store
+    nr_decision_entry_t *entry = nr_decision_cache_entry(cache, key->hash);
+    unsigned seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+    if ((seq & 1) || !atomic_compare_exchange_strong_explicit(&entry->seq, &seq, seq + 1,
+                                                              memory_order_acquire, memory_order_relaxed)) {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+
+    char *stored_key = (char*)(entry + 1);
+    entry->generation = generation;
+    entry->hash = key->hash;
+    entry->key_len = key->len;
+    entry->value_len = (uint16_t)value_len;
+    entry->applied = applied;
+    memcpy(stored_key, key->bytes, key->len);
+    if (value_len > 0) {
+        memcpy(stored_key + NR_DECISION_CACHE_KEY_LEN, value, value_len);
+    }
+
+    atomic_store_explicit(&entry->seq, seq + 2, memory_order_release);
+}
+
+void nr_decision_cache_stats(const nr_decision_cache_t *cache, uint32_t *hits, uint32_t *lookups) {
+    uint32_t total_hits = 0;
+    uint32_t total_lookups = 0;
+    if (cache != NULL) {
+        for (size_t i = 0; i < NR_DECISION_CACHE_STRIPES; i++) {
+            // Counters only ever go up, so a const cache can still read them
+            nr_decision_stripe_t *stripe = (nr_decision_stripe_t*) &cache->stripes[i];
+            uint32_t stripe_hits = atomic_load_explicit(&stripe->hits, memory_order_relaxed);
+            total_hits += stripe_hits;
+            total_lookups += stripe_hits + atomic_load_explicit(&stripe->misses, memory_order_relaxed);
+        }
+    }
+    if (hits != NULL) {
+        *hits = total_hits;
+    }
+    if (lookups != NULL) {
+        *lookups = total_lookups;
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef NANOROUTER_DECISION_CACHE_H
+#define NANOROUTER_DECISION_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_config.h" // For NR_DECISION_CACHE_KEY_LEN
+#include "nanorouter_condition_matching.h" // For nanorouter_request_context_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief What a middleware decision depends on: the request URL and its context.
+ *
+ * Built once per request by nr_decision_key_init and used for both the
+ * lookup and, on a miss, the store.
+ */
+typedef struct {
+    char bytes[NR_DECISION_CACHE_KEY_LEN];  /**< URL length, URL, then domain, country, language and scheme, NUL-separated. */
+    uint16_t len;                           /**< Number of bytes used. */
+    uint32_t hash;                          /**< Hash of bytes. */
+} nr_decision_key_t;
+
+/**
+ * @brief Opaque fixed-size cache of middleware responses, by request key.
+ *
+ * Direct-mapped: each key has one entry, and a newer decision replaces
+ * whatever was there. Every entry is guarded by its own sequence number, so
+ * any number of threads can look up and store at once without locks: a
+ * reader that overlaps a writer treats the entry as a miss, and a writer that
+ * finds the entry busy drops its store.
+ *
+ * Entries carry the generation of the rule list they were decided with, and
+ * only count as hits for that generation, so reloading or changing the rules
+ * needs no explicit flush.
+ */
+typedef struct nr_decision_cache_t nr_decision_cache_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Returns a generation number no rule list has had before.
+ *
+ * Rule lists take one when they are created and whenever their rules change.
+ *
+ * @return The new generation; never 0.
+ */
+uint32_t nr_decision_cache_next_generation(void);
+
+/**
+ * @brief Builds the cache key of a request.
+ *
+ * @param key The key to fill.
+ * @param url The request URL, not necessarily null-terminated.
+ * @param url_len Length of url.
+ * @param context Request data the decision depends on. May be NULL.
+ * @return true if the key fits in NR_DECISION_CACHE_KEY_LEN, false if the request must bypass the cache.
+ */
+bool nr_decision_key_init(nr_decision_key_t *key, const char *url, size_t url_len, const nanorouter_request_context_t *context);
+
+/**
+ * @brief Creates an empty decision cache.
+ *
+ * @param num_entries Number of entries, rounded up to a power of two.
+ * @param max_value_len Largest response the cache stores, in bytes, at most UINT16_MAX.
+ *        sizeof(nanorouter_redirect_response_t) is enough for redirects,
+ *        sizeof(nanorouter_header_response_t) for either middleware.
+ * @return A pointer to the new cache, or NULL on allocation failure or invalid sizes.
+ */
+nr_decision_cache_t* nr_decision_cache_create(size_t num_entries, size_t max_value_len);
+
+/**
+ * @brief Frees a decision cache created with nr_decision_cache_create.
+ *
+ * No other thread may be using the cache.
+ *
+ * @param cache The cache to free. May be NULL.
+ */
+void nr_decision_cache_free(nr_decision_cache_t *cache);
+
+/**
+ * @brief Looks up the response stored for a request.
+ *
+ * value may be partly overwritten even when the lookup misses.
+ *
+ * @param cache The decision cache.
+ * @param key The request key, from nr_decision_key_init.
+ * @param generation The generation of the rule list the response must come from.
+ * @param value Output: the stored response.
+ * @param value_len In: size of value. Out: length of the stored response.
+ * @param applied Output: what the middleware returned for the request.
+ * @return true on a hit, false otherwise.
+ */
+bool nr_decision_cache_lookup(nr_decision_cache_t *cache, const nr_decision_key_t *key, uint32_t generation,
+                              void *value, size_t *value_len, bool *applied);
+
+/**
+ * @brief Stores the response decided for a request, replacing the entry's previous one.
+ *
+ * The store is dropped if value_len is over the cache's max_value_len or
+ * another thread is writing the same entry.
+ *
+ * @param cache The decision cache.
+ * @param key The request key, from nr_decision_key_init.
+ * @param generation The generation of the rule list the response was decided with.
+ * @param value The response.
+ * @param value_len Length of value.
+ * @param applied What the middleware returned for the request.
+ */
+void nr_decision_cache_store(nr_decision_cache_t *cache, const nr_decision_key_t *key, uint32_t generation,
+                             const void *value, size_t value_len, bool applied);
+
+/**
+ * @brief Reads the cache's hit counters.
+ *
+ * The counters are 32 bits and wrap; read them often enough to keep the ratio meaningful.
+ *
+ * @param cache The decision cache.
+ * @param hits Output: lookups that were served from the cache. May be NULL.
+ * @param lookups Output: all lookups. May be NULL.
+ */
+void nr_decision_cache_stats(const nr_decision_cache_t *cache, uint32_t *hits, uint32_t *lookups);
+
+#endif // NANOROUTER_DECISION_CACHE_H
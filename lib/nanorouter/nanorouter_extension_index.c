@@ -0,0 +1,97 @@
+#include "nanorouter_extension_index.h"
+#include "nanorouter_slot_table.h" // For nr_slot_table_t
+#include "nanorouter_string_utils.h" // For nr_hash_bytes
+#include <stdlib.h> // For calloc, free
+
+struct nr_extension_index_t {
+    nr_slot_table_t table;          // Extension -> const void* rules, in the order they were added
+};
+
+// Gives the part of text from its last '.', or NULL if it has none or a '/' comes after it.
+static const char* nr_extension_of(const char *text, size_t text_len, size_t *len) {
+    for (size_t i = text_len; i > 0; i--) {
+        if (text[i - 1] == '/') {
+            return NULL;
+        }
+        if (text[i - 1] == '.') {
+            *len = text_len - (i - 1);
+            return text + i - 1;
+        }
+    }
+    return NULL;
+}
+
+const char* nr_route_program_extension(const nr_route_program_t *program, const char *from_route, size_t *len) {
+    if (program == NULL || from_route == NULL || program->num_ops == 0) {
+        return NULL;
+    }
+    const nr_route_op_t *last = &program->ops[program->num_ops - 1];
+    if (last->opcode != NR_ROUTE_OP_SUFFIX) {
+        return NULL;
+    }
+    return nr_extension_of(from_route + last->offset, last->len, len);
+}
+
+const char* nr_url_path_extension(const char *path, size_t path_len, size_t *len) {
+    if (path == NULL) {
+        return NULL;
+    }
+    return nr_extension_of(path, path_len, len);
+}
+
+nr_extension_index_t* nr_extension_index_create(void) {
+    nr_extension_index_t *index = (nr_extension_index_t*) calloc(1, sizeof(nr_extension_index_t));
+    if (index == NULL) {
+        return NULL;
+    }
+    if (!nr_slot_table_init(&index->table, NR_SLOT_KEYS_BYTES, sizeof(const void*))) {
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+bool nr_extension_index_add(nr_extension_index_t *index, const char *extension, size_t len, const void *rule) {
+    if (index == NULL || extension == NULL || rule == NULL) {
+        return false;
+    }
+    const void **value = (const void**) nr_slot_table_append(&index->table, extension, len, nr_hash_bytes(extension, len));
+    if (value == NULL) {
+        return false;
+    }
+    *value = rule;
+    return true;
+}
+
+bool nr_extension_index_remove_last(nr_extension_index_t *index, const char *extension, size_t len, const void *rule) {
+    if (index == NULL || extension == NULL || rule == NULL) {
+        return false;
+    }
+    return nr_slot_table_remove_last(&index->table, extension, len, nr_hash_bytes(extension, len), rule);
+}
+
+void nr_extension_index_free(nr_extension_index_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    nr_slot_table_free(&index->table);
+    free(index);
+}
+
+const void* const* nr_extension_index_lookup(const nr_extension_index_t *index, const char *extension, size_t len, size_t *num_rules) {
+    if (num_rules != NULL) {
+        *num_rules = 0;
+    }
+    if (index == NULL || extension == NULL) {
+        return NULL;
+    }
+
+    const nr_slot_t *slot = nr_slot_table_find(&index->table, extension, len, nr_hash_bytes(extension, len));
+    if (slot == NULL) {
+        return NULL;
+    }
+    if (num_rules != NULL) {
+        *num_rules = slot->num_values;
+    }
+    return (const void* const*) slot->values;
+}
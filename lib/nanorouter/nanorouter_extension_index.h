@@ -0,0 +1,97 @@
+#ifndef NANOROUTER_EXTENSION_INDEX_H
+#define NANOROUTER_EXTENSION_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_route_matcher.h" // For nr_route_program_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque index of rules by the file extension their from_route ends in ("*.css").
+ *
+ * Holds rules of any list (redirect or header rule nodes) as plain pointers,
+ * each extension keeping its rules in the order they were added. A request
+ * finds the rules that can match it with one hash probe on the extension of
+ * its last segment. Built on nr_slot_table_t.
+ */
+typedef struct nr_extension_index_t nr_extension_index_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Gives the extension a compiled from_route ends in.
+ *
+ * A from_route ending in ".min.js" gives ".js": the suffix from its last '.'.
+ *
+ * @param program The compiled from_route.
+ * @param from_route The from_route the program was compiled from.
+ * @param len Output: length of the extension.
+ * @return The extension inside from_route (not null-terminated), or NULL if the program does not end in NR_ROUTE_OP_SUFFIX.
+ */
+const char* nr_route_program_extension(const nr_route_program_t *program, const char *from_route, size_t *len);
+
+/**
+ * @brief Gives the extension of the last segment of a request path.
+ *
+ * @param path The request path, as nr_parse_url gives it (no trailing '/').
+ * @param path_len Length of path.
+ * @param len Output: length of the extension, including its '.'.
+ * @return The extension inside path, or NULL if the last segment has no '.'.
+ */
+const char* nr_url_path_extension(const char *path, size_t path_len, size_t *len);
+
+/**
+ * @brief Creates an empty extension index.
+ *
+ * @return A pointer to the new index, or NULL on allocation failure.
+ */
+nr_extension_index_t* nr_extension_index_create(void);
+
+/**
+ * @brief Files a rule under an extension.
+ *
+ * The index only references the rule, so the rule must outlive the index.
+ *
+ * @param index The extension index.
+ * @param extension The extension, as nr_route_program_extension gives it (not necessarily null-terminated).
+ * @param len Length of extension.
+ * @param rule The rule to file.
+ * @return true if the rule was added, false on allocation failure.
+ */
+bool nr_extension_index_add(nr_extension_index_t *index, const char *extension, size_t len, const void *rule);
+
+/**
+ * @brief Takes back the rule most recently filed with nr_extension_index_add.
+ *
+ * See nr_slot_table_remove_last.
+ *
+ * @param index The extension index.
+ * @param extension The extension the rule was filed under.
+ * @param len Length of extension.
+ * @param rule The rule last added.
+ * @return true if the rule was removed, false if it is not the last rule filed under the extension.
+ */
+bool nr_extension_index_remove_last(nr_extension_index_t *index, const char *extension, size_t len, const void *rule);
+
+/**
+ * @brief Frees an extension index created with nr_extension_index_create.
+ *
+ * @param index The index to free. May be NULL.
+ */
+void nr_extension_index_free(nr_extension_index_t *index);
+
+/**
+ * @brief Returns the rules filed under an extension, with a single hash probe.
+ *
+ * @param index The extension index. May be NULL.
+ * @param extension The extension, as nr_url_path_extension gives it. May be NULL.
+ * @param len Length of extension.
+ * @param num_rules Output: number of rules returned.
+ * @return The rules in the order they were added, or NULL if none is filed under the extension.
+ */
+const void* const* nr_extension_index_lookup(const nr_extension_index_t *index, const char *extension, size_t len, size_t *num_rules);
+
+#endif // NANOROUTER_EXTENSION_INDEX_H
@@ -1,5 +1,7 @@
 #include "nanorouter_header_rule_parser.h"
 #include "nanorouter_string_utils.h" // For nr_trim_whitespace
+#include "nanorouter_extension_index.h" // For nr_extension_index_add and nr_route_program_extension
+#include "nanorouter_decision_cache.h" // For nr_decision_cache_next_generation
 #include <string.h> // For strncpy, strlen, strchr, strstr
 #include <stdio.h>  // For sscanf, snprintf
 #include <stdlib.h> // For malloc, free
@@ -16,6 +18,8 @@ nanorouter_header_rule_list_t* nanorouter_header_rule_list_create() {
     }
     list->head = NULL;
     list->count = 0;
+    list->extensions = NULL;
+    list->generation = nr_decision_cache_next_generation();
     return list;
 }
 
@@ -23,7 +27,8 @@ nanorouter_header_rule_list_t* nanorouter_header_rule_list_create() {
  * @brief Adds a new header_rule_t to the linked list.
  *
  * This function allocates a nanorouter_header_rule_node_t node, copies the rule_data into it,
- * and adds it to the end of the list.
+ * compiles its from_route pattern and adds it to the end of the list. Rules whose
+ * from_route ends in a file suffix are also filed in the list's extension index.
  *
  * @param list A pointer to the nanorouter_header_rule_list_t.
  * @param rule_data A pointer to the header_rule_t data to be added.
@@ -41,8 +46,23 @@ bool nanorouter_header_rule_list_add_rule(nanorouter_header_rule_list_t *list, c
 
     // Copy the rule data
     new_node->rule = *rule_data; // Direct copy
+    nr_compile_route_pattern(new_node->rule.from_route, &new_node->program);
     new_node->next = NULL;
 
+    // Suffix rules ("/*.css") are looked up by the request's extension instead of matched in turn
+    size_t extension_len = 0;
+    const char *extension = nr_route_program_extension(&new_node->program, new_node->rule.from_route, &extension_len);
+    new_node->by_extension = extension != NULL;
+    if (new_node->by_extension) {
+        if (list->extensions == NULL) {
+            list->extensions = nr_extension_index_create();
+        }
+        if (list->extensions == NULL || !nr_extension_index_add(list->extensions, extension, extension_len, new_node)) {
+            free(new_node);
+            return false;
+        }
+    }
+
     if (list->head == NULL) {
         list->head = new_node;
     } else {
@@ -54,6 +74,7 @@ bool nanorouter_header_rule_list_add_rule(nanorouter_header_rule_list_t *list, c
     }
 
     list->count++;
+    list->generation = nr_decision_cache_next_generation();
     return true;
 }
 
@@ -73,6 +94,7 @@ void nanorouter_header_rule_list_free(nanorouter_header_rule_list_t *list) {
         free(current);
         current = next;
     }
+    nr_extension_index_free(list->extensions);
     free(list);
 }
 
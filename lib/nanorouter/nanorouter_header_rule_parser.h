@@ -6,6 +6,7 @@
 #include <stddef.h>
 
 #include "nanorouter_config.h" // For configuration defines
+#include "nanorouter_route_matcher.h" // For nr_route_program_t
 
 // --- Struct Definitions ---
 
@@ -31,15 +32,21 @@ typedef struct {
  */
 typedef struct nanorouter_header_rule_node_t {
     header_rule_t rule;                                /**< The actual header rule data. */
+    nr_route_program_t program;                        /**< rule.from_route compiled by nr_compile_route_pattern. */
+    bool by_extension;                                 /**< Filed in the list's extension index; only requests with that extension match it. */
     struct nanorouter_header_rule_node_t *next;        /**< Pointer to the next rule in the list. */
 } nanorouter_header_rule_node_t;
 
+struct nr_extension_index_t;
+
 /**
  * @brief Structure to manage a linked list of header rules.
  */
 typedef struct {
     nanorouter_header_rule_node_t *head;               /**< Pointer to the first rule in the list. */
     size_t count;                                      /**< Number of rules in the list. */
+    struct nr_extension_index_t *extensions;           /**< Rules whose from_route ends in a file suffix ("*.css"), by extension. Kept up to date by add_rule. */
+    uint32_t generation;                               /**< Renewed whenever the rules change; decision cache entries of other generations are stale. */
 } nanorouter_header_rule_list_t;
 
 // --- Function Prototypes for Rule List Management ---
@@ -55,7 +62,7 @@ nanorouter_header_rule_list_t* nanorouter_header_rule_list_create();
  * @brief Adds a new header_rule_t to the linked list.
  *
  * This function allocates a nanorouter_header_rule_node_t node, copies the rule_data into it,
- * and adds it to the end of the list.
+ * compiles its from_route pattern and adds it to the end of the list.
  *
  * @param list A pointer to the nanorouter_header_rule_list_t.
  * @param rule_data A pointer to the header_rule_t data to be added.
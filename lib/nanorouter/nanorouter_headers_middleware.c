@@ -1,7 +1,8 @@
 #include "nanorouter_headers_middleware.h"
 #include "nanorouter_header_rule_parser.h" // For nanorouter_header_rule_list_t and header_rule_t, NR_MAX_HEADER_VALUE_LEN
 #include "nanorouter_condition_matching.h" // For nanorouter_request_context_t and nanorouter_match_conditions
-#include "nanorouter_route_matcher.h" // For nanorouter_match_rule and nr_matched_params_t
+#include "nanorouter_route_matcher.h" // For nr_match_compiled_pattern
+#include "nanorouter_extension_index.h" // For nr_extension_index_lookup
 #include "nanorouter_string_utils.h" // For string utility functions (nr_string_split, nr_trim_whitespace)
 #include <stdlib.h> // For malloc, free
 #include <string.h> // For strncpy, strlen, strcmp, strncat, strcasecmp
@@ -94,6 +95,18 @@ static bool is_ignored_header(const char *header_key) {
 }
 
 
+/**
+ * @brief Checks whether a header rule's path pattern matches a parsed request URL.
+ *
+ * @param node The header rule node, with its compiled from_route.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @return true if the path matches, false otherwise.
+ */
+static bool nr_header_rule_matches(const nanorouter_header_rule_node_t *node, const nr_parsed_url_t *parsed_url) {
+    // Header rules only need the verdict, so nothing is captured
+    return nr_match_compiled_pattern(node->rule.from_route, &node->program, NULL, 0, parsed_url, NULL);
+}
+
 /**
  * @brief Processes an incoming request URL against a list of header rules.
  *
@@ -115,71 +128,178 @@ bool nanorouter_process_header_request(
         return false;
     }
 
+    nr_parsed_url_t parsed_url;
+    nr_parse_url(request_url, &parsed_url);
+    return nanorouter_process_header_request_parsed(&parsed_url, rules, response_context, request_context);
+}
+
+/**
+ * @brief Processes a length-delimited request URL against a list of header rules.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    if (request_url == NULL || rules == NULL || response_context == NULL) {
+        return false;
+    }
+
+    nr_parsed_url_t parsed_url;
+    nr_parse_url_n(request_url, request_url_len, &parsed_url);
+    return nanorouter_process_header_request_parsed(&parsed_url, rules, response_context, request_context);
+}
+
+/**
+ * @brief Processes a request shared with the redirect middleware against a list of header rules.
+ *
+ * @param request The request, created with nr_request_init.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_shared(
+    nr_request_t *request,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context
+) {
+    if (request == NULL) {
+        return false;
+    }
+    return nanorouter_process_header_request_parsed(&request->url, rules, response_context, request->context);
+}
+
+/**
+ * @brief Processes a request URL against a list of header rules, through a decision cache.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @param cache The cache to use, or NULL to decide every request afresh.
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_cached(
+    const char *request_url,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context,
+    nr_decision_cache_t *cache
+) {
+    nr_decision_key_t key;
+    if (cache == NULL || request_url == NULL || rules == NULL || response_context == NULL ||
+        !nr_decision_key_init(&key, request_url, strlen(request_url), request_context)) {
+        return nanorouter_process_header_request(request_url, rules, response_context, request_context);
+    }
+
+    // Cached as the used part of the headers array
+    size_t value_len = sizeof(response_context->headers);
+    bool applied;
+    if (nr_decision_cache_lookup(cache, &key, rules->generation, response_context->headers, &value_len, &applied)) {
+        response_context->num_headers = (uint8_t)(value_len / sizeof(nanorouter_header_entry_t));
+        return applied;
+    }
+
+    applied = nanorouter_process_header_request(request_url, rules, response_context, request_context);
+    nr_decision_cache_store(cache, &key, rules->generation, response_context->headers,
+                            response_context->num_headers * sizeof(nanorouter_header_entry_t), applied);
+    return applied;
+}
+
+/**
+ * @brief Processes a request URL that was already split by nr_parse_url against a list of header rules.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url (may be shared with the redirect middleware).
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_parsed(
+    const nr_parsed_url_t *parsed_url,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    (void)request_context; // Header rules have no conditions yet
+
+    if (parsed_url == NULL || rules == NULL || response_context == NULL) {
+        return false;
+    }
+
     response_context->num_headers = 0; // Initialize to no headers
 
+    // Suffix rules that can match are those filed under the request's extension, in list order
+    size_t extension_len = 0;
+    const char *extension = rules->extensions != NULL ? nr_url_path_extension(parsed_url->path, parsed_url->path_len, &extension_len) : NULL;
+    size_t num_candidates = 0;
+    const void *const *candidates = nr_extension_index_lookup(rules->extensions, extension, extension_len, &num_candidates);
+    size_t next_candidate = 0;
+
     nanorouter_header_rule_node_t *current_rule_node = rules->head;
     bool rule_applied = false;
 
     while (current_rule_node != NULL) {
-        nr_matched_params_t matched_params;
-        matched_params.num_params = 0; // Initialize matched_params
-
-        // Create a dummy redirect_rule_t to pass to nanorouter_match_rule for path matching.
-        // Header rules don't have query params or conditions in their definition,
-        // but the matcher expects a redirect_rule_t.
-        redirect_rule_t dummy_redirect_rule;
-        memset(&dummy_redirect_rule, 0, sizeof(redirect_rule_t)); // Initialize to zeros
-        strncpy(dummy_redirect_rule.from_route, current_rule_node->rule.from_route, NR_MAX_ROUTE_LEN);
-        dummy_redirect_rule.from_route[NR_MAX_ROUTE_LEN] = '\0';
-
-        if (nanorouter_match_rule(&dummy_redirect_rule, request_url, &matched_params)) {
-            // For header rules, conditions are not defined in the _headers file itself.
-            // However, if the request_context is provided, we should still pass it to
-            // nanorouter_match_conditions, even if num_conditions is 0 for header rules.
-            // This ensures consistency in the API.
-            if (nanorouter_match_conditions(
-                    dummy_redirect_rule.conditions, // This will be empty for header rules
-                    dummy_redirect_rule.num_conditions, // This will be 0 for header rules
-                    request_context
-                )) {
-                rule_applied = true;
-                for (uint8_t i = 0; i < current_rule_node->rule.num_headers; i++) {
-                    const nanorouter_header_entry_t *header_entry = &current_rule_node->rule.headers[i];
-
-                    if (is_ignored_header(header_entry->key)) {
-                        continue; // Skip ignored headers
-                    }
+        bool matches;
+        if (current_rule_node->by_extension) {
+            // Walked alongside the list, so headers still merge in file order
+            matches = next_candidate < num_candidates && candidates[next_candidate] == current_rule_node;
+            if (matches) {
+                next_candidate++;
+                matches = nr_header_rule_matches(current_rule_node, parsed_url);
+            }
+        } else {
+            // Header rules have no query parameters or conditions, only the path is matched
+            matches = nr_header_rule_matches(current_rule_node, parsed_url);
+        }
+
+        if (matches) {
+            rule_applied = true;
+            for (uint8_t i = 0; i < current_rule_node->rule.num_headers; i++) {
+                const nanorouter_header_entry_t *header_entry = &current_rule_node->rule.headers[i];
 
-                    // Check if this header key already exists in the response_context
-                    bool header_exists = false;
-                    for (uint8_t j = 0; j < response_context->num_headers; j++) {
-                        if (strcasecmp(response_context->headers[j].key, header_entry->key) == 0) {
-                            // Check if the exact value already exists in the concatenated string
-                            if (!nr_header_value_contains(response_context->headers[j].value, header_entry->value)) {
-                                // Multi-value header: concatenate values if the value is new
-                                size_t current_value_len = strlen(response_context->headers[j].value);
-                                size_t new_value_len = strlen(header_entry->value);
-                                
-                                if (current_value_len + 1 + new_value_len < NR_MAX_HEADER_VALUE_LEN) { // +1 for comma
-                                    strncat(response_context->headers[j].value, ",", NR_MAX_HEADER_VALUE_LEN - current_value_len - 1);
-                                    strncat(response_context->headers[j].value, header_entry->value, NR_MAX_HEADER_VALUE_LEN - (current_value_len + 1) - 1);
-                                    response_context->headers[j].value[NR_MAX_HEADER_VALUE_LEN] = '\0';
-                                }
+                if (is_ignored_header(header_entry->key)) {
+                    continue; // Skip ignored headers
+                }
+
+                // Check if this header key already exists in the response_context
+                bool header_exists = false;
+                for (uint8_t j = 0; j < response_context->num_headers; j++) {
+                    if (strcasecmp(response_context->headers[j].key, header_entry->key) == 0) {
+                        // Check if the exact value already exists in the concatenated string
+                        if (!nr_header_value_contains(response_context->headers[j].value, header_entry->value)) {
+                            // Multi-value header: concatenate values if the value is new
+                            size_t current_value_len = strlen(response_context->headers[j].value);
+                            size_t new_value_len = strlen(header_entry->value);
+                            
+                            if (current_value_len + 1 + new_value_len < NR_MAX_HEADER_VALUE_LEN) { // +1 for comma
+                                strncat(response_context->headers[j].value, ",", NR_MAX_HEADER_VALUE_LEN - current_value_len - 1);
+                                strncat(response_context->headers[j].value, header_entry->value, NR_MAX_HEADER_VALUE_LEN - (current_value_len + 1) - 1);
+                                response_context->headers[j].value[NR_MAX_HEADER_VALUE_LEN] = '\0';
                             }
-                            header_exists = true; // Mark as existing, even if value wasn't concatenated
-                            break;
                         }
+                        header_exists = true; // Mark as existing, even if value wasn't concatenated
+                        break;
                     }
+                }
 
-                    if (!header_exists) {
-                        // Add new header if space is available
-                        if (response_context->num_headers < NR_HEADERS_MAX_ENTRIES_PER_RESPONSE) {
-                            strncpy(response_context->headers[response_context->num_headers].key, header_entry->key, NR_MAX_HEADER_KEY_LEN);
-                            response_context->headers[response_context->num_headers].key[NR_MAX_HEADER_KEY_LEN] = '\0';
-                            strncpy(response_context->headers[response_context->num_headers].value, header_entry->value, NR_MAX_HEADER_VALUE_LEN);
-                            response_context->headers[response_context->num_headers].value[NR_MAX_HEADER_VALUE_LEN] = '\0';
-                            response_context->num_headers++;
-                        }
+                if (!header_exists) {
+                    // Add new header if space is available
+                    if (response_context->num_headers < NR_HEADERS_MAX_ENTRIES_PER_RESPONSE) {
+                        strncpy(response_context->headers[response_context->num_headers].key, header_entry->key, NR_MAX_HEADER_KEY_LEN);
+                        response_context->headers[response_context->num_headers].key[NR_MAX_HEADER_KEY_LEN] = '\0';
+                        strncpy(response_context->headers[response_context->num_headers].value, header_entry->value, NR_MAX_HEADER_VALUE_LEN);
+                        response_context->headers[response_context->num_headers].value[NR_MAX_HEADER_VALUE_LEN] = '\0';
+                        response_context->num_headers++;
                     }
                 }
             }
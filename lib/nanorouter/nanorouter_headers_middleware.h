@@ -5,6 +5,9 @@
 #include <stddef.h>
 #include "nanorouter_header_rule_parser.h" // For header_rule_t and nanorouter_header_entry_t
 #include "nanorouter_condition_matching.h" // For nanorouter_request_context_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+#include "nanorouter_request.h" // For nr_request_t
+#include "nanorouter_decision_cache.h" // For nr_decision_cache_t
 
 #include "nanorouter_config.h" // For configuration defines
 
@@ -39,4 +42,84 @@ bool nanorouter_process_header_request(
     const nanorouter_request_context_t *request_context
 );
 
+/**
+ * @brief Processes a length-delimited request URL against a list of header rules.
+ *
+ * The URL needs no terminating NUL and is matched in place. Results are the
+ * same as nanorouter_process_header_request.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
+/**
+ * @brief Processes a request URL that was already split by nr_parse_url against a list of header rules.
+ *
+ * Lets a server parse the URL once and share it between the redirect and
+ * header middleware. Results are the same as nanorouter_process_header_request.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_parsed(
+    const nr_parsed_url_t *parsed_url,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
+/**
+ * @brief Processes a request shared with the redirect middleware against a list of header rules.
+ *
+ * Results are the same as nanorouter_process_header_request.
+ *
+ * @param request The request, created with nr_request_init.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_shared(
+    nr_request_t *request,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context
+);
+
+/**
+ * @brief Processes a request URL against a list of header rules, through a decision cache.
+ *
+ * The headers for a URL and request context are decided once and then served
+ * from the cache until the rules change; the cache needs entries of
+ * sizeof(nanorouter_header_response_t) to hold them. Safe to call from many
+ * threads at once with the same cache, as long as no thread changes the rules
+ * meanwhile. Results are the same as nanorouter_process_header_request.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_header_rule_list_t containing all loaded header rules.
+ * @param response_context A pointer to a nanorouter_header_response_t structure to be populated.
+ * @param request_context Request data for conditions (header rules currently have none).
+ * @param cache The cache to use, or NULL to decide every request afresh. It may be shared with the redirect middleware.
+ * @return true if any header rules were applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_header_request_cached(
+    const char *request_url,
+    nanorouter_header_rule_list_t *rules,
+    nanorouter_header_response_t *response_context,
+    const nanorouter_request_context_t *request_context,
+    nr_decision_cache_t *cache
+);
+
 #endif // NANOROUTER_HEADERS_MIDDLEWARE_H
@@ -0,0 +1,249 @@
+#include "nanorouter_redirect_bitset.h"
+#include <stdlib.h> // For malloc, calloc, realloc, free
+#include <string.h> // For memcmp, memmove
+
+#define NR_BITSET_WORD_BITS 64
+
+// A literal segment seen at one depth, with the rules that expect it there.
+typedef struct {
+    const char *segment;    // Points into a rule's from_route (not null-terminated)
+    size_t len;
+    uint64_t *rules;        // num_words words
+} nr_bitset_literal_t;
+
+typedef struct {
+    nr_bitset_literal_t *literals;  // Sorted by (length, bytes)
+    size_t num_literals;
+    size_t capacity;
+} nr_bitset_depth_t;
+
+struct nr_redirect_bitset_t {
+    const nanorouter_redirect_rule_t **rules;   // Rule nodes by index
+    size_t num_rules;
+    size_t num_words;
+    uint64_t *any_segment;      // [depth][word]: rules accepting any segment at depth (splats, "/*")
+    uint64_t *non_empty;        // [depth][word]: rules with a placeholder at depth
+    uint64_t *segment_count;    // [count][word]: rules accepting a URL with count segments
+    nr_bitset_depth_t depths[NR_MAX_PATH_SEGMENTS];
+};
+
+static inline void nr_bitset_set(uint64_t *words, size_t bit) {
+    words[bit / NR_BITSET_WORD_BITS] |= (uint64_t)1 << (bit % NR_BITSET_WORD_BITS);
+}
+
+// Orders literals by length first, then by bytes, like the trie children.
+static int nr_bitset_segment_compare(const char *a, size_t a_len, const char *b, size_t b_len) {
+    if (a_len != b_len) {
+        return a_len < b_len ? -1 : 1;
+    }
+    return a_len == 0 ? 0 : memcmp(a, b, a_len);
+}
+
+// Binary search for a literal; on a miss, *insert_pos receives where it belongs.
+static nr_bitset_literal_t* nr_bitset_find_literal(const nr_bitset_depth_t *depth, const char *segment, size_t segment_len, size_t *insert_pos) {
+    size_t low = 0;
+    size_t high = depth->num_literals;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const nr_bitset_literal_t *literal = &depth->literals[mid];
+        int cmp = nr_bitset_segment_compare(segment, segment_len, literal->segment, literal->len);
+        if (cmp == 0) {
+            return &depth->literals[mid];
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    if (insert_pos != NULL) {
+        *insert_pos = low;
+    }
+    return NULL;
+}
+
+static uint64_t* nr_bitset_get_or_add_literal(nr_redirect_bitset_t *bitset, nr_bitset_depth_t *depth, const char *segment, size_t segment_len) {
+    size_t insert_pos = 0;
+    nr_bitset_literal_t *literal = nr_bitset_find_literal(depth, segment, segment_len, &insert_pos);
+    if (literal != NULL) {
+        return literal->rules;
+    }
+
+    if (depth->num_literals >= depth->capacity) {
+        size_t new_capacity = depth->capacity == 0 ? 4 : depth->capacity * 2;
+        nr_bitset_literal_t *literals = (nr_bitset_literal_t*) realloc(depth->literals, new_capacity * sizeof(nr_bitset_literal_t));
+        if (literals == NULL) {
+            return NULL;
+        }
+        depth->literals = literals;
+        depth->capacity = new_capacity;
+    }
+
+    uint64_t *rules = (uint64_t*) calloc(bitset->num_words, sizeof(uint64_t));
+    if (rules == NULL) {
+        return NULL;
+    }
+    memmove(&depth->literals[insert_pos + 1], &depth->literals[insert_pos], (depth->num_literals - insert_pos) * sizeof(nr_bitset_literal_t));
+    depth->literals[insert_pos].segment = segment;
+    depth->literals[insert_pos].len = segment_len;
+    depth->literals[insert_pos].rules = rules;
+    depth->num_literals++;
+    return rules;
+}
+
+/**
+ * @brief Sets a rule's bit everywhere its compiled route program accepts a segment.
+ *
+ * Op i of a program consumes segment i, so the op index is the segment depth.
+ */
+static bool nr_bitset_insert(nr_redirect_bitset_t *bitset, const nanorouter_redirect_rule_t *node, size_t index) {
+    const nr_route_program_t *program = &node->program;
+    size_t words = bitset->num_words;
+
+    for (uint8_t i = 0; i < program->num_ops; i++) {
+        const nr_route_op_t *op = &program->ops[i];
+        switch (op->opcode) {
+            case NR_ROUTE_OP_ANY:
+                for (size_t d = 0; d < NR_MAX_PATH_SEGMENTS; d++) {
+                    nr_bitset_set(&bitset->any_segment[d * words], index);
+                }
+                for (size_t k = 0; k <= NR_MAX_PATH_SEGMENTS; k++) {
+                    nr_bitset_set(&bitset->segment_count[k * words], index);
+                }
+                return true;
+            case NR_ROUTE_OP_FAIL:
+                return true; // Never matches, never a candidate
+            case NR_ROUTE_OP_SPLAT:
+            case NR_ROUTE_OP_SUFFIX:
+                // Any further segments, at least one
+                for (size_t d = i; d < NR_MAX_PATH_SEGMENTS; d++) {
+                    nr_bitset_set(&bitset->any_segment[d * words], index);
+                }
+                for (size_t k = (size_t)i + 1; k <= NR_MAX_PATH_SEGMENTS; k++) {
+                    nr_bitset_set(&bitset->segment_count[k * words], index);
+                }
+                return true;
+            case NR_ROUTE_OP_END:
+                nr_bitset_set(&bitset->segment_count[(size_t)i * words], index);
+                return true;
+            case NR_ROUTE_OP_PARAM:
+                nr_bitset_set(&bitset->non_empty[(size_t)i * words], index);
+                break;
+            default: { // NR_ROUTE_OP_LITERAL
+                uint64_t *rules = nr_bitset_get_or_add_literal(bitset, &bitset->depths[i], node->rule.from_route + op->offset, op->len);
+                if (rules == NULL) {
+                    return false;
+                }
+                nr_bitset_set(rules, index);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+nr_redirect_bitset_t* nr_redirect_bitset_build(const nanorouter_redirect_rule_list_t *list) {
+    if (list == NULL) {
+        return NULL;
+    }
+
+    nr_redirect_bitset_t *bitset = (nr_redirect_bitset_t*) calloc(1, sizeof(nr_redirect_bitset_t));
+    if (bitset == NULL) {
+        return NULL;
+    }
+
+    size_t num_rules = list->count > 0 ? list->count : 1;
+    bitset->num_words = (num_rules + NR_BITSET_WORD_BITS - 1) / NR_BITSET_WORD_BITS;
+    bitset->rules = (const nanorouter_redirect_rule_t**) malloc(num_rules * sizeof(nanorouter_redirect_rule_t*));
+    bitset->any_segment = (uint64_t*) calloc(NR_MAX_PATH_SEGMENTS * bitset->num_words, sizeof(uint64_t));
+    bitset->non_empty = (uint64_t*) calloc(NR_MAX_PATH_SEGMENTS * bitset->num_words, sizeof(uint64_t));
+    bitset->segment_count = (uint64_t*) calloc((NR_MAX_PATH_SEGMENTS + 1) * bitset->num_words, sizeof(uint64_t));
+    if (bitset->rules == NULL || bitset->any_segment == NULL || bitset->non_empty == NULL || bitset->segment_count == NULL) {
+        nr_redirect_bitset_free(bitset);
+        return NULL;
+    }
+
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next) {
+        size_t index = bitset->num_rules;
+        bitset->rules[bitset->num_rules++] = current;
+        if (!nr_bitset_insert(bitset, current, index)) {
+            nr_redirect_bitset_free(bitset);
+            return NULL;
+        }
+    }
+
+    return bitset;
+}
+
+void nr_redirect_bitset_free(nr_redirect_bitset_t *bitset) {
+    if (bitset == NULL) {
+        return;
+    }
+    for (size_t d = 0; d < NR_MAX_PATH_SEGMENTS; d++) {
+        for (size_t i = 0; i < bitset->depths[d].num_literals; i++) {
+            free(bitset->depths[d].literals[i].rules);
+        }
+        free(bitset->depths[d].literals);
+    }
+    free(bitset->rules);
+    free(bitset->any_segment);
+    free(bitset->non_empty);
+    free(bitset->segment_count);
+    free(bitset);
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_bitset_find(
+    const nr_redirect_bitset_t *bitset,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (bitset == NULL || parsed_url == NULL || confirm == NULL) {
+        return NULL;
+    }
+
+    if (parsed_url->too_many_segments) {
+        // Too deep to filter, fall back to trying every rule in order
+        for (size_t i = 0; i < bitset->num_rules; i++) {
+            if (confirm(bitset->rules[i], user_data)) {
+                return bitset->rules[i];
+            }
+        }
+        return NULL;
+    }
+
+    // One literal lookup per segment, then only word-wise ANDs
+    size_t num_segments = parsed_url->num_segments;
+    const uint64_t *literal_rules[NR_MAX_PATH_SEGMENTS];
+    for (size_t d = 0; d < num_segments; d++) {
+        const nr_url_segment_t *segment = &parsed_url->segments[d];
+        const nr_bitset_literal_t *literal = nr_bitset_find_literal(&bitset->depths[d], segment->start, segment->len, NULL);
+        literal_rules[d] = literal != NULL ? literal->rules : NULL;
+    }
+
+    size_t words = bitset->num_words;
+    const uint64_t *count_rules = &bitset->segment_count[num_segments * words];
+    for (size_t w = 0; w < words; w++) {
+        uint64_t candidates = count_rules[w];
+        for (size_t d = 0; d < num_segments && candidates != 0; d++) {
+            uint64_t accepted = bitset->any_segment[d * words + w];
+            if (parsed_url->segments[d].len > 0) {
+                accepted |= bitset->non_empty[d * words + w];
+            }
+            if (literal_rules[d] != NULL) {
+                accepted |= literal_rules[d][w];
+            }
+            candidates &= accepted;
+        }
+
+        // Words are visited in order and bits lowest first, so the first confirmed rule wins
+        while (candidates != 0) {
+            size_t index = w * NR_BITSET_WORD_BITS + (size_t)__builtin_ctzll(candidates);
+            candidates &= candidates - 1;
+            if (confirm(bitset->rules[index], user_data)) {
+                return bitset->rules[index];
+            }
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef NANOROUTER_REDIRECT_BITSET_H
+#define NANOROUTER_REDIRECT_BITSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and nr_redirect_confirm_callback_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque bit-parallel candidate filter built from a redirect rule list.
+ *
+ * For every segment depth, each distinct literal segment maps to a bitset of
+ * the rules that accept it there (bit i is rule i). Placeholder and splat
+ * positions are kept in per-depth bitsets that accept any segment, and a
+ * bitset per URL segment count keeps only rules of a compatible length.
+ * A request ANDs one bitset per segment, 64 rules per word, and confirms the
+ * surviving rules in ascending order.
+ */
+typedef struct nr_redirect_bitset_t nr_redirect_bitset_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds the bitset filter over all rules currently stored in a list.
+ *
+ * The filter only references the list nodes, so the list must outlive it and
+ * must not be modified while it is in use.
+ *
+ * @param list The rule list to index.
+ * @return A pointer to the newly built filter, or NULL on allocation failure.
+ */
+nr_redirect_bitset_t* nr_redirect_bitset_build(const nanorouter_redirect_rule_list_t *list);
+
+/**
+ * @brief Frees a filter built with nr_redirect_bitset_build.
+ *
+ * @param bitset The filter to free. May be NULL.
+ */
+void nr_redirect_bitset_free(nr_redirect_bitset_t *bitset);
+
+/**
+ * @brief Finds the lowest-index rule that survives the filter and passes confirmation.
+ *
+ * @param bitset The filter to search.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm Callback that performs the full rule check for a candidate.
+ * @param user_data Data passed through to the confirm callback.
+ * @return The winning rule node, or NULL if no rule matches.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_bitset_find(
+    const nr_redirect_bitset_t *bitset,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+#endif // NANOROUTER_REDIRECT_BITSET_H
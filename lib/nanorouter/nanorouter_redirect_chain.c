@@ -0,0 +1,658 @@
+#include "nanorouter_redirect_chain.h"
+#include "nanorouter_redirect_host.h" // For nr_redirect_rule_path_program
+#include <stdlib.h> // For malloc, free
+#include <string.h> // For memcpy, memcmp, memchr, strlen, strncasecmp
+
+// How a rule relates to a target whose placeholders are not known until a request comes
+typedef enum {
+    NR_CHAIN_NO,                // The rule matches no request the target stands for
+    NR_CHAIN_YES,               // The rule matches every request the target stands for
+    NR_CHAIN_MAYBE              // It depends on the request
+} nr_chain_verdict_t;
+
+// What a path segment of a target holds once its placeholders are filled in
+typedef enum {
+    NR_CHAIN_SEGMENT_LITERAL,   // Known bytes
+    NR_CHAIN_SEGMENT_ONE,       // Exactly one non-empty segment, bytes unknown
+    NR_CHAIN_SEGMENT_MANY       // Any number of segments
+} nr_chain_segment_t;
+
+// The first rule of a chain; every target of the chain is written in terms of its captures
+typedef struct {
+    const nanorouter_redirect_rule_t *node;
+    const char *path_pattern;
+    nr_route_program_t buffer;                  // The path program of a host rule
+    const nr_route_program_t *program;
+    nr_capture_key_t keys[NR_MAX_MATCHED_PARAMS];
+    uint8_t num_keys;
+} nr_chain_origin_t;
+
+// A placeholder of a target that stands for one of the first rule's captures
+typedef struct {
+    uint16_t offset;
+    uint16_t len;
+    uint8_t key;                                // Index into nr_chain_origin_t.keys
+} nr_chain_var_t;
+
+// The target one step of a chain rewrites to
+typedef struct {
+    char text[NR_MAX_ROUTE_LEN + 1];
+    size_t len;
+    nr_chain_var_t vars[NR_MAX_TEMPLATE_PARTS]; // In text order
+    uint8_t num_vars;
+} nr_chain_target_t;
+
+// A target split into path segments, with what each segment can hold
+typedef struct {
+    nr_parsed_url_t parsed;
+    uint8_t shapes[NR_MAX_PATH_SEGMENTS];       // nr_chain_segment_t of each segment
+    bool has_many;
+} nr_chain_path_t;
+
+// What a chain follows
+typedef enum {
+    NR_CHAIN_REWRITES,          // 200 rules, matched again inside the server
+    NR_CHAIN_REDIRECTS          // 301/302/307/308 rules, requested again by the browser
+} nr_chain_mode_t;
+
+// Where a followed chain ends
+typedef struct {
+    const nr_chain_target_t *target;
+    const nanorouter_redirect_rule_t *hops[NR_MAX_REWRITE_HOPS];  // The rules followed after the first one
+    size_t num_hops;
+    uint16_t status_code;
+} nr_chain_end_t;
+
+// A value a rule captures from a target, as a span of the target's text
+typedef struct {
+    const char *key;
+    size_t key_len;
+    size_t offset;
+    size_t len;
+} nr_chain_binding_t;
+
+static void nr_chain_origin_init(nr_chain_origin_t *origin, const nanorouter_redirect_rule_t *node) {
+    const char *host;
+    size_t host_len;
+    origin->node = node;
+    // Host rules capture from their path part, as they are matched at request time
+    origin->path_pattern = nr_redirect_rule_path_program(node, &origin->buffer, &origin->program, &host, &host_len);
+    origin->num_keys = nr_route_capture_keys(origin->path_pattern, origin->program, node->rule.query_params, node->rule.num_query_params, origin->keys);
+}
+
+/**
+ * @brief Finds the placeholders of a target that the first rule fills in.
+ *
+ * Placeholders naming nothing the first rule captures are rendered as written,
+ * so they count as literal bytes.
+ *
+ * @return false if the target needs more than NR_MAX_TEMPLATE_PARTS parts.
+ */
+static bool nr_chain_target_scan(const nr_chain_origin_t *origin, nr_chain_target_t *target) {
+    const redirect_rule_t *rule = &origin->node->rule;
+    nr_route_template_t route_template;
+    if (!nr_compile_route_template(target->text, origin->path_pattern, origin->program, rule->query_params, rule->num_query_params, &route_template)) {
+        return false;
+    }
+    target->num_vars = 0;
+    for (uint8_t i = 0; i < route_template.num_parts; i++) {
+        const nr_template_part_t *part = &route_template.parts[i];
+        if (part->kind != NR_TEMPLATE_PART_LITERAL && part->capture != NR_TEMPLATE_NO_CAPTURE) {
+            nr_chain_var_t *var = &target->vars[target->num_vars++];
+            var->offset = part->offset;
+            var->len = part->len;
+            var->key = part->capture;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Splits a target into segments and works out what each one can hold.
+ *
+ * @return false if the target's path cannot be reasoned about without its values:
+ *         a query value in the path, a possibly empty last segment (whose '/'
+ *         the request path would drop), or too many segments.
+ */
+static bool nr_chain_path_init(const nr_chain_origin_t *origin, const nr_chain_target_t *target, nr_chain_path_t *path) {
+    nr_parsed_url_t *parsed = &path->parsed;
+    nr_parse_url_n(target->text, target->len, parsed);
+    if (parsed->too_many_segments) {
+        return false;
+    }
+    memset(path->shapes, NR_CHAIN_SEGMENT_LITERAL, sizeof(path->shapes));
+    path->has_many = false;
+
+    for (uint8_t i = 0; i < target->num_vars; i++) {
+        const nr_chain_var_t *var = &target->vars[i];
+        if (var->offset >= parsed->path_len) {
+            continue; // In the query
+        }
+        uint8_t kind = origin->keys[var->key].kind;
+        if (kind == NR_CAPTURE_QUERY || parsed->num_segments == 0) {
+            return false; // May hold '/', '?' or nothing at all
+        }
+        uint8_t s = parsed->num_segments - 1;
+        while (s > 0 && (size_t)(parsed->segments[s].start - target->text) > var->offset) {
+            s--;
+        }
+        if (kind == NR_CAPTURE_SEGMENT) {
+            if (path->shapes[s] == NR_CHAIN_SEGMENT_LITERAL) {
+                path->shapes[s] = NR_CHAIN_SEGMENT_ONE;
+            }
+            continue;
+        }
+        if (kind == NR_CAPTURE_PATH && s == parsed->num_segments - 1 && parsed->segments[s].len == var->len) {
+            return false; // An empty value leaves a trailing '/'
+        }
+        path->shapes[s] = NR_CHAIN_SEGMENT_MANY;
+        path->has_many = true;
+    }
+    return true;
+}
+
+static void nr_chain_bind(nr_chain_binding_t *bindings, uint8_t *num_bindings, const char *key, size_t key_len, size_t offset, size_t len) {
+    if (*num_bindings >= NR_MAX_MATCHED_PARAMS) {
+        return;
+    }
+    nr_chain_binding_t *binding = &bindings[(*num_bindings)++];
+    binding->key = key;
+    binding->key_len = key_len;
+    binding->offset = offset;
+    binding->len = len;
+}
+
+/**
+ * @brief Runs a compiled path pattern over a target, the way nr_match_compiled_pattern runs it over a request.
+ *
+ * @param pattern The pattern the program was compiled from.
+ * @param program The compiled path pattern.
+ * @param path The target, split into segments.
+ * @param case_insensitive Compare literal segments without case, as a case-insensitive list does.
+ * @param bindings Output: the captured spans of the target, when the verdict is NR_CHAIN_YES.
+ * @param num_bindings Output: number of entries in bindings.
+ * @return The verdict.
+ */
+static nr_chain_verdict_t nr_chain_match_path(
+    const char *pattern,
+    const nr_route_program_t *program,
+    const nr_chain_path_t *path,
+    bool case_insensitive,
+    nr_chain_binding_t *bindings,
+    uint8_t *num_bindings
+) {
+    const nr_parsed_url_t *parsed = &path->parsed;
+    uint8_t pos = 0;
+    *num_bindings = 0;
+    for (uint8_t i = 0; i < program->num_ops; i++) {
+        const nr_route_op_t *op = &program->ops[i];
+        const char *name = pattern + op->offset;
+        switch (op->opcode) {
+            case NR_ROUTE_OP_LITERAL:
+            case NR_ROUTE_OP_PARAM: {
+                if (pos >= parsed->num_segments) return NR_CHAIN_NO;
+                const nr_url_segment_t *segment = &parsed->segments[pos];
+                uint8_t shape = path->shapes[pos++];
+                if (shape == NR_CHAIN_SEGMENT_MANY) {
+                    return NR_CHAIN_MAYBE; // Its value decides how many segments it covers
+                }
+                if (op->opcode == NR_ROUTE_OP_PARAM) {
+                    if (shape == NR_CHAIN_SEGMENT_LITERAL && segment->len == 0) return NR_CHAIN_NO;
+                    nr_chain_bind(bindings, num_bindings, name, op->len, (size_t)(segment->start - parsed->url), segment->len);
+                } else if (shape == NR_CHAIN_SEGMENT_ONE) {
+                    return NR_CHAIN_MAYBE; // Its value decides
+                } else if (segment->len != op->len ||
+                           (case_insensitive ? strncasecmp(segment->start, name, op->len) : memcmp(segment->start, name, op->len)) != 0) {
+                    return NR_CHAIN_NO;
+                }
+                break;
+            }
+            case NR_ROUTE_OP_SPLAT: {
+                if (pos >= parsed->num_segments) return NR_CHAIN_NO;
+                size_t offset = (size_t)(parsed->segments[pos].start - parsed->url);
+                nr_chain_bind(bindings, num_bindings, op->len == 0 ? "*" : name, op->len == 0 ? 1 : op->len, offset, parsed->path_len - offset);
+                return NR_CHAIN_YES;
+            }
+            case NR_ROUTE_OP_SUFFIX:
+                // How the target ends decides, and placeholders may stand for it
+                return pos >= parsed->num_segments ? NR_CHAIN_NO : NR_CHAIN_MAYBE;
+            case NR_ROUTE_OP_ANY:
+                nr_chain_bind(bindings, num_bindings, "*", 1, 1, parsed->path_len > 1 ? parsed->path_len - 1 : 0);
+                return NR_CHAIN_YES;
+            case NR_ROUTE_OP_END:
+                return pos == parsed->num_segments ? NR_CHAIN_YES : NR_CHAIN_NO;
+            default: // NR_ROUTE_OP_FAIL: only paths deeper than NR_MAX_PATH_SEGMENTS
+                return path->has_many ? NR_CHAIN_MAYBE : NR_CHAIN_NO;
+        }
+    }
+    return NR_CHAIN_NO;
+}
+
+/**
+ * @brief Decides whether a rule applies to a target, judging by the rule alone.
+ *
+ * Host rules depend on the request's domain, and query parameters and
+ * conditions on the request itself, so they are never decided here.
+ */
+static nr_chain_verdict_t nr_chain_match_rule(
+    const nanorouter_redirect_rule_t *node,
+    const nr_chain_path_t *path,
+    bool case_insensitive,
+    nr_chain_binding_t *bindings,
+    uint8_t *num_bindings
+) {
+    nr_route_program_t buffer;
+    const nr_route_program_t *program;
+    const char *host;
+    size_t host_len;
+    const char *pattern = nr_redirect_rule_path_program(node, &buffer, &program, &host, &host_len);
+    nr_chain_verdict_t verdict = nr_chain_match_path(pattern, program, path, case_insensitive, bindings, num_bindings);
+    if (verdict == NR_CHAIN_YES && (host != NULL || node->rule.num_query_params > 0 || node->rule.num_conditions > 0)) {
+        return NR_CHAIN_MAYBE;
+    }
+    return verdict;
+}
+
+// Appends bytes to a target being composed; false once it outgrows NR_MAX_ROUTE_LEN
+static bool nr_chain_append(nr_chain_target_t *target, const char *bytes, size_t len) {
+    if (len > NR_MAX_ROUTE_LEN - target->len) {
+        return false;
+    }
+    memcpy(target->text + target->len, bytes, len);
+    target->len += len;
+    return true;
+}
+
+// Appends a span of another target, with the placeholders inside it
+static bool nr_chain_append_span(nr_chain_target_t *next, const nr_chain_target_t *target, size_t offset, size_t len) {
+    size_t base = next->len;
+    if (!nr_chain_append(next, target->text + offset, len)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < target->num_vars; i++) {
+        const nr_chain_var_t *var = &target->vars[i];
+        if (var->offset + var->len <= offset || var->offset >= offset + len) {
+            continue;
+        }
+        if (var->offset < offset || var->offset + var->len > offset + len || next->num_vars >= NR_MAX_TEMPLATE_PARTS) {
+            return false; // Cut in two
+        }
+        nr_chain_var_t *copy = &next->vars[next->num_vars++];
+        *copy = *var;
+        copy->offset = (uint16_t)(base + var->offset - offset);
+    }
+    return true;
+}
+
+// Checks whether a span of a target is made of placeholders only, so it may render empty
+static bool nr_chain_span_is_placeholders(const nr_chain_target_t *target, size_t offset, size_t end) {
+    size_t covered = 0;
+    for (uint8_t i = 0; i < target->num_vars; i++) {
+        if (target->vars[i].offset >= offset && target->vars[i].offset < end) {
+            covered += target->vars[i].len;
+        }
+    }
+    return covered == end - offset;
+}
+
+/**
+ * @brief Renders a rule's to_route from a target it matched, keeping the target's placeholders.
+ *
+ * Mirrors the request-time render: captured spans are substituted, and the
+ * target's own query pairs are passed through unless to_route has a '?'.
+ *
+ * @return false if the result does not fit NR_MAX_ROUTE_LEN, or would not read
+ *         back as the same placeholders ("/:id" followed by ".html").
+ */
+static bool nr_chain_compose(
+    const nr_chain_origin_t *origin,
+    const nanorouter_redirect_rule_t *node,
+    const nr_chain_target_t *target,
+    const nr_chain_path_t *path,
+    const nr_chain_binding_t *bindings,
+    uint8_t num_bindings,
+    nr_chain_target_t *next
+) {
+    const nr_route_template_t *route_template = &node->to_template;
+    const char *to_route = node->rule.to_route;
+    next->len = 0;
+    next->num_vars = 0;
+
+    for (uint8_t i = 0; i < route_template->num_parts; i++) {
+        const nr_template_part_t *part = &route_template->parts[i];
+        if (part->kind != NR_TEMPLATE_PART_LITERAL) {
+            size_t key_len;
+            const char *key = nr_route_template_part_key(route_template, i, to_route, &key_len);
+            const nr_chain_binding_t *binding = NULL;
+            for (uint8_t b = 0; b < num_bindings && binding == NULL; b++) {
+                if (bindings[b].key_len == key_len && memcmp(bindings[b].key, key, key_len) == 0) {
+                    binding = &bindings[b];
+                }
+            }
+            if (binding != NULL) {
+                if (!nr_chain_append_span(next, target, binding->offset, binding->len)) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        // Literal chunk, or a placeholder with nothing captured, kept as written
+        if (!nr_chain_append(next, to_route + part->offset, part->len)) {
+            return false;
+        }
+    }
+
+    const nr_parsed_url_t *parsed = &path->parsed;
+    if (!route_template->has_query && parsed->query_len > 0) {
+        size_t query_end = (size_t)(parsed->query - parsed->url) + parsed->query_len;
+        bool first_pair = true;
+        for (size_t pair = (size_t)(parsed->query - parsed->url); pair < query_end; ) {
+            const char *amp = (const char *)memchr(target->text + pair, '&', query_end - pair);
+            size_t pair_end = amp != NULL ? (size_t)(amp - target->text) : query_end;
+            if (pair_end > pair) {
+                if (nr_chain_span_is_placeholders(target, pair, pair_end)) {
+                    return false; // Dropped at request time if its values are empty
+                }
+                if (!nr_chain_append(next, first_pair ? "?" : "&", 1) || !nr_chain_append_span(next, target, pair, pair_end - pair)) {
+                    return false;
+                }
+                first_pair = false;
+            }
+            pair = pair_end + 1;
+        }
+    }
+    next->text[next->len] = '\0';
+
+    // Joining chunks can turn literal bytes into a placeholder name, so the result must read back the same
+    nr_chain_var_t vars[NR_MAX_TEMPLATE_PARTS];
+    uint8_t num_vars = next->num_vars;
+    memcpy(vars, next->vars, num_vars * sizeof(nr_chain_var_t));
+    if (!nr_chain_target_scan(origin, next) || next->num_vars != num_vars) {
+        return false;
+    }
+    for (uint8_t i = 0; i < num_vars; i++) {
+        if (vars[i].offset != next->vars[i].offset || vars[i].len != next->vars[i].len || vars[i].key != next->vars[i].key) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reports a cycle once: from the rule of the cycle that is listed first.
+ *
+ * @param node The rule the chain started from.
+ * @param members The rules of the cycle, in the order they rewrite.
+ * @param num_members Number of entries in members.
+ */
+static void nr_chain_report_cycle(
+    const nanorouter_redirect_rule_t *node,
+    const nanorouter_redirect_rule_t *const *members,
+    size_t num_members,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+) {
+    size_t start = num_members;
+    for (size_t i = 0; i < num_members; i++) {
+        if (members[i]->index < node->index) {
+            return; // Reported from that rule
+        }
+        if (members[i] == node && start == num_members) {
+            start = i;
+        }
+    }
+    if (on_cycle == NULL || start == num_members) {
+        return; // The chain runs into a cycle it is not part of
+    }
+    const redirect_rule_t *rules[NR_MAX_REWRITE_HOPS];
+    for (size_t i = 0; i < num_members; i++) {
+        rules[i] = &members[(start + i) % num_members]->rule;
+    }
+    on_cycle(rules, num_members, user_data);
+}
+
+/**
+ * @brief Checks whether a browser requests a redirect's target again, so a chain of them can be collapsed.
+ */
+static bool nr_chain_status_is_redirect(uint16_t status_code) {
+    return status_code == 301 || status_code == 302 || status_code == 307 || status_code == 308;
+}
+
+/**
+ * @brief Gives the status of one redirect that does what two consecutive ones do.
+ *
+ * The result is permanent only if both are (301, 308), and keeps the request
+ * method only if both do (307, 308): a 301 or 302 anywhere may already have
+ * turned a POST into a GET.
+ */
+static uint16_t nr_chain_status_combine(uint16_t first, uint16_t second) {
+    bool permanent = (first == 301 || first == 308) && (second == 301 || second == 308);
+    bool keeps_method = (first == 307 || first == 308) && (second == 307 || second == 308);
+    if (keeps_method) {
+        return permanent ? 308 : 307;
+    }
+    return permanent ? 301 : 302;
+}
+
+/**
+ * @brief Checks whether a forced rule listed after a target's first matching rule may match the target too.
+ *
+ * The forced pass answers with such a rule before the static-file lookup, so
+ * which of the two wins depends on the pass serving the request.
+ */
+static bool nr_chain_forced_rule_below(
+    const nanorouter_redirect_rule_list_t *list,
+    const nanorouter_redirect_rule_t *winner,
+    const nr_chain_path_t *path
+) {
+    nr_chain_binding_t bindings[NR_MAX_MATCHED_PARAMS];
+    uint8_t num_bindings = 0;
+    for (size_t i = 0; i < list->num_forced_rules; i++) {
+        const nanorouter_redirect_rule_t *forced = list->forced_rules[i];
+        if (forced->index > winner->index &&
+            nr_chain_match_rule(forced, path, list->case_insensitive, bindings, &num_bindings) != NR_CHAIN_NO) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Follows the target of one rule through the rules it matches, as far as the rules alone decide.
+ *
+ * Rewrites are followed inside the server, through 200 rules, and end at the
+ * first rule with another status, which is included. Redirects are followed
+ * the way a browser follows them, through 301/302/307/308 rules, and end
+ * before any other rule, whose answer the browser would get at that URL.
+ *
+ * A chain only goes through a rule every request pass would pick: it ends
+ * before an unforced rule when a forced one listed below may match too, and a
+ * forced rule's chain ends before any unforced rule, which a static file at
+ * the target would shadow.
+ *
+ * @param list The rule list.
+ * @param node The rule to follow.
+ * @param mode What to follow.
+ * @param targets Scratch space for NR_MAX_REWRITE_HOPS + 1 targets.
+ * @param on_cycle Called when the rule is the first listed of a cycle. May be NULL.
+ * @param user_data Data passed through to on_cycle.
+ * @param end Output: where the chain ends.
+ * @return true if the chain was followed to its end through at least one other rule, false otherwise.
+ */
+static bool nr_chain_follow(
+    const nanorouter_redirect_rule_list_t *list,
+    const nanorouter_redirect_rule_t *node,
+    nr_chain_mode_t mode,
+    nr_chain_target_t *targets,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data,
+    nr_chain_end_t *end
+) {
+    nr_chain_origin_t origin;
+    nr_chain_origin_init(&origin, node);
+    targets[0].len = strlen(node->rule.to_route);
+    memcpy(targets[0].text, node->rule.to_route, targets[0].len + 1);
+    if (!nr_chain_target_scan(&origin, &targets[0])) {
+        return false;
+    }
+
+    end->target = NULL;
+    end->num_hops = 0;
+    end->status_code = node->rule.status_code;
+    for (size_t step = 0; end->target == NULL; step++) {
+        const nr_chain_target_t *target = &targets[step];
+        nr_chain_path_t path;
+        if (!nr_chain_path_init(&origin, target, &path)) {
+            return false;
+        }
+
+        // The first rule that can match decides, as at request time
+        nr_chain_binding_t bindings[NR_MAX_MATCHED_PARAMS];
+        uint8_t num_bindings = 0;
+        const nanorouter_redirect_rule_t *winner = NULL;
+        for (const nanorouter_redirect_rule_t *current = list->head; current != NULL && winner == NULL; current = current->next) {
+            nr_chain_verdict_t verdict = nr_chain_match_rule(current, &path, list->case_insensitive, bindings, &num_bindings);
+            if (verdict == NR_CHAIN_MAYBE) {
+                return false; // Left to the request
+            }
+            if (verdict == NR_CHAIN_YES) {
+                winner = current;
+            }
+        }
+        if (winner != NULL && !winner->rule.force && (node->rule.force || nr_chain_forced_rule_below(list, winner, &path))) {
+            winner = NULL; // Left to the pass serving the target
+        }
+        bool follows = winner != NULL &&
+                       (mode == NR_CHAIN_REWRITES ? winner->rule.status_code == 200 : nr_chain_status_is_redirect(winner->rule.status_code));
+        if (winner == NULL || (mode == NR_CHAIN_REDIRECTS && !follows)) {
+            end->target = target; // Served as it is
+            break;
+        }
+
+        nr_chain_target_t *next = &targets[step + 1];
+        if (!nr_chain_compose(&origin, winner, target, &path, bindings, num_bindings, next)) {
+            return false;
+        }
+        if (mode == NR_CHAIN_REWRITES && follows && next->len == target->len && memcmp(next->text, target->text, next->len) == 0) {
+            end->target = target; // Rewritten to itself ("/* /index.html 200")
+            break;
+        }
+        end->hops[end->num_hops++] = winner;
+        end->status_code = mode == NR_CHAIN_REWRITES ? winner->rule.status_code : nr_chain_status_combine(end->status_code, winner->rule.status_code);
+        if (!follows || next->text[0] != '/') {
+            end->target = next; // A redirect after rewrites, or another site, ends the chain
+            break;
+        }
+        for (size_t i = 0; i <= step; i++) {
+            if (targets[i].len == next->len && memcmp(targets[i].text, next->text, next->len) == 0) {
+                nr_chain_report_cycle(node, end->hops + i, step + 1 - i, on_cycle, user_data);
+                return false;
+            }
+        }
+        if (step + 1 >= NR_MAX_REWRITE_HOPS) {
+            return false; // Followed at request time
+        }
+    }
+    return end->num_hops > 0;
+}
+
+/**
+ * @brief Stores where a followed chain ends on its first rule.
+ *
+ * @return false on allocation failure.
+ */
+static bool nr_chain_annotate(nanorouter_redirect_rule_t *node, const nr_chain_end_t *end) {
+    nr_redirect_chain_t *chain = (nr_redirect_chain_t*) malloc(sizeof(nr_redirect_chain_t));
+    if (chain == NULL) {
+        return false;
+    }
+    memcpy(chain->to_route, end->target->text, end->target->len + 1);
+    if (!nr_compile_route_template(chain->to_route, node->rule.from_route, &node->program,
+                                   node->rule.query_params, node->rule.num_query_params, &chain->to_template)) {
+        free(chain);
+        return true; // Left unresolved
+    }
+    chain->final_rule = end->hops[end->num_hops - 1];
+    chain->status_code = end->status_code;
+    chain->num_hops = (uint8_t)end->num_hops;
+    node->chain = chain;
+    return true;
+}
+
+/**
+ * @brief Follows every rule of a list that a mode starts from and annotates the rules whose chain ends elsewhere.
+ *
+ * @return false on allocation failure (no rule is annotated then).
+ */
+static bool nr_chains_follow_all(
+    nanorouter_redirect_rule_list_t *list,
+    nr_chain_mode_t mode,
+    nr_redirect_collapse_callback_t on_follow,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+) {
+    nr_redirect_chains_drop(list);
+    nr_chain_target_t *targets = (nr_chain_target_t*) malloc((NR_MAX_REWRITE_HOPS + 1) * sizeof(nr_chain_target_t));
+    if (targets == NULL) {
+        return false;
+    }
+    nr_chain_end_t end;
+    for (nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next) {
+        // Only rules whose target comes back to this site are followed
+        uint16_t status_code = node->rule.status_code;
+        if ((mode == NR_CHAIN_REWRITES ? status_code != 200 : !nr_chain_status_is_redirect(status_code)) || node->rule.to_route[0] != '/' ||
+            !nr_chain_follow(list, node, mode, targets, on_cycle, user_data, &end)) {
+            continue;
+        }
+        if (!nr_chain_annotate(node, &end)) {
+            free(targets);
+            nr_redirect_chains_drop(list);
+            return false;
+        }
+        if (on_follow != NULL && node->chain != NULL) {
+            const redirect_rule_t *rules[NR_MAX_REWRITE_HOPS + 1];
+            rules[0] = &node->rule;
+            for (size_t i = 0; i < end.num_hops; i++) {
+                rules[i + 1] = &end.hops[i]->rule;
+            }
+            on_follow(rules, end.num_hops + 1, user_data);
+        }
+    }
+    free(targets);
+    return true;
+}
+
+bool nr_redirect_chains_resolve(nanorouter_redirect_rule_list_t *list, nr_redirect_cycle_callback_t on_cycle, void *user_data) {
+    return nr_chains_follow_all(list, NR_CHAIN_REWRITES, NULL, on_cycle, user_data);
+}
+
+bool nr_redirect_chains_collapse(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_collapse_callback_t on_collapse,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+) {
+    // Every chain is followed through the rules as written before any of them is rewritten
+    if (!nr_chains_follow_all(list, NR_CHAIN_REDIRECTS, on_collapse, on_cycle, user_data)) {
+        return false;
+    }
+    for (nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next) {
+        nr_redirect_chain_t *chain = node->chain;
+        if (chain == NULL) {
+            continue;
+        }
+        memcpy(node->rule.to_route, chain->to_route, sizeof(node->rule.to_route));
+        node->rule.status_code = chain->status_code;
+        node->to_template = chain->to_template; // Compiled against this rule, refers into to_route at the same offsets
+        free(chain);
+        node->chain = NULL;
+    }
+    return true;
+}
+
+void nr_redirect_chains_drop(nanorouter_redirect_rule_list_t *list) {
+    for (nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next) {
+        free(node->chain);
+        node->chain = NULL;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef NANOROUTER_REDIRECT_CHAIN_H
+#define NANOROUTER_REDIRECT_CHAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_config.h" // For NR_MAX_ROUTE_LEN and NR_MAX_REWRITE_HOPS
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and the chain callbacks
+#include "nanorouter_route_template.h" // For nr_route_template_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Where a 200 rewrite ends up once the rules its target matches have been followed.
+ *
+ * to_route is written in terms of the first rule's captures, so it renders in
+ * one pass from the first rule's match, like the rule's own to_route.
+ */
+typedef struct nr_redirect_chain_t {
+    char to_route[NR_MAX_ROUTE_LEN + 1];                /**< The final target. Null-terminated. */
+    nr_route_template_t to_template;                    /**< to_route, compiled against the first rule. */
+    const nanorouter_redirect_rule_t *final_rule;       /**< The last rule followed. */
+    uint16_t status_code;                               /**< The final status: 200, or the status of a redirect that ended the chain. */
+    uint8_t num_hops;                                   /**< Rules followed after the first one. */
+} nr_redirect_chain_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Resolves the rewrite chain of every 200 rule of a list whose target another rule rewrites.
+ *
+ * Targets are matched symbolically against the rules in list order, with
+ * placeholders standing for the first rule's captures. Earlier resolutions
+ * are dropped first.
+ *
+ * @param list The rule list.
+ * @param on_cycle Called once for every cycle of rewrites. May be NULL.
+ * @param user_data Data passed through to on_cycle.
+ * @return true on success, false on allocation failure (no rule is resolved then).
+ */
+bool nr_redirect_chains_resolve(nanorouter_redirect_rule_list_t *list, nr_redirect_cycle_callback_t on_cycle, void *user_data);
+
+/**
+ * @brief Rewrites every redirect of a list whose target another redirect sends on, to point at the end of the chain.
+ *
+ * Chains are followed through the rules as written, then every collapsed
+ * rule gets the final target as its to_route and the combined status.
+ * Resolved rewrite chains are dropped.
+ *
+ * @param list The rule list.
+ * @param on_collapse Called for every collapsed rule, before it is rewritten. May be NULL.
+ * @param on_cycle Called once for every cycle of redirects. May be NULL.
+ * @param user_data Data passed through to the callbacks.
+ * @return true on success, false on allocation failure (no rule is rewritten then).
+ */
+bool nr_redirect_chains_collapse(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_collapse_callback_t on_collapse,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+);
+
+/**
+ * @brief Drops the resolved chains of every rule of a list.
+ *
+ * @param list The rule list.
+ */
+void nr_redirect_chains_drop(nanorouter_redirect_rule_list_t *list);
+
+#endif // NANOROUTER_REDIRECT_CHAIN_H
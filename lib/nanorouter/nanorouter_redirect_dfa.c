@@ -0,0 +1,436 @@
+#include "nanorouter_redirect_dfa.h"
+#include "nanorouter_string_utils.h" // For nr_hash_bytes
+#include "nanorouter_config.h" // For NR_REDIRECT_DFA_MAX_STATES
+#include <stdlib.h> // For malloc, calloc, realloc, free, qsort
+#include <string.h> // For memcpy, memcmp
+
+#define NR_DFA_DEAD UINT32_MAX  // Transition target when no pattern can match any more
+#define NR_DFA_DONE 0xFFu       // Op index of a rule whose trailing splat already matched
+
+// A live pattern position: rule index in the upper bits, op index in the low byte.
+typedef uint32_t nr_dfa_position_t;
+#define NR_DFA_POSITION(rule, op) (((uint32_t)(rule) << 8) | (uint32_t)(op))
+#define NR_DFA_POSITION_RULE(pos) ((pos) >> 8)
+#define NR_DFA_POSITION_OP(pos) ((pos) & 0xFFu)
+#define NR_DFA_MAX_RULES (1u << 24)
+
+typedef struct {
+    const char *segment;    // Points into a rule's from_route (not null-terminated)
+    uint16_t len;
+    uint32_t target;
+} nr_dfa_edge_t;
+
+typedef struct {
+    nr_dfa_edge_t *edges;       // Literal segments, sorted by (length, bytes)
+    size_t num_edges;
+    uint32_t other_target;      // Any other non-empty segment
+    uint32_t empty_target;      // An empty segment without an edge of its own
+    uint32_t *accept_rules;     // Rules whose path pattern matches if the URL ends here, ascending
+    size_t num_accept_rules;
+} nr_dfa_state_t;
+
+struct nr_redirect_dfa_t {
+    nr_dfa_state_t *states;     // State 0 is the start state
+    size_t num_states;
+    const nanorouter_redirect_rule_t **rules; // Rule nodes by index
+    size_t num_rules;
+};
+
+// State kept only while the automaton is being built.
+typedef struct {
+    nr_redirect_dfa_t *dfa;
+    size_t states_capacity;
+    nr_dfa_position_t **positions;  // Position set of each state, ascending
+    size_t *num_positions;
+    uint32_t *lookup;               // Open-addressing table of state indexes, keyed by position set
+    size_t lookup_capacity;
+} nr_dfa_builder_t;
+
+static const nr_route_op_t* nr_dfa_position_op(const nr_redirect_dfa_t *dfa, nr_dfa_position_t position) {
+    if (NR_DFA_POSITION_OP(position) == NR_DFA_DONE) {
+        return NULL;
+    }
+    return &dfa->rules[NR_DFA_POSITION_RULE(position)]->program.ops[NR_DFA_POSITION_OP(position)];
+}
+
+// Orders segments by length first, then by bytes, like the trie children.
+static int nr_dfa_segment_compare(const char *a, size_t a_len, const char *b, size_t b_len) {
+    if (a_len != b_len) {
+        return a_len < b_len ? -1 : 1;
+    }
+    return a_len == 0 ? 0 : memcmp(a, b, a_len);
+}
+
+static int nr_dfa_edge_compare(const void *a, const void *b) {
+    const nr_dfa_edge_t *edge_a = (const nr_dfa_edge_t*) a;
+    const nr_dfa_edge_t *edge_b = (const nr_dfa_edge_t*) b;
+    return nr_dfa_segment_compare(edge_a->segment, edge_a->len, edge_b->segment, edge_b->len);
+}
+
+static uint32_t nr_dfa_set_hash(const nr_dfa_position_t *set, size_t count) {
+    return nr_hash_bytes((const char*) set, count * sizeof(nr_dfa_position_t));
+}
+
+// Returns the lookup slot holding the set, or the empty slot where it belongs.
+static uint32_t* nr_dfa_lookup_slot(const nr_dfa_builder_t *builder, const nr_dfa_position_t *set, size_t count) {
+    size_t mask = builder->lookup_capacity - 1;
+    size_t pos = nr_dfa_set_hash(set, count) & mask;
+    while (true) {
+        uint32_t *slot = &builder->lookup[pos];
+        if (*slot == NR_DFA_DEAD) {
+            return slot;
+        }
+        if (builder->num_positions[*slot] == count &&
+            (count == 0 || memcmp(builder->positions[*slot], set, count * sizeof(nr_dfa_position_t)) == 0)) {
+            return slot;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+static bool nr_dfa_lookup_grow(nr_dfa_builder_t *builder) {
+    size_t new_capacity = builder->lookup_capacity == 0 ? 64 : builder->lookup_capacity * 2;
+    uint32_t *lookup = (uint32_t*) malloc(new_capacity * sizeof(uint32_t));
+    if (lookup == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < new_capacity; i++) {
+        lookup[i] = NR_DFA_DEAD;
+    }
+    free(builder->lookup);
+    builder->lookup = lookup;
+    builder->lookup_capacity = new_capacity;
+
+    for (uint32_t i = 0; i < builder->dfa->num_states; i++) {
+        *nr_dfa_lookup_slot(builder, builder->positions[i], builder->num_positions[i]) = i;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the state for a position set, creating it if it does not exist yet.
+ *
+ * @return true on success, false on allocation failure or when the state limit is reached.
+ */
+static bool nr_dfa_get_state(nr_dfa_builder_t *builder, const nr_dfa_position_t *set, size_t count, uint32_t *state_index) {
+    nr_redirect_dfa_t *dfa = builder->dfa;
+
+    if ((dfa->num_states + 1) * 2 > builder->lookup_capacity && !nr_dfa_lookup_grow(builder)) {
+        return false;
+    }
+    uint32_t *slot = nr_dfa_lookup_slot(builder, set, count);
+    if (*slot != NR_DFA_DEAD) {
+        *state_index = *slot;
+        return true;
+    }
+
+    if (dfa->num_states >= NR_REDIRECT_DFA_MAX_STATES) {
+        return false; // Pattern set is too ambiguous to determinize within the limit
+    }
+    if (dfa->num_states >= builder->states_capacity) {
+        size_t new_capacity = builder->states_capacity == 0 ? 16 : builder->states_capacity * 2;
+        nr_dfa_state_t *states = (nr_dfa_state_t*) realloc(dfa->states, new_capacity * sizeof(nr_dfa_state_t));
+        if (states == NULL) {
+            return false;
+        }
+        dfa->states = states;
+        nr_dfa_position_t **positions = (nr_dfa_position_t**) realloc(builder->positions, new_capacity * sizeof(nr_dfa_position_t*));
+        if (positions == NULL) {
+            return false;
+        }
+        builder->positions = positions;
+        size_t *num_positions = (size_t*) realloc(builder->num_positions, new_capacity * sizeof(size_t));
+        if (num_positions == NULL) {
+            return false;
+        }
+        builder->num_positions = num_positions;
+        builder->states_capacity = new_capacity;
+    }
+
+    uint32_t index = (uint32_t) dfa->num_states;
+    nr_dfa_state_t *state = &dfa->states[index];
+    memset(state, 0, sizeof(nr_dfa_state_t));
+    state->other_target = NR_DFA_DEAD;
+    state->empty_target = NR_DFA_DEAD;
+
+    builder->positions[index] = (nr_dfa_position_t*) malloc((count > 0 ? count : 1) * sizeof(nr_dfa_position_t));
+    state->accept_rules = (uint32_t*) malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    if (builder->positions[index] == NULL || state->accept_rules == NULL) {
+        free(builder->positions[index]);
+        free(state->accept_rules);
+        return false;
+    }
+    if (count > 0) {
+        memcpy(builder->positions[index], set, count * sizeof(nr_dfa_position_t));
+    }
+    builder->num_positions[index] = count;
+
+    // Positions are ordered by rule, so the accepting rules come out in file order
+    for (size_t i = 0; i < count; i++) {
+        const nr_route_op_t *op = nr_dfa_position_op(dfa, set[i]);
+        if (op == NULL || op->opcode == NR_ROUTE_OP_END) {
+            state->accept_rules[state->num_accept_rules++] = NR_DFA_POSITION_RULE(set[i]);
+        }
+    }
+
+    dfa->num_states++;
+    *slot = index;
+    *state_index = index;
+    return true;
+}
+
+/**
+ * @brief Advances every position of a set over one segment.
+ *
+ * @param segment The literal segment read, or NULL for a segment no literal in the set expects.
+ * @param non_empty Whether the segment has at least one character (placeholders need one).
+ * @return The number of positions written to next.
+ */
+static size_t nr_dfa_step(const nr_redirect_dfa_t *dfa, const nr_dfa_position_t *set, size_t count,
+                          const char *segment, size_t segment_len, bool non_empty, nr_dfa_position_t *next) {
+    size_t num_next = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t rule = NR_DFA_POSITION_RULE(set[i]);
+        const nr_route_op_t *op = nr_dfa_position_op(dfa, set[i]);
+        if (op == NULL || op->opcode == NR_ROUTE_OP_SPLAT || op->opcode == NR_ROUTE_OP_SUFFIX) {
+            next[num_next++] = NR_DFA_POSITION(rule, NR_DFA_DONE); // Splats take any remaining segments; suffixes are confirmed later
+            continue;
+        }
+        bool advance = false;
+        switch (op->opcode) {
+            case NR_ROUTE_OP_PARAM:
+                advance = non_empty;
+                break;
+            case NR_ROUTE_OP_LITERAL:
+                advance = segment != NULL &&
+                          nr_dfa_segment_compare(segment, segment_len, dfa->rules[rule]->rule.from_route + op->offset, op->len) == 0;
+                break;
+            default: // NR_ROUTE_OP_END, the URL is longer than the pattern
+                break;
+        }
+        if (advance) {
+            next[num_next++] = NR_DFA_POSITION(rule, NR_DFA_POSITION_OP(set[i]) + 1);
+        }
+    }
+    return num_next;
+}
+
+// Steps a set and resolves the resulting set to a state (NR_DFA_DEAD when empty).
+static bool nr_dfa_transition(nr_dfa_builder_t *builder, const nr_dfa_position_t *set, size_t count,
+                              const char *segment, size_t segment_len, bool non_empty,
+                              nr_dfa_position_t *scratch, uint32_t *target) {
+    size_t num_next = nr_dfa_step(builder->dfa, set, count, segment, segment_len, non_empty, scratch);
+    if (num_next == 0) {
+        *target = NR_DFA_DEAD;
+        return true;
+    }
+    return nr_dfa_get_state(builder, scratch, num_next, target);
+}
+
+// Computes all outgoing transitions of a state, creating the states they lead to.
+static bool nr_dfa_expand(nr_dfa_builder_t *builder, uint32_t state_index, nr_dfa_position_t *scratch) {
+    nr_redirect_dfa_t *dfa = builder->dfa;
+    const nr_dfa_position_t *set = builder->positions[state_index];
+    size_t count = builder->num_positions[state_index];
+
+    // One edge per distinct literal segment expected next
+    nr_dfa_edge_t *edges = NULL;
+    size_t num_edges = 0;
+    for (size_t i = 0; i < count; i++) {
+        const nr_route_op_t *op = nr_dfa_position_op(dfa, set[i]);
+        if (op != NULL && op->opcode == NR_ROUTE_OP_LITERAL) {
+            num_edges++;
+        }
+    }
+    if (num_edges > 0) {
+        edges = (nr_dfa_edge_t*) malloc(num_edges * sizeof(nr_dfa_edge_t));
+        if (edges == NULL) {
+            return false;
+        }
+        num_edges = 0;
+        for (size_t i = 0; i < count; i++) {
+            const nr_route_op_t *op = nr_dfa_position_op(dfa, set[i]);
+            if (op != NULL && op->opcode == NR_ROUTE_OP_LITERAL) {
+                edges[num_edges].segment = dfa->rules[NR_DFA_POSITION_RULE(set[i])]->rule.from_route + op->offset;
+                edges[num_edges].len = op->len;
+                edges[num_edges].target = NR_DFA_DEAD;
+                num_edges++;
+            }
+        }
+        qsort(edges, num_edges, sizeof(nr_dfa_edge_t), nr_dfa_edge_compare);
+        size_t unique = 1;
+        for (size_t i = 1; i < num_edges; i++) {
+            if (nr_dfa_edge_compare(&edges[unique - 1], &edges[i]) != 0) {
+                edges[unique++] = edges[i];
+            }
+        }
+        num_edges = unique;
+    }
+    dfa->states[state_index].edges = edges;
+    dfa->states[state_index].num_edges = num_edges;
+
+    // Creating states may move dfa->states, so targets are stored through the index
+    for (size_t i = 0; i < num_edges; i++) {
+        uint32_t target;
+        if (!nr_dfa_transition(builder, set, count, edges[i].segment, edges[i].len, edges[i].len > 0, scratch, &target)) {
+            return false;
+        }
+        edges[i].target = target;
+    }
+    uint32_t other_target;
+    if (!nr_dfa_transition(builder, set, count, NULL, 0, true, scratch, &other_target)) {
+        return false;
+    }
+    dfa->states[state_index].other_target = other_target;
+    uint32_t empty_target;
+    if (!nr_dfa_transition(builder, set, count, NULL, 0, false, scratch, &empty_target)) {
+        return false;
+    }
+    dfa->states[state_index].empty_target = empty_target;
+    return true;
+}
+
+static void nr_dfa_builder_release(nr_dfa_builder_t *builder) {
+    if (builder->positions != NULL) {
+        for (size_t i = 0; i < builder->dfa->num_states; i++) {
+            free(builder->positions[i]);
+        }
+    }
+    free(builder->positions);
+    free(builder->num_positions);
+    free(builder->lookup);
+}
+
+nr_redirect_dfa_t* nr_redirect_dfa_build(const nanorouter_redirect_rule_list_t *list) {
+    if (list == NULL || list->count >= NR_DFA_MAX_RULES) {
+        return NULL;
+    }
+
+    nr_redirect_dfa_t *dfa = (nr_redirect_dfa_t*) calloc(1, sizeof(nr_redirect_dfa_t));
+    if (dfa == NULL) {
+        return NULL;
+    }
+    size_t num_rules = list->count > 0 ? list->count : 1;
+    dfa->rules = (const nanorouter_redirect_rule_t**) malloc(num_rules * sizeof(nanorouter_redirect_rule_t*));
+    nr_dfa_position_t *initial = (nr_dfa_position_t*) malloc(num_rules * sizeof(nr_dfa_position_t));
+    nr_dfa_position_t *scratch = (nr_dfa_position_t*) malloc(num_rules * sizeof(nr_dfa_position_t));
+    nr_dfa_builder_t builder = { .dfa = dfa };
+    bool ok = dfa->rules != NULL && initial != NULL && scratch != NULL;
+
+    if (ok) {
+        size_t num_initial = 0;
+        for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next) {
+            uint32_t index = (uint32_t) dfa->num_rules;
+            dfa->rules[dfa->num_rules++] = current;
+            switch (current->program.ops[0].opcode) {
+                case NR_ROUTE_OP_ANY:
+                    initial[num_initial++] = NR_DFA_POSITION(index, NR_DFA_DONE); // Also matches "/"
+                    break;
+                case NR_ROUTE_OP_FAIL:
+                    break; // Never matches
+                default:
+                    initial[num_initial++] = NR_DFA_POSITION(index, 0);
+                    break;
+            }
+        }
+
+        uint32_t start;
+        ok = nr_dfa_get_state(&builder, initial, num_initial, &start);
+        // States are appended as they are discovered, so this walks the whole automaton
+        for (uint32_t i = 0; ok && i < dfa->num_states; i++) {
+            ok = nr_dfa_expand(&builder, i, scratch);
+        }
+    }
+
+    nr_dfa_builder_release(&builder);
+    free(initial);
+    free(scratch);
+    if (!ok) {
+        nr_redirect_dfa_free(dfa);
+        return NULL;
+    }
+    return dfa;
+}
+
+void nr_redirect_dfa_free(nr_redirect_dfa_t *dfa) {
+    if (dfa == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < dfa->num_states; i++) {
+        free(dfa->states[i].edges);
+        free(dfa->states[i].accept_rules);
+    }
+    free(dfa->states);
+    free(dfa->rules);
+    free(dfa);
+}
+
+size_t nr_redirect_dfa_num_states(const nr_redirect_dfa_t *dfa) {
+    return dfa != NULL ? dfa->num_states : 0;
+}
+
+// Binary search for a literal edge; NULL if the segment has none.
+static const nr_dfa_edge_t* nr_dfa_find_edge(const nr_dfa_state_t *state, const char *segment, size_t segment_len) {
+    size_t low = 0;
+    size_t high = state->num_edges;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const nr_dfa_edge_t *edge = &state->edges[mid];
+        int cmp = nr_dfa_segment_compare(segment, segment_len, edge->segment, edge->len);
+        if (cmp == 0) {
+            return edge;
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_dfa_find(
+    const nr_redirect_dfa_t *dfa,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (dfa == NULL || parsed_url == NULL || confirm == NULL || dfa->num_states == 0) {
+        return NULL;
+    }
+
+    if (parsed_url->too_many_segments) {
+        // Too deep to segment, fall back to trying every rule in order
+        for (size_t i = 0; i < dfa->num_rules; i++) {
+            if (confirm(dfa->rules[i], user_data)) {
+                return dfa->rules[i];
+            }
+        }
+        return NULL;
+    }
+
+    uint32_t current = 0;
+    for (uint8_t i = 0; i < parsed_url->num_segments; i++) {
+        const nr_url_segment_t *segment = &parsed_url->segments[i];
+        const nr_dfa_state_t *state = &dfa->states[current];
+        const nr_dfa_edge_t *edge = nr_dfa_find_edge(state, segment->start, segment->len);
+        if (edge != NULL) {
+            current = edge->target;
+        } else {
+            current = segment->len > 0 ? state->other_target : state->empty_target;
+        }
+        if (current == NR_DFA_DEAD) {
+            return NULL; // No path pattern can match any more
+        }
+    }
+
+    // Every rule listed here matches the path; the first that also passes confirmation wins
+    const nr_dfa_state_t *final_state = &dfa->states[current];
+    for (size_t i = 0; i < final_state->num_accept_rules; i++) {
+        const nanorouter_redirect_rule_t *node = dfa->rules[final_state->accept_rules[i]];
+        if (confirm(node, user_data)) {
+            return node;
+        }
+    }
+    return NULL;
+}
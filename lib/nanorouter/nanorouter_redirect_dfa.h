@@ -0,0 +1,69 @@
+#ifndef NANOROUTER_REDIRECT_DFA_H
+#define NANOROUTER_REDIRECT_DFA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and nr_redirect_confirm_callback_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque deterministic automaton built from every rule's compiled `from_route`.
+ *
+ * The automaton reads a URL one path segment at a time. Each state has one
+ * transition per literal segment any live pattern expects next, plus default
+ * transitions for any other non-empty or empty segment. After the last segment,
+ * the state lists every rule whose path pattern matched, in file order, so a
+ * lookup costs one pass over the URL regardless of the number of rules.
+ */
+typedef struct nr_redirect_dfa_t nr_redirect_dfa_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds the automaton over all rules currently stored in a list.
+ *
+ * States are built by subset construction. The list must outlive the automaton
+ * and must not be modified while it is in use.
+ *
+ * @param list The rule list to compile.
+ * @return A pointer to the automaton, or NULL on allocation failure or if more
+ *         than NR_REDIRECT_DFA_MAX_STATES states would be needed.
+ */
+nr_redirect_dfa_t* nr_redirect_dfa_build(const nanorouter_redirect_rule_list_t *list);
+
+/**
+ * @brief Frees an automaton built with nr_redirect_dfa_build.
+ *
+ * @param dfa The automaton to free. May be NULL.
+ */
+void nr_redirect_dfa_free(nr_redirect_dfa_t *dfa);
+
+/**
+ * @brief Returns the number of states of an automaton.
+ *
+ * @param dfa The automaton.
+ * @return The number of states, 0 for NULL.
+ */
+size_t nr_redirect_dfa_num_states(const nr_redirect_dfa_t *dfa);
+
+/**
+ * @brief Finds the lowest-index rule whose path matches the URL and that passes confirmation.
+ *
+ * @param dfa The automaton to run.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm Callback that performs the full rule check for a candidate.
+ * @param user_data Data passed through to the confirm callback.
+ * @return The winning rule node, or NULL if no rule matches.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_dfa_find(
+    const nr_redirect_dfa_t *dfa,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+#endif // NANOROUTER_REDIRECT_DFA_H
@@ -0,0 +1,324 @@
+#include "nanorouter_redirect_hash.h"
+#include "nanorouter_string_utils.h" // For nr_hash_bytes
+#include <stdlib.h> // For malloc, calloc, realloc, free
+#include <string.h> // For memcmp
+
+// Reference from the index to a rule in the list, with its original position.
+typedef struct {
+    const nanorouter_redirect_rule_t *node;
+    uint32_t index;
+} nr_hash_rule_ref_t;
+
+// One open-addressing slot: a distinct literal path and the rules sharing it.
+typedef struct {
+    const char *key;            // Points into the first rule's from_route (not null-terminated)
+    size_t key_len;
+    uint32_t hash;
+    nr_hash_rule_ref_t *refs;   // Rules with this path, in ascending index order
+    size_t num_refs;
+} nr_hash_slot_t;
+
+struct nr_redirect_hash_t {
+    nr_hash_slot_t *slots;
+    size_t capacity;                    // Power of two
+    nr_hash_rule_ref_t *pattern_rules;  // Rules with placeholders or splats, in file order
+    size_t num_pattern_rules;
+    nr_hash_rule_ref_t *all_rules;      // Every rule, for URLs too deep to segment
+    size_t num_all_rules;
+    const nr_redirect_mph_table_t *mph; // Generated table used instead of slots, if set
+};
+
+/**
+ * @brief Returns the normalized path key of a literal-only route program.
+ *
+ * The key is the pattern's segments joined by '/', without the leading slash,
+ * which is the same form nr_redirect_hash_url_key produces for a request.
+ *
+ * @return true if the program only contains literal segments, false otherwise.
+ */
+static bool nr_redirect_hash_rule_key(const nanorouter_redirect_rule_t *node, const char **key, size_t *key_len) {
+    const nr_route_program_t *program = &node->program;
+    if (program->num_ops == 0 || program->ops[program->num_ops - 1].opcode != NR_ROUTE_OP_END) {
+        return false;
+    }
+    for (uint8_t i = 0; i + 1 < program->num_ops; i++) {
+        if (program->ops[i].opcode != NR_ROUTE_OP_LITERAL) {
+            return false;
+        }
+    }
+
+    if (program->num_ops == 1) {
+        *key = node->rule.from_route;
+        *key_len = 0;
+    } else {
+        const nr_route_op_t *first = &program->ops[0];
+        const nr_route_op_t *last = &program->ops[program->num_ops - 2];
+        *key = node->rule.from_route + first->offset;
+        *key_len = (size_t)(last->offset + last->len - first->offset);
+    }
+    return true;
+}
+
+// Segments are consecutive in the path with a single '/' between them, so the key is a plain span.
+static void nr_redirect_hash_url_key(const nr_parsed_url_t *parsed_url, const char **key, size_t *key_len) {
+    if (parsed_url->num_segments == 0) {
+        *key = parsed_url->path;
+        *key_len = 0;
+        return;
+    }
+    const nr_url_segment_t *first = &parsed_url->segments[0];
+    const nr_url_segment_t *last = &parsed_url->segments[parsed_url->num_segments - 1];
+    *key = first->start;
+    *key_len = (size_t)(last->start + last->len - first->start);
+}
+
+// Linear probing; returns the slot holding the key, or the empty slot where it belongs.
+static nr_hash_slot_t* nr_redirect_hash_probe(const nr_redirect_hash_t *hash, const char *key, size_t key_len, uint32_t key_hash) {
+    size_t mask = hash->capacity - 1;
+    size_t pos = key_hash & mask;
+    while (true) {
+        nr_hash_slot_t *slot = &hash->slots[pos];
+        if (slot->refs == NULL) {
+            return slot;
+        }
+        if (slot->hash == key_hash && slot->key_len == key_len && (key_len == 0 || memcmp(slot->key, key, key_len) == 0)) {
+            return slot;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+static bool nr_redirect_hash_slot_push(nr_hash_slot_t *slot, const nanorouter_redirect_rule_t *node, uint32_t index) {
+    nr_hash_rule_ref_t *refs = (nr_hash_rule_ref_t*) realloc(slot->refs, (slot->num_refs + 1) * sizeof(nr_hash_rule_ref_t));
+    if (refs == NULL) {
+        return false;
+    }
+    refs[slot->num_refs].node = node;
+    refs[slot->num_refs].index = index;
+    slot->refs = refs;
+    slot->num_refs++;
+    return true;
+}
+
+// Allocates an empty index with room for every rule of the list in the rule arrays.
+static nr_redirect_hash_t* nr_redirect_hash_alloc(const nanorouter_redirect_rule_list_t *list, size_t capacity) {
+    nr_redirect_hash_t *hash = (nr_redirect_hash_t*) calloc(1, sizeof(nr_redirect_hash_t));
+    if (hash == NULL) {
+        return NULL;
+    }
+
+    size_t num_rules = list->count > 0 ? list->count : 1;
+    hash->capacity = capacity;
+    hash->slots = capacity > 0 ? (nr_hash_slot_t*) calloc(capacity, sizeof(nr_hash_slot_t)) : NULL;
+    hash->pattern_rules = (nr_hash_rule_ref_t*) malloc(num_rules * sizeof(nr_hash_rule_ref_t));
+    hash->all_rules = (nr_hash_rule_ref_t*) malloc(num_rules * sizeof(nr_hash_rule_ref_t));
+    if ((capacity > 0 && hash->slots == NULL) || hash->pattern_rules == NULL || hash->all_rules == NULL) {
+        nr_redirect_hash_free(hash);
+        return NULL;
+    }
+    return hash;
+}
+
+static void nr_redirect_hash_add_pattern(nr_redirect_hash_t *hash, const nanorouter_redirect_rule_t *node, uint32_t index) {
+    if (node->program.ops[0].opcode == NR_ROUTE_OP_FAIL) {
+        return; // Never matches, nothing to index
+    }
+    hash->pattern_rules[hash->num_pattern_rules].node = node;
+    hash->pattern_rules[hash->num_pattern_rules].index = index;
+    hash->num_pattern_rules++;
+}
+
+nr_redirect_hash_t* nr_redirect_hash_build(const nanorouter_redirect_rule_list_t *list) {
+    if (list == NULL) {
+        return NULL;
+    }
+
+    // Keep the load factor at or below one half
+    size_t capacity = 8;
+    while (capacity < list->count * 2) {
+        capacity *= 2;
+    }
+
+    nr_redirect_hash_t *hash = nr_redirect_hash_alloc(list, capacity);
+    if (hash == NULL) {
+        return NULL;
+    }
+
+    uint32_t index = 0;
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next, index++) {
+        hash->all_rules[hash->num_all_rules].node = current;
+        hash->all_rules[hash->num_all_rules].index = index;
+        hash->num_all_rules++;
+
+        const char *key;
+        size_t key_len;
+        if (nr_redirect_hash_rule_key(current, &key, &key_len)) {
+            uint32_t key_hash = nr_hash_bytes(key, key_len);
+            nr_hash_slot_t *slot = nr_redirect_hash_probe(hash, key, key_len, key_hash);
+            if (slot->refs == NULL) {
+                slot->key = key;
+                slot->key_len = key_len;
+                slot->hash = key_hash;
+            }
+            if (!nr_redirect_hash_slot_push(slot, current, index)) {
+                nr_redirect_hash_free(hash);
+                return NULL;
+            }
+        } else {
+            nr_redirect_hash_add_pattern(hash, current, index);
+        }
+    }
+
+    return hash;
+}
+
+// Checks that a generated table entry lists a given rule index.
+static bool nr_redirect_hash_entry_has_rule(const nr_redirect_mph_table_t *table, const nr_redirect_mph_entry_t *entry, uint32_t index) {
+    for (uint16_t i = 0; i < entry->num_rules; i++) {
+        if (table->rule_indices[entry->first_rule + i] == index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+nr_redirect_hash_t* nr_redirect_hash_build_static(const nanorouter_redirect_rule_list_t *list, const nr_redirect_mph_table_t *table) {
+    if (list == NULL || table == NULL || table->num_rules != list->count) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < table->num_rule_indices; i++) {
+        if (table->rule_indices[i] >= list->count) {
+            return NULL;
+        }
+    }
+
+    nr_redirect_hash_t *hash = nr_redirect_hash_alloc(list, 0);
+    if (hash == NULL) {
+        return NULL;
+    }
+
+    // The table must describe exactly the literal rules of this list
+    size_t num_literals = 0;
+    uint32_t index = 0;
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next, index++) {
+        hash->all_rules[hash->num_all_rules].node = current;
+        hash->all_rules[hash->num_all_rules].index = index;
+        hash->num_all_rules++;
+
+        const char *key;
+        size_t key_len;
+        if (nr_redirect_hash_rule_key(current, &key, &key_len)) {
+            const nr_redirect_mph_entry_t *entry = nr_redirect_mph_lookup(table, key, key_len);
+            if (entry == NULL || !nr_redirect_hash_entry_has_rule(table, entry, index)) {
+                nr_redirect_hash_free(hash);
+                return NULL;
+            }
+            num_literals++;
+        } else {
+            nr_redirect_hash_add_pattern(hash, current, index);
+        }
+    }
+    if (num_literals != table->num_rule_indices) {
+        nr_redirect_hash_free(hash);
+        return NULL;
+    }
+
+    hash->mph = table;
+    return hash;
+}
+
+void nr_redirect_hash_free(nr_redirect_hash_t *hash) {
+    if (hash == NULL) {
+        return;
+    }
+    if (hash->slots != NULL) {
+        for (size_t i = 0; i < hash->capacity; i++) {
+            free(hash->slots[i].refs);
+        }
+    }
+    free(hash->slots);
+    free(hash->pattern_rules);
+    free(hash->all_rules);
+    free(hash);
+}
+
+void nr_redirect_hash_prefetch(const nr_redirect_hash_t *hash, const nr_parsed_url_t *parsed_url) {
+    if (hash == NULL || parsed_url == NULL || parsed_url->too_many_segments) {
+        return;
+    }
+    const char *key;
+    size_t key_len;
+    nr_redirect_hash_url_key(parsed_url, &key, &key_len);
+#if defined(__GNUC__)
+    if (hash->mph != NULL) {
+        // The generated table's entry for the key; its seed is a small array that stays cached across a batch
+        if (hash->mph->num_entries > 0 && hash->mph->num_buckets > 0) {
+            __builtin_prefetch(&hash->mph->entries[nr_redirect_mph_slot(hash->mph, key, key_len)]);
+        }
+    } else {
+        __builtin_prefetch(&hash->slots[nr_hash_bytes(key, key_len) & (hash->capacity - 1)]);
+    }
+#endif
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_hash_find(
+    const nr_redirect_hash_t *hash,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (hash == NULL || parsed_url == NULL || confirm == NULL) {
+        return NULL;
+    }
+
+    if (parsed_url->too_many_segments) {
+        // Too deep to index, fall back to trying every rule in order
+        for (size_t i = 0; i < hash->num_all_rules; i++) {
+            if (confirm(hash->all_rules[i].node, user_data)) {
+                return hash->all_rules[i].node;
+            }
+        }
+        return NULL;
+    }
+
+    const char *key;
+    size_t key_len;
+    nr_redirect_hash_url_key(parsed_url, &key, &key_len);
+
+    // Literal candidates come either from a runtime slot or from a generated table entry
+    const nr_hash_rule_ref_t *literals = NULL;
+    const uint16_t *literal_indices = NULL;
+    size_t num_literals = 0;
+    if (hash->mph != NULL) {
+        const nr_redirect_mph_entry_t *entry = nr_redirect_mph_lookup(hash->mph, key, key_len);
+        if (entry != NULL) {
+            literal_indices = &hash->mph->rule_indices[entry->first_rule];
+            num_literals = entry->num_rules;
+        }
+    } else {
+        const nr_hash_slot_t *slot = nr_redirect_hash_probe(hash, key, key_len, nr_hash_bytes(key, key_len));
+        literals = slot->refs;
+        num_literals = slot->num_refs;
+    }
+
+    // Merge the literal hits with the pattern rules by original index
+    size_t l = 0;
+    size_t p = 0;
+    while (l < num_literals || p < hash->num_pattern_rules) {
+        const nr_hash_rule_ref_t *candidate;
+        uint32_t literal_index = UINT32_MAX;
+        if (l < num_literals) {
+            literal_index = literals != NULL ? literals[l].index : literal_indices[l];
+        }
+        if (p >= hash->num_pattern_rules || literal_index < hash->pattern_rules[p].index) {
+            candidate = literals != NULL ? &literals[l] : &hash->all_rules[literal_index];
+            l++;
+        } else {
+            candidate = &hash->pattern_rules[p++];
+        }
+        if (confirm(candidate->node, user_data)) {
+            return candidate->node;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,90 @@
+#ifndef NANOROUTER_REDIRECT_HASH_H
+#define NANOROUTER_REDIRECT_HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and nr_redirect_confirm_callback_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+#include "nanorouter_redirect_mph.h" // For nr_redirect_mph_table_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque literal-route index built from a redirect rule list.
+ *
+ * Rules whose `from_route` has no placeholder or splat are stored in an
+ * open-addressing hash table keyed by their normalized path. All other rules
+ * are kept in file order and merged with the hash hit by rule index, so
+ * first-match-wins semantics are preserved.
+ */
+typedef struct nr_redirect_hash_t nr_redirect_hash_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds a literal-route hash index over all rules currently stored in a list.
+ *
+ * The index only references the list nodes, so the list must outlive the index
+ * and must not be modified while the index is in use.
+ *
+ * @param list The rule list to index.
+ * @return A pointer to the newly built index, or NULL on allocation failure.
+ */
+nr_redirect_hash_t* nr_redirect_hash_build(const nanorouter_redirect_rule_list_t *list);
+
+/**
+ * @brief Builds the same index on top of a perfect-hash table generated offline.
+ *
+ * Literal routes are looked up in the const table, so only the pattern rules
+ * and the rule-by-index array are allocated. The table is checked against the
+ * list, so one generated from a different _redirects file is rejected.
+ *
+ * @param list The rule list to index, loaded from the same file as the table.
+ * @param table The generated table. Must outlive the index.
+ * @return A pointer to the newly built index, or NULL if the table does not
+ *         match the list or on allocation failure.
+ */
+nr_redirect_hash_t* nr_redirect_hash_build_static(const nanorouter_redirect_rule_list_t *list, const nr_redirect_mph_table_t *table);
+
+/**
+ * @brief Frees an index built with nr_redirect_hash_build or nr_redirect_hash_build_static.
+ *
+ * @param hash The index to free. May be NULL.
+ */
+void nr_redirect_hash_free(nr_redirect_hash_t *hash);
+
+/**
+ * @brief Finds the lowest-index rule that matches the URL and passes confirmation.
+ *
+ * The literal rules for the request path are found with a single hash probe.
+ * Only pattern rules (placeholders or splats) that come before them in the
+ * file are tried in addition.
+ *
+ * @param hash The index to search.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm Callback that performs the full rule check for a candidate.
+ * @param user_data Data passed through to the confirm callback.
+ * @return The winning rule node, or NULL if no rule matches.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_hash_find(
+    const nr_redirect_hash_t *hash,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+/**
+ * @brief Starts loading the slot nr_redirect_hash_find will probe first for a request.
+ *
+ * Lets a batch of requests overlap the cache miss of one lookup with the
+ * matching of another. For an index on a generated table, that is the
+ * table entry the key hashes to.
+ *
+ * @param hash The index that will be searched. May be NULL.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ */
+void nr_redirect_hash_prefetch(const nr_redirect_hash_t *hash, const nr_parsed_url_t *parsed_url);
+
+#endif // NANOROUTER_REDIRECT_HASH_H
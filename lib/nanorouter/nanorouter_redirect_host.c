@@ -0,0 +1,161 @@
+#include "nanorouter_redirect_host.h"
+#include "nanorouter_slot_table.h" // For nr_slot_table_t
+#include "nanorouter_string_utils.h" // For nr_hash_bytes_nocase
+#include <stdlib.h> // For calloc, free
+#include <string.h> // For strncasecmp
+
+struct nr_redirect_host_table_t {
+    nr_slot_table_t table;          // Host name -> nr_redirect_host_rule_t, in file order
+};
+
+bool nr_redirect_route_split_host(const char *route, bool *https, size_t *host_offset, size_t *host_len, size_t *path_offset) {
+    if (route == NULL) {
+        return false;
+    }
+
+    size_t start;
+    bool is_https;
+    if (strncasecmp(route, "https://", 8) == 0) {
+        start = 8;
+        is_https = true;
+    } else if (strncasecmp(route, "http://", 7) == 0) {
+        start = 7;
+        is_https = false;
+    } else {
+        return false;
+    }
+
+    size_t end = start;
+    while (route[end] != '\0' && route[end] != '/' && route[end] != '?') {
+        end++;
+    }
+    if (end == start) {
+        return false; // No host name
+    }
+
+    if (https != NULL) *https = is_https;
+    if (host_offset != NULL) *host_offset = start;
+    if (host_len != NULL) *host_len = end - start;
+    if (path_offset != NULL) *path_offset = end;
+    return true;
+}
+
+/**
+ * @brief Gives the compiled path part of a rule's from_route and the host it names, if any.
+ *
+ * @param node The rule node.
+ * @param buffer Storage for the program of a host rule, whose path is compiled here.
+ * @param program Output: the compiled path pattern (node->program for path rules).
+ * @param host Output: the host name inside from_route, NULL for path rules.
+ * @param host_len Output: length of the host name, 0 for path rules.
+ * @return The path pattern the program was compiled from.
+ */
+const char* nr_redirect_rule_path_program(
+    const nanorouter_redirect_rule_t *node,
+    nr_route_program_t *buffer,
+    const nr_route_program_t **program,
+    const char **host,
+    size_t *host_len
+) {
+    const char *from_route = node->rule.from_route;
+    size_t host_offset;
+    size_t path_offset;
+    if (!nr_redirect_route_split_host(from_route, NULL, &host_offset, host_len, &path_offset)) {
+        *program = &node->program;
+        *host = NULL;
+        *host_len = 0;
+        return from_route;
+    }
+    const char *path_pattern = from_route[path_offset] == '/' ? from_route + path_offset : "/";
+    nr_compile_route_pattern(path_pattern, buffer);
+    *program = buffer;
+    *host = from_route + host_offset;
+    return path_pattern;
+}
+
+nr_redirect_host_table_t* nr_redirect_host_table_create(void) {
+    nr_redirect_host_table_t *table = (nr_redirect_host_table_t*) calloc(1, sizeof(nr_redirect_host_table_t));
+    if (table == NULL) {
+        return NULL;
+    }
+    if (!nr_slot_table_init(&table->table, NR_SLOT_KEYS_NOCASE, sizeof(nr_redirect_host_rule_t))) {
+        free(table);
+        return NULL;
+    }
+    return table;
+}
+
+bool nr_redirect_host_table_add(nr_redirect_host_table_t *table, const nanorouter_redirect_rule_t *node) {
+    if (table == NULL || node == NULL) {
+        return false;
+    }
+
+    const char *from_route = node->rule.from_route;
+    bool https;
+    size_t host_offset;
+    size_t host_len;
+    size_t path_offset;
+    if (!nr_redirect_route_split_host(from_route, &https, &host_offset, &host_len, &path_offset)) {
+        return false;
+    }
+
+    const char *host = from_route + host_offset;
+    nr_redirect_host_rule_t *host_rule = (nr_redirect_host_rule_t*) nr_slot_table_append(
+        &table->table, host, host_len, nr_hash_bytes_nocase(host, host_len));
+    if (host_rule == NULL) {
+        return false;
+    }
+    host_rule->node = node;
+    host_rule->https = https;
+    // "http://example.com" on its own stands for the root path
+    host_rule->path_pattern = from_route[path_offset] == '/' ? from_route + path_offset : "/";
+    nr_compile_route_pattern(host_rule->path_pattern, &host_rule->program);
+    // A blanket redirect such as "http://example.com/* https://example.com/:splat 301!" is decided by the host alone
+    host_rule->canonical = host_rule->program.num_ops == 1 && host_rule->program.ops[0].opcode == NR_ROUTE_OP_ANY &&
+                           node->rule.num_query_params == 0 && node->rule.num_conditions == 0 &&
+                           node->rule.status_code >= 300 && node->rule.status_code < 400;
+    return true;
+}
+
+bool nr_redirect_host_table_remove_last(nr_redirect_host_table_t *table, const nanorouter_redirect_rule_t *node) {
+    size_t host_offset;
+    size_t host_len;
+    if (table == NULL || node == NULL ||
+        !nr_redirect_route_split_host(node->rule.from_route, NULL, &host_offset, &host_len, NULL)) {
+        return false;
+    }
+
+    const char *host = node->rule.from_route + host_offset;
+    return nr_slot_table_remove_last(&table->table, host, host_len, nr_hash_bytes_nocase(host, host_len), node);
+}
+
+void nr_redirect_host_table_free(nr_redirect_host_table_t *table) {
+    if (table == NULL) {
+        return;
+    }
+    nr_slot_table_free(&table->table);
+    free(table);
+}
+
+const nr_redirect_host_rule_t* nr_redirect_host_table_lookup(
+    const nr_redirect_host_table_t *table,
+    const char *host,
+    size_t host_len,
+    size_t *num_rules
+) {
+    if (num_rules != NULL) {
+        *num_rules = 0;
+    }
+    if (table == NULL || host == NULL || host_len == 0) {
+        return NULL;
+    }
+
+    const nr_slot_t *slot = nr_slot_table_find(&table->table, host, host_len, nr_hash_bytes_nocase(host, host_len));
+    if (slot == NULL) {
+        return NULL;
+    }
+    if (num_rules != NULL) {
+        *num_rules = slot->num_values;
+    }
+    return (const nr_redirect_host_rule_t*) slot->values;
+}
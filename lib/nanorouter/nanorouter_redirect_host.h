@@ -0,0 +1,117 @@
+#ifndef NANOROUTER_REDIRECT_HOST_H
+#define NANOROUTER_REDIRECT_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_t
+#include "nanorouter_route_matcher.h" // For nr_route_program_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief A rule whose from_route names a scheme and host, with its path compiled on its own.
+ */
+typedef struct {
+    const nanorouter_redirect_rule_t *node;     /**< The rule node in the list; first, as nr_slot_table_t needs. */
+    bool https;                                 /**< true for "https://" rules, false for "http://". */
+    const char *path_pattern;                   /**< The path part of from_route ("/" if it has none). */
+    nr_route_program_t program;                 /**< path_pattern, compiled. */
+    bool canonical;                             /**< Redirects every path of the host, with no query parameter or condition to check (http to https, www to apex). */
+} nr_redirect_host_rule_t;
+
+/**
+ * @brief Opaque table of per-host rule lists, keyed by host name.
+ *
+ * Host names are hashed and compared case-insensitively. Each host keeps its
+ * rules in file order. Built on nr_slot_table_t.
+ */
+typedef struct nr_redirect_host_table_t nr_redirect_host_table_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Splits an absolute route such as "http://blog.example.com/path" into scheme, host and path.
+ *
+ * @param route The route or URL to split.
+ * @param https Output: true if the scheme is "https". May be NULL.
+ * @param host_offset Output: offset of the host name inside route. May be NULL.
+ * @param host_len Output: length of the host name. May be NULL.
+ * @param path_offset Output: offset of the path (its '/' or the end of route). May be NULL.
+ * @return true if route starts with "http://" or "https://" followed by a host name, false otherwise.
+ */
+bool nr_redirect_route_split_host(const char *route, bool *https, size_t *host_offset, size_t *host_len, size_t *path_offset);
+
+/**
+ * @brief Gives the compiled path part of a rule's from_route and the host it names, if any.
+ *
+ * @param node The rule node.
+ * @param buffer Storage for the program of a host rule, whose path is compiled here.
+ * @param program Output: the compiled path pattern (node->program for path rules).
+ * @param host Output: the host name inside from_route, NULL for path rules.
+ * @param host_len Output: length of the host name, 0 for path rules.
+ * @return The path pattern the program was compiled from.
+ */
+const char* nr_redirect_rule_path_program(
+    const nanorouter_redirect_rule_t *node,
+    nr_route_program_t *buffer,
+    const nr_route_program_t **program,
+    const char **host,
+    size_t *host_len
+);
+
+/**
+ * @brief Creates an empty host table.
+ *
+ * @return A pointer to the new table, or NULL on allocation failure.
+ */
+nr_redirect_host_table_t* nr_redirect_host_table_create(void);
+
+/**
+ * @brief Files a rule under the host named by its from_route.
+ *
+ * Rules must be added in list order. The table only references the node, so
+ * the node must outlive the table.
+ *
+ * @param table The host table.
+ * @param node The rule node; its from_route must pass nr_redirect_route_split_host.
+ * @return true if the rule was added, false on allocation failure or if from_route names no host.
+ */
+bool nr_redirect_host_table_add(nr_redirect_host_table_t *table, const nanorouter_redirect_rule_t *node);
+
+/**
+ * @brief Takes back the rule most recently filed with nr_redirect_host_table_add.
+ *
+ * See nr_slot_table_remove_last.
+ *
+ * @param table The host table.
+ * @param node The rule node last added.
+ * @return true if the rule was removed, false if it is not the last rule filed under its host.
+ */
+bool nr_redirect_host_table_remove_last(nr_redirect_host_table_t *table, const nanorouter_redirect_rule_t *node);
+
+/**
+ * @brief Frees a host table created with nr_redirect_host_table_create.
+ *
+ * @param table The table to free. May be NULL.
+ */
+void nr_redirect_host_table_free(nr_redirect_host_table_t *table);
+
+/**
+ * @brief Returns the rules written for one host, with a single hash probe.
+ *
+ * @param table The host table.
+ * @param host The request's host name (not necessarily null-terminated).
+ * @param host_len Length of host.
+ * @param num_rules Output: number of rules returned.
+ * @return The host's rules in file order, or NULL if no rule names this host.
+ */
+const nr_redirect_host_rule_t* nr_redirect_host_table_lookup(
+    const nr_redirect_host_table_t *table,
+    const char *host,
+    size_t host_len,
+    size_t *num_rules
+);
+
+#endif // NANOROUTER_REDIRECT_HOST_H
@@ -1,12 +1,22 @@
 #include "nanorouter_redirect_middleware.h"
 #include "nanorouter_redirect_rule_parser.h" // For redirect_rule_t
-#include "nanorouter_condition_matching.h" // For nanorouter_request_context_t and nanorouter_match_conditions
+#include "nanorouter_condition_matching.h" // For nanorouter_request_context_t and nr_match_conditions_cached
 #include <stdlib.h> // For malloc, free
-#include <string.h> // For strncpy, strlen, strncat
+#include <string.h> // For strncpy, strlen, memchr
 #include <stdio.h>  // For snprintf
 
-#include "nanorouter_route_matcher.h" // For nanorouter_match_rule and nr_matched_params_t
+#include "nanorouter_route_matcher.h" // For nr_match_compiled_pattern and nr_capture_spans_t
 #include "nanorouter_string_utils.h" // For string utility functions
+#include "nanorouter_redirect_trie.h" // For nr_redirect_trie_build and nr_redirect_trie_find
+#include "nanorouter_redirect_hash.h" // For nr_redirect_hash_build and nr_redirect_hash_find
+#include "nanorouter_redirect_dfa.h" // For nr_redirect_dfa_build and nr_redirect_dfa_find
+#include "nanorouter_redirect_bitset.h" // For nr_redirect_bitset_build and nr_redirect_bitset_find
+#include "nanorouter_redirect_prefilter.h" // For nr_redirect_prefilter_build and nr_redirect_prefilter_find
+#include "nanorouter_redirect_host.h" // For nr_redirect_host_table_add, nr_redirect_host_table_remove_last, nr_redirect_host_table_lookup and nr_redirect_rule_path_program
+#include "nanorouter_redirect_not_found.h" // For nr_redirect_not_found_map_add, nr_redirect_not_found_map_remove_last and nr_redirect_not_found_map_find
+#include "nanorouter_extension_index.h" // For nr_extension_index_add and nr_extension_index_lookup
+#include "nanorouter_redirect_chain.h" // For nr_redirect_chains_resolve, nr_redirect_chains_collapse and nr_redirect_chain_t
+#include "nanorouter_decision_cache.h" // For nr_decision_cache_next_generation and the cached request
 
 /**
  * @brief Creates and initializes an empty nanorouter_redirect_rule_list_t.
@@ -20,14 +30,63 @@ nanorouter_redirect_rule_list_t* nanorouter_redirect_rule_list_create() {
     }
     list->head = NULL;
     list->count = 0;
+    list->engine = NR_REDIRECT_ENGINE_LINEAR;
+    list->trie = NULL;
+    list->hash = NULL;
+    list->dfa = NULL;
+    list->bitset = NULL;
+    list->prefilter = NULL;
+    list->hosts = NULL;
+    list->first_path_index = UINT32_MAX;
+    list->not_found = NULL;
+    list->extensions = NULL;
+    list->forced_rules = NULL;
+    list->num_forced_rules = 0;
+    list->order = NR_REDIRECT_ORDER_FILE;
+    list->case_insensitive = false;
+    list->generation = nr_decision_cache_next_generation();
     return list;
 }
 
+/**
+ * @brief Releases any lookup index and returns the list to the linear engine.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ */
+static void nr_redirect_rule_list_drop_index(nanorouter_redirect_rule_list_t *list) {
+    nr_redirect_trie_free(list->trie);
+    list->trie = NULL;
+    nr_redirect_hash_free(list->hash);
+    list->hash = NULL;
+    nr_redirect_dfa_free(list->dfa);
+    list->dfa = NULL;
+    nr_redirect_bitset_free(list->bitset);
+    list->bitset = NULL;
+    nr_redirect_prefilter_free(list->prefilter);
+    list->prefilter = NULL;
+    list->engine = NR_REDIRECT_ENGINE_LINEAR;
+}
+
+// Takes a node that could not be added back out of the lookup tables it was already filed in, so it can be freed.
+// Those tables are filled in the order host, not-found, extension, and the node is the last one filed in each.
+static void nr_redirect_rule_list_unfile(nanorouter_redirect_rule_list_t *list, const nanorouter_redirect_rule_t *node,
+                                         bool in_hosts, bool in_not_found) {
+    if (in_hosts) {
+        nr_redirect_host_table_remove_last(list->hosts, node);
+    }
+    if (in_not_found) {
+        nr_redirect_not_found_map_remove_last(list->not_found, node);
+    }
+}
+
 /**
  * @brief Adds a new redirect_rule_t to the linked list.
  *
  * This function allocates a nanorouter_redirect_rule_t node, copies the rule_data into it,
- * and adds it to the end of the list.
+ * compiles its from_route pattern and adds it to the end of the list. Rules whose
+ * from_route starts with a scheme and host are also filed in the list's host table,
+ * 404 rules scoped to a path prefix in its not-found map, and path rules ending
+ * in a file suffix in its extension index.
  *
  * @param list A pointer to the nanorouter_redirect_rule_list_t.
  * @param rule_data A pointer to the redirect_rule_t data to be added.
@@ -43,10 +102,89 @@ bool nanorouter_redirect_rule_list_add_rule(nanorouter_redirect_rule_list_t *lis
         return false;
     }
 
+    // New rules are appended in file order
+    if (list->order != NR_REDIRECT_ORDER_FILE && !nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_FILE, NULL, NULL)) {
+        free(new_node);
+        return false;
+    }
+
+    // Any index or rewrite chain built so far no longer covers the whole list
+    nr_redirect_rule_list_drop_index(list);
+    nr_redirect_chains_drop(list);
+
     // Copy the rule data
     new_node->rule = *rule_data; // Direct copy since redirect_rule_t contains fixed-size arrays
+    if (list->case_insensitive) {
+        // Folded once here, so requests only fold their own path
+        nr_fold_route_pattern(new_node->rule.from_route);
+    }
+    nr_compile_route_pattern(new_node->rule.from_route, &new_node->program);
+    if (!nr_compile_route_template(new_node->rule.to_route, new_node->rule.from_route, &new_node->program,
+                                   new_node->rule.query_params, new_node->rule.num_query_params, &new_node->to_template)) {
+        free(new_node);
+        return false; // to_route has more than NR_MAX_TEMPLATE_PARTS parts
+    }
+    new_node->query_key_mask = nr_query_params_key_mask(new_node->rule.query_params, new_node->rule.num_query_params);
+    new_node->chain = NULL;
+    new_node->index = (uint32_t)list->count;
+    new_node->file_index = new_node->index;
     new_node->next = NULL;
 
+    // Forced rules are also kept apart for nanorouter_process_redirect_request_forced
+    if (new_node->rule.force) {
+        nanorouter_redirect_rule_t **forced_rules = (nanorouter_redirect_rule_t**) realloc(
+            list->forced_rules, (list->num_forced_rules + 1) * sizeof(nanorouter_redirect_rule_t*));
+        if (forced_rules == NULL) {
+            free(new_node);
+            return false;
+        }
+        list->forced_rules = forced_rules;
+    }
+
+    // Rules for a specific host ("https://blog.example.com/*") are also filed under that host
+    bool names_host = nr_redirect_route_split_host(new_node->rule.from_route, NULL, NULL, NULL, NULL);
+    if (names_host) {
+        if (list->hosts == NULL) {
+            list->hosts = nr_redirect_host_table_create();
+        }
+        if (list->hosts == NULL || !nr_redirect_host_table_add(list->hosts, new_node)) {
+            free(new_node);
+            return false;
+        }
+    }
+
+    // 404 rules scoped to a path prefix ("/en/*") are looked up by that prefix instead of in turn
+    new_node->not_found_prefix = nr_redirect_rule_is_not_found_prefix(new_node);
+    if (new_node->not_found_prefix) {
+        if (list->not_found == NULL) {
+            list->not_found = nr_redirect_not_found_map_create();
+        }
+        if (list->not_found == NULL || !nr_redirect_not_found_map_add(list->not_found, new_node)) {
+            nr_redirect_rule_list_unfile(list, new_node, names_host, false);
+            free(new_node);
+            return false;
+        }
+    }
+
+    // Path rules ending in a file suffix ("/assets/*.js") are looked up by the request's extension
+    size_t extension_len = 0;
+    const char *extension = names_host ? NULL : nr_route_program_extension(&new_node->program, new_node->rule.from_route, &extension_len);
+    new_node->by_extension = extension != NULL;
+    if (new_node->by_extension) {
+        if (list->extensions == NULL) {
+            list->extensions = nr_extension_index_create();
+        }
+        if (list->extensions == NULL || !nr_extension_index_add(list->extensions, extension, extension_len, new_node)) {
+            nr_redirect_rule_list_unfile(list, new_node, names_host, new_node->not_found_prefix);
+            free(new_node);
+            return false;
+        }
+    }
+
+    if (new_node->rule.force) {
+        list->forced_rules[list->num_forced_rules++] = new_node;
+    }
+
     if (list->head == NULL) {
         list->head = new_node;
     } else {
@@ -57,7 +195,11 @@ bool nanorouter_redirect_rule_list_add_rule(nanorouter_redirect_rule_list_t *lis
         current->next = new_node;
     }
 
+    if (!names_host && list->first_path_index == UINT32_MAX) {
+        list->first_path_index = new_node->index;
+    }
     list->count++;
+    list->generation = nr_decision_cache_next_generation();
     return true;
 }
 
@@ -75,205 +217,1439 @@ void nanorouter_redirect_rule_list_free(nanorouter_redirect_rule_list_t *list) {
     while (current != NULL) {
         nanorouter_redirect_rule_t *next = current->next;
         // No need to free individual members of current->rule as they are fixed-size arrays
+        free(current->chain);
         free(current);
         current = next;
     }
+    nr_redirect_rule_list_drop_index(list);
+    nr_redirect_host_table_free(list->hosts);
+    nr_redirect_not_found_map_free(list->not_found);
+    nr_extension_index_free(list->extensions);
+    free(list->forced_rules);
     free(list);
 }
 
 /**
- * @brief Safely appends a source string to a destination buffer, respecting buffer size.
+ * @brief Builds the lookup index for the selected engine once all rules are loaded.
  *
- * @param dest The destination buffer.
- * @param dest_size The total size of the destination buffer.
- * @param src The source string to append.
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param engine The engine to use for nanorouter_process_redirect_request.
+ * @return true if the index was built, false otherwise (the list stays on the linear engine).
  */
-static void nr_append_string_to_buffer(char *dest, size_t dest_size, const char *src) {
-    size_t dest_len = strlen(dest);
-    size_t src_len = strlen(src);
-    size_t copy_len = (dest_len + src_len < dest_size) ? src_len : (dest_size - dest_len - 1);
-    strncat(dest, src, copy_len);
-    dest[dest_size - 1] = '\0'; // Ensure null-termination
+bool nanorouter_redirect_rule_list_compile(nanorouter_redirect_rule_list_t *list, nanorouter_redirect_engine_t engine) {
+    if (list == NULL) {
+        return false;
+    }
+
+    nr_redirect_rule_list_drop_index(list);
+
+    switch (engine) {
+        case NR_REDIRECT_ENGINE_LINEAR:
+            return true;
+        case NR_REDIRECT_ENGINE_TRIE:
+            list->trie = nr_redirect_trie_build(list);
+            if (list->trie == NULL) {
+                return false;
+            }
+            break;
+        case NR_REDIRECT_ENGINE_HASH:
+            list->hash = nr_redirect_hash_build(list);
+            if (list->hash == NULL) {
+                return false;
+            }
+            break;
+        case NR_REDIRECT_ENGINE_DFA:
+            list->dfa = nr_redirect_dfa_build(list);
+            if (list->dfa == NULL) {
+                return false;
+            }
+            break;
+        case NR_REDIRECT_ENGINE_BITSET:
+            list->bitset = nr_redirect_bitset_build(list);
+            if (list->bitset == NULL) {
+                return false;
+            }
+            break;
+        case NR_REDIRECT_ENGINE_PREFILTER:
+            list->prefilter = nr_redirect_prefilter_build(list);
+            if (list->prefilter == NULL) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    list->engine = engine;
+    return true;
 }
 
 /**
- * @brief Extracts the query string part from a full URL.
+ * @brief Selects NR_REDIRECT_ENGINE_STATIC_HASH using a table generated by scripts/generate_redirect_mph.py.
  *
- * @param url The full URL string.
- * @param buffer The buffer to store the extracted query string.
- * @param buffer_size The size of the buffer.
- * @return A pointer to the buffer if a query string is found, otherwise NULL.
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param table The generated table. Must outlive the list or the next compile.
+ * @return true if the index was built, false otherwise (the list stays on the linear engine).
  */
-static char* nr_extract_query_string(const char *url, char *buffer, size_t buffer_size) {
-    const char *query_start = strchr(url, '?');
-    if (query_start != NULL) {
-        strncpy(buffer, query_start + 1, buffer_size - 1);
-        buffer[buffer_size - 1] = '\0';
-        return buffer;
+bool nanorouter_redirect_rule_list_compile_static(nanorouter_redirect_rule_list_t *list, const nr_redirect_mph_table_t *table) {
+    if (list == NULL || table == NULL) {
+        return false;
     }
-    return NULL;
+
+    nr_redirect_rule_list_drop_index(list);
+
+    list->hash = nr_redirect_hash_build_static(list, table);
+    if (list->hash == NULL) {
+        return false;
+    }
+    list->engine = NR_REDIRECT_ENGINE_STATIC_HASH;
+    return true;
 }
 
-// --- Middleware Function Implementation ---
+/**
+ * @brief Makes path matching for a list case-insensitive or case-sensitive.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param case_insensitive true to ignore the casing of from_route literals and request paths.
+ * @return true if the mode was set, false if list is NULL or already holds rules loaded in the other mode.
+ */
+bool nanorouter_redirect_rule_list_set_case_insensitive(nanorouter_redirect_rule_list_t *list, bool case_insensitive) {
+    if (list == NULL) {
+        return false;
+    }
+    if (list->count > 0 && list->case_insensitive != case_insensitive) {
+        return false; // Rules are folded as they are added
+    }
+    list->case_insensitive = case_insensitive;
+    return true;
+}
+
+// qsort comparator for file order
+static int nr_redirect_compare_file_order(const void *a, const void *b) {
+    const nanorouter_redirect_rule_t *node_a = *(const nanorouter_redirect_rule_t *const *)a;
+    const nanorouter_redirect_rule_t *node_b = *(const nanorouter_redirect_rule_t *const *)b;
+    return node_a->file_index < node_b->file_index ? -1 : (node_a->file_index > node_b->file_index ? 1 : 0);
+}
+
+// qsort comparator for specificity order; see nanorouter_redirect_rule_list_set_order
+static int nr_redirect_compare_specificity(const void *a, const void *b) {
+    const nanorouter_redirect_rule_t *node_a = *(const nanorouter_redirect_rule_t *const *)a;
+    const nanorouter_redirect_rule_t *node_b = *(const nanorouter_redirect_rule_t *const *)b;
+
+    nr_route_program_t buffer_a;
+    nr_route_program_t buffer_b;
+    const nr_route_program_t *program_a;
+    const nr_route_program_t *program_b;
+    const char *host_a;
+    const char *host_b;
+    size_t host_len_a;
+    size_t host_len_b;
+    nr_redirect_rule_path_program(node_a, &buffer_a, &program_a, &host_a, &host_len_a);
+    nr_redirect_rule_path_program(node_b, &buffer_b, &program_b, &host_b, &host_len_b);
+
+    // A rule written for one host is more specific than one for every host
+    if ((host_a != NULL) != (host_b != NULL)) {
+        return host_a != NULL ? -1 : 1;
+    }
+    int cmp = nr_route_program_compare_specificity(program_a, program_b);
+    if (cmp != 0) {
+        return cmp;
+    }
+    int constraints_a = node_a->rule.num_query_params + node_a->rule.num_conditions;
+    int constraints_b = node_b->rule.num_query_params + node_b->rule.num_conditions;
+    if (constraints_a != constraints_b) {
+        return constraints_b - constraints_a;
+    }
+    return nr_redirect_compare_file_order(a, b);
+}
 
 /**
- * @brief Processes an incoming request URL against a list of redirect rules.
+ * @brief Checks whether two rules can match the same request, judging by host and path.
  *
- * If a matching rule is found, the response_context will be populated with the
- * new URL and status code.
+ * Query parameters and conditions are not looked at, so the answer errs on the side of true.
+ */
+static bool nr_redirect_rules_overlap(const nanorouter_redirect_rule_t *a, const nanorouter_redirect_rule_t *b) {
+    nr_route_program_t buffer_a;
+    nr_route_program_t buffer_b;
+    const nr_route_program_t *program_a;
+    const nr_route_program_t *program_b;
+    const char *host_a;
+    const char *host_b;
+    size_t host_len_a;
+    size_t host_len_b;
+    const char *path_a = nr_redirect_rule_path_program(a, &buffer_a, &program_a, &host_a, &host_len_a);
+    const char *path_b = nr_redirect_rule_path_program(b, &buffer_b, &program_b, &host_b, &host_len_b);
+
+    if (host_a != NULL && host_b != NULL && (host_len_a != host_len_b || strncasecmp(host_a, host_b, host_len_a) != 0)) {
+        return false; // Different hosts
+    }
+    return nr_route_programs_overlap(program_a, path_a, program_b, path_b);
+}
+
+/**
+ * @brief Puts the list in file order or in specificity order.
  *
- * @param request_url The incoming URL string.
- * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
- * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
- * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param order The order to use.
+ * @param warn Called for every pair of rules whose winner the new order changes. May be NULL.
+ * @param user_data Data passed through to warn.
+ * @return true if the list was reordered, false otherwise (the list is unchanged).
  */
-bool nanorouter_process_redirect_request(
-    const char *request_url,
-    nanorouter_redirect_rule_list_t *rules,
-    nanorouter_redirect_response_t *response_context,
-    const nanorouter_request_context_t *request_context
+bool nanorouter_redirect_rule_list_set_order(
+    nanorouter_redirect_rule_list_t *list,
+    nanorouter_redirect_order_t order,
+    nr_redirect_order_warning_callback_t warn,
+    void *user_data
 ) {
-    // Initialize response_context to indicate no redirect by default
-    if (response_context != NULL) {
-        response_context->new_url[0] = '\0';
-        response_context->status_code = 0;
+    if (list == NULL || (order != NR_REDIRECT_ORDER_FILE && order != NR_REDIRECT_ORDER_SPECIFICITY)) {
+        return false;
+    }
+    if (list->count == 0) {
+        list->order = order;
+        return true;
     }
 
-    if (request_url == NULL || rules == NULL || response_context == NULL) {
+    nanorouter_redirect_rule_t **nodes = (nanorouter_redirect_rule_t**) malloc(list->count * sizeof(nanorouter_redirect_rule_t*));
+    if (nodes == NULL) {
         return false;
     }
+    size_t num_nodes = 0;
+    for (nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next) {
+        nodes[num_nodes++] = current;
+    }
+    qsort(nodes, num_nodes, sizeof(nanorouter_redirect_rule_t*),
+          order == NR_REDIRECT_ORDER_SPECIFICITY ? nr_redirect_compare_specificity : nr_redirect_compare_file_order);
 
-    nanorouter_redirect_rule_t *current_rule_node = rules->head;
-    while (current_rule_node != NULL) {
-        nr_matched_params_t matched_params;
-        matched_params.num_params = 0; // Initialize matched_params
-
-        // First, match the path and query parameters
-        if (nanorouter_match_rule(&current_rule_node->rule, request_url, &matched_params)) {
-            // If path and query match, then check conditions
-            if (nanorouter_match_conditions(
-                    current_rule_node->rule.conditions,
-                    current_rule_node->rule.num_conditions,
-                    request_context
-                )) {
-                // Both path/query and conditions match, apply the rule
-                response_context->status_code = current_rule_node->rule.status_code;
-
-                // Construct new_url from to_route and matched_params
-                const char *to_route_ptr = current_rule_node->rule.to_route;
-                char temp_new_url[NR_REDIRECT_MAX_URL_LEN + 1] = {0};
-                size_t current_len = 0;
-
-                while (*to_route_ptr != '\0' && current_len < NR_REDIRECT_MAX_URL_LEN) {
-                    if (*to_route_ptr == ':' || *to_route_ptr == '*') {
-                        // Found a placeholder or splat
-                        const char *placeholder_or_splat_indicator = to_route_ptr; // Store ':' or '*'
-                        const char *param_name_start_in_to_route = to_route_ptr + 1; // Start of actual name (e.g., "id" from ":id")
-
-                        const char *param_name_end_in_to_route = param_name_start_in_to_route;
-                        while (*param_name_end_in_to_route != '\0' && *param_name_end_in_to_route != '/' && *param_name_end_in_to_route != '?') {
-                            param_name_end_in_to_route++;
-                        }
-                        size_t param_name_len = param_name_end_in_to_route - param_name_start_in_to_route;
-
-                        char search_key[NR_MAX_MATCHED_KEY_LEN + 1];
-                        if (*placeholder_or_splat_indicator == '*') {
-                            strncpy(search_key, "*", NR_MAX_MATCHED_KEY_LEN); // Use "*" as key for splats
-                            search_key[NR_MAX_MATCHED_KEY_LEN] = '\0';
-                        } else { // It's a ':' placeholder
-                            // Check if the placeholder name is "splat"
-                            if (param_name_len == strlen("splat") && strncmp(param_name_start_in_to_route, "splat", param_name_len) == 0) {
-                                strncpy(search_key, "*", NR_MAX_MATCHED_KEY_LEN); // Map :splat to * for lookup
-                                search_key[NR_MAX_MATCHED_KEY_LEN] = '\0';
-                            } else {
-                                strncpy(search_key, param_name_start_in_to_route, param_name_len);
-                                search_key[param_name_len] = '\0';
-                            }
-                        }
-
-                        // Search for the matched parameter
-                        bool found_param = false;
-                        for (uint8_t i = 0; i < matched_params.num_params; i++) {
-                            if (strcmp(matched_params.params[i].key, search_key) == 0) {
-                                nr_append_string_to_buffer(temp_new_url, NR_REDIRECT_MAX_URL_LEN + 1, matched_params.params[i].value);
-                                current_len = strlen(temp_new_url);
-                                found_param = true;
-                                break;
-                            }
-                        }
-                        if (!found_param) {
-                            // If param not found in matched_params, append the original placeholder/splat indicator and name
-                            nr_append_string_to_buffer(temp_new_url, NR_REDIRECT_MAX_URL_LEN + 1, placeholder_or_splat_indicator);
-                            nr_append_string_to_buffer(temp_new_url, NR_REDIRECT_MAX_URL_LEN + 1, param_name_start_in_to_route);
-                            current_len = strlen(temp_new_url);
-                        }
-                        to_route_ptr = param_name_end_in_to_route;
-                    } else {
-                        // Append literal character
-                        temp_new_url[current_len++] = *to_route_ptr++;
-                        temp_new_url[current_len] = '\0';
-                    }
-                }
+    // Host rules are kept per host in list order, so the table is refiled in the new order
+    nr_redirect_host_table_t *hosts = NULL;
+    if (list->hosts != NULL) {
+        hosts = nr_redirect_host_table_create();
+        for (size_t i = 0; hosts != NULL && i < num_nodes; i++) {
+            if (nr_redirect_route_split_host(nodes[i]->rule.from_route, NULL, NULL, NULL, NULL) &&
+                !nr_redirect_host_table_add(hosts, nodes[i])) {
+                nr_redirect_host_table_free(hosts);
+                hosts = NULL;
+            }
+        }
+        if (hosts == NULL) {
+            free(nodes);
+            return false;
+        }
+    }
+
+    // So is the not-found map, per prefix
+    nr_redirect_not_found_map_t *not_found = NULL;
+    if (list->not_found != NULL) {
+        not_found = nr_redirect_not_found_map_create();
+        for (size_t i = 0; not_found != NULL && i < num_nodes; i++) {
+            if (nodes[i]->not_found_prefix && !nr_redirect_not_found_map_add(not_found, nodes[i])) {
+                nr_redirect_not_found_map_free(not_found);
+                not_found = NULL;
+            }
+        }
+        if (not_found == NULL) {
+            nr_redirect_host_table_free(hosts);
+            free(nodes);
+            return false;
+        }
+    }
+
+    // And the extension index, per extension
+    nr_extension_index_t *extensions = NULL;
+    if (list->extensions != NULL) {
+        extensions = nr_extension_index_create();
+        for (size_t i = 0; extensions != NULL && i < num_nodes; i++) {
+            size_t extension_len = 0;
+            const char *extension = nodes[i]->by_extension ?
+                nr_route_program_extension(&nodes[i]->program, nodes[i]->rule.from_route, &extension_len) : NULL;
+            if (extension != NULL && !nr_extension_index_add(extensions, extension, extension_len, nodes[i])) {
+                nr_extension_index_free(extensions);
+                extensions = NULL;
+            }
+        }
+        if (extensions == NULL) {
+            nr_redirect_not_found_map_free(not_found);
+            nr_redirect_host_table_free(hosts);
+            free(nodes);
+            return false;
+        }
+    }
+
+    nr_redirect_rule_list_drop_index(list);
+    nr_redirect_chains_drop(list); // Chains follow the list order
+    nr_redirect_host_table_free(list->hosts);
+    list->hosts = hosts;
+    nr_redirect_not_found_map_free(list->not_found);
+    list->not_found = not_found;
+    nr_extension_index_free(list->extensions);
+    list->extensions = extensions;
+
+    size_t num_forced = 0;
+    list->first_path_index = UINT32_MAX;
+    for (size_t i = 0; i < num_nodes; i++) {
+        nodes[i]->index = (uint32_t)i;
+        if (list->first_path_index == UINT32_MAX && !nr_redirect_route_split_host(nodes[i]->rule.from_route, NULL, NULL, NULL, NULL)) {
+            list->first_path_index = (uint32_t)i;
+        }
+        nodes[i]->next = i + 1 < num_nodes ? nodes[i + 1] : NULL;
+        if (nodes[i]->rule.force) {
+            list->forced_rules[num_forced++] = nodes[i];
+        }
+    }
+    list->head = nodes[0];
+    list->order = order;
+    list->generation = nr_decision_cache_next_generation();
 
-                // Append original query string if to_route doesn't specify one
-                // This logic needs to be careful not to duplicate query parameters already handled by placeholders.
-                // The rule is: if the to_route itself contains a '?', assume it explicitly defines its query params.
-                // Otherwise, append the original query string from the request_url, excluding those already matched.
-                if (strchr(current_rule_node->rule.to_route, '?') == NULL) {
-                    char original_query_full_buffer[NR_MAX_ROUTE_LEN + 1]; // Buffer for the full original query string
-                    char *original_query_str = nr_extract_query_string(request_url, original_query_full_buffer, sizeof(original_query_full_buffer));
-
-                    if (original_query_str != NULL && strlen(original_query_str) > 0) {
-                        char remaining_query_buffer[NR_MAX_ROUTE_LEN + 1] = {0};
-                        char temp_original_query_copy[NR_MAX_ROUTE_LEN + 1]; // Copy for strtok_r
-                        strncpy(temp_original_query_copy, original_query_str, sizeof(temp_original_query_copy) - 1);
-                        temp_original_query_copy[sizeof(temp_original_query_copy) - 1] = '\0';
-
-                        char *token_save_ptr = NULL;
-                        char *current_param_pair = strtok_r(temp_original_query_copy, "&", &token_save_ptr);
-                        bool first_param = true;
-
-                        while (current_param_pair != NULL) {
-                            const char *equals_sign = strchr(current_param_pair, '=');
-                            char param_key[NR_MAX_QUERY_KEY_LEN + 1];
-                            
-                            if (equals_sign) {
-                                size_t key_len = equals_sign - current_param_pair;
-                                strncpy(param_key, current_param_pair, key_len);
-                                param_key[key_len] = '\0';
-                            } else {
-                                strncpy(param_key, current_param_pair, NR_MAX_QUERY_KEY_LEN);
-                                param_key[NR_MAX_QUERY_KEY_LEN] = '\0';
-                            }
-
-                            // If to_route does not explicitly define query parameters,
-                            // all original query parameters should be passed through.
-                            // The 'handled_by_placeholder' check is removed here to ensure this.
-                            if (!first_param) {
-                                nr_append_string_to_buffer(remaining_query_buffer, sizeof(remaining_query_buffer), "&");
-                            }
-                            nr_append_string_to_buffer(remaining_query_buffer, sizeof(remaining_query_buffer), current_param_pair);
-                            first_param = false;
-                            current_param_pair = strtok_r(NULL, "&", &token_save_ptr);
-                        }
-
-                        if (strlen(remaining_query_buffer) > 0) {
-                            if (strchr(temp_new_url, '?') == NULL) {
-                                nr_append_string_to_buffer(temp_new_url, NR_REDIRECT_MAX_URL_LEN + 1, "?");
-                            }
-                            nr_append_string_to_buffer(temp_new_url, NR_REDIRECT_MAX_URL_LEN + 1, remaining_query_buffer);
-                        }
-                    }
+    if (warn != NULL) {
+        // A pair changes winner when the file-earlier rule now comes later and both can match one URL
+        for (size_t i = 0; i < num_nodes; i++) {
+            for (size_t j = i + 1; j < num_nodes; j++) {
+                if (nodes[j]->file_index < nodes[i]->file_index && nr_redirect_rules_overlap(nodes[i], nodes[j])) {
+                    warn(&nodes[j]->rule, &nodes[i]->rule, user_data);
                 }
-                
-                strncpy(response_context->new_url, temp_new_url, NR_REDIRECT_MAX_URL_LEN);
-                response_context->new_url[NR_REDIRECT_MAX_URL_LEN] = '\0'; // Ensure null-termination
+            }
+        }
+    }
+
+    free(nodes);
+    return true;
+}
+
+/**
+ * @brief Follows 200 rewrites through the rules their targets match, once, at load time.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param on_cycle Called once for every cycle of rewrites. May be NULL.
+ * @param user_data Data passed through to on_cycle.
+ * @return true if the rules were resolved, false otherwise (no rule is resolved).
+ */
+bool nanorouter_redirect_rule_list_resolve_rewrites(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+) {
+    if (list == NULL || !nr_redirect_chains_resolve(list, on_cycle, user_data)) {
+        return false;
+    }
+    list->generation = nr_decision_cache_next_generation();
+    return true;
+}
+
+/**
+ * @brief Points redirects straight at the end of their chain, to save the browser a round trip per hop.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param on_collapse Called for every rule that was rewritten. May be NULL.
+ * @param on_cycle Called once for every cycle of redirects. May be NULL.
+ * @param user_data Data passed through to the callbacks.
+ * @return true if the pass ran, false otherwise (no rule is rewritten).
+ */
+bool nanorouter_redirect_rule_list_collapse_redirects(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_collapse_callback_t on_collapse,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+) {
+    if (list == NULL || !nr_redirect_chains_collapse(list, on_collapse, on_cycle, user_data)) {
+        return false;
+    }
+    list->generation = nr_decision_cache_next_generation();
+    return true;
+}
+
+/**
+ * @brief Parses a _redirects file content and appends every valid rule to a list.
+ *
+ * Empty lines, comments and malformed rules are skipped.
+ *
+ * @param file_content The content of the _redirects file as a string.
+ * @param rule_list A pointer to the nanorouter_redirect_rule_list_t to populate.
+ * @return true if parsing was successful, false otherwise (e.g., memory allocation failure).
+ */
+bool nanorouter_parse_redirects_file(const char *file_content, nanorouter_redirect_rule_list_t *rule_list) {
+    if (file_content == NULL || rule_list == NULL) {
+        return false;
+    }
+
+    const char *current_pos = file_content;
+    while (*current_pos != '\0') {
+        const char *line_end = strchr(current_pos, '\n');
+        size_t line_len = (line_end == NULL) ? strlen(current_pos) : (size_t)(line_end - current_pos);
+
+        redirect_rule_t rule;
+        if (line_len > 0 && nr_parse_redirect_rule(current_pos, line_len, &rule)) {
+            if (!nanorouter_redirect_rule_list_add_rule(rule_list, &rule)) {
+                return false; // Failed to add rule
+            }
+        }
+
+        if (line_end == NULL) {
+            break; // End of content
+        }
+        current_pos = line_end + 1;
+    }
+
+    return true;
+}
+
+// Where a rendered redirect target goes: a buffer, an iovec array, or neither (only counted)
+typedef struct {
+    char *buffer;
+    size_t buffer_size;     // Including the terminator; 0 for no buffer
+    size_t len;             // Full length of the target, even past buffer_size
+    nr_iovec_t *iov;
+    size_t max_iov;
+    size_t num_iov;         // Pieces in the full target, even past max_iov
+} nr_redirect_output_t;
+
+/**
+ * @brief Adds one piece of the target to an output, cutting the buffer copy at its size.
+ *
+ * @param output The output being filled.
+ * @param bytes The piece (not necessarily null-terminated).
+ * @param len Length of the piece.
+ */
+static void nr_redirect_output_write(nr_redirect_output_t *output, const char *bytes, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (output->buffer != NULL && output->len + 1 < output->buffer_size) {
+        size_t room = output->buffer_size - 1 - output->len;
+        memcpy(output->buffer + output->len, bytes, len < room ? len : room);
+    }
+    if (output->num_iov < output->max_iov) {
+        output->iov[output->num_iov].iov_base = bytes;
+        output->iov[output->num_iov].iov_len = len;
+    }
+    output->num_iov++;
+    output->len += len;
+}
+
+// Which rules a request pass evaluates
+typedef enum {
+    NR_REDIRECT_PHASE_ALL,          // Every rule in file order
+    NR_REDIRECT_PHASE_FORCED,       // Only '!' rules, before the static-file lookup
+    NR_REDIRECT_PHASE_FALLBACK      // Only the rules a static file shadows, after the lookup
+} nr_redirect_phase_t;
+
+// Data handed to nr_redirect_rule_confirm while an index is searched
+typedef struct {
+    const nr_parsed_url_t *parsed_url;
+    const nanorouter_request_context_t *request_context;
+    nr_language_tags_t *language_tags;  // Split on the first Language condition, then reused
+    nr_redirect_phase_t phase;
+} nr_redirect_confirm_data_t;
+
+/**
+ * @brief Checks whether a rule takes part in a request pass.
+ *
+ * @param phase The pass being run.
+ * @param rule The rule to check.
+ * @return true if the pass evaluates the rule, false otherwise.
+ */
+static bool nr_redirect_phase_includes(nr_redirect_phase_t phase, const redirect_rule_t *rule) {
+    switch (phase) {
+        case NR_REDIRECT_PHASE_FORCED:
+            return rule->force;
+        case NR_REDIRECT_PHASE_FALLBACK:
+            return !rule->force;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief Checks whether a request has every query key a rule needs, without looking at its path.
+ *
+ * "/v1/user/info id=:id" is turned away here when the request has no id,
+ * with one AND against the request's key mask. Bits are shared by hashing,
+ * so a pass only means the rule is worth matching in full.
+ *
+ * @param node The rule node.
+ * @param parsed_url The request URL; its query pairs are split here on first use.
+ * @return false if a required key is certainly absent, true otherwise.
+ */
+static bool nr_redirect_query_keys_present(const nanorouter_redirect_rule_t *node, const nr_parsed_url_t *parsed_url) {
+    if (node->query_key_mask == 0) {
+        return true;
+    }
+    if (parsed_url->query_len == 0) {
+        return false; // The rule needs a query the request does not have
+    }
+    nr_query_pairs_t *query_pairs = parsed_url->query_pairs;
+    if (query_pairs == NULL) {
+        return true; // No table to check against, the full match scans the query
+    }
+    if (!query_pairs->parsed) {
+        nr_parse_query_pairs(parsed_url->query, parsed_url->query_len, query_pairs);
+    }
+    return query_pairs->too_many || (node->query_key_mask & ~query_pairs->key_mask) == 0;
+}
+
+/**
+ * @brief Checks whether a rule fully matches a request (path, query and conditions).
+ *
+ * @param node The rule node.
+ * @param user_data A pointer to nr_redirect_confirm_data_t.
+ * @return true if the rule applies to the request, false otherwise.
+ */
+static bool nr_redirect_rule_applies(const nanorouter_redirect_rule_t *node, void *user_data) {
+    const nr_redirect_confirm_data_t *data = (const nr_redirect_confirm_data_t *)user_data;
+    if (!nr_redirect_phase_includes(data->phase, &node->rule)) {
+        return false; // Belongs to the other pass
+    }
+    if (!nr_redirect_query_keys_present(node, data->parsed_url)) {
+        return false; // Needs a query key the request does not have
+    }
+
+    // Only the verdict is needed here; the winner's captures are collected once afterwards
+    return nr_match_compiled_pattern(node->rule.from_route, &node->program, node->rule.query_params, node->rule.num_query_params, data->parsed_url, NULL) &&
+           nr_match_conditions_cached(node->rule.conditions, node->rule.num_conditions, data->request_context, data->language_tags);
+}
+
+/**
+ * @brief Checks whether a candidate from the rule list or an index fully matches a request.
+ *
+ * Rules in the not-found map or the extension index are turned away: they
+ * have already been looked up by prefix or by extension.
+ *
+ * @param node The candidate rule node.
+ * @param user_data A pointer to nr_redirect_confirm_data_t.
+ * @return true if the rule applies to the request, false otherwise.
+ */
+static bool nr_redirect_rule_confirm(const nanorouter_redirect_rule_t *node, void *user_data) {
+    return !node->not_found_prefix && !node->by_extension && nr_redirect_rule_applies(node, user_data);
+}
+
+/**
+ * @brief Finds the first rule of the extension index that applies to a request.
+ *
+ * @param rules The rule list.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param below_index Only rules placed before this index are looked at.
+ * @param confirm_data The request, for nr_redirect_rule_applies.
+ * @return The applying rule with the lowest index, or NULL if none applies.
+ */
+static const nanorouter_redirect_rule_t* nr_redirect_extension_find(
+    const nanorouter_redirect_rule_list_t *rules,
+    const nr_parsed_url_t *parsed_url,
+    uint32_t below_index,
+    nr_redirect_confirm_data_t *confirm_data
+) {
+    if (rules->extensions == NULL) {
+        return NULL;
+    }
+    size_t extension_len = 0;
+    const char *extension = nr_url_path_extension(parsed_url->path, parsed_url->path_len, &extension_len);
+    size_t num_candidates = 0;
+    const void *const *candidates = nr_extension_index_lookup(rules->extensions, extension, extension_len, &num_candidates);
+
+    // Filed in list order, so the first one that applies is the winner
+    for (size_t i = 0; i < num_candidates; i++) {
+        const nanorouter_redirect_rule_t *node = (const nanorouter_redirect_rule_t*) candidates[i];
+        if (node->index >= below_index) {
+            break;
+        }
+        if (nr_redirect_rule_applies(node, confirm_data)) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Returns the compiled to_route a matched rule renders, and the string it was compiled from.
+ *
+ * A rewrite resolved by nanorouter_redirect_rule_list_resolve_rewrites
+ * renders its final target instead of its own.
+ */
+static const nr_route_template_t* nr_redirect_match_template(const nanorouter_redirect_match_t *match, const char **to_route) {
+    const nanorouter_redirect_rule_t *node = match->rule;
+    const nr_redirect_chain_t *chain = node->chain;
+    *to_route = chain != NULL ? chain->to_route : node->rule.to_route;
+    return chain != NULL ? &chain->to_template : &node->to_template;
+}
+
+/**
+ * @brief Passes the request's query string through to a rendered target, unless to_route defines its own.
+ *
+ * The rule is: if the to_route itself contains a '?', assume it explicitly
+ * defines its query params. Otherwise, all pairs of the request's query string
+ * are passed through, without empty ones, after a '?' or, when a captured
+ * value already carries one, an '&'.
+ *
+ * @param match The matched rule and its captures.
+ * @param route_template The template the target was rendered from.
+ * @param to_route The to_route it was compiled from.
+ * @param output The output the target was written to.
+ */
+static void nr_render_redirect_query(
+    const nanorouter_redirect_match_t *match,
+    const nr_route_template_t *route_template,
+    const char *to_route,
+    nr_redirect_output_t *output
+) {
+    if (route_template->has_query || match->query_len == 0) {
+        return;
+    }
+    bool has_query = false;
+    for (uint8_t i = 0; i < route_template->num_parts && !has_query; i++) {
+        if (route_template->parts[i].kind != NR_TEMPLATE_PART_LITERAL) {
+            size_t len;
+            const char *bytes = nr_route_template_part(route_template, i, to_route, match->url, &match->captures, &len);
+            has_query = memchr(bytes, '?', len) != NULL; // A captured query value may carry one
+        }
+    }
 
-                return true; // Rule applied
+    const char *query_end = match->query + match->query_len;
+    bool first_param = true;
+    for (const char *pair = match->query; pair < query_end; ) {
+        const char *pair_end = (const char *)memchr(pair, '&', (size_t)(query_end - pair));
+        if (pair_end == NULL) {
+            pair_end = query_end;
+        }
+        if (pair_end > pair) {
+            if (!first_param) {
+                nr_redirect_output_write(output, "&", 1);
+            } else if (!has_query) {
+                nr_redirect_output_write(output, "?", 1);
             }
+            nr_redirect_output_write(output, pair, (size_t)(pair_end - pair));
+            first_param = false;
         }
-        current_rule_node = current_rule_node->next;
+        pair = pair_end + 1;
+    }
+}
+
+/**
+ * @brief Renders the target of a matched rule into a buffer, snprintf style.
+ *
+ * The template's length comes from the literal length summed when the rule
+ * was compiled, plus the captured values, so a length query renders nothing
+ * but the query string. Captured values and query pairs are taken straight
+ * from the request URL.
+ *
+ * @param match The matched rule and its captures.
+ * @param buffer Output buffer. May be NULL when buffer_size is 0.
+ * @param buffer_size Size of buffer, including the terminator.
+ * @return The length of the full target, without the terminator.
+ */
+static size_t nr_render_redirect_match(const nanorouter_redirect_match_t *match, char *buffer, size_t buffer_size) {
+    const char *to_route;
+    const nr_route_template_t *route_template = nr_redirect_match_template(match, &to_route);
+    nr_redirect_output_t output = {
+        .buffer = buffer_size > 0 ? buffer : NULL,
+        .buffer_size = buffer_size,
+        .len = nr_route_template_length(route_template, to_route, &match->captures)
+    };
+    if (output.buffer != NULL) {
+        nr_render_route_template(route_template, to_route, match->url, &match->captures, buffer, buffer_size);
+    }
+    nr_render_redirect_query(match, route_template, to_route, &output);
+    if (output.buffer != NULL) {
+        buffer[output.len < buffer_size ? output.len : buffer_size - 1] = '\0';
+    }
+    return output.len;
+}
+
+/**
+ * @brief Describes the target of a matched rule as pieces of the rule and the request URL.
+ *
+ * One pass over the compiled to_route: literal chunks and captured spans,
+ * then the query pairs passed through.
+ *
+ * @param match The matched rule and its captures.
+ * @param output The output to fill.
+ */
+static void nr_render_redirect_match_pieces(const nanorouter_redirect_match_t *match, nr_redirect_output_t *output) {
+    const char *to_route;
+    const nr_route_template_t *route_template = nr_redirect_match_template(match, &to_route);
+    for (uint8_t i = 0; i < route_template->num_parts; i++) {
+        size_t len;
+        const char *bytes = nr_route_template_part(route_template, i, to_route, match->url, &match->captures, &len);
+        nr_redirect_output_write(output, bytes, len);
     }
+    nr_render_redirect_query(match, route_template, to_route, output);
+}
 
-    return false; // No rule applied
+/**
+ * @brief Fills the response for a rule that matched the request.
+ *
+ * new_url is cut at NR_REDIRECT_MAX_URL_LEN; nanorouter_redirect_match_render
+ * gives the full target.
+ *
+ * @param match The matched rule and its captures.
+ * @param response_context The response to populate.
+ */
+static void nr_apply_redirect_match(const nanorouter_redirect_match_t *match, nanorouter_redirect_response_t *response_context) {
+    response_context->status_code = match->status_code;
+    nr_render_redirect_match(match, response_context->new_url, sizeof(response_context->new_url));
+}
+
+/**
+ * @brief Checks whether a request URL is absolute ("http://host/path"), so it names its own host.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @return true if the path starts with "http://" or "https://" followed by a host name, false otherwise.
+ */
+static bool nr_parsed_url_is_absolute(const nr_parsed_url_t *parsed_url) {
+    const char *path = parsed_url->path;
+    size_t path_len = parsed_url->path_len;
+    size_t host_start;
+    if (path_len >= 8 && strncasecmp(path, "https://", 8) == 0) {
+        host_start = 8;
+    } else if (path_len >= 7 && strncasecmp(path, "http://", 7) == 0) {
+        host_start = 7;
+    } else {
+        return false;
+    }
+    return host_start < path_len && path[host_start] != '/';
+}
+
+// Which scheme a request came in on, as far as host rules care
+typedef enum {
+    NR_REQUEST_SCHEME_UNKNOWN,      // Host rules are skipped
+    NR_REQUEST_SCHEME_HTTP,
+    NR_REQUEST_SCHEME_HTTPS
+} nr_request_scheme_t;
+
+static nr_request_scheme_t nr_request_scheme(const nanorouter_request_context_t *request_context) {
+    if (strcasecmp(request_context->scheme, "https") == 0) {
+        return NR_REQUEST_SCHEME_HTTPS;
+    }
+    return strcasecmp(request_context->scheme, "http") == 0 ? NR_REQUEST_SCHEME_HTTP : NR_REQUEST_SCHEME_UNKNOWN;
+}
+
+/**
+ * @brief Checks whether a host rule takes part in a request pass, judging by scheme and phase.
+ *
+ * @param host_rule The host rule.
+ * @param scheme The request's scheme, HTTP or HTTPS.
+ * @param phase The pass being run.
+ * @return true if the rule is evaluated for the request, false otherwise.
+ */
+static bool nr_redirect_host_rule_takes_part(const nr_redirect_host_rule_t *host_rule, nr_request_scheme_t scheme, nr_redirect_phase_t phase) {
+    return host_rule->https == (scheme == NR_REQUEST_SCHEME_HTTPS) && nr_redirect_phase_includes(phase, &host_rule->node->rule);
+}
+
+/**
+ * @brief Matches a host rule's path and query parameters against a request.
+ *
+ * @param host_rule The host rule, with its path compiled on its own.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param captures Output: the spans captured while matching. May be NULL.
+ * @return true if the path and query parameters match, false otherwise.
+ */
+static bool nr_redirect_host_rule_match(const nr_redirect_host_rule_t *host_rule, const nr_parsed_url_t *parsed_url, nr_capture_spans_t *captures) {
+    const redirect_rule_t *rule = &host_rule->node->rule;
+    return nr_match_compiled_pattern(host_rule->path_pattern, &host_rule->program, rule->query_params, rule->num_query_params, parsed_url, captures);
+}
+
+/**
+ * @brief Finds the first rule written for the request's host that applies to the request.
+ *
+ * The host is taken from request_context->domain and picks its rules with one
+ * hash lookup, so rules for other hosts are never looked at. Absolute request
+ * URLs carry their own host and are matched against the full from_route by the
+ * regular rule search instead. Requests without a known scheme skip host rules.
+ *
+ * @param rules The rule list.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param request_context Request data with the domain, scheme and condition values.
+ * @param language_tags The request's language tags, split on first use.
+ * @param phase The pass being run; host rules of the other pass are skipped.
+ * @return The winning host rule, or NULL if none applies.
+ */
+static const nr_redirect_host_rule_t* nr_redirect_host_find(
+    const nanorouter_redirect_rule_list_t *rules,
+    const nr_parsed_url_t *parsed_url,
+    const nanorouter_request_context_t *request_context,
+    nr_language_tags_t *language_tags,
+    nr_redirect_phase_t phase
+) {
+    if (rules->hosts == NULL || request_context == NULL || request_context->domain[0] == '\0' ||
+        nr_parsed_url_is_absolute(parsed_url)) {
+        return NULL;
+    }
+
+    // Every host rule names a scheme; without the request's, an http:// rule would also answer the https request it redirects to
+    nr_request_scheme_t scheme = nr_request_scheme(request_context);
+    if (scheme == NR_REQUEST_SCHEME_UNKNOWN) {
+        return NULL;
+    }
+
+    size_t num_rules = 0;
+    const nr_redirect_host_rule_t *host_rules = nr_redirect_host_table_lookup(
+        rules->hosts, request_context->domain, strlen(request_context->domain), &num_rules);
+
+    for (size_t i = 0; i < num_rules; i++) {
+        const nr_redirect_host_rule_t *host_rule = &host_rules[i];
+        if (!nr_redirect_host_rule_takes_part(host_rule, scheme, phase) ||
+            !nr_redirect_query_keys_present(host_rule->node, parsed_url)) {
+            continue;
+        }
+        if (nr_redirect_host_rule_match(host_rule, parsed_url, NULL) &&
+            nr_match_conditions_cached(host_rule->node->rule.conditions, host_rule->node->rule.num_conditions, request_context, language_tags)) {
+            return host_rule;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Canonicalization stage: applies a host-wide redirect (http to https, www to apex) before the path is split.
+ *
+ * The request's host picks its rules with one hash lookup. When the first one
+ * the pass evaluates redirects every path and comes before all path rules, it
+ * wins whatever the path is, so the match is recorded from the path and query
+ * as they are, without running the matcher. Anything else is left to it,
+ * including every request whose scheme is unknown.
+ *
+ * @param rules The rule list.
+ * @param url The request URL.
+ * @param path_len Length of the path at the start of url, as nr_split_url_n gives it.
+ * @param query The request's query string, without '?'.
+ * @param query_len Length of query.
+ * @param request_context Request data with the domain and scheme.
+ * @param phase The pass being run.
+ * @param match Output: the host-wide redirect and its splat.
+ * @return true if a host-wide redirect applies, false if the matcher has to decide.
+ */
+static bool nr_redirect_canonical_find(
+    const nanorouter_redirect_rule_list_t *rules,
+    const char *url,
+    size_t path_len,
+    const char *query,
+    size_t query_len,
+    const nanorouter_request_context_t *request_context,
+    nr_redirect_phase_t phase,
+    nanorouter_redirect_match_t *match
+) {
+    if (rules->hosts == NULL || request_context == NULL || request_context->domain[0] == '\0' ||
+        path_len == 0 || url[0] != '/' || path_len > UINT16_MAX ||
+        (rules->case_insensitive && path_len > NR_MAX_ROUTE_LEN)) {
+        return false;
+    }
+    // A path such as "/https://example.com/x" can match a host rule's from_route as a plain path
+    if (path_len >= 5 && strncasecmp(url, "/http", 5) == 0) {
+        return false;
+    }
+    // Without the request's scheme, "http://example.com/* https://example.com/:splat" would also
+    // answer the https request it redirects to, and the client would loop
+    nr_request_scheme_t scheme = nr_request_scheme(request_context);
+    if (scheme == NR_REQUEST_SCHEME_UNKNOWN) {
+        return false;
+    }
+
+    size_t num_rules = 0;
+    const nr_redirect_host_rule_t *host_rules = nr_redirect_host_table_lookup(
+        rules->hosts, request_context->domain, strlen(request_context->domain), &num_rules);
+
+    for (size_t i = 0; i < num_rules; i++) {
+        const nr_redirect_host_rule_t *host_rule = &host_rules[i];
+        if (!nr_redirect_host_rule_takes_part(host_rule, scheme, phase)) {
+            continue;
+        }
+        const nanorouter_redirect_rule_t *node = host_rule->node;
+        if (!host_rule->canonical || node->index >= rules->first_path_index) {
+            return false; // The path decides
+        }
+
+        match->rule = node;
+        match->status_code = node->chain != NULL ? node->chain->status_code : node->rule.status_code;
+        match->url = url;
+        match->query = query;
+        match->query_len = query_len;
+        // The splat of "/*": the path without its '/'
+        nr_capture_span_t *span = &match->captures.spans[0];
+        span->key = "*";
+        span->key_len = 1;
+        span->offset = path_len > 1 ? 1 : 0;
+        span->len = (uint16_t)(path_len - 1);
+        match->captures.num_spans = 1;
+        return true;
+    }
+    return false;
+}
+
+// --- Middleware Function Implementation ---
+
+/**
+ * @brief Searches the list's lookup index for the first rule that applies to a request.
+ *
+ * @param rules The compiled rule list (engine other than NR_REDIRECT_ENGINE_LINEAR).
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm_data The request data handed to nr_redirect_rule_confirm.
+ * @return The winning rule node, or NULL if no rule applies.
+ */
+static const nanorouter_redirect_rule_t* nr_redirect_index_find(
+    const nanorouter_redirect_rule_list_t *rules,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_data_t *confirm_data
+) {
+    switch (rules->engine) {
+        case NR_REDIRECT_ENGINE_TRIE:
+            return nr_redirect_trie_find(rules->trie, parsed_url, nr_redirect_rule_confirm, confirm_data);
+        case NR_REDIRECT_ENGINE_HASH:
+        case NR_REDIRECT_ENGINE_STATIC_HASH:
+            return nr_redirect_hash_find(rules->hash, parsed_url, nr_redirect_rule_confirm, confirm_data);
+        case NR_REDIRECT_ENGINE_DFA:
+            return nr_redirect_dfa_find(rules->dfa, parsed_url, nr_redirect_rule_confirm, confirm_data);
+        case NR_REDIRECT_ENGINE_BITSET:
+            return nr_redirect_bitset_find(rules->bitset, parsed_url, nr_redirect_rule_confirm, confirm_data);
+        case NR_REDIRECT_ENGINE_PREFILTER:
+            return nr_redirect_prefilter_find(rules->prefilter, parsed_url, nr_redirect_rule_confirm, confirm_data);
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief Starts loading the index entry a request's lookup will read first.
+ *
+ * @param rules The rule list.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ */
+static void nr_redirect_index_prefetch(const nanorouter_redirect_rule_list_t *rules, const nr_parsed_url_t *parsed_url) {
+    // Only the hash engines start from one entry a key picks; the others walk from a shared root that stays cached
+    if (rules->engine == NR_REDIRECT_ENGINE_HASH || rules->engine == NR_REDIRECT_ENGINE_STATIC_HASH) {
+        nr_redirect_hash_prefetch(rules->hash, parsed_url);
+    }
+}
+
+/**
+ * @brief Runs one request pass over a rule list and records the winning rule.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param rules The rule list.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @param language_tags The request's language tags, split on first use.
+ * @param phase Which rules to evaluate.
+ * @param match Output: the winning rule and its captures.
+ * @return true if a redirect rule matched, false otherwise.
+ */
+static bool nr_match_redirect_phase(
+    const nr_parsed_url_t *parsed_url,
+    const nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *request_context,
+    nr_language_tags_t *language_tags,
+    nr_redirect_phase_t phase,
+    nanorouter_redirect_match_t *match
+) {
+    match->url = parsed_url->url;
+    match->query = parsed_url->query;
+    match->query_len = parsed_url->query_len;
+    match->captures.num_spans = 0;
+
+    // Rules for the request's host compete with the path rules by file position
+    const nr_redirect_host_rule_t *host_winner = nr_redirect_host_find(rules, parsed_url, request_context, language_tags, phase);
+    uint32_t host_index = host_winner != NULL ? host_winner->node->index : UINT32_MAX;
+
+    nr_redirect_confirm_data_t confirm_data = {
+        .parsed_url = parsed_url,
+        .request_context = request_context,
+        .language_tags = language_tags,
+        .phase = phase
+    };
+
+    // Path-scoped 404 rules take one probe per path segment; the first one found bounds the search below
+    const nanorouter_redirect_rule_t *indexed_winner = nr_redirect_not_found_map_find(
+        rules->not_found, parsed_url, host_index, nr_redirect_rule_applies, &confirm_data);
+    uint32_t bound = indexed_winner != NULL ? indexed_winner->index : host_index;
+
+    // Rules ending in a file suffix take one probe on the request's extension
+    const nanorouter_redirect_rule_t *extension_winner = nr_redirect_extension_find(rules, parsed_url, bound, &confirm_data);
+    if (extension_winner != NULL) {
+        indexed_winner = extension_winner;
+        bound = extension_winner->index;
+    }
+    const nanorouter_redirect_rule_t *winner = NULL;
+
+    if (phase == NR_REDIRECT_PHASE_FORCED) {
+        // Forced rules are kept apart at load, so this pass never looks at the others
+        for (size_t i = 0; i < rules->num_forced_rules && rules->forced_rules[i]->index < bound; i++) {
+            if (nr_redirect_rule_confirm(rules->forced_rules[i], &confirm_data)) {
+                winner = rules->forced_rules[i];
+                break;
+            }
+        }
+    } else if (rules->engine != NR_REDIRECT_ENGINE_LINEAR) {
+        winner = nr_redirect_index_find(rules, parsed_url, &confirm_data);
+    } else {
+        for (const nanorouter_redirect_rule_t *current = rules->head; current != NULL && current->index < bound; current = current->next) {
+            if (nr_redirect_rule_confirm(current, &confirm_data)) {
+                winner = current;
+                break;
+            }
+        }
+    }
+
+    if (winner == NULL || winner->index >= bound) {
+        winner = indexed_winner;
+    }
+    if (winner != NULL) {
+        // Re-run the winner alone to collect its captures
+        nr_match_compiled_pattern(winner->rule.from_route, &winner->program, winner->rule.query_params, winner->rule.num_query_params, parsed_url, &match->captures);
+    } else if (host_winner != NULL) {
+        nr_redirect_host_rule_match(host_winner, parsed_url, &match->captures);
+        winner = host_winner->node;
+    } else {
+        return false; // No rule matched
+    }
+
+    match->rule = winner;
+    match->status_code = winner->chain != NULL ? winner->chain->status_code : winner->rule.status_code;
+    return true;
+}
+
+// What one request pass splits from its URL, on the caller's stack or in a batch's scratch
+typedef struct {
+    nr_parsed_url_t parsed_url;
+    nr_query_pairs_t query_pairs;
+    nr_language_tags_t language_tags;
+    char folded_path[NR_MAX_ROUTE_LEN + 1];
+} nr_redirect_request_scratch_t;
+
+/**
+ * @brief Splits a length-delimited URL into scratch for nr_match_redirect_phase.
+ *
+ * @return false if the list is case-insensitive and the path is too long to fold.
+ */
+static bool nr_redirect_request_split(
+    const char *request_url,
+    size_t request_url_len,
+    const nanorouter_redirect_rule_list_t *rules,
+    nr_redirect_request_scratch_t *scratch
+) {
+    // Split the URL once, in place; every rule reuses the same segments and query table
+    nr_parse_url_n(request_url, request_url_len, &scratch->parsed_url);
+    scratch->query_pairs.parsed = false;
+    scratch->parsed_url.query_pairs = &scratch->query_pairs;
+    scratch->language_tags.parsed = false;
+    return !rules->case_insensitive || nr_fold_parsed_url(&scratch->parsed_url, scratch->folded_path);
+}
+
+/**
+ * @brief Runs one request pass over a length-delimited URL and records the winning rule.
+ */
+static bool nr_match_redirect_url(
+    const char *request_url,
+    size_t request_url_len,
+    const nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *request_context,
+    nr_redirect_phase_t phase,
+    nanorouter_redirect_match_t *match
+) {
+    // Host-wide redirects are decided before the path is split
+    size_t path_len;
+    const char *query;
+    size_t query_len;
+    nr_split_url_n(request_url, request_url_len, &path_len, &query, &query_len);
+    if (nr_redirect_canonical_find(rules, request_url, path_len, query, query_len, request_context, phase, match)) {
+        return true;
+    }
+
+    nr_redirect_request_scratch_t scratch;
+    if (!nr_redirect_request_split(request_url, request_url_len, rules, &scratch)) {
+        return false; // Longer than NR_MAX_ROUTE_LEN, too long to fold
+    }
+    return nr_match_redirect_phase(&scratch.parsed_url, rules, request_context, &scratch.language_tags, phase, match);
+}
+
+/**
+ * @brief Resets the response and runs one request pass over a length-delimited URL.
+ */
+static bool nr_process_redirect_url(
+    const char *request_url,
+    size_t request_url_len,
+    const nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context,
+    nr_redirect_phase_t phase
+) {
+    // Initialize response_context to indicate no redirect by default
+    if (response_context != NULL) {
+        response_context->new_url[0] = '\0';
+        response_context->status_code = 0;
+    }
+
+    if (request_url == NULL || rules == NULL || response_context == NULL) {
+        return false;
+    }
+
+    nanorouter_redirect_match_t match;
+    if (!nr_match_redirect_url(request_url, request_url_len, rules, request_context, phase, &match)) {
+        return false;
+    }
+    nr_apply_redirect_match(&match, response_context);
+    return true; // Rule applied
+}
+
+/**
+ * @brief Processes an incoming request URL against a list of redirect rules.
+ *
+ * If a matching rule is found, the response_context will be populated with the
+ * new URL and status code.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    return nr_process_redirect_url(request_url, request_url != NULL ? strlen(request_url) : 0, rules, response_context, request_context, NR_REDIRECT_PHASE_ALL);
+}
+
+/**
+ * @brief Processes a length-delimited request URL against a list of redirect rules.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    return nr_process_redirect_url(request_url, request_url_len, rules, response_context, request_context, NR_REDIRECT_PHASE_ALL);
+}
+
+// One request of a batch group: its scratch, and its match once decided
+typedef struct {
+    nr_redirect_request_scratch_t scratch;
+    nanorouter_redirect_match_t match;
+    bool split;                         // Scratch is ready for nr_match_redirect_phase
+    bool matched;                       // A rule applies; match holds it
+} nr_redirect_batch_slot_t;
+
+/**
+ * @brief Processes many request URLs against a list of redirect rules in one call.
+ *
+ * @param urls The request URLs, null-terminated. A NULL entry gets an empty result.
+ * @param num_urls Number of entries in urls, contexts and results.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param contexts Request data for each URL, or NULL to match every URL without one.
+ * @param results Output: one response per URL.
+ * @return Number of URLs a redirect rule was applied to.
+ */
+size_t nanorouter_process_redirect_batch(
+    const char *const *urls,
+    size_t num_urls,
+    nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *contexts,
+    nanorouter_redirect_response_t *results
+) {
+    if (urls == NULL || rules == NULL || results == NULL) {
+        return 0;
+    }
+
+    size_t applied = 0;
+    nr_redirect_batch_slot_t *slots = (nr_redirect_batch_slot_t*) malloc(NR_REDIRECT_BATCH_SIZE * sizeof(nr_redirect_batch_slot_t));
+    if (slots == NULL) {
+        // No scratch to spare, so one request at a time
+        for (size_t i = 0; i < num_urls; i++) {
+            applied += nanorouter_process_redirect_request(urls[i], rules, &results[i], contexts != NULL ? &contexts[i] : NULL) ? 1 : 0;
+        }
+        return applied;
+    }
+
+    for (size_t first = 0; first < num_urls; first += NR_REDIRECT_BATCH_SIZE) {
+        size_t group_size = num_urls - first < NR_REDIRECT_BATCH_SIZE ? num_urls - first : NR_REDIRECT_BATCH_SIZE;
+
+        // Split the whole group first, so the index loads of later requests overlap the matching of earlier ones
+        for (size_t g = 0; g < group_size; g++) {
+            size_t i = first + g;
+            nr_redirect_batch_slot_t *slot = &slots[g];
+            results[i].new_url[0] = '\0';
+            results[i].status_code = 0;
+            slot->split = false;
+            slot->matched = false;
+            if (urls[i] == NULL) {
+                continue;
+            }
+
+            size_t url_len = strlen(urls[i]);
+            size_t path_len;
+            const char *query;
+            size_t query_len;
+            nr_split_url_n(urls[i], url_len, &path_len, &query, &query_len);
+            if (nr_redirect_canonical_find(rules, urls[i], path_len, query, query_len, contexts != NULL ? &contexts[i] : NULL,
+                                           NR_REDIRECT_PHASE_ALL, &slot->match)) {
+                slot->matched = true; // Decided by the host alone
+            } else if (nr_redirect_request_split(urls[i], url_len, rules, &slot->scratch)) {
+                slot->split = true;
+                nr_redirect_index_prefetch(rules, &slot->scratch.parsed_url);
+            }
+        }
+
+        for (size_t g = 0; g < group_size; g++) {
+            size_t i = first + g;
+            nr_redirect_batch_slot_t *slot = &slots[g];
+            if (slot->split) {
+                slot->matched = nr_match_redirect_phase(&slot->scratch.parsed_url, rules, contexts != NULL ? &contexts[i] : NULL,
+                                                        &slot->scratch.language_tags, NR_REDIRECT_PHASE_ALL, &slot->match);
+            }
+            if (slot->matched) {
+                nr_apply_redirect_match(&slot->match, &results[i]);
+                applied++;
+            }
+        }
+    }
+
+    free(slots);
+    return applied;
+}
+
+/**
+ * @brief Processes a request URL against a list of redirect rules, through a decision cache.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @param cache The cache to use, or NULL to decide every request afresh.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_cached(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context,
+    nr_decision_cache_t *cache
+) {
+    nr_decision_key_t key;
+    if (cache == NULL || request_url == NULL || rules == NULL || response_context == NULL ||
+        !nr_decision_key_init(&key, request_url, strlen(request_url), request_context)) {
+        return nanorouter_process_redirect_request(request_url, rules, response_context, request_context);
+    }
+
+    // Cached as the status code followed by new_url and its NUL
+    char value[sizeof(int) + NR_REDIRECT_MAX_URL_LEN + 1];
+    size_t value_len = sizeof(value);
+    bool applied;
+    if (nr_decision_cache_lookup(cache, &key, rules->generation, value, &value_len, &applied) && value_len > sizeof(int)) {
+        memcpy(&response_context->status_code, value, sizeof(int));
+        memcpy(response_context->new_url, value + sizeof(int), value_len - sizeof(int));
+        return applied;
+    }
+
+    applied = nanorouter_process_redirect_request(request_url, rules, response_context, request_context);
+    size_t new_url_len = strlen(response_context->new_url) + 1;
+    memcpy(value, &response_context->status_code, sizeof(int));
+    memcpy(value + sizeof(int), response_context->new_url, new_url_len);
+    nr_decision_cache_store(cache, &key, rules->generation, value, sizeof(int) + new_url_len, applied);
+    return applied;
+}
+
+/**
+ * @brief Runs the full request pass over a URL that other middleware may also read.
+ *
+ * The caller's URL is left alone; a case-insensitive list folds a private copy.
+ */
+static bool nr_match_redirect_shared_url(
+    const nr_parsed_url_t *parsed_url,
+    const nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *request_context,
+    nr_language_tags_t *language_tags,
+    nanorouter_redirect_match_t *match
+) {
+    if (nr_redirect_canonical_find(rules, parsed_url->url, parsed_url->path_len, parsed_url->query, parsed_url->query_len,
+                                   request_context, NR_REDIRECT_PHASE_ALL, match)) {
+        return true;
+    }
+    if (rules->case_insensitive) {
+        nr_parsed_url_t folded_url = *parsed_url;
+        char folded_path[NR_MAX_ROUTE_LEN + 1];
+        if (!nr_fold_parsed_url(&folded_url, folded_path)) {
+            return false; // Longer than NR_MAX_ROUTE_LEN, too long to fold
+        }
+        return nr_match_redirect_phase(&folded_url, rules, request_context, language_tags, NR_REDIRECT_PHASE_ALL, match);
+    }
+    return nr_match_redirect_phase(parsed_url, rules, request_context, language_tags, NR_REDIRECT_PHASE_ALL, match);
+}
+
+/**
+ * @brief Processes a request URL that was already split by nr_parse_url against a list of redirect rules.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url (may be shared with the header middleware).
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_parsed(
+    const nr_parsed_url_t *parsed_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    // Initialize response_context to indicate no redirect by default
+    if (response_context != NULL) {
+        response_context->new_url[0] = '\0';
+        response_context->status_code = 0;
+    }
+
+    if (parsed_url == NULL || rules == NULL || response_context == NULL) {
+        return false;
+    }
+
+    nr_language_tags_t language_tags;
+    language_tags.parsed = false;
+    nanorouter_redirect_match_t match;
+    if (!nr_match_redirect_shared_url(parsed_url, rules, request_context, &language_tags, &match)) {
+        return false;
+    }
+    nr_apply_redirect_match(&match, response_context);
+    return true; // Rule applied
+}
+
+/**
+ * @brief Processes a request shared with the header middleware against a list of redirect rules.
+ *
+ * @param request The request, created with nr_request_init.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_shared(
+    nr_request_t *request,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context
+) {
+    // Initialize response_context to indicate no redirect by default
+    if (response_context != NULL) {
+        response_context->new_url[0] = '\0';
+        response_context->status_code = 0;
+    }
+
+    nanorouter_redirect_match_t match;
+    if (response_context == NULL || !nanorouter_match_redirect_request_shared(request, rules, &match)) {
+        return false;
+    }
+    nr_apply_redirect_match(&match, response_context);
+    return true; // Rule applied
+}
+
+/**
+ * @brief Finds the rule for a length-delimited request URL without rendering its target.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated. Must outlive match.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @param match Output: the winning rule and its captures.
+ * @return true if a rule matched, false otherwise.
+ */
+bool nanorouter_match_redirect_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *request_context,
+    nanorouter_redirect_match_t *match
+) {
+    if (request_url == NULL || rules == NULL || match == NULL) {
+        return false;
+    }
+    return nr_match_redirect_url(request_url, request_url_len, rules, request_context, NR_REDIRECT_PHASE_ALL, match);
+}
+
+/**
+ * @brief Finds the rule for a request shared with the header middleware without rendering its target.
+ *
+ * @param request The request, created with nr_request_init. Its URL must outlive match.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param match Output: the winning rule and its captures.
+ * @return true if a rule matched, false otherwise.
+ */
+bool nanorouter_match_redirect_request_shared(
+    nr_request_t *request,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_match_t *match
+) {
+    if (request == NULL || rules == NULL || match == NULL) {
+        return false;
+    }
+    return nr_match_redirect_shared_url(&request->url, rules, request->context, &request->language_tags, match);
+}
+
+/**
+ * @brief Renders a matched rule's target into a buffer, snprintf style.
+ *
+ * @param match A match filled by nanorouter_match_redirect_request_n or _shared.
+ * @param buffer Output buffer. May be NULL when buffer_size is 0.
+ * @param buffer_size Size of buffer, including the terminator.
+ * @return The length of the full target, without the terminator.
+ */
+size_t nanorouter_redirect_match_render(const nanorouter_redirect_match_t *match, char *buffer, size_t buffer_size) {
+    if (match == NULL) {
+        return 0;
+    }
+    return nr_render_redirect_match(match, buffer, buffer_size);
+}
+
+/**
+ * @brief Describes a matched rule's target as pieces of the rule and the request URL.
+ *
+ * @param match A match filled by nanorouter_match_redirect_request_n or _shared.
+ * @param iov Output array. May be NULL when max_iov is 0.
+ * @param max_iov Number of entries in iov.
+ * @return The number of pieces in the full target.
+ */
+size_t nanorouter_redirect_match_iovec(const nanorouter_redirect_match_t *match, nr_iovec_t *iov, size_t max_iov) {
+    if (match == NULL) {
+        return 0;
+    }
+    nr_redirect_output_t output = {
+        .iov = iov,
+        .max_iov = iov != NULL ? max_iov : 0
+    };
+    nr_render_redirect_match_pieces(match, &output);
+    return output.num_iov;
+}
+
+/**
+ * @brief Pre-filesystem pass: processes a request URL against the forced ('!') rules only.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a forced rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_forced(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    return nr_process_redirect_url(request_url, request_url != NULL ? strlen(request_url) : 0, rules, response_context, request_context, NR_REDIRECT_PHASE_FORCED);
+}
+
+/**
+ * @brief Fallback pass: processes a request URL against the rules without '!' only.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if an unforced rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_fallback(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+) {
+    return nr_process_redirect_url(request_url, request_url != NULL ? strlen(request_url) : 0, rules, response_context, request_context, NR_REDIRECT_PHASE_FALLBACK);
 }
@@ -5,6 +5,11 @@
 #include <stddef.h>
 #include "nanorouter_redirect_rule_parser.h" // For redirect_rule_t
 #include "nanorouter_condition_matching.h" // For nanorouter_request_context_t
+#include "nanorouter_route_matcher.h" // For nr_route_program_t
+#include "nanorouter_route_template.h" // For nr_route_template_t
+#include "nanorouter_request.h" // For nr_request_t
+#include "nanorouter_redirect_mph.h" // For nr_redirect_mph_table_t
+#include "nanorouter_decision_cache.h" // For nr_decision_cache_t
 
 #include "nanorouter_config.h" // For configuration defines
 
@@ -18,22 +23,140 @@ typedef struct {
     int status_code;                           /**< The HTTP status code to be used. 0 if no redirect. */
 } nanorouter_redirect_response_t;
 
+struct nr_redirect_chain_t;
+
 /**
  * @brief Node structure for the linked list of redirect rules.
  */
 typedef struct nanorouter_redirect_rule_t {
     redirect_rule_t rule;                          /**< The actual redirect rule data. */
+    nr_route_program_t program;                    /**< The rule's from_route, compiled when the rule is added. */
+    nr_route_template_t to_template;               /**< The rule's to_route, compiled when the rule is added. */
+    uint32_t index;                                /**< Position of the rule in the list; file order unless the list is in specificity order. */
+    uint32_t file_index;                           /**< Position of the rule in the _redirects file, whatever the list order. */
+    uint32_t query_key_mask;                       /**< nr_query_params_key_mask of the rule's query parameters, 0 if it has none. */
+    struct nr_redirect_chain_t *chain;             /**< Where the rule's rewrite ends up, set by nanorouter_redirect_rule_list_resolve_rewrites; NULL if unresolved. */
+    bool not_found_prefix;                         /**< Filed in the list's not-found map, which alone looks it up. */
+    bool by_extension;                             /**< Filed in the list's extension index, which alone looks it up. */
     struct nanorouter_redirect_rule_t *next;       /**< Pointer to the next rule in the list. */
 } nanorouter_redirect_rule_t;
 
+/**
+ * @brief The rule that matched a request, kept so its target can be rendered at any length.
+ *
+ * Points into the rule list and the request URL, which must outlive it.
+ */
+typedef struct {
+    const nanorouter_redirect_rule_t *rule;        /**< The winning rule node. */
+    const char *url;                               /**< The request URL the captures point into. */
+    const char *query;                             /**< The request's query string, without '?'; passed through unless to_route has its own. */
+    size_t query_len;                              /**< Length of query. */
+    nr_capture_spans_t captures;                   /**< Values captured by the rule, as spans of url. */
+    int status_code;                               /**< The rule's HTTP status code. */
+} nanorouter_redirect_match_t;
+
+/**
+ * @brief One piece of a rendered redirect target: a chunk of the rule's to_route or a span of the request URL.
+ *
+ * Laid out like POSIX struct iovec, so an array can be passed to writev.
+ */
+typedef struct {
+    const void *iov_base;                          /**< First byte of the piece (not null-terminated). */
+    size_t iov_len;                                /**< Length of the piece. */
+} nr_iovec_t;
+
+/**
+ * @brief Lookup engines available for a redirect rule list.
+ */
+typedef enum {
+    NR_REDIRECT_ENGINE_LINEAR = 0,                 /**< Try every rule in file order (default). */
+    NR_REDIRECT_ENGINE_TRIE,                       /**< Path-segment trie, only candidate rules are tried. */
+    NR_REDIRECT_ENGINE_HASH,                       /**< Literal routes in a hash table, patterns tried in order. */
+    NR_REDIRECT_ENGINE_STATIC_HASH,                /**< Like HASH, with a perfect-hash table generated offline. */
+    NR_REDIRECT_ENGINE_DFA,                        /**< All patterns in one automaton, one pass per URL. */
+    NR_REDIRECT_ENGINE_BITSET,                     /**< Per-depth rule bitsets ANDed per segment. */
+    NR_REDIRECT_ENGINE_PREFILTER                   /**< SIMD scan of first-segment hashes and segment counts. */
+} nanorouter_redirect_engine_t;
+
+/**
+ * @brief Which rule wins when several rules match a request.
+ */
+typedef enum {
+    NR_REDIRECT_ORDER_FILE = 0,                    /**< The first matching rule in the file wins (default). */
+    NR_REDIRECT_ORDER_SPECIFICITY                  /**< The most specific matching pattern wins. */
+} nanorouter_redirect_order_t;
+
+struct nr_redirect_trie_t;
+struct nr_redirect_hash_t;
+struct nr_redirect_dfa_t;
+struct nr_redirect_bitset_t;
+struct nr_redirect_prefilter_t;
+struct nr_redirect_host_table_t;
+struct nr_redirect_not_found_map_t;
+struct nr_extension_index_t;
+
 /**
  * @brief Structure to manage a linked list of redirect rules.
  */
 typedef struct {
     nanorouter_redirect_rule_t *head;              /**< Pointer to the first rule in the list. */
     size_t count;                                  /**< Number of rules in the list. */
+    nanorouter_redirect_engine_t engine;           /**< Engine selected by nanorouter_redirect_rule_list_compile(). */
+    struct nr_redirect_trie_t *trie;               /**< Segment trie, built for NR_REDIRECT_ENGINE_TRIE. */
+    struct nr_redirect_hash_t *hash;               /**< Literal route index, built for NR_REDIRECT_ENGINE_HASH and NR_REDIRECT_ENGINE_STATIC_HASH. */
+    struct nr_redirect_dfa_t *dfa;                 /**< Segment automaton, built for NR_REDIRECT_ENGINE_DFA. */
+    struct nr_redirect_bitset_t *bitset;           /**< Candidate bitsets, built for NR_REDIRECT_ENGINE_BITSET. */
+    struct nr_redirect_prefilter_t *prefilter;     /**< Rule lanes, built for NR_REDIRECT_ENGINE_PREFILTER. */
+    struct nr_redirect_host_table_t *hosts;        /**< Rules whose from_route names a scheme and host, by host. Kept up to date by add_rule. */
+    uint32_t first_path_index;                     /**< Index of the first rule that names no host, UINT32_MAX if none; host-wide redirects before it skip the matcher. */
+    struct nr_redirect_not_found_map_t *not_found; /**< 404 rules scoped to a path prefix, by prefix. Kept up to date by add_rule. */
+    struct nr_extension_index_t *extensions;       /**< Path rules whose from_route ends in a file suffix ("*.css"), by extension. Kept up to date by add_rule. */
+    nanorouter_redirect_rule_t **forced_rules;     /**< Rules with force set ('!'), in file order. Kept up to date by add_rule. */
+    size_t num_forced_rules;                       /**< Number of entries in forced_rules. */
+    nanorouter_redirect_order_t order;             /**< Order of the list, set by nanorouter_redirect_rule_list_set_order(). */
+    bool case_insensitive;                         /**< from_route literals are folded to lowercase as rules are added, and so are request paths. */
+    uint32_t generation;                           /**< Renewed whenever the rules change; decision cache entries of other generations are stale. */
 } nanorouter_redirect_rule_list_t;
 
+/**
+ * @brief Callback used by the lookup engines to confirm a candidate rule.
+ *
+ * Engines only narrow down which rules can match the path; the callback does
+ * the full check (path, query parameters and conditions).
+ *
+ * @param node The candidate rule node.
+ * @param user_data Caller supplied data.
+ * @return true if the rule fully matches the request, false otherwise.
+ */
+typedef bool (*nr_redirect_confirm_callback_t)(const nanorouter_redirect_rule_t *node, void *user_data);
+
+/**
+ * @brief Callback reporting a pair of rules whose winner changes with specificity order.
+ *
+ * @param earlier The rule that comes first in the file and won in file order.
+ * @param later The more specific rule that wins in specificity order.
+ * @param user_data Caller supplied data.
+ */
+typedef void (*nr_redirect_order_warning_callback_t)(const redirect_rule_t *earlier, const redirect_rule_t *later, void *user_data);
+
+/**
+ * @brief Callback reporting rewrite rules whose targets rewrite back to each other forever.
+ *
+ * @param rules The rules of the cycle, in the order they rewrite, starting with the one listed first.
+ * @param num_rules Number of entries in rules.
+ * @param user_data Caller supplied data.
+ */
+typedef void (*nr_redirect_cycle_callback_t)(const redirect_rule_t *const *rules, size_t num_rules, void *user_data);
+
+/**
+ * @brief Callback reporting a redirect that was pointed straight at the end of its chain.
+ *
+ * @param rules The collapsed rule as it was written, then the rules its target went through, in order.
+ * @param num_rules Number of entries in rules.
+ * @param user_data Caller supplied data.
+ */
+typedef void (*nr_redirect_collapse_callback_t)(const redirect_rule_t *const *rules, size_t num_rules, void *user_data);
+
 // --- Function Prototypes for Rule List Management ---
 
 /**
@@ -47,7 +170,8 @@ nanorouter_redirect_rule_list_t* nanorouter_redirect_rule_list_create();
  * @brief Adds a new redirect_rule_t to the linked list.
  *
  * This function allocates a nanorouter_redirect_rule_t node, copies the rule_data into it,
- * and adds it to the end of the list.
+ * compiles its from_route pattern and adds it to the end of the list. Rules whose
+ * from_route starts with a scheme and host are also filed in the list's host table.
  *
  * @param list A pointer to the nanorouter_redirect_rule_list_t.
  * @param rule_data A pointer to the redirect_rule_t data to be added.
@@ -62,6 +186,159 @@ bool nanorouter_redirect_rule_list_add_rule(nanorouter_redirect_rule_list_t *lis
  */
 void nanorouter_redirect_rule_list_free(nanorouter_redirect_rule_list_t *list);
 
+/**
+ * @brief Builds the lookup index for the selected engine once all rules are loaded.
+ *
+ * Matching results are identical for every engine; only the number of rules
+ * that have to be tried per request changes. Adding a rule afterwards drops
+ * the index and returns the list to NR_REDIRECT_ENGINE_LINEAR.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param engine The engine to use for nanorouter_process_redirect_request.
+ * @return true if the index was built, false otherwise (the list stays on the linear engine).
+ */
+bool nanorouter_redirect_rule_list_compile(nanorouter_redirect_rule_list_t *list, nanorouter_redirect_engine_t engine);
+
+/**
+ * @brief Selects NR_REDIRECT_ENGINE_STATIC_HASH using a table generated by scripts/generate_redirect_mph.py.
+ *
+ * The list must have been loaded from the same _redirects file the table was
+ * generated from; a table that does not describe the list's literal routes is
+ * rejected.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param table The generated table. Must outlive the list or the next compile.
+ * @return true if the index was built, false otherwise (the list stays on the linear engine).
+ */
+bool nanorouter_redirect_rule_list_compile_static(nanorouter_redirect_rule_list_t *list, const nr_redirect_mph_table_t *table);
+
+/**
+ * @brief Makes path matching for a list case-insensitive or case-sensitive (the default).
+ *
+ * Must be called before rules are added: the literal segments of every
+ * from_route are then folded to lowercase once, as the rule is added, and each
+ * request folds its path once into a stack buffer. All engines see folded
+ * bytes on both sides, so lookups cost the same as in case-sensitive mode.
+ * Placeholder and splat values are taken from the request as written, so
+ * to_route receives the original casing.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param case_insensitive true to ignore the casing of from_route literals and request paths.
+ * @return true if the mode was set, false if list is NULL or already holds rules loaded in the other mode.
+ */
+bool nanorouter_redirect_rule_list_set_case_insensitive(nanorouter_redirect_rule_list_t *list, bool case_insensitive);
+
+/**
+ * @brief Puts the list in file order or in specificity order.
+ *
+ * In specificity order, rules naming a host come first, then patterns are
+ * ranked depth by depth (a literal segment beats a placeholder, which beats a
+ * splat, so deeper patterns beat shallower ones), then rules with more query
+ * parameters and conditions, then file order. Every engine follows the list
+ * order, and the trie engine can stop at the first rule it confirms.
+ *
+ * Switching order drops the index like adding a rule does, so compile again
+ * afterwards. Adding a rule returns the list to file order.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param order The order to use.
+ * @param warn Called for every pair of rules that can match the same URL and
+ *             whose winner the new order changes compared with file order. May be NULL.
+ * @param user_data Data passed through to warn.
+ * @return true if the list was reordered, false otherwise (e.g., memory allocation failure; the list is unchanged).
+ */
+bool nanorouter_redirect_rule_list_set_order(
+    nanorouter_redirect_rule_list_t *list,
+    nanorouter_redirect_order_t order,
+    nr_redirect_order_warning_callback_t warn,
+    void *user_data
+);
+
+/**
+ * @brief Follows 200 rewrites through the rules their targets match, once, at load time.
+ *
+ * A rewrite whose target is rewritten again ("/old /new 200" then
+ * "/new /index.html 200") is annotated with where the chain ends: the last
+ * target, with the placeholders of every step written in terms of the first
+ * rule's captures, and the status of the last rule followed (a redirect ends
+ * the chain). Requests then render the final target from the first match
+ * instead of being processed again for every hop.
+ *
+ * A chain is only resolved when each step is decided by the rule path alone.
+ * It is left to be followed at request time when a step depends on the
+ * request: a rule with query parameters or conditions, a host rule, a
+ * placeholder value a later pattern has to test, or more than
+ * NR_MAX_REWRITE_HOPS steps. A target a rule rewrites to itself ends the
+ * chain. Resolution assumes no static file shadows an intermediate target,
+ * so, as when collapsing redirects, a forced ('!') rewrite's chain stops before
+ * unforced rules, and a chain stops before an unforced rule when a forced one
+ * listed below may match the same target.
+ *
+ * Adding a rule or changing the order drops every resolution, so resolve
+ * again once loading is finished.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param on_cycle Called once for every cycle of rewrites. May be NULL. Rules in a cycle stay unresolved.
+ * @param user_data Data passed through to on_cycle.
+ * @return true if the rules were resolved, false otherwise (e.g., memory allocation failure; no rule is resolved).
+ */
+bool nanorouter_redirect_rule_list_resolve_rewrites(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+);
+
+/**
+ * @brief Points redirects straight at the end of their chain, to save the browser a round trip per hop.
+ *
+ * With "/a /b 301" and "/b /c 301", a browser asking for /a comes back for
+ * /b before it is sent to /c. This pass follows each 301, 302, 307 or 308
+ * rule's target through the redirects it matches, the way a browser would,
+ * and rewrites the rule's to_route to the final target, with placeholders
+ * carried through ("/old/:slug /new/:slug 301" then "/new/:page /blog/:page 301"
+ * gives "/old/:slug /blog/:slug"). The status becomes the one a single
+ * redirect needs to do what the chain did: permanent (301, 308) only if every
+ * hop is, method-preserving (307, 308) only if every hop is.
+ *
+ * A chain stops at a target no redirect matches (a 200 rewrite, a 404 or a
+ * page), at another site, and wherever the next rule depends on the request
+ * (query parameters, conditions, host rules, or a placeholder value a later
+ * literal has to be compared with). Rules that redirect back to each other are
+ * left alone and reported. Collapsing assumes no static file shadows an
+ * intermediate target, so a chain only goes through rules both request passes
+ * would pick: a forced ('!') rule's chain stops before unforced rules, and a
+ * chain stops before an unforced rule when a forced one listed below may
+ * answer the same target.
+ *
+ * Call it once the list is loaded and before
+ * nanorouter_redirect_rule_list_resolve_rewrites, whose resolutions it drops.
+ *
+ * @param list A pointer to the nanorouter_redirect_rule_list_t.
+ * @param on_collapse Called for every rule that was rewritten. May be NULL.
+ * @param on_cycle Called once for every cycle of redirects. May be NULL.
+ * @param user_data Data passed through to the callbacks.
+ * @return true if the pass ran, false otherwise (e.g., memory allocation failure; no rule is rewritten).
+ */
+bool nanorouter_redirect_rule_list_collapse_redirects(
+    nanorouter_redirect_rule_list_t *list,
+    nr_redirect_collapse_callback_t on_collapse,
+    nr_redirect_cycle_callback_t on_cycle,
+    void *user_data
+);
+
+// --- Function Prototypes for Redirect File Parsing ---
+
+/**
+ * @brief Parses a _redirects file content and appends every valid rule to a list.
+ *
+ * Empty lines, comments and malformed rules are skipped.
+ *
+ * @param file_content The content of the _redirects file as a string.
+ * @param rule_list A pointer to the nanorouter_redirect_rule_list_t to populate.
+ * @return true if parsing was successful, false otherwise (e.g., memory allocation failure).
+ */
+bool nanorouter_parse_redirects_file(const char *file_content, nanorouter_redirect_rule_list_t *rule_list);
+
 // --- Function Prototype for Middleware ---
 
 /**
@@ -82,4 +359,222 @@ bool nanorouter_process_redirect_request(
     const nanorouter_request_context_t *request_context
 );
 
+/**
+ * @brief Processes a length-delimited request URL against a list of redirect rules.
+ *
+ * For servers whose HTTP parser hands out (pointer, length) slices of its
+ * receive buffer: the URL needs no terminating NUL, is matched in place without
+ * copies, and is not cut at NR_MAX_ROUTE_LEN. Results are the same as
+ * nanorouter_process_redirect_request.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
+/**
+ * @brief Processes many request URLs against a list of redirect rules in one call.
+ *
+ * For cache warming and log replay. Requests are taken NR_REDIRECT_BATCH_SIZE
+ * at a time: every URL of a group is split and the index entry its lookup
+ * starts from is prefetched, then the group is matched. The per-request
+ * scratch is allocated once and reused by every group. Each result is what
+ * nanorouter_process_redirect_request gives for that URL.
+ *
+ * The prefetch only applies to NR_REDIRECT_ENGINE_HASH and
+ * NR_REDIRECT_ENGINE_STATIC_HASH, whose lookups start from a slot picked by
+ * the URL. The other engines start from state every request shares, so for
+ * them the batch saves the per-call setup but overlaps no memory stalls.
+ *
+ * @param urls The request URLs, null-terminated. A NULL entry gets an empty result.
+ * @param num_urls Number of entries in urls, contexts and results.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param contexts Request data for each URL, or NULL to match every URL without one.
+ * @param results Output: one response per URL; status_code is 0 where no rule applied.
+ * @return Number of URLs a redirect rule was applied to.
+ */
+size_t nanorouter_process_redirect_batch(
+    const char *const *urls,
+    size_t num_urls,
+    nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *contexts,
+    nanorouter_redirect_response_t *results
+);
+
+/**
+ * @brief Processes a request URL against a list of redirect rules, through a decision cache.
+ *
+ * The response for a URL and request context is decided once and then served
+ * from the cache until the rules change. Safe to call from many threads at
+ * once with the same cache, as long as no thread changes the rules meanwhile.
+ * Results are the same as nanorouter_process_redirect_request.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @param cache The cache to use, or NULL to decide every request afresh. Requests
+ *        whose key is over NR_DECISION_CACHE_KEY_LEN always are.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_cached(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context,
+    nr_decision_cache_t *cache
+);
+
+/**
+ * @brief Processes a request URL that was already split by nr_parse_url against a list of redirect rules.
+ *
+ * Lets a server parse the URL once and share it between the redirect and
+ * header middleware. Results are the same as nanorouter_process_redirect_request.
+ *
+ * @param parsed_url The request URL, split by nr_parse_url. Its path pointer must be the full URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_parsed(
+    const nr_parsed_url_t *parsed_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
+/**
+ * @brief Processes a request shared with the header middleware against a list of redirect rules.
+ *
+ * The request's query pairs and language tags are split by the first rule that
+ * needs them and reused by every later rule, here and in
+ * nanorouter_process_header_request_shared. Results are the same as
+ * nanorouter_process_redirect_request.
+ *
+ * @param request The request, created with nr_request_init (its context is used for conditions).
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @return true if a redirect rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_shared(
+    nr_request_t *request,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context
+);
+
+/**
+ * @brief Finds the rule for a length-delimited request URL without rendering its target.
+ *
+ * Picks the same rule as nanorouter_process_redirect_request_n. The target is
+ * then rendered at full length with nanorouter_redirect_match_render or
+ * nanorouter_redirect_match_iovec, instead of being cut at
+ * NR_REDIRECT_MAX_URL_LEN in new_url.
+ *
+ * @param request_url The incoming URL, not necessarily null-terminated. Must outlive match.
+ * @param request_url_len Length of request_url.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @param match Output: the winning rule and its captures.
+ * @return true if a rule matched, false otherwise.
+ */
+bool nanorouter_match_redirect_request_n(
+    const char *request_url,
+    size_t request_url_len,
+    nanorouter_redirect_rule_list_t *rules,
+    const nanorouter_request_context_t *request_context,
+    nanorouter_redirect_match_t *match
+);
+
+/**
+ * @brief Finds the rule for a request shared with the header middleware without rendering its target.
+ *
+ * @param request The request, created with nr_request_init. Its URL must outlive match.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param match Output: the winning rule and its captures.
+ * @return true if a rule matched, false otherwise.
+ */
+bool nanorouter_match_redirect_request_shared(
+    nr_request_t *request,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_match_t *match
+);
+
+/**
+ * @brief Renders a matched rule's target (to_route with captures and passed-through query) into a buffer.
+ *
+ * Works like snprintf: the return value is the full length, so a call with
+ * buffer_size 0 sizes the buffer for a second call.
+ *
+ * @param match A match filled by nanorouter_match_redirect_request_n or _shared.
+ * @param buffer Output buffer. May be NULL when buffer_size is 0.
+ * @param buffer_size Size of buffer, including the terminator. Output is cut at buffer_size - 1 bytes and null-terminated.
+ * @return The length of the full target, without the terminator.
+ */
+size_t nanorouter_redirect_match_render(const nanorouter_redirect_match_t *match, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Describes a matched rule's target as pieces of the rule and the request URL, without copying.
+ *
+ * Literal pieces point into the rule's to_route (or its resolved rewrite
+ * target), captured values and passed-through query pairs into the request
+ * URL. Nothing is truncated.
+ *
+ * @param match A match filled by nanorouter_match_redirect_request_n or _shared.
+ * @param iov Output array. May be NULL when max_iov is 0.
+ * @param max_iov Number of entries in iov. Pieces past it are counted but not stored.
+ * @return The number of pieces in the full target.
+ */
+size_t nanorouter_redirect_match_iovec(const nanorouter_redirect_match_t *match, nr_iovec_t *iov, size_t max_iov);
+
+/**
+ * @brief Pre-filesystem pass: processes a request URL against the forced ('!') rules only.
+ *
+ * Forced rules apply whether or not a static file exists at the path, so a
+ * server can run this pass before its file lookup. Forced rules are kept apart
+ * when the list is loaded, so the pass never evaluates the other rules.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if a forced rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_forced(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
+/**
+ * @brief Fallback pass: processes a request URL against the rules without '!' only.
+ *
+ * Run this pass when the forced pass did not apply and no static file exists
+ * at the path. Because forced rules have already been evaluated by then, a
+ * forced rule wins over an earlier unforced rule that matches the same URL.
+ *
+ * @param request_url The incoming URL string.
+ * @param rules The nanorouter_redirect_rule_list_t containing all loaded redirect rules.
+ * @param response_context A pointer to a nanorouter_redirect_response_t structure to be populated.
+ * @param request_context Request data used to evaluate rule conditions.
+ * @return true if an unforced rule was applied and response_context was updated, false otherwise.
+ */
+bool nanorouter_process_redirect_request_fallback(
+    const char *request_url,
+    nanorouter_redirect_rule_list_t *rules,
+    nanorouter_redirect_response_t *response_context,
+    const nanorouter_request_context_t *request_context
+);
+
 #endif // NANOROUTER_REDIRECT_MIDDLEWARE_H
@@ -0,0 +1,21 @@
+#include "nanorouter_redirect_mph.h"
+#include "nanorouter_string_utils.h" // For nr_hash_bytes and nr_hash_bytes_seeded
+#include <string.h> // For memcmp
+
+uint32_t nr_redirect_mph_slot(const nr_redirect_mph_table_t *table, const char *key, size_t key_len) {
+    uint32_t bucket = nr_hash_bytes(key, key_len) % table->num_buckets;
+    return nr_hash_bytes_seeded(key, key_len, table->seeds[bucket]) % table->num_entries;
+}
+
+const nr_redirect_mph_entry_t* nr_redirect_mph_lookup(const nr_redirect_mph_table_t *table, const char *key, size_t key_len) {
+    if (table == NULL || key == NULL || table->num_entries == 0 || table->num_buckets == 0) {
+        return NULL;
+    }
+
+    // A perfect hash places every known key in its own slot, so a single compare decides
+    const nr_redirect_mph_entry_t *entry = &table->entries[nr_redirect_mph_slot(table, key, key_len)];
+    if (entry->key_len != key_len || (key_len > 0 && memcmp(entry->key, key, key_len) != 0)) {
+        return NULL;
+    }
+    return entry;
+}
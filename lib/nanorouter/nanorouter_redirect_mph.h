@@ -0,0 +1,67 @@
+#ifndef NANOROUTER_REDIRECT_MPH_H
+#define NANOROUTER_REDIRECT_MPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Struct Definitions ---
+
+/**
+ * @brief One literal route in a generated perfect-hash table.
+ */
+typedef struct {
+    const char *key;        /**< Route path without the leading slash, e.g. "blog/old-post". */
+    uint16_t key_len;       /**< Length of key. */
+    uint16_t first_rule;    /**< Offset of this key's rule indexes in rule_indices. */
+    uint16_t num_rules;     /**< Number of rules sharing this path. */
+} nr_redirect_mph_entry_t;
+
+/**
+ * @brief Minimal perfect hash over the literal routes of a fixed _redirects file.
+ *
+ * Generated offline by scripts/generate_redirect_mph.py (hash and displace).
+ * A key is first hashed into a bucket, and the bucket's seed places it in one
+ * of num_entries slots with no collisions and no empty slots. All arrays are
+ * `const` so the table can stay in flash.
+ *
+ * The generator has its own copies of nr_parse_redirect_rule (which lines
+ * are rules), nr_compile_route_pattern (which routes are literal and their
+ * keys) and nr_hash_bytes_seeded. A change to any of them must be made in
+ * the script too; CI regenerates test_redirect_mph_table.c with --check to
+ * catch drift, and nanorouter_redirect_rule_list_compile_static rejects a
+ * table whose rule count no longer matches.
+ */
+typedef struct {
+    const uint32_t *seeds;                  /**< Displacement seed per bucket. */
+    uint32_t num_buckets;
+    const nr_redirect_mph_entry_t *entries; /**< One slot per distinct literal path. */
+    uint32_t num_entries;
+    const uint16_t *rule_indices;           /**< Rule positions in the file, grouped per entry in ascending order. */
+    uint32_t num_rule_indices;
+    uint32_t num_rules;                     /**< Number of valid rules in the source file. */
+} nr_redirect_mph_table_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Computes the slot a key hashes to in a perfect-hash table.
+ *
+ * @param table The generated table. Must have at least one entry.
+ * @param key The route path without the leading slash (not null-terminated).
+ * @param key_len Length of key.
+ * @return The slot index, in the range [0, num_entries).
+ */
+uint32_t nr_redirect_mph_slot(const nr_redirect_mph_table_t *table, const char *key, size_t key_len);
+
+/**
+ * @brief Looks up a literal route with a single table probe.
+ *
+ * @param table The generated table.
+ * @param key The route path without the leading slash (not null-terminated).
+ * @param key_len Length of key.
+ * @return The matching entry, or NULL if the path is not in the table.
+ */
+const nr_redirect_mph_entry_t* nr_redirect_mph_lookup(const nr_redirect_mph_table_t *table, const char *key, size_t key_len);
+
+#endif // NANOROUTER_REDIRECT_MPH_H
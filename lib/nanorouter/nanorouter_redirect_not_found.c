@@ -0,0 +1,126 @@
+#include "nanorouter_redirect_not_found.h"
+#include "nanorouter_redirect_host.h" // For nr_redirect_route_split_host
+#include "nanorouter_slot_table.h" // For nr_slot_table_t
+#include <stdlib.h> // For calloc, free
+
+#define NR_NOT_FOUND_PREFIX_SEED 2166136261u
+
+struct nr_redirect_not_found_map_t {
+    nr_slot_table_t table;                      // (depth, prefix hash) -> rules, in list order; the key is the depth
+    uint8_t max_depth;                          // Deepest prefix filed; requests stop probing there
+};
+
+// Extends a prefix hash by one segment, from the segment's own nr_hash_bytes.
+static inline uint32_t nr_not_found_prefix_step(uint32_t hash, uint32_t segment_hash) {
+    return (hash ^ segment_hash) * 16777619u;
+}
+
+bool nr_redirect_rule_is_not_found_prefix(const nanorouter_redirect_rule_t *node) {
+    if (node == NULL || node->rule.status_code != 404 || nr_redirect_route_split_host(node->rule.from_route, NULL, NULL, NULL, NULL)) {
+        return false;
+    }
+    const nr_route_program_t *program = &node->program;
+    if (program->num_ops == 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i + 1 < program->num_ops; i++) {
+        if (program->ops[i].opcode != NR_ROUTE_OP_LITERAL) {
+            return false;
+        }
+    }
+    uint8_t last = program->ops[program->num_ops - 1].opcode;
+    return last == NR_ROUTE_OP_SPLAT || last == NR_ROUTE_OP_ANY;
+}
+
+nr_redirect_not_found_map_t* nr_redirect_not_found_map_create(void) {
+    nr_redirect_not_found_map_t *map = (nr_redirect_not_found_map_t*) calloc(1, sizeof(nr_redirect_not_found_map_t));
+    if (map == NULL) {
+        return NULL;
+    }
+    // A prefix is told apart by its hash and depth alone: a collision only files two prefixes together, and every rule is confirmed in full
+    if (!nr_slot_table_init(&map->table, NR_SLOT_KEYS_HASHED, sizeof(const nanorouter_redirect_rule_t*))) {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+// Hashes the literal prefix of a rule that passes nr_redirect_rule_is_not_found_prefix.
+static uint32_t nr_not_found_rule_prefix(const nanorouter_redirect_rule_t *node, uint8_t *depth) {
+    // Every op before the splat is a literal, whose hash the compiler already took
+    const nr_route_program_t *program = &node->program;
+    *depth = (uint8_t)(program->num_ops - 1);
+    uint32_t hash = NR_NOT_FOUND_PREFIX_SEED;
+    for (uint8_t i = 0; i < *depth; i++) {
+        hash = nr_not_found_prefix_step(hash, program->ops[i].hash);
+    }
+    return hash;
+}
+
+bool nr_redirect_not_found_map_add(nr_redirect_not_found_map_t *map, const nanorouter_redirect_rule_t *node) {
+    if (map == NULL || !nr_redirect_rule_is_not_found_prefix(node)) {
+        return false;
+    }
+
+    uint8_t depth;
+    uint32_t hash = nr_not_found_rule_prefix(node, &depth);
+    const nanorouter_redirect_rule_t **value = (const nanorouter_redirect_rule_t**) nr_slot_table_append(&map->table, NULL, depth, hash);
+    if (value == NULL) {
+        return false;
+    }
+    *value = node;
+    if (depth > map->max_depth) {
+        map->max_depth = depth;
+    }
+    return true;
+}
+
+bool nr_redirect_not_found_map_remove_last(nr_redirect_not_found_map_t *map, const nanorouter_redirect_rule_t *node) {
+    if (map == NULL || !nr_redirect_rule_is_not_found_prefix(node)) {
+        return false;
+    }
+
+    uint8_t depth;
+    uint32_t hash = nr_not_found_rule_prefix(node, &depth);
+    return nr_slot_table_remove_last(&map->table, NULL, depth, hash, node);
+}
+
+void nr_redirect_not_found_map_free(nr_redirect_not_found_map_t *map) {
+    if (map == NULL) {
+        return;
+    }
+    nr_slot_table_free(&map->table);
+    free(map);
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_not_found_map_find(
+    const nr_redirect_not_found_map_t *map,
+    const nr_parsed_url_t *parsed_url,
+    uint32_t below_index,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (map == NULL || map->table.num_keys == 0 || parsed_url == NULL || confirm == NULL) {
+        return NULL;
+    }
+
+    // Every prefix of the path is probed, shallowest first; a deeper rule only wins if it comes earlier in the list
+    const nanorouter_redirect_rule_t *winner = NULL;
+    uint32_t hash = NR_NOT_FOUND_PREFIX_SEED;
+    for (uint8_t depth = 0; ; depth++) {
+        const nr_slot_t *slot = nr_slot_table_find(&map->table, NULL, depth, hash);
+        const nanorouter_redirect_rule_t *const *rules = slot != NULL ? (const nanorouter_redirect_rule_t *const *) slot->values : NULL;
+        for (size_t i = 0; rules != NULL && i < slot->num_values && rules[i]->index < below_index; i++) {
+            if (confirm(rules[i], user_data)) {
+                winner = rules[i];
+                below_index = winner->index;
+                break;
+            }
+        }
+        if (depth >= map->max_depth || depth >= parsed_url->num_segments) {
+            break;
+        }
+        hash = nr_not_found_prefix_step(hash, parsed_url->segments[depth].hash);
+    }
+    return winner;
+}
@@ -0,0 +1,90 @@
+#ifndef NANOROUTER_REDIRECT_NOT_FOUND_H
+#define NANOROUTER_REDIRECT_NOT_FOUND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_t and nr_redirect_confirm_callback_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque map of 404 rules scoped to a path prefix, keyed by that literal prefix.
+ *
+ * A prefix is keyed by its depth and a hash of its segment hashes, so a
+ * request probes one slot per segment of its path. Each prefix keeps its
+ * rules in list order. Built on nr_slot_table_t.
+ */
+typedef struct nr_redirect_not_found_map_t nr_redirect_not_found_map_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Checks whether a rule belongs in a not-found map.
+ *
+ * That is a 404 path rule whose from_route is literal segments followed by a
+ * splat ("/docs/:rest"), or the root splat alone.
+ *
+ * @param node The rule node, with its from_route compiled.
+ * @return true if the rule can be filed by prefix, false otherwise.
+ */
+bool nr_redirect_rule_is_not_found_prefix(const nanorouter_redirect_rule_t *node);
+
+/**
+ * @brief Creates an empty not-found map.
+ *
+ * @return A pointer to the new map, or NULL on allocation failure.
+ */
+nr_redirect_not_found_map_t* nr_redirect_not_found_map_create(void);
+
+/**
+ * @brief Files a rule under the literal prefix of its from_route.
+ *
+ * Rules must be added in list order. The map only references the node, so
+ * the node must outlive the map.
+ *
+ * @param map The not-found map.
+ * @param node The rule node; must pass nr_redirect_rule_is_not_found_prefix.
+ * @return true if the rule was added, false on allocation failure or if the rule has no such prefix.
+ */
+bool nr_redirect_not_found_map_add(nr_redirect_not_found_map_t *map, const nanorouter_redirect_rule_t *node);
+
+/**
+ * @brief Takes back the rule most recently filed with nr_redirect_not_found_map_add.
+ *
+ * See nr_slot_table_remove_last.
+ *
+ * @param map The not-found map.
+ * @param node The rule node last added.
+ * @return true if the rule was removed, false if it is not the last rule filed under its prefix.
+ */
+bool nr_redirect_not_found_map_remove_last(nr_redirect_not_found_map_t *map, const nanorouter_redirect_rule_t *node);
+
+/**
+ * @brief Frees a not-found map created with nr_redirect_not_found_map_create.
+ *
+ * @param map The map to free. May be NULL.
+ */
+void nr_redirect_not_found_map_free(nr_redirect_not_found_map_t *map);
+
+/**
+ * @brief Finds the first filed rule that applies to a request, probing one slot per prefix of its path.
+ *
+ * @param map The not-found map. May be NULL.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param below_index Only rules placed before this index are looked at.
+ * @param confirm Does the full check of a candidate (path, query and conditions).
+ * @param user_data Data passed through to confirm.
+ * @return The confirmed rule with the lowest index, or NULL if none applies.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_not_found_map_find(
+    const nr_redirect_not_found_map_t *map,
+    const nr_parsed_url_t *parsed_url,
+    uint32_t below_index,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+#endif // NANOROUTER_REDIRECT_NOT_FOUND_H
@@ -0,0 +1,209 @@
+#include "nanorouter_redirect_prefilter.h"
+#include <stdlib.h> // For malloc, free
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NR_PREFILTER_KERNEL "avx2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NR_PREFILTER_KERNEL "sse2"
+#else
+#define NR_PREFILTER_KERNEL "scalar"
+#endif
+
+#define NR_PREFILTER_LANES 8    // Rules compared per block; one AVX2 register of 32-bit lanes
+#define NR_PREFILTER_NO_LIMIT INT32_MAX
+
+struct nr_redirect_prefilter_t {
+    const nanorouter_redirect_rule_t **rules;   // Rule nodes by index
+    size_t num_rules;
+    size_t num_blocks;
+    // Parallel arrays, padded to num_blocks * NR_PREFILTER_LANES lanes
+    int32_t *first_hash;        // Hash of the first literal segment
+    int32_t *first_wildcard;    // -1 when the first segment accepts anything, 0 otherwise
+    int32_t *min_segments;      // Fewest URL segments the rule can match
+    int32_t *max_segments;      // Most URL segments the rule can match
+};
+
+// Fills one lane from a rule's compiled route program. Padding lanes use min > max and never survive.
+static void nr_prefilter_set_lane(nr_redirect_prefilter_t *prefilter, size_t lane, const nanorouter_redirect_rule_t *node) {
+    const nr_route_program_t *program = &node->program;
+    const nr_route_op_t *first = &program->ops[0];
+
+    prefilter->first_hash[lane] = 0;
+    prefilter->first_wildcard[lane] = -1;
+    prefilter->min_segments[lane] = 1;
+    prefilter->max_segments[lane] = 0;
+
+    if (first->opcode == NR_ROUTE_OP_FAIL) {
+        return; // Never matches
+    }
+    if (first->opcode == NR_ROUTE_OP_ANY) {
+        prefilter->min_segments[lane] = 0;
+        prefilter->max_segments[lane] = NR_PREFILTER_NO_LIMIT;
+        return;
+    }
+    if (first->opcode == NR_ROUTE_OP_LITERAL) {
+        prefilter->first_hash[lane] = (int32_t) first->hash;
+        prefilter->first_wildcard[lane] = 0;
+    }
+
+    // Op i consumes segment i, so the terminating op gives the segment count
+    for (uint8_t i = 0; i < program->num_ops; i++) {
+        if (program->ops[i].opcode == NR_ROUTE_OP_END) {
+            prefilter->min_segments[lane] = i;
+            prefilter->max_segments[lane] = i;
+            return;
+        }
+        if (program->ops[i].opcode == NR_ROUTE_OP_SPLAT || program->ops[i].opcode == NR_ROUTE_OP_SUFFIX) {
+            prefilter->min_segments[lane] = i + 1;
+            prefilter->max_segments[lane] = NR_PREFILTER_NO_LIMIT;
+            return;
+        }
+    }
+}
+
+nr_redirect_prefilter_t* nr_redirect_prefilter_build(const nanorouter_redirect_rule_list_t *list) {
+    if (list == NULL) {
+        return NULL;
+    }
+
+    nr_redirect_prefilter_t *prefilter = (nr_redirect_prefilter_t*) calloc(1, sizeof(nr_redirect_prefilter_t));
+    if (prefilter == NULL) {
+        return NULL;
+    }
+
+    prefilter->num_blocks = (list->count + NR_PREFILTER_LANES - 1) / NR_PREFILTER_LANES;
+    size_t num_lanes = (prefilter->num_blocks > 0 ? prefilter->num_blocks : 1) * NR_PREFILTER_LANES;
+    prefilter->rules = (const nanorouter_redirect_rule_t**) malloc(num_lanes * sizeof(nanorouter_redirect_rule_t*));
+    prefilter->first_hash = (int32_t*) malloc(num_lanes * sizeof(int32_t));
+    prefilter->first_wildcard = (int32_t*) malloc(num_lanes * sizeof(int32_t));
+    prefilter->min_segments = (int32_t*) malloc(num_lanes * sizeof(int32_t));
+    prefilter->max_segments = (int32_t*) malloc(num_lanes * sizeof(int32_t));
+    if (prefilter->rules == NULL || prefilter->first_hash == NULL || prefilter->first_wildcard == NULL ||
+        prefilter->min_segments == NULL || prefilter->max_segments == NULL) {
+        nr_redirect_prefilter_free(prefilter);
+        return NULL;
+    }
+
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next) {
+        prefilter->rules[prefilter->num_rules] = current;
+        nr_prefilter_set_lane(prefilter, prefilter->num_rules, current);
+        prefilter->num_rules++;
+    }
+    for (size_t lane = prefilter->num_rules; lane < num_lanes; lane++) {
+        prefilter->rules[lane] = NULL;
+        prefilter->first_hash[lane] = 0;
+        prefilter->first_wildcard[lane] = 0;
+        prefilter->min_segments[lane] = 1;
+        prefilter->max_segments[lane] = 0;
+    }
+
+    return prefilter;
+}
+
+void nr_redirect_prefilter_free(nr_redirect_prefilter_t *prefilter) {
+    if (prefilter == NULL) {
+        return;
+    }
+    free(prefilter->rules);
+    free(prefilter->first_hash);
+    free(prefilter->first_wildcard);
+    free(prefilter->min_segments);
+    free(prefilter->max_segments);
+    free(prefilter);
+}
+
+const char* nr_redirect_prefilter_kernel(void) {
+    return NR_PREFILTER_KERNEL;
+}
+
+/**
+ * @brief Compares one block of rules against the request.
+ *
+ * A lane survives when its first segment matches (same hash or wildcard) and
+ * the URL's segment count is within the lane's range.
+ *
+ * @return A bit mask of the surviving lanes, lane 0 in bit 0.
+ */
+static uint32_t nr_prefilter_block_mask(const nr_redirect_prefilter_t *prefilter, size_t base, int32_t hash, int32_t count) {
+#if defined(__AVX2__)
+    __m256i hash_v = _mm256_set1_epi32(hash);
+    __m256i count_v = _mm256_set1_epi32(count);
+    __m256i first = _mm256_or_si256(
+        _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) &prefilter->first_hash[base]), hash_v),
+        _mm256_loadu_si256((const __m256i*) &prefilter->first_wildcard[base]));
+    __m256i out_of_range = _mm256_or_si256(
+        _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*) &prefilter->min_segments[base]), count_v),
+        _mm256_cmpgt_epi32(count_v, _mm256_loadu_si256((const __m256i*) &prefilter->max_segments[base])));
+    return (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(out_of_range, first)));
+#elif defined(__SSE2__)
+    __m128i hash_v = _mm_set1_epi32(hash);
+    __m128i count_v = _mm_set1_epi32(count);
+    uint32_t mask = 0;
+    for (size_t half = 0; half < NR_PREFILTER_LANES; half += 4) {
+        size_t lane = base + half;
+        __m128i first = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) &prefilter->first_hash[lane]), hash_v),
+            _mm_loadu_si128((const __m128i*) &prefilter->first_wildcard[lane]));
+        __m128i out_of_range = _mm_or_si128(
+            _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*) &prefilter->min_segments[lane]), count_v),
+            _mm_cmpgt_epi32(count_v, _mm_loadu_si128((const __m128i*) &prefilter->max_segments[lane])));
+        mask |= (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(out_of_range, first))) << half;
+    }
+    return mask;
+#else
+    // Portable fallback; a NEON kernel would slot in here with the same lane layout
+    uint32_t mask = 0;
+    for (size_t i = 0; i < NR_PREFILTER_LANES; i++) {
+        size_t lane = base + i;
+        bool first = prefilter->first_wildcard[lane] != 0 || prefilter->first_hash[lane] == hash;
+        bool in_range = prefilter->min_segments[lane] <= count && count <= prefilter->max_segments[lane];
+        if (first && in_range) {
+            mask |= (uint32_t)1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_prefilter_find(
+    const nr_redirect_prefilter_t *prefilter,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (prefilter == NULL || parsed_url == NULL || confirm == NULL) {
+        return NULL;
+    }
+
+    if (parsed_url->too_many_segments) {
+        // Too deep to count, fall back to trying every rule in order
+        for (size_t i = 0; i < prefilter->num_rules; i++) {
+            if (confirm(prefilter->rules[i], user_data)) {
+                return prefilter->rules[i];
+            }
+        }
+        return NULL;
+    }
+
+    int32_t hash = 0;
+    if (parsed_url->num_segments > 0) {
+        hash = (int32_t) parsed_url->segments[0].hash;
+    }
+    int32_t count = parsed_url->num_segments;
+
+    for (size_t block = 0; block < prefilter->num_blocks; block++) {
+        size_t base = block * NR_PREFILTER_LANES;
+        uint32_t mask = nr_prefilter_block_mask(prefilter, base, hash, count);
+        // Lowest lane first keeps file order
+        while (mask != 0) {
+            size_t lane = base + (size_t)__builtin_ctz(mask);
+            mask &= mask - 1;
+            if (confirm(prefilter->rules[lane], user_data)) {
+                return prefilter->rules[lane];
+            }
+        }
+    }
+    return NULL;
+}
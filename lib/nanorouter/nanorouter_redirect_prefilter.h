@@ -0,0 +1,68 @@
+#ifndef NANOROUTER_REDIRECT_PREFILTER_H
+#define NANOROUTER_REDIRECT_PREFILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and nr_redirect_confirm_callback_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque structure-of-arrays prefilter built from a redirect rule list.
+ *
+ * Each rule contributes one lane to parallel arrays: the hash of its first
+ * literal segment (or a wildcard flag when the first segment is a placeholder
+ * or splat) and the range of URL segment counts it can match. A request's
+ * first-segment hash and segment count are compared against a block of rules
+ * at once, with SSE2 or AVX2 when the target supports them and a scalar loop
+ * otherwise. Only surviving rules are confirmed.
+ */
+typedef struct nr_redirect_prefilter_t nr_redirect_prefilter_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds the prefilter over all rules currently stored in a list.
+ *
+ * The prefilter only references the list nodes, so the list must outlive it
+ * and must not be modified while it is in use.
+ *
+ * @param list The rule list to index.
+ * @return A pointer to the newly built prefilter, or NULL on allocation failure.
+ */
+nr_redirect_prefilter_t* nr_redirect_prefilter_build(const nanorouter_redirect_rule_list_t *list);
+
+/**
+ * @brief Frees a prefilter built with nr_redirect_prefilter_build.
+ *
+ * @param prefilter The prefilter to free. May be NULL.
+ */
+void nr_redirect_prefilter_free(nr_redirect_prefilter_t *prefilter);
+
+/**
+ * @brief Returns the name of the compare kernel selected at build time.
+ *
+ * @return "avx2", "sse2" or "scalar".
+ */
+const char* nr_redirect_prefilter_kernel(void);
+
+/**
+ * @brief Finds the lowest-index rule that survives the prefilter and passes confirmation.
+ *
+ * @param prefilter The prefilter to search.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm Callback that performs the full rule check for a candidate.
+ * @param user_data Data passed through to the confirm callback.
+ * @return The winning rule node, or NULL if no rule matches.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_prefilter_find(
+    const nr_redirect_prefilter_t *prefilter,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+#endif // NANOROUTER_REDIRECT_PREFILTER_H
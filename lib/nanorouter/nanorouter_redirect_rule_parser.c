@@ -245,6 +245,7 @@ static void nr_redirect_rule_parser_callback(
 }
 
 // --- Implementation of nr_parse_redirect_rule ---
+// scripts/generate_redirect_mph.py mirrors which lines this accepts (parse_redirect_line) and must be kept in sync.
 bool nr_parse_redirect_rule(
     const char *rule_line,
     size_t rule_line_len,
@@ -0,0 +1,341 @@
+#include "nanorouter_redirect_trie.h"
+#include <stdlib.h> // For malloc, calloc, realloc, free
+#include <string.h> // For memcpy, memcmp, memmove
+
+// Reference from a trie node to a rule in the list, with its original position.
+typedef struct {
+    const nanorouter_redirect_rule_t *node;
+    uint32_t index;
+} nr_trie_rule_ref_t;
+
+// Growable array of rule references, kept in ascending index order.
+typedef struct {
+    nr_trie_rule_ref_t *items;
+    size_t count;
+    size_t capacity;
+} nr_trie_rule_refs_t;
+
+typedef struct nr_trie_node_t {
+    char *segment;                       // Literal segment this node was reached by (not null-terminated)
+    size_t segment_len;
+    struct nr_trie_node_t **children;    // Literal children, sorted by (length, bytes)
+    size_t num_children;
+    size_t children_capacity;
+    struct nr_trie_node_t *param_child;  // Shared child for ':placeholder' segments
+    nr_trie_rule_refs_t terminal_rules;  // Rules whose pattern ends at this node
+    nr_trie_rule_refs_t splat_rules;     // Rules with a trailing splat hanging off this node
+    uint32_t min_index;                  // Lowest rule index stored in this subtree
+} nr_trie_node_t;
+
+struct nr_redirect_trie_t {
+    nr_trie_node_t *root;
+    nr_trie_rule_refs_t catch_all_rules; // "/*" rules, which also match "/"
+    nr_trie_rule_refs_t all_rules;       // Every rule, for URLs too deep to segment
+    bool most_specific_first;            // Built from a list in specificity order
+};
+
+// State carried through a lookup.
+typedef struct {
+    nr_redirect_confirm_callback_t confirm;
+    void *user_data;
+    uint32_t best_index;
+    const nanorouter_redirect_rule_t *best_node;
+} nr_trie_search_t;
+
+static bool nr_trie_refs_push(nr_trie_rule_refs_t *refs, const nanorouter_redirect_rule_t *node, uint32_t index) {
+    if (refs->count >= refs->capacity) {
+        size_t new_capacity = refs->capacity == 0 ? 2 : refs->capacity * 2;
+        nr_trie_rule_ref_t *items = (nr_trie_rule_ref_t*) realloc(refs->items, new_capacity * sizeof(nr_trie_rule_ref_t));
+        if (items == NULL) {
+            return false;
+        }
+        refs->items = items;
+        refs->capacity = new_capacity;
+    }
+    refs->items[refs->count].node = node;
+    refs->items[refs->count].index = index;
+    refs->count++;
+    return true;
+}
+
+static nr_trie_node_t* nr_trie_node_create(const char *segment, size_t segment_len) {
+    nr_trie_node_t *node = (nr_trie_node_t*) calloc(1, sizeof(nr_trie_node_t));
+    if (node == NULL) {
+        return NULL;
+    }
+    if (segment_len > 0) {
+        node->segment = (char*) malloc(segment_len);
+        if (node->segment == NULL) {
+            free(node);
+            return NULL;
+        }
+        memcpy(node->segment, segment, segment_len);
+    }
+    node->segment_len = segment_len;
+    node->min_index = UINT32_MAX;
+    return node;
+}
+
+static void nr_trie_node_free(nr_trie_node_t *node) {
+    if (node == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < node->num_children; i++) {
+        nr_trie_node_free(node->children[i]);
+    }
+    nr_trie_node_free(node->param_child);
+    free(node->children);
+    free(node->terminal_rules.items);
+    free(node->splat_rules.items);
+    free(node->segment);
+    free(node);
+}
+
+// Orders literal children by length first, then by bytes.
+static int nr_trie_segment_compare(const char *a, size_t a_len, const char *b, size_t b_len) {
+    if (a_len != b_len) {
+        return a_len < b_len ? -1 : 1;
+    }
+    return a_len == 0 ? 0 : memcmp(a, b, a_len);
+}
+
+// Binary search for a literal child; on a miss, *insert_pos receives where it belongs.
+static nr_trie_node_t* nr_trie_find_child(const nr_trie_node_t *node, const char *segment, size_t segment_len, size_t *insert_pos) {
+    size_t low = 0;
+    size_t high = node->num_children;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const nr_trie_node_t *child = node->children[mid];
+        int cmp = nr_trie_segment_compare(segment, segment_len, child->segment, child->segment_len);
+        if (cmp == 0) {
+            return node->children[mid];
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    if (insert_pos != NULL) {
+        *insert_pos = low;
+    }
+    return NULL;
+}
+
+static nr_trie_node_t* nr_trie_get_or_add_child(nr_trie_node_t *node, const char *segment, size_t segment_len) {
+    size_t insert_pos = 0;
+    nr_trie_node_t *child = nr_trie_find_child(node, segment, segment_len, &insert_pos);
+    if (child != NULL) {
+        return child;
+    }
+
+    if (node->num_children >= node->children_capacity) {
+        size_t new_capacity = node->children_capacity == 0 ? 4 : node->children_capacity * 2;
+        nr_trie_node_t **children = (nr_trie_node_t**) realloc(node->children, new_capacity * sizeof(nr_trie_node_t*));
+        if (children == NULL) {
+            return NULL;
+        }
+        node->children = children;
+        node->children_capacity = new_capacity;
+    }
+
+    child = nr_trie_node_create(segment, segment_len);
+    if (child == NULL) {
+        return NULL;
+    }
+    memmove(&node->children[insert_pos + 1], &node->children[insert_pos], (node->num_children - insert_pos) * sizeof(nr_trie_node_t*));
+    node->children[insert_pos] = child;
+    node->num_children++;
+    return child;
+}
+
+/**
+ * @brief Inserts a single rule into the trie, following its compiled route program.
+ *
+ * Rules whose program can never match are left out of the trie.
+ */
+static bool nr_trie_insert(nr_redirect_trie_t *trie, const nanorouter_redirect_rule_t *rule_node, uint32_t index) {
+    const nr_route_program_t *program = &rule_node->program;
+    nr_trie_node_t *current = trie->root;
+
+    for (uint8_t i = 0; i < program->num_ops; i++) {
+        const nr_route_op_t *op = &program->ops[i];
+
+        if (op->opcode == NR_ROUTE_OP_ANY) {
+            return nr_trie_refs_push(&trie->catch_all_rules, rule_node, index);
+        }
+        if (op->opcode == NR_ROUTE_OP_FAIL) {
+            return true; // Never matches, nothing to index
+        }
+
+        if (index < current->min_index) {
+            current->min_index = index;
+        }
+
+        switch (op->opcode) {
+            case NR_ROUTE_OP_SPLAT:
+            case NR_ROUTE_OP_SUFFIX: // Filed as a splat; the suffix is checked when the rule is confirmed
+                return nr_trie_refs_push(&current->splat_rules, rule_node, index);
+            case NR_ROUTE_OP_END:
+                return nr_trie_refs_push(&current->terminal_rules, rule_node, index);
+            case NR_ROUTE_OP_PARAM:
+                if (current->param_child == NULL) {
+                    current->param_child = nr_trie_node_create(NULL, 0);
+                    if (current->param_child == NULL) {
+                        return false;
+                    }
+                }
+                current = current->param_child;
+                break;
+            default: // NR_ROUTE_OP_LITERAL
+                current = nr_trie_get_or_add_child(current, rule_node->rule.from_route + op->offset, op->len);
+                if (current == NULL) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+nr_redirect_trie_t* nr_redirect_trie_build(const nanorouter_redirect_rule_list_t *list) {
+    if (list == NULL) {
+        return NULL;
+    }
+
+    nr_redirect_trie_t *trie = (nr_redirect_trie_t*) calloc(1, sizeof(nr_redirect_trie_t));
+    if (trie == NULL) {
+        return NULL;
+    }
+    trie->root = nr_trie_node_create(NULL, 0);
+    if (trie->root == NULL) {
+        free(trie);
+        return NULL;
+    }
+
+    trie->most_specific_first = list->order == NR_REDIRECT_ORDER_SPECIFICITY;
+
+    uint32_t index = 0;
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next, index++) {
+        if (!nr_trie_refs_push(&trie->all_rules, current, index) || !nr_trie_insert(trie, current, index)) {
+            nr_redirect_trie_free(trie);
+            return NULL;
+        }
+    }
+
+    return trie;
+}
+
+void nr_redirect_trie_free(nr_redirect_trie_t *trie) {
+    if (trie == NULL) {
+        return;
+    }
+    nr_trie_node_free(trie->root);
+    free(trie->catch_all_rules.items);
+    free(trie->all_rules.items);
+    free(trie);
+}
+
+// Confirms candidates in index order, stopping at the first one that matches or can no longer win.
+static void nr_trie_check_refs(const nr_trie_rule_refs_t *refs, nr_trie_search_t *search) {
+    for (size_t i = 0; i < refs->count; i++) {
+        const nr_trie_rule_ref_t *ref = &refs->items[i];
+        if (ref->index >= search->best_index) {
+            return;
+        }
+        if (search->confirm(ref->node, search->user_data)) {
+            search->best_index = ref->index;
+            search->best_node = ref->node;
+            return;
+        }
+    }
+}
+
+static void nr_trie_search(const nr_trie_node_t *node, const nr_url_segment_t *segments, size_t num_segments, size_t depth, nr_trie_search_t *search) {
+    if (node->min_index >= search->best_index) {
+        return; // Nothing in this subtree can beat the current winner
+    }
+
+    if (depth == num_segments) {
+        nr_trie_check_refs(&node->terminal_rules, search);
+        return;
+    }
+
+    nr_trie_check_refs(&node->splat_rules, search);
+
+    const nr_url_segment_t *segment = &segments[depth];
+    const nr_trie_node_t *child = nr_trie_find_child(node, segment->start, segment->len, NULL);
+    if (child != NULL) {
+        nr_trie_search(child, segments, num_segments, depth + 1, search);
+    }
+    if (node->param_child != NULL && segment->len > 0) {
+        nr_trie_search(node->param_child, segments, num_segments, depth + 1, search);
+    }
+}
+
+/**
+ * @brief Descends the trie most specific branch first and stops at the first confirmed rule.
+ *
+ * In specificity order a literal child only holds rules that rank before the
+ * placeholder child, whose rules rank before the splats hanging off the node,
+ * so the first rule confirmed on the way is the winner.
+ */
+static void nr_trie_search_specific(const nr_trie_node_t *node, const nr_url_segment_t *segments, size_t num_segments, size_t depth, nr_trie_search_t *search) {
+    if (depth == num_segments) {
+        nr_trie_check_refs(&node->terminal_rules, search);
+        return;
+    }
+
+    const nr_url_segment_t *segment = &segments[depth];
+    const nr_trie_node_t *child = nr_trie_find_child(node, segment->start, segment->len, NULL);
+    if (child != NULL) {
+        nr_trie_search_specific(child, segments, num_segments, depth + 1, search);
+        if (search->best_node != NULL) {
+            return;
+        }
+    }
+    if (node->param_child != NULL && segment->len > 0) {
+        nr_trie_search_specific(node->param_child, segments, num_segments, depth + 1, search);
+        if (search->best_node != NULL) {
+            return;
+        }
+    }
+    nr_trie_check_refs(&node->splat_rules, search);
+}
+
+const nanorouter_redirect_rule_t* nr_redirect_trie_find(
+    const nr_redirect_trie_t *trie,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+) {
+    if (trie == NULL || parsed_url == NULL || confirm == NULL) {
+        return NULL;
+    }
+
+    nr_trie_search_t search = {
+        .confirm = confirm,
+        .user_data = user_data,
+        .best_index = UINT32_MAX,
+        .best_node = NULL
+    };
+
+    if (parsed_url->too_many_segments) {
+        // Too deep to index, fall back to trying every rule in order
+        nr_trie_check_refs(&trie->all_rules, &search);
+        return search.best_node;
+    }
+
+    if (trie->most_specific_first) {
+        // "/*" ranks after every other pattern
+        nr_trie_search_specific(trie->root, parsed_url->segments, parsed_url->num_segments, 0, &search);
+        if (search.best_node == NULL) {
+            nr_trie_check_refs(&trie->catch_all_rules, &search);
+        }
+        return search.best_node;
+    }
+
+    nr_trie_check_refs(&trie->catch_all_rules, &search);
+    nr_trie_search(trie->root, parsed_url->segments, parsed_url->num_segments, 0, &search);
+    return search.best_node;
+}
@@ -0,0 +1,67 @@
+#ifndef NANOROUTER_REDIRECT_TRIE_H
+#define NANOROUTER_REDIRECT_TRIE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_redirect_middleware.h" // For nanorouter_redirect_rule_list_t and nanorouter_redirect_rule_t
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Opaque path-segment trie built from a redirect rule list.
+ *
+ * Every rule's compiled `from_route` is walked op by op. Literal segments become keyed
+ * children, `:placeholder` segments share a single placeholder child, and
+ * trailing splats (`*` or a trailing `:name`) are attached to the node they
+ * hang off. Each rule keeps its original list index so lookups preserve
+ * first-match-wins semantics.
+ */
+typedef struct nr_redirect_trie_t nr_redirect_trie_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Builds a segment trie over all rules currently stored in a list.
+ *
+ * The trie only references the list nodes, so the list must outlive the trie
+ * and must not be modified while the trie is in use.
+ *
+ * @param list The rule list to index.
+ * @return A pointer to the newly built trie, or NULL on allocation failure.
+ */
+nr_redirect_trie_t* nr_redirect_trie_build(const nanorouter_redirect_rule_list_t *list);
+
+/**
+ * @brief Frees a trie built with nr_redirect_trie_build.
+ *
+ * @param trie The trie to free. May be NULL.
+ */
+void nr_redirect_trie_free(nr_redirect_trie_t *trie);
+
+/**
+ * @brief Finds the lowest-index rule whose path pattern matches the URL and that passes confirmation.
+ *
+ * Only rules reachable through the URL's segments are visited. Candidates are
+ * handed to the confirm callback in ascending index order per trie node, and
+ * subtrees whose lowest rule index cannot beat the current best are skipped.
+ * For a list in specificity order the trie is descended literal children
+ * first, then placeholders, then splats, and the search ends at the first
+ * confirmed rule.
+ *
+ * @param trie The trie to search.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param confirm Callback that performs the full rule check for a candidate.
+ * @param user_data Data passed through to the confirm callback.
+ * @return The winning rule node, or NULL if no rule matches.
+ */
+const nanorouter_redirect_rule_t* nr_redirect_trie_find(
+    const nr_redirect_trie_t *trie,
+    const nr_parsed_url_t *parsed_url,
+    nr_redirect_confirm_callback_t confirm,
+    void *user_data
+);
+
+#endif // NANOROUTER_REDIRECT_TRIE_H
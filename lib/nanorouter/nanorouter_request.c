@@ -0,0 +1,9 @@
+#include "nanorouter_request.h"
+
+void nr_request_init(nr_request_t *request, const char *url, size_t url_len, const nanorouter_request_context_t *context) {
+    nr_parse_url_n(url, url_len, &request->url);
+    request->query_pairs.parsed = false;
+    request->url.query_pairs = &request->query_pairs; // Matchers split the query on first use
+    request->language_tags.parsed = false;
+    request->context = context;
+}
@@ -0,0 +1,43 @@
+#ifndef NANOROUTER_REQUEST_H
+#define NANOROUTER_REQUEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_route_matcher.h" // For nr_parsed_url_t and nr_query_pairs_t
+#include "nanorouter_condition_matching.h" // For nanorouter_request_context_t and nr_language_tags_t
+
+// --- Struct Definitions ---
+
+/**
+ * @brief One request, parsed once and shared by the redirect and header middleware.
+ *
+ * The path is split into segments when the request is created. The query
+ * string and the Accept-Language value are only split when the first rule
+ * that needs them is tried, and then kept for every later rule, whichever
+ * middleware it belongs to.
+ *
+ * The request points into the URL and the context it was created from, and
+ * into itself, so it must not be copied or moved once created.
+ */
+typedef struct {
+    nr_parsed_url_t url;                        /**< Path, query string and path segments. */
+    nr_query_pairs_t query_pairs;               /**< The query string's pairs (lazy). */
+    nr_language_tags_t language_tags;           /**< The context's language tags (lazy). */
+    const nanorouter_request_context_t *context; /**< Domain, scheme, country and language. May be NULL. */
+} nr_request_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Creates a request from a length-delimited URL and its context.
+ *
+ * @param request The request to fill.
+ * @param url The request URL, not necessarily null-terminated. Must outlive the request.
+ * @param url_len Length of url.
+ * @param context Request data used to evaluate rule conditions. May be NULL. Must outlive the request.
+ */
+void nr_request_init(nr_request_t *request, const char *url, size_t url_len, const nanorouter_request_context_t *context);
+
+#endif // NANOROUTER_REQUEST_H
@@ -1,59 +1,99 @@
 #include "nanorouter_route_matcher.h"
 #include "nanorouter_string_utils.h"
 #include <string.h>
+#include <ctype.h> // For tolower
 // #include <stdio.h> // Removed: For debugging, remove later
 
-// Helper to add a matched parameter
-static bool add_matched_param(nr_matched_params_t *matched_params, const char *key, size_t key_len, const char *value, size_t value_len) {
-    if (matched_params->num_params >= NR_MAX_MATCHED_PARAMS) {
-        return false; // No space left
+// Where a matcher stores its captures: copied into nr_matched_params_t, as spans, or nowhere
+typedef struct {
+    nr_matched_params_t *params;    // Copies of key and value, or NULL
+    nr_capture_spans_t *spans;      // Spans into url, or NULL
+    const char *url;                // The URL the values are taken from
+    const char *base;               // Text being matched: url itself, or a same-offset copy of part of it
+    size_t base_offset;             // Offset of base[0] inside url
+} nr_capture_sink_t;
+
+static nr_capture_sink_t nr_capture_sink(nr_matched_params_t *params, nr_capture_spans_t *spans, const char *url, const char *base, size_t base_offset) {
+    nr_capture_sink_t sink = { params, spans, url, base, base_offset };
+    return sink;
+}
+
+// Helper to add a matched parameter; value points into sink->base
+static bool add_matched_param(nr_capture_sink_t *sink, const char *key, size_t key_len, const char *value, size_t value_len) {
+    size_t offset = value_len > 0 ? sink->base_offset + (size_t)(value - sink->base) : 0;
+    value = sink->url + offset; // Same bytes, in the casing of the request
+
+    nr_matched_params_t *matched_params = sink->params;
+    if (matched_params != NULL) {
+        if (matched_params->num_params >= NR_MAX_MATCHED_PARAMS) {
+            return false; // No space left
+        }
+        nr_matched_param_t *param = &matched_params->params[matched_params->num_params++];
+        strncpy(param->key, key, key_len < NR_MAX_MATCHED_KEY_LEN ? key_len : NR_MAX_MATCHED_KEY_LEN);
+        param->key[key_len < NR_MAX_MATCHED_KEY_LEN ? key_len : NR_MAX_MATCHED_KEY_LEN] = '\0';
+        strncpy(param->value, value, value_len < NR_MAX_MATCHED_VALUE_LEN ? value_len : NR_MAX_MATCHED_VALUE_LEN);
+        param->value[value_len < NR_MAX_MATCHED_VALUE_LEN ? value_len : NR_MAX_MATCHED_VALUE_LEN] = '\0';
+    }
+
+    nr_capture_spans_t *captures = sink->spans;
+    if (captures != NULL) {
+        if (captures->num_spans >= NR_MAX_MATCHED_PARAMS || key_len > UINT8_MAX || offset + value_len > UINT16_MAX) {
+            return false; // No space left
+        }
+        nr_capture_span_t *span = &captures->spans[captures->num_spans++];
+        span->key = key;
+        span->key_len = (uint8_t)key_len;
+        span->offset = (uint16_t)offset;
+        span->len = (uint16_t)value_len;
     }
-    nr_matched_param_t *param = &matched_params->params[matched_params->num_params++];
-    strncpy(param->key, key, key_len < NR_MAX_MATCHED_KEY_LEN ? key_len : NR_MAX_MATCHED_KEY_LEN);
-    param->key[key_len < NR_MAX_MATCHED_KEY_LEN ? key_len : NR_MAX_MATCHED_KEY_LEN] = '\0';
-    strncpy(param->value, value, value_len < NR_MAX_MATCHED_VALUE_LEN ? value_len : NR_MAX_MATCHED_VALUE_LEN);
-    param->value[value_len < NR_MAX_MATCHED_VALUE_LEN ? value_len : NR_MAX_MATCHED_VALUE_LEN] = '\0';
     return true;
 }
 
-// Helper to parse URL into path and query string
-static void nr_parse_url_path_and_query(const char *url, char *path_buffer, size_t path_buffer_len, char *query_buffer, size_t query_buffer_len) {
-    const char *query_start = strchr(url, '?');
-    if (query_start) {
-        size_t path_len = query_start - url;
-        strncpy(path_buffer, url, path_len < path_buffer_len ? path_len : path_buffer_len - 1);
-        path_buffer[path_len < path_buffer_len ? path_len : path_buffer_len - 1] = '\0';
-
-        size_t query_len = strlen(query_start + 1);
-        strncpy(query_buffer, query_start + 1, query_len < query_buffer_len ? query_len : query_buffer_len - 1);
-        query_buffer[query_len < query_buffer_len ? query_len : query_buffer_len - 1] = '\0';
-    } else {
-        strncpy(path_buffer, url, path_buffer_len - 1);
-        path_buffer[path_buffer_len - 1] = '\0';
-        query_buffer[0] = '\0';
+/**
+ * @brief Gives the length of the suffix of an extension splat ("*.css", "*.min.js").
+ *
+ * @param star The '*' of a pattern segment.
+ * @return The length of the suffix after the '*', or 0 if the segment is not the last one or is no extension splat.
+ */
+static size_t nr_route_suffix_len(const char *star) {
+    if (star[1] != '.') {
+        return 0;
     }
+    size_t len = 1;
+    while (star[len + 1] != '\0') {
+        if (star[len + 1] == '/' || star[len + 1] == '*') {
+            return 0;
+        }
+        len++;
+    }
+    return len > 1 ? len : 0; // A lone '.' names no extension
+}
 
-    // Normalize path by removing trailing slash if not root
-    size_t path_len = strlen(path_buffer);
-    if (path_len > 1 && path_buffer[path_len - 1] == '/') {
-        path_buffer[path_len - 1] = '\0';
+// Matches the rest of a path against an extension splat; the splat must end in a non-empty segment
+static bool nr_match_route_suffix(nr_capture_sink_t *matched_params, const char *rest, size_t rest_len, const char *suffix, size_t suffix_len) {
+    if (rest_len <= suffix_len || rest[rest_len - suffix_len - 1] == '/' ||
+        memcmp(rest + rest_len - suffix_len, suffix, suffix_len) != 0) {
+        return false;
     }
+    add_matched_param(matched_params, "*", 1, rest, rest_len - suffix_len);
+    return true;
 }
 
-bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern, nr_matched_params_t *matched_params) {
-    matched_params->num_params = 0;
+// url_path is not null-terminated; it ends at url_path + url_path_len
+static bool nr_match_path_pattern_sink(const char *url_path, size_t url_path_len, const char *from_route_pattern, nr_capture_sink_t *matched_params) {
 
     const char *url_curr = url_path;
+    const char *url_end = url_path + url_path_len;
     const char *pattern_curr = from_route_pattern;
 
     // Handle root path special case
-    if (strcmp(url_path, "/") == 0 && strcmp(from_route_pattern, "/") == 0) {
+    if (url_path_len == 1 && url_path[0] == '/' && strcmp(from_route_pattern, "/") == 0) {
         return true;
     }
     // Handle root wildcard special case (e.g., "/*" matching "/any/path")
     if (strcmp(from_route_pattern, "/*") == 0) {
-        if (strlen(url_path) > 1) { // If URL is not just "/"
-            add_matched_param(matched_params, "*", 1, url_path + 1, strlen(url_path) - 1);
+        if (url_path_len > 1) { // If URL is not just "/"
+            add_matched_param(matched_params, "*", 1, url_path + 1, url_path_len - 1);
         } else { // If URL is just "/"
             add_matched_param(matched_params, "*", 1, "", 0);
         }
@@ -61,10 +101,17 @@ bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern,
     }
 
     // Skip leading '/' for easier segment processing
-    if (*url_curr == '/') url_curr++;
+    if (url_curr < url_end && *url_curr == '/') url_curr++;
     if (*pattern_curr == '/') pattern_curr++;
 
-    while (*url_curr != '\0' && *pattern_curr != '\0') {
+    while (url_curr < url_end && *pattern_curr != '\0') {
+        const char *url_segment_start = url_curr;
+        const char *url_segment_end = (const char *)memchr(url_curr, '/', (size_t)(url_end - url_curr));
+        if (!url_segment_end) {
+            url_segment_end = url_end;
+        }
+        size_t url_segment_len = url_segment_end - url_segment_start;
+
         if (*pattern_curr == ':') { // Placeholder or named splat
             const char *placeholder_name_start = pattern_curr + 1;
             const char *placeholder_name_end = strchr(placeholder_name_start, '/');
@@ -73,16 +120,9 @@ bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern,
             }
             size_t placeholder_name_len = placeholder_name_end - placeholder_name_start;
 
-            const char *url_segment_start = url_curr;
-            const char *url_segment_end = strchr(url_curr, '/');
-            if (!url_segment_end) {
-                url_segment_end = strchr(url_curr, '\0');
-            }
-            size_t url_segment_len = url_segment_end - url_segment_start;
-
             // Check if it's a named splat (i.e., it's the last segment in the pattern)
             if (*placeholder_name_end == '\0') { // This is the last segment in the pattern
-                add_matched_param(matched_params, placeholder_name_start, placeholder_name_len, url_curr, strlen(url_curr));
+                add_matched_param(matched_params, placeholder_name_start, placeholder_name_len, url_curr, (size_t)(url_end - url_curr));
                 return true; // Named splat matches the rest
             } else { // Regular placeholder (matches a single segment)
                 if (url_segment_len == 0) return false; // Placeholder must match something
@@ -90,10 +130,12 @@ bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern,
             }
 
             url_curr = url_segment_end;
-            if (*url_curr == '/') url_curr++;
+            if (url_curr < url_end) url_curr++; // Skip the '/'
             pattern_curr = placeholder_name_end;
             if (*pattern_curr == '/') pattern_curr++;
 
+        } else if (*pattern_curr == '*' && nr_route_suffix_len(pattern_curr) > 0) { // Extension splat ("*.css")
+            return nr_match_route_suffix(matched_params, url_curr, (size_t)(url_end - url_curr), pattern_curr + 1, nr_route_suffix_len(pattern_curr));
         } else if (*pattern_curr == '*') { // Unnamed splat
             // According to documentation, '*' can only be at the end of a path segment.
             // If we find it in the middle, it's a mismatch.
@@ -102,7 +144,7 @@ bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern,
             }
             // If '*' is the last segment in the pattern, it matches the rest of the URL
             if (*(pattern_curr + 1) == '\0') {
-                add_matched_param(matched_params, "*", 1, url_curr, strlen(url_curr));
+                add_matched_param(matched_params, "*", 1, url_curr, (size_t)(url_end - url_curr));
                 return true; // Splat matches the rest
             } else { // '*' followed by '/', meaning it's a single segment wildcard
                 // This case is problematic based on documentation. For now, treat as mismatch.
@@ -117,107 +159,577 @@ bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern,
             }
             size_t pattern_segment_len = pattern_segment_end - pattern_segment_start;
 
-            const char *url_segment_start = url_curr;
-            const char *url_segment_end = strchr(url_curr, '/');
-            if (!url_segment_end) {
-                url_segment_end = strchr(url_curr, '\0');
-            }
-            size_t url_segment_len = url_segment_end - url_segment_start;
-
-            if (pattern_segment_len != url_segment_len || strncmp(pattern_segment_start, url_segment_start, pattern_segment_len) != 0) {
+            if (pattern_segment_len != url_segment_len || memcmp(pattern_segment_start, url_segment_start, pattern_segment_len) != 0) {
                 return false; // Mismatch
             }
 
             url_curr = url_segment_end;
-            if (*url_curr == '/') url_curr++;
+            if (url_curr < url_end) url_curr++; // Skip the '/'
             pattern_curr = pattern_segment_end;
             if (*pattern_curr == '/') pattern_curr++;
         }
     }
 
     // If both reached end simultaneously, it's a match
-    return *url_curr == '\0' && *pattern_curr == '\0';
+    return url_curr == url_end && *pattern_curr == '\0';
 }
 
-bool nr_match_query_params(const char *url_query, const nr_key_value_item_t *rule_query_params, uint8_t num_rule_query_params, nr_matched_params_t *matched_params) {
+bool nr_match_path_pattern(const char *url_path, const char *from_route_pattern, nr_matched_params_t *matched_params) {
+    matched_params->num_params = 0;
+    nr_capture_sink_t sink = nr_capture_sink(matched_params, NULL, url_path, url_path, 0);
+    return nr_match_path_pattern_sink(url_path, strlen(url_path), from_route_pattern, &sink);
+}
+
+// Looks for one rule query parameter among the '&'-separated pairs of url_query
+static bool nr_match_query_param(const char *url_query, size_t url_query_len, const nr_key_value_item_t *rule_param, nr_capture_sink_t *matched_params) {
+    size_t rule_key_len = strlen(rule_param->key);
+    const char *pair = url_query;
+    const char *query_end = url_query + url_query_len;
+
+    while (pair < query_end) {
+        const char *pair_end = (const char *)memchr(pair, '&', (size_t)(query_end - pair));
+        if (!pair_end) {
+            pair_end = query_end;
+        }
+        const char *equals_sign = (const char *)memchr(pair, '=', (size_t)(pair_end - pair));
+        const char *key_end = equals_sign ? equals_sign : pair_end;
+
+        if (pair_end > pair && (size_t)(key_end - pair) == rule_key_len && memcmp(pair, rule_param->key, rule_key_len) == 0) {
+            if (equals_sign) {
+                const char *url_value = equals_sign + 1;
+                size_t url_value_len = (size_t)(pair_end - url_value);
+                if (rule_param->is_present) { // Placeholder like 'id=:id'
+                    add_matched_param(matched_params, rule_param->key, rule_key_len, url_value, url_value_len);
+                    return true;
+                }
+                // Exact match like 'id=123'
+                if (strlen(rule_param->value) == url_value_len && memcmp(rule_param->value, url_value, url_value_len) == 0) {
+                    return true;
+                }
+            } else if (!rule_param->is_present && rule_param->value[0] == '\0') { // Query param without value, e.g., "?param"
+                return true;
+            }
+        }
+        pair = pair_end + 1; // Empty pairs ("a=1&&b=2") are skipped
+    }
+    return false;
+}
+
+// Same as nr_match_query_param, over a query string that was already split
+static bool nr_match_query_pair(const nr_query_pairs_t *query_pairs, const nr_key_value_item_t *rule_param, nr_capture_sink_t *matched_params) {
+    size_t rule_key_len = strlen(rule_param->key);
+    // One probe finds the key's first pair; repeats of the key follow in URL order
+    const nr_query_pair_t *pair = nr_query_pairs_find(query_pairs, rule_param->key, rule_key_len);
+    for (; pair != NULL; pair = pair->next != 0 ? &query_pairs->pairs[pair->next - 1] : NULL) {
+        if (pair->value != NULL) {
+            if (rule_param->is_present) { // Placeholder like 'id=:id'
+                add_matched_param(matched_params, rule_param->key, rule_key_len, pair->value, pair->value_len);
+                return true;
+            }
+            // Exact match like 'id=123'
+            if (strlen(rule_param->value) == pair->value_len && memcmp(rule_param->value, pair->value, pair->value_len) == 0) {
+                return true;
+            }
+        } else if (!rule_param->is_present && rule_param->value[0] == '\0') { // Query param without value, e.g., "?param"
+            return true;
+        }
+    }
+    return false;
+}
+
+// url_query is not null-terminated; sink->base must be url_query, at sink->base_offset inside sink->url.
+// query_pairs, when given, is split from url_query on first use and searched instead of the raw string.
+static bool nr_match_query_params_sink(const char *url_query, size_t url_query_len, nr_query_pairs_t *query_pairs, const nr_key_value_item_t *rule_query_params, uint8_t num_rule_query_params, nr_capture_sink_t *matched_params) {
     if (num_rule_query_params == 0) {
         return true; // No query params to match in the rule
     }
-    if (url_query == NULL || strlen(url_query) == 0) {
+    if (url_query == NULL || url_query_len == 0) {
         return false; // Rule has query params, but URL doesn't
     }
 
-    // Create a mutable copy of the URL query string for strtok_r
-    char url_query_copy[NR_MAX_ROUTE_LEN + 1];
-    strncpy(url_query_copy, url_query, NR_MAX_ROUTE_LEN);
-    url_query_copy[NR_MAX_ROUTE_LEN] = '\0';
-
-    // char *rest_of_url_query = url_query_copy;
+    if (query_pairs != NULL && !query_pairs->parsed) {
+        nr_parse_query_pairs(url_query, url_query_len, query_pairs);
+    }
+    bool use_pairs = query_pairs != NULL && !query_pairs->too_many;
 
     for (uint8_t i = 0; i < num_rule_query_params; ++i) {
-        const nr_key_value_item_t *rule_param = &rule_query_params[i];
-        bool found_match = false;
-
-        // Use a temporary copy for strtok_r to avoid modifying the original for subsequent rule params
-        char temp_query_for_strtok[NR_MAX_ROUTE_LEN + 1];
-        strncpy(temp_query_for_strtok, url_query, NR_MAX_ROUTE_LEN);
-        temp_query_for_strtok[NR_MAX_ROUTE_LEN] = '\0';
-        char *token_save_ptr = NULL;
-        char *current_url_param = strtok_r(temp_query_for_strtok, "&", &token_save_ptr);
-
-        while (current_url_param != NULL) {
-            char *equals_sign = strchr(current_url_param, '=');
-            if (equals_sign) {
-                *equals_sign = '\0'; // Temporarily null-terminate key
-                const char *url_key = current_url_param;
-                const char *url_value = equals_sign + 1;
+        bool found = use_pairs ? nr_match_query_pair(query_pairs, &rule_query_params[i], matched_params)
+                               : nr_match_query_param(url_query, url_query_len, &rule_query_params[i], matched_params);
+        if (!found) {
+            return false; // A rule query param was not matched
+        }
+    }
 
-                if (strcmp(rule_param->key, url_key) == 0) {
-                    if (rule_param->is_present) { // Placeholder like 'id=:id'
-                        add_matched_param(matched_params, rule_param->key, strlen(rule_param->key), url_value, strlen(url_value));
-                        found_match = true;
-                        break;
-                    } else { // Exact match like 'id=123'
-                        if (strcmp(rule_param->value, url_value) == 0) {
-                            found_match = true;
-                            break;
-                        }
-                    }
-                }
-            } else { // Query param without value, e.g., "?param"
-                if (strcmp(rule_param->key, current_url_param) == 0 && !rule_param->is_present && strlen(rule_param->value) == 0) {
-                    found_match = true;
-                    break;
+    return true;
+}
+
+bool nr_match_query_params(const char *url_query, const nr_key_value_item_t *rule_query_params, uint8_t num_rule_query_params, nr_matched_params_t *matched_params) {
+    nr_capture_sink_t sink = nr_capture_sink(matched_params, NULL, url_query, url_query, 0);
+    return nr_match_query_params_sink(url_query, url_query != NULL ? strlen(url_query) : 0, NULL, rule_query_params, num_rule_query_params, &sink);
+}
+
+bool nanorouter_match_rule(const redirect_rule_t *rule, const char *url, nr_matched_params_t *matched_params) {
+    return nanorouter_match_rule_n(rule, url, strlen(url), matched_params);
+}
+
+bool nanorouter_match_rule_n(const redirect_rule_t *rule, const char *url, size_t url_len, nr_matched_params_t *matched_params) {
+    nr_parsed_url_t parsed_url;
+    nr_parse_url_n(url, url_len, &parsed_url);
+    matched_params->num_params = 0;
+
+    // 1. Match path pattern
+    nr_capture_sink_t sink = nr_capture_sink(matched_params, NULL, url, url, 0);
+    if (!nr_match_path_pattern_sink(parsed_url.path, parsed_url.path_len, rule->from_route, &sink)) {
+        return false;
+    }
+
+    // 2. Match query parameters
+    if (rule->num_query_params > 0) {
+        sink.base = parsed_url.query;
+        sink.base_offset = (size_t)(parsed_url.query - url);
+        if (!nr_match_query_params_sink(parsed_url.query, parsed_url.query_len, NULL, rule->query_params, rule->num_query_params, &sink)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Appends an operation to a route program; returns false when the program is full.
+static bool nr_route_program_emit(nr_route_program_t *program, nr_route_opcode_t opcode, size_t offset, size_t len) {
+    if (program->num_ops >= NR_MAX_ROUTE_OPS) {
+        return false;
+    }
+    nr_route_op_t *op = &program->ops[program->num_ops++];
+    op->opcode = (uint8_t)opcode;
+    op->offset = (uint16_t)offset;
+    op->len = (uint16_t)len;
+    op->hash = 0;
+    return true;
+}
+
+// Replaces a program with a single FAIL operation.
+static void nr_route_program_fail(nr_route_program_t *program) {
+    program->num_ops = 0;
+    nr_route_program_emit(program, NR_ROUTE_OP_FAIL, 0, 0);
+}
+
+// scripts/generate_redirect_mph.py mirrors which patterns compile to literals only (literal_route_key) and must be kept in sync.
+void nr_compile_route_pattern(const char *from_route_pattern, nr_route_program_t *program) {
+    program->num_ops = 0;
+
+    if (from_route_pattern == NULL) {
+        nr_route_program_fail(program);
+        return;
+    }
+
+    if (strcmp(from_route_pattern, "/*") == 0) {
+        nr_route_program_emit(program, NR_ROUTE_OP_ANY, 0, 0);
+        return;
+    }
+
+    const char *cursor = from_route_pattern;
+    if (*cursor == '/') cursor++;
+
+    while (*cursor != '\0') {
+        const char *segment_end = strchr(cursor, '/');
+        if (!segment_end) {
+            segment_end = strchr(cursor, '\0');
+        }
+        size_t segment_len = segment_end - cursor;
+        size_t offset = cursor - from_route_pattern;
+        bool is_last = (*segment_end == '\0');
+        bool emitted;
+
+        if (*cursor == '*' && nr_route_suffix_len(cursor) > 0) {
+            // "*.css": the rest of the path, ending in the suffix
+            emitted = nr_route_program_emit(program, NR_ROUTE_OP_SUFFIX, offset + 1, segment_len - 1);
+        } else if (*cursor == '*') {
+            // '*' only matches as a whole trailing segment
+            if (segment_len != 1 || !is_last) {
+                nr_route_program_fail(program);
+                return;
+            }
+            emitted = nr_route_program_emit(program, NR_ROUTE_OP_SPLAT, offset, 0);
+        } else if (*cursor == ':') {
+            // A trailing placeholder is a named splat
+            emitted = nr_route_program_emit(program, is_last ? NR_ROUTE_OP_SPLAT : NR_ROUTE_OP_PARAM, offset + 1, segment_len - 1);
+        } else {
+            emitted = nr_route_program_emit(program, NR_ROUTE_OP_LITERAL, offset, segment_len);
+            if (emitted) {
+                program->ops[program->num_ops - 1].hash = nr_hash_bytes(cursor, segment_len);
+            }
+        }
+
+        if (!emitted) {
+            // More segments than any compiled match can see
+            nr_route_program_fail(program);
+            return;
+        }
+        uint8_t last = program->ops[program->num_ops - 1].opcode;
+        if (last == NR_ROUTE_OP_SPLAT || last == NR_ROUTE_OP_SUFFIX) {
+            return;
+        }
+
+        cursor = segment_end;
+        if (*cursor == '/') cursor++;
+    }
+
+    if (!nr_route_program_emit(program, NR_ROUTE_OP_END, 0, 0)) {
+        nr_route_program_fail(program);
+    }
+}
+
+void nr_parse_url(const char *url, nr_parsed_url_t *parsed_url) {
+    nr_parse_url_n(url, strlen(url), parsed_url);
+}
+
+void nr_split_url_n(const char *url, size_t url_len, size_t *path_len, const char **query, size_t *query_len) {
+    const char *query_start = (const char *)memchr(url, '?', url_len);
+    size_t len = query_start ? (size_t)(query_start - url) : url_len;
+    // Normalize path by removing trailing slash if not root
+    if (len > 1 && url[len - 1] == '/') {
+        len--;
+    }
+    *path_len = len;
+    *query = query_start ? query_start + 1 : "";
+    *query_len = query_start ? (size_t)(url + url_len - *query) : 0;
+}
+
+void nr_parse_url_n(const char *url, size_t url_len, nr_parsed_url_t *parsed_url) {
+    size_t path_len;
+    nr_split_url_n(url, url_len, &path_len, &parsed_url->query, &parsed_url->query_len);
+
+    parsed_url->url = url;
+    parsed_url->path = url;
+    parsed_url->path_len = path_len;
+    parsed_url->query_pairs = NULL;
+    parsed_url->num_segments = 0;
+    parsed_url->too_many_segments = false;
+
+    size_t pos = 0;
+    if (pos < path_len && url[pos] == '/') pos++;
+
+    while (pos < path_len) {
+        if (parsed_url->num_segments >= NR_MAX_PATH_SEGMENTS) {
+            parsed_url->too_many_segments = true;
+            return;
+        }
+        size_t start = pos;
+        while (pos < path_len && url[pos] != '/') {
+            pos++;
+        }
+        nr_url_segment_t *segment = &parsed_url->segments[parsed_url->num_segments++];
+        segment->start = url + start;
+        segment->len = pos - start;
+        segment->hash = nr_hash_bytes(segment->start, segment->len);
+        if (pos < path_len) pos++; // Skip the separator
+    }
+}
+
+// Linear probing; returns the slot holding the key, or the empty slot where it belongs
+static uint8_t* nr_query_pairs_probe(const nr_query_pairs_t *query_pairs, const char *key, size_t key_len, uint32_t hash) {
+    size_t mask = NR_QUERY_TABLE_SLOTS - 1;
+    size_t pos = hash & mask;
+    while (true) {
+        uint8_t slot = query_pairs->slots[pos];
+        if (slot == 0) {
+            return (uint8_t *)&query_pairs->slots[pos];
+        }
+        const nr_query_pair_t *pair = &query_pairs->pairs[slot - 1];
+        if (pair->hash == hash && pair->key_len == key_len && memcmp(pair->key, key, key_len) == 0) {
+            return (uint8_t *)&query_pairs->slots[pos];
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+// The top five bits of the key hash pick the bit; the table probes with the low ones
+static inline uint32_t nr_query_key_bit_for_hash(uint32_t hash) {
+    return (uint32_t)1 << (hash >> 27);
+}
+
+uint32_t nr_query_key_bit(const char *key, size_t key_len) {
+    return nr_query_key_bit_for_hash(nr_hash_bytes(key, key_len));
+}
+
+uint32_t nr_query_params_key_mask(const nr_key_value_item_t *query_params, uint8_t num_query_params) {
+    uint32_t key_mask = 0;
+    for (uint8_t i = 0; i < num_query_params; i++) {
+        key_mask |= nr_query_key_bit(query_params[i].key, strlen(query_params[i].key));
+    }
+    return key_mask;
+}
+
+const nr_query_pair_t* nr_query_pairs_find(const nr_query_pairs_t *query_pairs, const char *key, size_t key_len) {
+    uint8_t slot = *nr_query_pairs_probe(query_pairs, key, key_len, nr_hash_bytes(key, key_len));
+    return slot != 0 ? &query_pairs->pairs[slot - 1] : NULL;
+}
+
+void nr_parse_query_pairs(const char *query, size_t query_len, nr_query_pairs_t *query_pairs) {
+    query_pairs->num_pairs = 0;
+    query_pairs->parsed = true;
+    query_pairs->too_many = false;
+    query_pairs->key_mask = 0;
+    memset(query_pairs->slots, 0, sizeof(query_pairs->slots));
+
+    const char *query_end = query + query_len;
+    for (const char *pair = query; pair < query_end; ) {
+        const char *pair_end = (const char *)memchr(pair, '&', (size_t)(query_end - pair));
+        if (!pair_end) {
+            pair_end = query_end;
+        }
+        if (pair_end > pair) {
+            if (query_pairs->num_pairs >= NR_MAX_QUERY_PAIRS || (size_t)(pair_end - pair) > UINT16_MAX) {
+                query_pairs->too_many = true;
+                return;
+            }
+            nr_query_pair_t *entry = &query_pairs->pairs[query_pairs->num_pairs++];
+            const char *equals_sign = (const char *)memchr(pair, '=', (size_t)(pair_end - pair));
+            entry->key = pair;
+            entry->key_len = (uint16_t)((equals_sign ? equals_sign : pair_end) - pair);
+            entry->value = equals_sign ? equals_sign + 1 : NULL;
+            entry->value_len = equals_sign ? (uint16_t)(pair_end - equals_sign - 1) : 0;
+            entry->hash = nr_hash_bytes(entry->key, entry->key_len);
+            entry->next = 0;
+            query_pairs->key_mask |= nr_query_key_bit_for_hash(entry->hash);
+
+            // File the pair under its key, after earlier pairs with the same key
+            uint8_t *slot = nr_query_pairs_probe(query_pairs, entry->key, entry->key_len, entry->hash);
+            if (*slot == 0) {
+                *slot = query_pairs->num_pairs;
+            } else {
+                nr_query_pair_t *last = &query_pairs->pairs[*slot - 1];
+                while (last->next != 0) {
+                    last = &query_pairs->pairs[last->next - 1];
                 }
+                last->next = query_pairs->num_pairs;
             }
-            current_url_param = strtok_r(NULL, "&", &token_save_ptr);
         }
+        pair = pair_end + 1;
+    }
+}
 
-        if (!found_match) {
-            return false; // A rule query param was not matched
+bool nr_fold_parsed_url(nr_parsed_url_t *parsed_url, char *buffer) {
+    if (parsed_url->path_len > NR_MAX_ROUTE_LEN) {
+        return false; // Does not fit the buffer
+    }
+    for (size_t i = 0; i < parsed_url->path_len; i++) {
+        buffer[i] = (char)tolower((unsigned char)parsed_url->path[i]);
+    }
+    buffer[parsed_url->path_len] = '\0';
+
+    for (uint8_t i = 0; i < parsed_url->num_segments; i++) {
+        nr_url_segment_t *segment = &parsed_url->segments[i];
+        segment->start = buffer + (segment->start - parsed_url->path);
+        segment->hash = nr_hash_bytes(segment->start, segment->len);
+    }
+    parsed_url->path = buffer;
+    return true;
+}
+
+void nr_fold_route_pattern(char *from_route_pattern) {
+    if (from_route_pattern == NULL) {
+        return;
+    }
+    bool in_placeholder = false;
+    for (char *cursor = from_route_pattern; *cursor != '\0'; cursor++) {
+        if (*cursor == '/') {
+            in_placeholder = false;
+        } else if (*cursor == ':' && (cursor == from_route_pattern || cursor[-1] == '/')) {
+            in_placeholder = true;
+        } else if (!in_placeholder) {
+            *cursor = (char)tolower((unsigned char)*cursor);
         }
     }
+}
+
+// The sink's base must be parsed_url->path; values are copied from parsed_url->url at the same offsets
+static bool nr_match_route_program_sink(const nr_route_program_t *program, const char *from_route_pattern, const nr_parsed_url_t *parsed_url, nr_capture_sink_t *matched_params) {
+
+    uint8_t pos = 0;
+    for (uint8_t i = 0; i < program->num_ops; i++) {
+        const nr_route_op_t *op = &program->ops[i];
+        const char *name = from_route_pattern + op->offset;
 
+        switch (op->opcode) {
+            case NR_ROUTE_OP_LITERAL: {
+                if (pos >= parsed_url->num_segments) return false;
+                const nr_url_segment_t *segment = &parsed_url->segments[pos++];
+                // Hashes decide almost every mismatch; bytes are only compared on a hash hit
+                if (segment->hash != op->hash || segment->len != op->len || memcmp(segment->start, name, op->len) != 0) {
+                    return false; // Mismatch
+                }
+                break;
+            }
+            case NR_ROUTE_OP_PARAM: {
+                if (pos >= parsed_url->num_segments) return false;
+                const nr_url_segment_t *segment = &parsed_url->segments[pos++];
+                if (segment->len == 0) return false; // Placeholder must match something
+                add_matched_param(matched_params, name, op->len, segment->start, segment->len);
+                break;
+            }
+            case NR_ROUTE_OP_SPLAT: {
+                if (pos >= parsed_url->num_segments) return false;
+                const char *rest = parsed_url->segments[pos].start;
+                size_t rest_len = (size_t)(parsed_url->path + parsed_url->path_len - rest);
+                if (op->len == 0) {
+                    add_matched_param(matched_params, "*", 1, rest, rest_len);
+                } else {
+                    add_matched_param(matched_params, name, op->len, rest, rest_len);
+                }
+                return true; // Splat matches the rest
+            }
+            case NR_ROUTE_OP_SUFFIX: {
+                if (pos >= parsed_url->num_segments) return false;
+                const char *rest = parsed_url->segments[pos].start;
+                return nr_match_route_suffix(matched_params, rest, (size_t)(parsed_url->path + parsed_url->path_len - rest), name, op->len);
+            }
+            case NR_ROUTE_OP_ANY:
+                if (parsed_url->path_len > 1) {
+                    add_matched_param(matched_params, "*", 1, parsed_url->path + 1, parsed_url->path_len - 1);
+                } else {
+                    add_matched_param(matched_params, "*", 1, "", 0);
+                }
+                return true;
+            case NR_ROUTE_OP_END:
+                return pos == parsed_url->num_segments;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+bool nr_match_route_program(const nr_route_program_t *program, const char *from_route_pattern, const nr_parsed_url_t *parsed_url, nr_matched_params_t *matched_params) {
+    matched_params->num_params = 0;
+    nr_capture_sink_t sink = nr_capture_sink(matched_params, NULL, parsed_url->url, parsed_url->path, 0);
+    return nr_match_route_program_sink(program, from_route_pattern, parsed_url, &sink);
+}
+
+bool nr_match_compiled_pattern(
+    const char *from_route_pattern,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    const nr_parsed_url_t *parsed_url,
+    nr_capture_spans_t *captures
+) {
+    if (captures != NULL) {
+        captures->num_spans = 0;
+    }
+    nr_capture_sink_t sink = nr_capture_sink(NULL, captures, parsed_url->url, parsed_url->path, 0);
+
+    bool path_matched;
+    if (parsed_url->too_many_segments) {
+        // Deeper than the compiled form can describe, use the string matcher
+        path_matched = nr_match_path_pattern_sink(parsed_url->path, parsed_url->path_len, from_route_pattern, &sink);
+    } else {
+        path_matched = nr_match_route_program_sink(program, from_route_pattern, parsed_url, &sink);
+    }
+    if (!path_matched) {
+        return false;
+    }
+
+    if (num_query_params > 0) {
+        sink.base = parsed_url->query;
+        sink.base_offset = (size_t)(parsed_url->query - parsed_url->url);
+        return nr_match_query_params_sink(parsed_url->query, parsed_url->query_len, parsed_url->query_pairs, query_params, num_query_params, &sink);
+    }
     return true;
 }
 
-bool nanorouter_match_rule(const redirect_rule_t *rule, const char *url, nr_matched_params_t *matched_params) {
-    char path_buffer[NR_MAX_ROUTE_LEN + 1];
-    char query_buffer[NR_MAX_ROUTE_LEN + 1];
+const nr_capture_span_t* nr_capture_spans_find(const nr_capture_spans_t *captures, const char *key, size_t key_len) {
+    for (uint8_t i = 0; i < captures->num_spans; i++) {
+        const nr_capture_span_t *span = &captures->spans[i];
+        if (span->key_len == key_len && memcmp(span->key, key, key_len) == 0) {
+            return span;
+        }
+    }
+    return NULL;
+}
 
-    nr_parse_url_path_and_query(url, path_buffer, sizeof(path_buffer), query_buffer, sizeof(query_buffer));
+bool nanorouter_match_compiled_rule(const redirect_rule_t *rule, const nr_route_program_t *program, const char *url, const nr_parsed_url_t *parsed_url, nr_matched_params_t *matched_params) {
+    if (parsed_url->too_many_segments) {
+        // Deeper than the compiled form can describe, use the string matcher
+        return nanorouter_match_rule(rule, url, matched_params);
+    }
 
     // 1. Match path pattern
-    if (!nr_match_path_pattern(path_buffer, rule->from_route, matched_params)) {
+    if (!nr_match_route_program(program, rule->from_route, parsed_url, matched_params)) {
         return false;
     }
 
     // 2. Match query parameters
     if (rule->num_query_params > 0) {
-        if (!nr_match_query_params(query_buffer, rule->query_params, rule->num_query_params, matched_params)) {
+        nr_capture_sink_t sink = nr_capture_sink(matched_params, NULL, parsed_url->query, parsed_url->query, 0);
+        if (!nr_match_query_params_sink(parsed_url->query, parsed_url->query_len, parsed_url->query_pairs, rule->query_params, rule->num_query_params, &sink)) {
             return false;
         }
     }
 
     return true;
 }
+
+// How specific an operation is when two programs are compared at the same depth.
+static int nr_route_op_specificity(uint8_t opcode) {
+    switch (opcode) {
+        case NR_ROUTE_OP_LITERAL: return 6;
+        case NR_ROUTE_OP_PARAM:   return 5;
+        case NR_ROUTE_OP_END:     return 4;
+        case NR_ROUTE_OP_SUFFIX:  return 3;
+        case NR_ROUTE_OP_SPLAT:   return 2;
+        case NR_ROUTE_OP_ANY:     return 1;
+        default:                  return 0; // NR_ROUTE_OP_FAIL
+    }
+}
+
+int nr_route_program_compare_specificity(const nr_route_program_t *a, const nr_route_program_t *b) {
+    uint8_t num_ops = a->num_ops < b->num_ops ? a->num_ops : b->num_ops;
+    for (uint8_t i = 0; i < num_ops; i++) {
+        int a_rank = nr_route_op_specificity(a->ops[i].opcode);
+        int b_rank = nr_route_op_specificity(b->ops[i].opcode);
+        if (a_rank != b_rank) {
+            return b_rank - a_rank;
+        }
+    }
+    // Every program ends in END, SUFFIX, SPLAT, ANY or FAIL, so equal ranks mean equal length
+    return 0;
+}
+
+bool nr_route_programs_overlap(const nr_route_program_t *a, const char *a_pattern, const nr_route_program_t *b, const char *b_pattern) {
+    uint8_t num_ops = a->num_ops < b->num_ops ? a->num_ops : b->num_ops;
+    for (uint8_t i = 0; i < num_ops; i++) {
+        const nr_route_op_t *a_op = &a->ops[i];
+        const nr_route_op_t *b_op = &b->ops[i];
+
+        if (a_op->opcode == NR_ROUTE_OP_FAIL || b_op->opcode == NR_ROUTE_OP_FAIL) {
+            return false;
+        }
+        if (a_op->opcode == NR_ROUTE_OP_ANY || b_op->opcode == NR_ROUTE_OP_ANY) {
+            return true;
+        }
+        if (a_op->opcode == NR_ROUTE_OP_END || b_op->opcode == NR_ROUTE_OP_END) {
+            return a_op->opcode == b_op->opcode;
+        }
+        if (a_op->opcode == NR_ROUTE_OP_SPLAT || b_op->opcode == NR_ROUTE_OP_SPLAT) {
+            return true; // The splat takes whatever the other side still wants
+        }
+        if (a_op->opcode == NR_ROUTE_OP_SUFFIX && b_op->opcode == NR_ROUTE_OP_SUFFIX) {
+            // A path can only end in both when one suffix ends the other
+            uint16_t len = a_op->len < b_op->len ? a_op->len : b_op->len;
+            return memcmp(a_pattern + a_op->offset + a_op->len - len, b_pattern + b_op->offset + b_op->len - len, len) == 0;
+        }
+        if (a_op->opcode == NR_ROUTE_OP_SUFFIX || b_op->opcode == NR_ROUTE_OP_SUFFIX) {
+            return true; // A deep enough path ending in the suffix fits the other side
+        }
+        if (a_op->opcode == NR_ROUTE_OP_LITERAL && b_op->opcode == NR_ROUTE_OP_LITERAL) {
+            if (a_op->hash != b_op->hash || a_op->len != b_op->len || memcmp(a_pattern + a_op->offset, b_pattern + b_op->offset, a_op->len) != 0) {
+                return false;
+            }
+        } else if ((a_op->opcode == NR_ROUTE_OP_LITERAL && a_op->len == 0) || (b_op->opcode == NR_ROUTE_OP_LITERAL && b_op->len == 0)) {
+            return false; // A placeholder never matches an empty segment
+        }
+    }
+    return false;
+}
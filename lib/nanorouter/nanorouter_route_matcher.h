@@ -6,11 +6,15 @@
 #include <stddef.h>  // For size_t
 
 #include "nanorouter_redirect_rule_parser.h" // For redirect_rule_t and nr_key_value_item_t
+#include "nanorouter_config.h" // For NR_MAX_PATH_SEGMENTS
 
 // --- Item Count Defines for Matcher ---
 #define NR_MAX_MATCHED_PARAMS       10
 #define NR_MAX_MATCHED_KEY_LEN      32
 #define NR_MAX_MATCHED_VALUE_LEN    128
+#define NR_MAX_ROUTE_OPS            (NR_MAX_PATH_SEGMENTS + 1)
+#define NR_MAX_QUERY_PAIRS          16
+#define NR_QUERY_TABLE_SLOTS        (NR_MAX_QUERY_PAIRS * 2)
 
 // --- Struct Definitions for Matcher ---
 
@@ -30,6 +34,118 @@ typedef struct {
     uint8_t num_params;
 } nr_matched_params_t;
 
+/**
+ * @brief A captured value, kept as a span of the request URL instead of a copy.
+ */
+typedef struct {
+    const char *key;        /**< Parameter name inside the rule (from_route or a query key, not null-terminated), or "*" for splats. */
+    uint8_t key_len;        /**< Length of key. */
+    uint16_t offset;        /**< Start of the value inside the request URL (nr_parsed_url_t.url). */
+    uint16_t len;           /**< Length of the value. */
+} nr_capture_span_t;
+
+/**
+ * @brief All values captured while matching one rule, as spans.
+ *
+ * About a tenth the size of nr_matched_params_t, and values are not cut at
+ * NR_MAX_MATCHED_VALUE_LEN. The spans are only valid while the URL and the
+ * rule they point into are.
+ */
+typedef struct {
+    nr_capture_span_t spans[NR_MAX_MATCHED_PARAMS];
+    uint8_t num_spans;
+} nr_capture_spans_t;
+
+/**
+ * @brief Operations of a compiled route pattern.
+ */
+typedef enum {
+    NR_ROUTE_OP_LITERAL,    /**< Segment must equal from_route[offset, offset + len). */
+    NR_ROUTE_OP_PARAM,      /**< Captures one non-empty segment under the name at from_route[offset, offset + len). */
+    NR_ROUTE_OP_SPLAT,      /**< Captures the rest of the path (at least one segment); len 0 means the "*" key. */
+    NR_ROUTE_OP_ANY,        /**< The root splat pattern: matches every path, including "/". */
+    NR_ROUTE_OP_END,        /**< Path must have no segments left. */
+    NR_ROUTE_OP_FAIL,       /**< Pattern can never match a path of at most NR_MAX_PATH_SEGMENTS segments. */
+    NR_ROUTE_OP_SUFFIX      /**< "*.css": the rest of the path must end in from_route[offset, offset + len); what comes before is captured under "*". */
+} nr_route_opcode_t;
+
+/**
+ * @brief A single operation of a compiled route pattern.
+ */
+typedef struct {
+    uint8_t opcode;         /**< One of nr_route_opcode_t. */
+    uint16_t offset;        /**< Offset of the literal or parameter name inside from_route. */
+    uint16_t len;           /**< Length of the literal or parameter name. */
+    uint32_t hash;          /**< nr_hash_bytes of the literal (LITERAL only), compared before the bytes. */
+} nr_route_op_t;
+
+/**
+ * @brief A from_route pattern compiled into a list of segment operations.
+ *
+ * The program refers into the from_route string it was compiled from, so it
+ * must be kept next to that rule.
+ */
+typedef struct {
+    nr_route_op_t ops[NR_MAX_ROUTE_OPS];
+    uint8_t num_ops;
+} nr_route_program_t;
+
+/**
+ * @brief One path segment of a parsed URL (not null-terminated).
+ */
+typedef struct {
+    const char *start;
+    size_t len;
+    uint32_t hash;          /**< nr_hash_bytes of the segment, computed once per request. */
+} nr_url_segment_t;
+
+/**
+ * @brief One key=value pair of a request's query string (not null-terminated).
+ */
+typedef struct {
+    const char *key;
+    const char *value;      /**< Start of the value, or NULL for a bare key ("?flag"). */
+    uint16_t key_len;
+    uint16_t value_len;
+    uint32_t hash;          /**< nr_hash_bytes of the key. */
+    uint8_t next;           /**< 1 + index of the next pair with the same key, 0 if none. */
+} nr_query_pair_t;
+
+/**
+ * @brief A query string split into its pairs, on first use, with a hash table over the keys.
+ *
+ * Empty pairs ("a=1&&b=2") are dropped. Set parsed to false before the first
+ * use; it is filled by the first rule that has query parameters. Each rule
+ * query parameter is then resolved with one probe of slots.
+ */
+typedef struct {
+    nr_query_pair_t pairs[NR_MAX_QUERY_PAIRS];
+    uint8_t slots[NR_QUERY_TABLE_SLOTS];    /**< Linear probing by key hash: 1 + index of a key's first pair, 0 if empty. */
+    uint32_t key_mask;                      /**< nr_query_key_bit of every key, to reject rules that need an absent key. */
+    uint8_t num_pairs;
+    bool parsed;            /**< true once pairs has been filled. */
+    bool too_many;          /**< The query has more than NR_MAX_QUERY_PAIRS pairs (or a pair over 64 KiB); rules then scan it directly. */
+} nr_query_pairs_t;
+
+/**
+ * @brief A request URL split once into its normalized path, query string and path segments.
+ *
+ * All pointers refer into the original URL string, nothing is copied, unless
+ * the path was case-folded by nr_fold_parsed_url. The URL does not have to be
+ * null-terminated, so path and query are spans: read them up to their lengths.
+ */
+typedef struct {
+    const char *url;                                    /**< The URL string that was parsed; captures are copied from here. */
+    const char *path;                                   /**< Start of the path (url itself, or a case-folded copy of its path). */
+    size_t path_len;                                    /**< Path length, without a trailing '/'. Never truncated. */
+    const char *query;                                  /**< Query string after '?', or an empty string. */
+    size_t query_len;                                   /**< Query string length, up to the end of the URL. */
+    nr_query_pairs_t *query_pairs;                      /**< Where the query is split on first use, or NULL to scan it for every rule. */
+    nr_url_segment_t segments[NR_MAX_PATH_SEGMENTS];    /**< Path segments, split the same way nr_match_path_pattern walks them. */
+    uint8_t num_segments;                               /**< Number of entries in segments. */
+    bool too_many_segments;                             /**< The path has more than NR_MAX_PATH_SEGMENTS segments. */
+} nr_parsed_url_t;
+
 // --- Function Signatures for Matcher ---
 
 /**
@@ -88,4 +204,230 @@ bool nanorouter_match_rule(
     nr_matched_params_t *matched_params
 );
 
+/**
+ * @brief Matches a length-delimited URL against a redirect rule.
+ *
+ * Same as nanorouter_match_rule, but the URL is a slice (for example of an
+ * HTTP receive buffer) that needs no terminating NUL. The URL is matched in
+ * place, without copies, and is not cut at NR_MAX_ROUTE_LEN.
+ *
+ * @param rule A pointer to the `redirect_rule_t` to match against.
+ * @param url The URL, not necessarily null-terminated.
+ * @param url_len Length of url.
+ * @param matched_params A pointer to `nr_matched_params_t` to store all captured values (placeholders and query params).
+ * @return true if the rule matches the URL, false otherwise.
+ */
+bool nanorouter_match_rule_n(
+    const redirect_rule_t *rule,
+    const char *url,
+    size_t url_len,
+    nr_matched_params_t *matched_params
+);
+
+/**
+ * @brief Compiles a from_route pattern into a route program.
+ *
+ * Segment boundaries and the root and root-splat special cases are resolved
+ * once here instead of on every request.
+ *
+ * @param from_route_pattern The pattern from the redirect rule (e.g., "/news/:month/:date/:slug").
+ * @param program A pointer to the nr_route_program_t to fill.
+ */
+void nr_compile_route_pattern(const char *from_route_pattern, nr_route_program_t *program);
+
+/**
+ * @brief Splits a URL into path, query string and path segments.
+ *
+ * @param url The full URL string (e.g., "/news/02/12/my-story?id=123").
+ * @param parsed_url A pointer to the nr_parsed_url_t to fill.
+ */
+void nr_parse_url(const char *url, nr_parsed_url_t *parsed_url);
+
+/**
+ * @brief Splits a length-delimited URL into path, query string and path segments.
+ *
+ * Nothing is copied and url is never read past url_len, so it can point
+ * straight into a receive buffer. The buffer must outlive parsed_url.
+ *
+ * @param url The URL, not necessarily null-terminated.
+ * @param url_len Length of url.
+ * @param parsed_url A pointer to the nr_parsed_url_t to fill.
+ */
+void nr_parse_url_n(const char *url, size_t url_len, nr_parsed_url_t *parsed_url);
+
+/**
+ * @brief Finds the path and query string of a length-delimited URL, without splitting the path.
+ *
+ * The path is normalized as nr_parse_url_n does: a trailing '/' is dropped
+ * unless the path is the root.
+ *
+ * @param url The URL, not necessarily null-terminated.
+ * @param url_len Length of url.
+ * @param path_len Output: length of the path at the start of url.
+ * @param query Output: the query string, without '?' ("" if there is none).
+ * @param query_len Output: length of query.
+ */
+void nr_split_url_n(const char *url, size_t url_len, size_t *path_len, const char **query, size_t *query_len);
+
+/**
+ * @brief Splits a query string into its key=value pairs.
+ *
+ * @param query The query string, without the '?' (not necessarily null-terminated).
+ * @param query_len Length of query.
+ * @param query_pairs The pairs to fill; parsed is set to true.
+ */
+void nr_parse_query_pairs(const char *query, size_t query_len, nr_query_pairs_t *query_pairs);
+
+/**
+ * @brief Finds the first pair with a given key, with one probe of the key table.
+ *
+ * Later pairs with the same key follow through next.
+ *
+ * @param query_pairs The pairs, filled by nr_parse_query_pairs.
+ * @param key The key to look up (not necessarily null-terminated).
+ * @param key_len Length of key.
+ * @return The first pair with this key, or NULL if the query has none.
+ */
+const nr_query_pair_t* nr_query_pairs_find(const nr_query_pairs_t *query_pairs, const char *key, size_t key_len);
+
+/**
+ * @brief Returns the bit a query key sets in a key mask.
+ *
+ * A rule whose keys' bits are not all set in a request's
+ * nr_query_pairs_t.key_mask cannot match that request.
+ *
+ * @param key The query key (not necessarily null-terminated).
+ * @param key_len Length of key.
+ * @return A mask with one bit set.
+ */
+uint32_t nr_query_key_bit(const char *key, size_t key_len);
+
+/**
+ * @brief Returns the key mask a request needs for a rule's query parameters to match.
+ *
+ * @param query_params The rule's query parameters.
+ * @param num_query_params Number of entries in query_params.
+ * @return The OR of nr_query_key_bit over the parameters' keys; 0 if there are none.
+ */
+uint32_t nr_query_params_key_mask(const nr_key_value_item_t *query_params, uint8_t num_query_params);
+
+/**
+ * @brief Lowercases the path of a parsed URL into a buffer and points path and segments at it.
+ *
+ * Segment hashes are recomputed for the folded bytes. The query string and
+ * url are left alone, so captured values keep the casing of the request.
+ *
+ * @param parsed_url The URL, split by nr_parse_url.
+ * @param buffer Storage for the folded path, at least NR_MAX_ROUTE_LEN + 1 bytes.
+ * @return true if the path was folded, false if it is longer than NR_MAX_ROUTE_LEN (parsed_url is left alone).
+ */
+bool nr_fold_parsed_url(nr_parsed_url_t *parsed_url, char *buffer);
+
+/**
+ * @brief Lowercases the literal segments of a from_route pattern in place.
+ *
+ * Placeholder names keep their casing, since to_route refers to them by name.
+ *
+ * @param from_route_pattern The pattern to fold (e.g., "/Blog/:Slug" becomes "/blog/:Slug").
+ */
+void nr_fold_route_pattern(char *from_route_pattern);
+
+/**
+ * @brief Runs a compiled route program against a parsed URL, capturing placeholders.
+ *
+ * Gives the same result as nr_match_path_pattern for the pattern the program
+ * was compiled from. The URL must not have too_many_segments set.
+ *
+ * @param program The compiled pattern.
+ * @param from_route_pattern The pattern the program was compiled from.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param matched_params A pointer to `nr_matched_params_t` to store captured placeholder values.
+ * @return true if the URL path matches the pattern, false otherwise.
+ */
+bool nr_match_route_program(
+    const nr_route_program_t *program,
+    const char *from_route_pattern,
+    const nr_parsed_url_t *parsed_url,
+    nr_matched_params_t *matched_params
+);
+
+/**
+ * @brief Matches a parsed URL against a redirect rule using its compiled pattern.
+ *
+ * Equivalent to nanorouter_match_rule, but the URL is split only once per
+ * request and the pattern only once per rule.
+ *
+ * @param rule A pointer to the `redirect_rule_t` to match against.
+ * @param program The rule's compiled from_route.
+ * @param url The full URL string parsed_url was built from.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param matched_params A pointer to `nr_matched_params_t` to store all captured values (placeholders and query params).
+ * @return true if the rule matches the URL, false otherwise.
+ */
+bool nanorouter_match_compiled_rule(
+    const redirect_rule_t *rule,
+    const nr_route_program_t *program,
+    const char *url,
+    const nr_parsed_url_t *parsed_url,
+    nr_matched_params_t *matched_params
+);
+
+/**
+ * @brief Orders two compiled patterns by specificity.
+ *
+ * Operations are compared depth by depth, and the first depth where they differ
+ * decides: a literal segment beats a placeholder, which beats a splat, so the
+ * deeper of two otherwise equal patterns wins. A pattern that ends there beats
+ * a splat or the root splat.
+ *
+ * @param a The first compiled pattern.
+ * @param b The second compiled pattern.
+ * @return A negative value if a is more specific, a positive value if b is, 0 if they have the same shape.
+ */
+int nr_route_program_compare_specificity(const nr_route_program_t *a, const nr_route_program_t *b);
+
+/**
+ * @brief Checks whether some URL path matches both of two compiled patterns.
+ *
+ * @param a The first compiled pattern.
+ * @param a_pattern The pattern a was compiled from.
+ * @param b The second compiled pattern.
+ * @param b_pattern The pattern b was compiled from.
+ * @return true if the patterns can match the same path, false otherwise.
+ */
+bool nr_route_programs_overlap(const nr_route_program_t *a, const char *a_pattern, const nr_route_program_t *b, const char *b_pattern);
+
+/**
+ * @brief Matches a parsed URL against a compiled pattern and query parameters, capturing spans.
+ *
+ * Same result as nanorouter_match_compiled_rule, but nothing is copied: each
+ * capture records where its value sits in parsed_url->url.
+ *
+ * @param from_route_pattern The pattern the program was compiled from.
+ * @param program The compiled pattern.
+ * @param query_params The rule's query parameters.
+ * @param num_query_params Number of entries in query_params.
+ * @param parsed_url The request URL, split by nr_parse_url.
+ * @param captures Output: the captured spans. May be NULL when only the result is needed.
+ * @return true if the path and query parameters match, false otherwise.
+ */
+bool nr_match_compiled_pattern(
+    const char *from_route_pattern,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    const nr_parsed_url_t *parsed_url,
+    nr_capture_spans_t *captures
+);
+
+/**
+ * @brief Finds the first capture with a given name.
+ *
+ * @param captures The captured spans.
+ * @param key The parameter name ("*" for splats).
+ * @param key_len Length of key.
+ * @return The capture, or NULL if none has this name.
+ */
+const nr_capture_span_t* nr_capture_spans_find(const nr_capture_spans_t *captures, const char *key, size_t key_len);
+
 #endif // NANOROUTER_MATCHER_H
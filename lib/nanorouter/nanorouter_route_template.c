@@ -0,0 +1,215 @@
+#include "nanorouter_route_template.h"
+#include <string.h> // For memcpy, memcmp, strlen
+#include <ctype.h>  // For isalnum
+
+uint8_t nr_route_capture_keys(
+    const char *from_route,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    nr_capture_key_t *keys
+) {
+    uint8_t num_keys = 0;
+    bool path_done = false;
+    for (uint8_t i = 0; i < program->num_ops && !path_done && num_keys < NR_MAX_MATCHED_PARAMS; i++) {
+        const nr_route_op_t *op = &program->ops[i];
+        switch (op->opcode) {
+            case NR_ROUTE_OP_PARAM:
+                keys[num_keys].key = from_route + op->offset;
+                keys[num_keys].key_len = op->len;
+                keys[num_keys++].kind = NR_CAPTURE_SEGMENT;
+                break;
+            case NR_ROUTE_OP_SPLAT:
+            case NR_ROUTE_OP_SUFFIX:
+            case NR_ROUTE_OP_ANY:
+                keys[num_keys].key = op->len == 0 ? "*" : from_route + op->offset;
+                keys[num_keys].key_len = op->len == 0 ? 1 : op->len;
+                keys[num_keys++].kind = op->opcode == NR_ROUTE_OP_ANY ? NR_CAPTURE_PATH : NR_CAPTURE_REST;
+                path_done = true;
+                break;
+            case NR_ROUTE_OP_LITERAL:
+                break;
+            default: // NR_ROUTE_OP_END, NR_ROUTE_OP_FAIL
+                path_done = true;
+                break;
+        }
+    }
+    for (uint8_t i = 0; i < num_query_params && num_keys < NR_MAX_MATCHED_PARAMS; i++) {
+        if (query_params[i].is_present) {
+            keys[num_keys].key = query_params[i].key;
+            keys[num_keys].key_len = strlen(query_params[i].key);
+            keys[num_keys++].kind = NR_CAPTURE_QUERY;
+        }
+    }
+    return num_keys;
+}
+
+// The name a placeholder part looks up: its own, or "*" for splats
+static inline void nr_template_part_key(const nr_template_part_t *part, const char *to_route, const char **key, size_t *key_len) {
+    if (part->kind == NR_TEMPLATE_PART_SPLAT) {
+        *key = "*";
+        *key_len = 1;
+    } else {
+        *key = to_route + part->offset + 1;
+        *key_len = (size_t)part->len - 1;
+    }
+}
+
+static bool nr_template_add_part(nr_route_template_t *route_template, nr_template_part_kind_t kind, size_t offset, size_t len) {
+    if (route_template->num_parts >= NR_MAX_TEMPLATE_PARTS) {
+        return false;
+    }
+    nr_template_part_t *part = &route_template->parts[route_template->num_parts++];
+    part->kind = (uint8_t)kind;
+    part->capture = NR_TEMPLATE_NO_CAPTURE;
+    part->offset = (uint16_t)offset;
+    part->len = (uint16_t)len;
+    if (kind == NR_TEMPLATE_PART_LITERAL) {
+        route_template->literal_len += (uint16_t)len;
+    }
+    return true;
+}
+
+bool nr_compile_route_template(
+    const char *to_route,
+    const char *from_route,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    nr_route_template_t *route_template
+) {
+    route_template->num_parts = 0;
+    route_template->literal_len = 0;
+    route_template->has_query = strchr(to_route, '?') != NULL;
+
+    size_t pos = 0;
+    size_t literal_start = 0;
+    while (to_route[pos] != '\0') {
+        // A ':' only starts a placeholder when a name follows, so "https://" stays literal
+        bool is_placeholder = to_route[pos] == ':' && (isalnum((unsigned char)to_route[pos + 1]) || to_route[pos + 1] == '_');
+        if (!is_placeholder && to_route[pos] != '*') {
+            pos++;
+            continue;
+        }
+
+        size_t name_end = pos + 1;
+        while (to_route[name_end] != '\0' && to_route[name_end] != '/' && to_route[name_end] != '?') {
+            name_end++;
+        }
+        size_t len = name_end - pos;
+        // Splats, and :splat, are captured under "*"
+        bool is_splat = to_route[pos] == '*' || (len == 6 && strncmp(to_route + pos + 1, "splat", 5) == 0);
+
+        if ((pos > literal_start && !nr_template_add_part(route_template, NR_TEMPLATE_PART_LITERAL, literal_start, pos - literal_start)) ||
+            !nr_template_add_part(route_template, is_splat ? NR_TEMPLATE_PART_SPLAT : NR_TEMPLATE_PART_PLACEHOLDER, pos, len)) {
+            return false; // Too many parts
+        }
+        pos = name_end;
+        literal_start = pos;
+    }
+    if (pos > literal_start && !nr_template_add_part(route_template, NR_TEMPLATE_PART_LITERAL, literal_start, pos - literal_start)) {
+        return false;
+    }
+
+    // Bind each placeholder to the first capture with its name, as nr_capture_spans_find would pick
+    nr_capture_key_t keys[NR_MAX_MATCHED_PARAMS];
+    uint8_t num_keys = nr_route_capture_keys(from_route, program, query_params, num_query_params, keys);
+    for (uint8_t i = 0; i < route_template->num_parts; i++) {
+        nr_template_part_t *part = &route_template->parts[i];
+        if (part->kind == NR_TEMPLATE_PART_LITERAL) {
+            continue;
+        }
+        const char *key;
+        size_t key_len;
+        nr_template_part_key(part, to_route, &key, &key_len);
+        for (uint8_t k = 0; k < num_keys; k++) {
+            if (keys[k].key_len == key_len && memcmp(keys[k].key, key, key_len) == 0) {
+                part->capture = k;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the capture a placeholder part stands for.
+ *
+ * The bound slot is checked by name first. Matches that record captures in
+ * another order (URLs too deep for the compiled program) fall back to a
+ * search by name.
+ */
+static const nr_capture_span_t* nr_template_capture(const nr_template_part_t *part, const char *to_route, const nr_capture_spans_t *captures) {
+    const char *key;
+    size_t key_len;
+    nr_template_part_key(part, to_route, &key, &key_len);
+    if (part->capture < captures->num_spans) {
+        const nr_capture_span_t *span = &captures->spans[part->capture];
+        if (span->key_len == key_len && memcmp(span->key, key, key_len) == 0) {
+            return span;
+        }
+    }
+    return nr_capture_spans_find(captures, key, key_len);
+}
+
+const char* nr_route_template_part_key(const nr_route_template_t *route_template, uint8_t index, const char *to_route, size_t *key_len) {
+    const char *key;
+    nr_template_part_key(&route_template->parts[index], to_route, &key, key_len);
+    return key;
+}
+
+const char* nr_route_template_part(
+    const nr_route_template_t *route_template,
+    uint8_t index,
+    const char *to_route,
+    const char *url,
+    const nr_capture_spans_t *captures,
+    size_t *len
+) {
+    const nr_template_part_t *part = &route_template->parts[index];
+    if (part->kind != NR_TEMPLATE_PART_LITERAL) {
+        // Captured values are taken straight from the request URL
+        const nr_capture_span_t *capture = nr_template_capture(part, to_route, captures);
+        if (capture != NULL) {
+            *len = capture->len;
+            return url + capture->offset;
+        }
+    }
+    *len = part->len; // Literal, or a placeholder with nothing captured, kept as written
+    return to_route + part->offset;
+}
+
+size_t nr_route_template_length(const nr_route_template_t *route_template, const char *to_route, const nr_capture_spans_t *captures) {
+    size_t len = route_template->literal_len;
+    for (uint8_t i = 0; i < route_template->num_parts; i++) {
+        const nr_template_part_t *part = &route_template->parts[i];
+        if (part->kind != NR_TEMPLATE_PART_LITERAL) {
+            const nr_capture_span_t *capture = nr_template_capture(part, to_route, captures);
+            len += capture != NULL ? capture->len : part->len;
+        }
+    }
+    return len;
+}
+
+size_t nr_render_route_template(
+    const nr_route_template_t *route_template,
+    const char *to_route,
+    const char *url,
+    const nr_capture_spans_t *captures,
+    char *buffer,
+    size_t buffer_size
+) {
+    size_t capacity = buffer_size - 1;
+    size_t len = 0;
+    for (uint8_t i = 0; i < route_template->num_parts && len < capacity; i++) {
+        size_t bytes_len;
+        const char *bytes = nr_route_template_part(route_template, i, to_route, url, captures, &bytes_len);
+        if (bytes_len > capacity - len) {
+            bytes_len = capacity - len;
+        }
+        memcpy(buffer + len, bytes, bytes_len);
+        len += bytes_len;
+    }
+    buffer[len] = '\0';
+    return len;
+}
@@ -0,0 +1,178 @@
+#ifndef NANOROUTER_ROUTE_TEMPLATE_H
+#define NANOROUTER_ROUTE_TEMPLATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nanorouter_config.h" // For NR_MAX_TEMPLATE_PARTS
+#include "nanorouter_route_matcher.h" // For nr_route_program_t and nr_capture_spans_t
+#include "nanorouter_redirect_rule_parser.h" // For nr_key_value_item_t
+
+#define NR_TEMPLATE_NO_CAPTURE      UINT8_MAX
+
+// --- Struct Definitions ---
+
+/**
+ * @brief Kinds of part a to_route is compiled into.
+ */
+typedef enum {
+    NR_TEMPLATE_PART_LITERAL,       /**< Copied as written: to_route[offset, offset + len). */
+    NR_TEMPLATE_PART_PLACEHOLDER,   /**< ":name", replaced by the capture named to_route[offset + 1, offset + len). */
+    NR_TEMPLATE_PART_SPLAT          /**< "*" or ":splat", replaced by the capture named "*". */
+} nr_template_part_kind_t;
+
+/**
+ * @brief What a captured value can hold, by the op or query parameter that captures it.
+ */
+typedef enum {
+    NR_CAPTURE_SEGMENT,     /**< One non-empty path segment (":name" before the last segment). */
+    NR_CAPTURE_REST,        /**< One or more path segments ("*", "*.css" without its suffix, or a trailing ":name"). */
+    NR_CAPTURE_PATH,        /**< The whole path without its '/', possibly empty (a splat right after the root). */
+    NR_CAPTURE_QUERY        /**< A query value ("id=:id"): any bytes, possibly empty. */
+} nr_capture_kind_t;
+
+/**
+ * @brief A name a rule captures under, in the order its match records it.
+ */
+typedef struct {
+    const char *key;        /**< Parameter name (not null-terminated), or "*" for splats. */
+    size_t key_len;
+    uint8_t kind;           /**< One of nr_capture_kind_t. */
+} nr_capture_key_t;
+
+/**
+ * @brief One literal chunk or placeholder of a compiled to_route.
+ *
+ * A placeholder with nothing captured under its name is kept as written.
+ */
+typedef struct {
+    uint8_t kind;           /**< One of nr_template_part_kind_t. */
+    uint8_t capture;        /**< Index the rule's match puts this capture at, or NR_TEMPLATE_NO_CAPTURE. */
+    uint16_t offset;        /**< Offset of the part inside to_route (the ':' or '*' for placeholders). */
+    uint16_t len;           /**< Length of the part as written. */
+} nr_template_part_t;
+
+/**
+ * @brief A to_route compiled into literal chunks and capture slots.
+ *
+ * The template refers into the to_route string it was compiled from, so it
+ * must be kept next to that rule.
+ */
+typedef struct {
+    nr_template_part_t parts[NR_MAX_TEMPLATE_PARTS];
+    uint8_t num_parts;
+    uint16_t literal_len;   /**< Total length of the literal parts. */
+    bool has_query;         /**< to_route has its own '?', so the request's query is not passed through. */
+} nr_route_template_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Lists the names a rule captures, in nr_capture_spans_t order: path first, then query placeholders.
+ *
+ * @param from_route The rule's from_route, as compiled into program.
+ * @param program The rule's compiled from_route.
+ * @param query_params The rule's query parameters.
+ * @param num_query_params Number of entries in query_params.
+ * @param keys Output: NR_MAX_MATCHED_PARAMS entries.
+ * @return The number of entries filled.
+ */
+uint8_t nr_route_capture_keys(
+    const char *from_route,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    nr_capture_key_t *keys
+);
+
+/**
+ * @brief Compiles a to_route into a template, with each placeholder bound to its capture slot.
+ *
+ * A ':' only starts a placeholder when a name follows, so "https://" stays
+ * literal. Placeholder names run to the next '/' or '?'.
+ *
+ * @param to_route The rule's to_route.
+ * @param from_route The rule's from_route, as compiled into program.
+ * @param program The rule's compiled from_route; decides the order of path captures.
+ * @param query_params The rule's query parameters; placeholders ("id=:id") are captured after the path.
+ * @param num_query_params Number of entries in query_params.
+ * @param route_template Output: the compiled template.
+ * @return true on success, false if to_route needs more than NR_MAX_TEMPLATE_PARTS parts.
+ */
+bool nr_compile_route_template(
+    const char *to_route,
+    const char *from_route,
+    const nr_route_program_t *program,
+    const nr_key_value_item_t *query_params,
+    uint8_t num_query_params,
+    nr_route_template_t *route_template
+);
+
+/**
+ * @brief Returns the name a placeholder part looks up: its own, or "*" for splats.
+ *
+ * @param route_template The compiled template.
+ * @param index A placeholder or splat part, below num_parts.
+ * @param to_route The to_route it was compiled from.
+ * @param key_len Output: length of the name.
+ * @return The name (not null-terminated).
+ */
+const char* nr_route_template_part_key(const nr_route_template_t *route_template, uint8_t index, const char *to_route, size_t *key_len);
+
+/**
+ * @brief Returns the bytes one part of a template renders to.
+ *
+ * Literal parts point into to_route, placeholders into the request URL (or
+ * into to_route, as written, when nothing was captured under their name).
+ *
+ * @param route_template The compiled template.
+ * @param index The part, below num_parts.
+ * @param to_route The to_route it was compiled from.
+ * @param url The request URL the captures point into (nr_parsed_url_t.url).
+ * @param captures The spans captured by the rule's match.
+ * @param len Output: number of bytes.
+ * @return The first byte (not null-terminated).
+ */
+const char* nr_route_template_part(
+    const nr_route_template_t *route_template,
+    uint8_t index,
+    const char *to_route,
+    const char *url,
+    const nr_capture_spans_t *captures,
+    size_t *len
+);
+
+/**
+ * @brief Returns the length a template renders to, before any truncation.
+ *
+ * @param route_template The compiled template.
+ * @param to_route The to_route it was compiled from.
+ * @param captures The spans captured by the rule's match.
+ * @return The rendered length, without the request query.
+ */
+size_t nr_route_template_length(const nr_route_template_t *route_template, const char *to_route, const nr_capture_spans_t *captures);
+
+/**
+ * @brief Renders a template into a buffer, substituting the captured values.
+ *
+ * Output is cut at buffer_size - 1 bytes and always null-terminated.
+ *
+ * @param route_template The compiled template.
+ * @param to_route The to_route it was compiled from.
+ * @param url The request URL the captures point into (nr_parsed_url_t.url).
+ * @param captures The spans captured by the rule's match.
+ * @param buffer Output buffer.
+ * @param buffer_size Size of buffer, including the terminator. Must be at least 1.
+ * @return The number of bytes written, without the terminator.
+ */
+size_t nr_render_route_template(
+    const nr_route_template_t *route_template,
+    const char *to_route,
+    const char *url,
+    const nr_capture_spans_t *captures,
+    char *buffer,
+    size_t buffer_size
+);
+
+#endif // NANOROUTER_ROUTE_TEMPLATE_H
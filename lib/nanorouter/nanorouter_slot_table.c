@@ -0,0 +1,119 @@
+#include "nanorouter_slot_table.h"
+#include <stdlib.h> // For calloc, realloc, free
+#include <string.h> // For memcmp, memcpy, strncasecmp
+
+bool nr_slot_table_init(nr_slot_table_t *table, nr_slot_keys_t keys, size_t value_size) {
+    if (table == NULL || value_size < sizeof(void*)) {
+        return false;
+    }
+    table->capacity = 8;
+    table->num_keys = 0;
+    table->value_size = value_size;
+    table->keys = (uint8_t)keys;
+    table->slots = (nr_slot_t*) calloc(table->capacity, sizeof(nr_slot_t));
+    return table->slots != NULL;
+}
+
+void nr_slot_table_free(nr_slot_table_t *table) {
+    if (table == NULL || table->slots == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < table->capacity; i++) {
+        free(table->slots[i].values);
+    }
+    free(table->slots);
+    table->slots = NULL;
+}
+
+// Checks whether a slot holds a key, as the table tells keys apart.
+static bool nr_slot_holds(const nr_slot_t *slot, uint8_t keys, const char *key, size_t key_len, uint32_t hash) {
+    if (slot->hash != hash || slot->key_len != key_len) {
+        return false;
+    }
+    switch (keys) {
+        case NR_SLOT_KEYS_BYTES:
+            return memcmp(slot->key, key, key_len) == 0;
+        case NR_SLOT_KEYS_NOCASE:
+            return strncasecmp(slot->key, key, key_len) == 0;
+        default:
+            return true; // A hash collision only files two keys together
+    }
+}
+
+// Linear probing; returns the slot holding the key, or the empty slot where it belongs.
+static nr_slot_t* nr_slot_probe(nr_slot_t *slots, size_t capacity, uint8_t keys, const char *key, size_t key_len, uint32_t hash) {
+    size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    while (true) {
+        nr_slot_t *slot = &slots[pos];
+        if (slot->values == NULL || nr_slot_holds(slot, keys, key, key_len, hash)) {
+            return slot;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+// Doubles the slot array, keeping the load factor at or below one half.
+static bool nr_slot_table_grow(nr_slot_table_t *table) {
+    size_t capacity = table->capacity * 2;
+    nr_slot_t *slots = (nr_slot_t*) calloc(capacity, sizeof(nr_slot_t));
+    if (slots == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < table->capacity; i++) {
+        const nr_slot_t *old = &table->slots[i];
+        if (old->values != NULL) {
+            *nr_slot_probe(slots, capacity, table->keys, old->key, old->key_len, old->hash) = *old;
+        }
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+nr_slot_t* nr_slot_table_find(const nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash) {
+    if (table == NULL || table->num_keys == 0) {
+        return NULL;
+    }
+    nr_slot_t *slot = nr_slot_probe(table->slots, table->capacity, table->keys, key, key_len, hash);
+    return slot->values != NULL ? slot : NULL;
+}
+
+void* nr_slot_table_append(nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash) {
+    if (table == NULL) {
+        return NULL;
+    }
+
+    if ((table->num_keys + 1) * 2 > table->capacity && !nr_slot_table_grow(table)) {
+        return NULL;
+    }
+
+    nr_slot_t *slot = nr_slot_probe(table->slots, table->capacity, table->keys, key, key_len, hash);
+    void *values = realloc(slot->values, (slot->num_values + 1) * table->value_size);
+    if (values == NULL) {
+        return NULL;
+    }
+    if (slot->values == NULL) {
+        slot->key = table->keys == NR_SLOT_KEYS_HASHED ? NULL : key;
+        slot->key_len = key_len;
+        slot->hash = hash;
+        table->num_keys++;
+    }
+    slot->values = values;
+    return (char*)slot->values + table->value_size * slot->num_values++;
+}
+
+bool nr_slot_table_remove_last(nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash, const void *rule) {
+    nr_slot_t *slot = nr_slot_table_find(table, key, key_len, hash);
+    if (slot == NULL || slot->num_values == 0) {
+        return false;
+    }
+    const void *last;
+    memcpy(&last, (const char*)slot->values + table->value_size * (slot->num_values - 1), sizeof(last));
+    if (last != rule) {
+        return false;
+    }
+    slot->num_values--;
+    return true;
+}
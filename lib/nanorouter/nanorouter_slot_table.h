@@ -0,0 +1,103 @@
+#ifndef NANOROUTER_SLOT_TABLE_H
+#define NANOROUTER_SLOT_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Struct Definitions ---
+
+/**
+ * @brief How a slot table tells its keys apart.
+ */
+typedef enum {
+    NR_SLOT_KEYS_BYTES,         /**< Compared byte for byte (file extensions). */
+    NR_SLOT_KEYS_NOCASE,        /**< Compared ignoring ASCII case (host names); hash them with nr_hash_bytes_nocase. */
+    NR_SLOT_KEYS_HASHED         /**< Told apart by hash and length alone; the key bytes are not kept (path prefixes). */
+} nr_slot_keys_t;
+
+/**
+ * @brief One open-addressing slot: a key and the values filed under it.
+ */
+typedef struct {
+    const char *key;            /**< Points into what the first value was filed for (not null-terminated); NULL for NR_SLOT_KEYS_HASHED. */
+    size_t key_len;
+    uint32_t hash;
+    void *values;               /**< num_values entries of the table's value_size, in the order they were added; NULL for an empty slot. */
+    size_t num_values;
+} nr_slot_t;
+
+/**
+ * @brief Open-addressing hash table of value arrays, keyed by byte strings.
+ *
+ * The shared core of the rule indexes: linear probing over a power-of-two
+ * slot array that doubles at half load, with each key keeping a growing array
+ * of fixed-size values. Every value starts with a pointer to the rule it is
+ * filed for. Keys are hashed by the caller, so a caller may fold anything into
+ * the hash, and the table only references key bytes, which must outlive it.
+ */
+typedef struct {
+    nr_slot_t *slots;
+    size_t capacity;            /**< Power of two. */
+    size_t num_keys;
+    size_t value_size;
+    uint8_t keys;               /**< One of nr_slot_keys_t. */
+} nr_slot_table_t;
+
+// --- Function Prototypes ---
+
+/**
+ * @brief Initializes an empty slot table.
+ *
+ * @param table The table to initialize.
+ * @param keys How keys are told apart.
+ * @param value_size Size of one value; at least sizeof(void*), as a value starts with its rule.
+ * @return true on success, false on allocation failure.
+ */
+bool nr_slot_table_init(nr_slot_table_t *table, nr_slot_keys_t keys, size_t value_size);
+
+/**
+ * @brief Frees the slots and value arrays of a table initialized with nr_slot_table_init.
+ *
+ * @param table The table. May be NULL.
+ */
+void nr_slot_table_free(nr_slot_table_t *table);
+
+/**
+ * @brief Returns the slot holding a key, with a single hash probe.
+ *
+ * @param table The table.
+ * @param key The key (not necessarily null-terminated). May be NULL for NR_SLOT_KEYS_HASHED.
+ * @param key_len Length of key.
+ * @param hash The key's hash, as it was given when the key was added.
+ * @return The slot, or NULL if nothing is filed under the key.
+ */
+nr_slot_t* nr_slot_table_find(const nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash);
+
+/**
+ * @brief Appends a value to a key's array, adding the key if it is new.
+ *
+ * @param table The table.
+ * @param key The key; referenced by the table, so it must outlive it.
+ * @param key_len Length of key.
+ * @param hash The key's hash.
+ * @return Storage for the new value, left for the caller to fill, or NULL on allocation failure (nothing is added then).
+ */
+void* nr_slot_table_append(nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash);
+
+/**
+ * @brief Takes back the value most recently appended under a key.
+ *
+ * Lets a caller that fails later in adding a rule free it without leaving
+ * the table pointing at it. The key keeps its slot, now possibly with no values.
+ *
+ * @param table The table.
+ * @param key The key the value was filed under.
+ * @param key_len Length of key.
+ * @param hash The key's hash.
+ * @param rule The rule the last value was filed for.
+ * @return true if the value was removed, false if the key's last value is not filed for rule.
+ */
+bool nr_slot_table_remove_last(nr_slot_table_t *table, const char *key, size_t key_len, uint32_t hash, const void *rule);
+
+#endif // NANOROUTER_SLOT_TABLE_H
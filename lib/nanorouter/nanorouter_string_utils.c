@@ -113,3 +113,39 @@ void nr_string_split(const char *str, size_t str_len, const char *delimiter, nr_
         }
     }
 }
+
+// 32-bit FNV-1a hash, used by the rule indexes
+uint32_t nr_hash_bytes(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Seeded variant of nr_hash_bytes with a final avalanche step, used by the perfect-hash tables.
+// scripts/generate_redirect_mph.py carries a copy of this function and must be kept in sync.
+uint32_t nr_hash_bytes_seeded(const char *data, size_t len, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// nr_hash_bytes over the ASCII-lowercased bytes, for host names and other case-insensitive keys.
+uint32_t nr_hash_bytes_nocase(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
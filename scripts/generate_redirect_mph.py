@@ -0,0 +1,273 @@
+import argparse
+import difflib
+import io
+import os
+import sys
+
+# Keep in sync with nanorouter_config.h
+NR_MAX_ROUTE_LEN = 128
+NR_MAX_PATH_SEGMENTS = 32
+
+MASK32 = 0xFFFFFFFF
+
+# Line endings of the generated sources, as in the rest of the tree
+NEWLINE = "\r\n"
+
+
+def hash_bytes(data):
+    """
+    32-bit FNV-1a, same as nr_hash_bytes() in nanorouter_string_utils.c.
+    """
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & MASK32
+    return h
+
+
+def hash_bytes_seeded(data, seed):
+    """
+    Same as nr_hash_bytes_seeded() in nanorouter_string_utils.c.
+    """
+    h = 2166136261 ^ seed
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & MASK32
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & MASK32
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & MASK32
+    h ^= h >> 16
+    return h
+
+
+def is_numeric(token):
+    return len(token) > 0 and all("0" <= c <= "9" for c in token)
+
+
+def parse_redirect_line(line):
+    """
+    Mirrors nr_parse_redirect_rule(): returns the from_route of a valid rule, or None.
+    """
+    tokens = line.split()
+    if not tokens or tokens[0].startswith("#"):
+        return None
+
+    from_route = tokens[0][:NR_MAX_ROUTE_LEN]
+    to_route = None
+    status_identified = False
+    for token in tokens[1:]:
+        if "=" in token:
+            continue  # Query parameter or condition
+        if to_route is None:
+            to_route = token[:NR_MAX_ROUTE_LEN]
+        elif not status_identified:
+            status = token[:-1] if token.endswith("!") else token
+            if is_numeric(status):
+                status_identified = True
+                if not 100 <= int(status) <= 1000:
+                    return None  # parsing_error
+    if not to_route:
+        return None
+    return from_route
+
+
+def literal_route_key(from_route):
+    """
+    Mirrors nr_compile_route_pattern(): returns the route's segments joined by '/'
+    if it only has literal segments, or None for placeholders, splats and
+    patterns that never match.
+    """
+    if from_route == "/*":
+        return None
+    path = from_route[1:] if from_route.startswith("/") else from_route
+    if path == "":
+        return b""
+    key = path[:-1] if path.endswith("/") else path
+    segments = key.split("/")
+    if len(segments) > NR_MAX_PATH_SEGMENTS:
+        return None
+    for segment in segments:
+        if segment.startswith("*") or segment.startswith(":"):
+            return None
+    return key.encode("utf-8")
+
+
+def build_table(keys, bucket_size):
+    """
+    Hash and displace: every key is assigned to a bucket with the plain hash,
+    then buckets are placed largest first by searching for a seed that sends
+    all of their keys to free slots.
+    """
+    num_entries = len(keys)
+    num_buckets = max(1, (num_entries + bucket_size - 1) // bucket_size)
+
+    buckets = [[] for _ in range(num_buckets)]
+    for key in keys:
+        buckets[hash_bytes(key) % num_buckets].append(key)
+
+    seeds = [0] * num_buckets
+    slots = [None] * num_entries
+    order = sorted(range(num_buckets), key=lambda b: len(buckets[b]), reverse=True)
+    for b in order:
+        if not buckets[b]:
+            continue
+        seed = 0
+        while True:
+            positions = [hash_bytes_seeded(key, seed) % num_entries for key in buckets[b]]
+            if len(set(positions)) == len(positions) and all(slots[p] is None for p in positions):
+                break
+            seed += 1
+            if seed > MASK32:
+                raise RuntimeError("no seed found for bucket %d" % b)
+        seeds[b] = seed
+        for key, position in zip(buckets[b], positions):
+            slots[position] = key
+
+    return seeds, slots
+
+
+def c_string(data):
+    out = []
+    for b in data:
+        c = chr(b)
+        if c in "\\\"":
+            out.append("\\" + c)
+        elif 0x20 <= b < 0x7F and c != "?":  # '?' is avoided to rule out trigraphs
+            out.append(c)
+        else:
+            out.append("\\%03o" % b)
+    return '"' + "".join(out) + '"'
+
+
+def render_sources(out_base, name, seeds, slots, rules_by_key, num_rules):
+    """
+    Returns the generated header and source text, keyed by output path.
+    """
+    guard = os.path.basename(out_base).upper().replace("-", "_").replace(".", "_") + "_H"
+    header_name = os.path.basename(out_base) + ".h"
+
+    h = io.StringIO()
+    h.write("// Generated by scripts/generate_redirect_mph.py, do not edit.\n")
+    h.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    h.write('#include "nanorouter_redirect_mph.h"\n\n')
+    h.write("extern const nr_redirect_mph_table_t %s;\n\n" % name)
+    h.write("#endif // %s\n" % guard)
+
+    rule_indices = []
+    entries = []
+    for key in slots:
+        indices = rules_by_key[key]
+        entries.append((key, len(rule_indices), len(indices)))
+        rule_indices.extend(indices)
+
+    f = io.StringIO()
+    f.write("// Generated by scripts/generate_redirect_mph.py, do not edit.\n")
+    f.write('#include "%s"\n\n' % header_name)
+
+    f.write("static const uint32_t %s_seeds[%d] = {\n" % (name, len(seeds)))
+    for i in range(0, len(seeds), 8):
+        f.write("    " + ", ".join("%uu" % s for s in seeds[i:i + 8]) + ",\n")
+    f.write("};\n\n")
+
+    f.write("static const nr_redirect_mph_entry_t %s_entries[%d] = {\n" % (name, max(1, len(entries))))
+    for key, first, count in entries:
+        f.write("    { %s, %d, %d, %d },\n" % (c_string(key), len(key), first, count))
+    if not entries:
+        f.write("    { \"\", 0, 0, 0 },\n")
+    f.write("};\n\n")
+
+    f.write("static const uint16_t %s_rule_indices[%d] = {\n" % (name, max(1, len(rule_indices))))
+    for i in range(0, len(rule_indices), 16):
+        f.write("    " + ", ".join(str(r) for r in rule_indices[i:i + 16]) + ",\n")
+    if not rule_indices:
+        f.write("    0,\n")
+    f.write("};\n\n")
+
+    f.write("const nr_redirect_mph_table_t %s = {\n" % name)
+    f.write("    .seeds = %s_seeds,\n" % name)
+    f.write("    .num_buckets = %d,\n" % len(seeds))
+    f.write("    .entries = %s_entries,\n" % name)
+    f.write("    .num_entries = %d,\n" % len(entries))
+    f.write("    .rule_indices = %s_rule_indices,\n" % name)
+    f.write("    .num_rule_indices = %d,\n" % len(rule_indices))
+    f.write("    .num_rules = %d,\n" % num_rules)
+    f.write("};\n")
+
+    return {out_base + ".h": h.getvalue(), out_base + ".c": f.getvalue()}
+
+
+def check_sources(sources):
+    """
+    Compares generated text with the files on disk; prints a diff and returns False if any differ.
+    """
+    same = True
+    for path, text in sources.items():
+        try:
+            with open(path, "r", encoding="utf-8", newline="") as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = ""
+        expected = text.replace("\n", NEWLINE)
+        if current != expected:
+            same = False
+            sys.stdout.writelines(difflib.unified_diff(
+                current.splitlines(True), expected.splitlines(True), path, path + " (regenerated)"))
+    return same
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate a const minimal perfect hash over the literal routes of a _redirects file.")
+    parser.add_argument("redirects", help="path to the _redirects file")
+    parser.add_argument("out_base", help="output path without extension; writes <out_base>.c and <out_base>.h")
+    parser.add_argument("--name", default="nr_redirect_mph_table", help="name of the generated table variable")
+    parser.add_argument("--bucket-size", type=int, default=4, help="average number of keys per bucket")
+    parser.add_argument("--check", action="store_true",
+                        help="write nothing; fail if <out_base>.c and <out_base>.h differ from what would be generated")
+    args = parser.parse_args()
+
+    with open(args.redirects, "r", encoding="utf-8") as f:
+        lines = f.read().split("\n")
+
+    # Rule indexes follow nanorouter_parse_redirects_file(), which skips invalid lines
+    rules_by_key = {}
+    num_rules = 0
+    for line in lines:
+        from_route = parse_redirect_line(line)
+        if from_route is None:
+            continue
+        key = literal_route_key(from_route)
+        if key is not None:
+            rules_by_key.setdefault(key, []).append(num_rules)
+        num_rules += 1
+
+    if num_rules > 0xFFFF:
+        print("Error: more than 65535 rules do not fit the uint16_t rule indexes.", flush=True)
+        sys.exit(1)
+
+    keys = list(rules_by_key.keys())
+    seeds, slots = build_table(keys, args.bucket_size)
+
+    # Every key must land in its own slot with a single probe
+    for key in keys:
+        bucket = hash_bytes(key) % len(seeds)
+        if slots[hash_bytes_seeded(key, seeds[bucket]) % len(slots)] != key:
+            print("Error: perfect hash verification failed for %r." % key, flush=True)
+            sys.exit(1)
+
+    sources = render_sources(args.out_base, args.name, seeds, slots, rules_by_key, num_rules)
+    if args.check:
+        if not check_sources(sources):
+            print("Error: %s.c/.h are out of date; regenerate them from %s." % (args.out_base, args.redirects), flush=True)
+            sys.exit(1)
+        print("%s.c/.h match %s" % (args.out_base, args.redirects), flush=True)
+        return
+    for path, text in sources.items():
+        with open(path, "w", newline=NEWLINE) as f:
+            f.write(text)
+    print("%d rules, %d literal routes, %d buckets, 0 collisions, 1 probe per lookup"
+          % (num_rules, len(keys), len(seeds)), flush=True)
+
+
+if __name__ == "__main__":
+    main()
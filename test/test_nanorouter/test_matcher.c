@@ -94,6 +94,29 @@ void test_match_path_unnamed_splat_wildcard(void) {
     TEST_ASSERT_EQUAL_STRING("api/v1/users", find_matched_param(&matched_params, "*"));
 }
 
+void test_match_path_extension_splat(void) {
+    nr_matched_params_t matched_params;
+    TEST_ASSERT_TRUE(nr_match_path_pattern("/style.css", "/*.css", &matched_params));
+    TEST_ASSERT_EQUAL(1, matched_params.num_params);
+    TEST_ASSERT_EQUAL_STRING("style", find_matched_param(&matched_params, "*"));
+
+    // The splat takes any depth, as a trailing '*' does
+    TEST_ASSERT_TRUE(nr_match_path_pattern("/assets/js/app.min.js", "/assets/*.js", &matched_params));
+    TEST_ASSERT_EQUAL_STRING("js/app.min", find_matched_param(&matched_params, "*"));
+    TEST_ASSERT_TRUE(nr_match_path_pattern("/assets/app.min.js", "/assets/*.min.js", &matched_params));
+    TEST_ASSERT_EQUAL_STRING("app", find_matched_param(&matched_params, "*"));
+
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/style.css.map", "/*.css", &matched_params));
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/other/app.js", "/assets/*.js", &matched_params));
+    // The splat must match something in the last segment
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/.css", "/*.css", &matched_params));
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/dir/.css", "/*.css", &matched_params));
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/", "/*.css", &matched_params));
+    // Only a whole segment after the last '/' makes an extension splat
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/app.js", "/a*.js", &matched_params));
+    TEST_ASSERT_FALSE(nr_match_path_pattern("/a.js/b", "/*.js/b", &matched_params));
+}
+
 void test_match_path_no_match(void) {
     nr_matched_params_t matched_params;
     TEST_ASSERT_FALSE(nr_match_path_pattern("/foo/bar", "/foo/baz", &matched_params));
@@ -250,6 +273,340 @@ void test_nanorouter_match_rule_no_match_query(void) {
     TEST_ASSERT_FALSE(nanorouter_match_rule(&rule, "/path?id=456", &matched_params));
 }
 
+// --- Compiled Route Program Tests (nr_compile_route_pattern / nr_match_route_program) ---
+
+void test_compile_route_pattern_ops(void) {
+    nr_route_program_t program;
+    nr_compile_route_pattern("/news/:month/*", &program);
+    TEST_ASSERT_EQUAL(3, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_LITERAL, program.ops[0].opcode);
+    TEST_ASSERT_EQUAL(1, program.ops[0].offset);
+    TEST_ASSERT_EQUAL(4, program.ops[0].len);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_PARAM, program.ops[1].opcode);
+    TEST_ASSERT_EQUAL(7, program.ops[1].offset);
+    TEST_ASSERT_EQUAL(5, program.ops[1].len);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_SPLAT, program.ops[2].opcode);
+    TEST_ASSERT_EQUAL(0, program.ops[2].len);
+
+    nr_compile_route_pattern("/", &program);
+    TEST_ASSERT_EQUAL(1, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_END, program.ops[0].opcode);
+
+    nr_compile_route_pattern("/*", &program);
+    TEST_ASSERT_EQUAL(1, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_ANY, program.ops[0].opcode);
+
+    nr_compile_route_pattern("/foo/*/baz", &program);
+    TEST_ASSERT_EQUAL(1, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_FAIL, program.ops[0].opcode);
+
+    nr_compile_route_pattern("/assets/*.min.js", &program);
+    TEST_ASSERT_EQUAL(2, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_SUFFIX, program.ops[1].opcode);
+    TEST_ASSERT_EQUAL(9, program.ops[1].offset);
+    TEST_ASSERT_EQUAL(7, program.ops[1].len);
+
+    nr_compile_route_pattern("/*.js/b", &program);
+    TEST_ASSERT_EQUAL(1, program.num_ops);
+    TEST_ASSERT_EQUAL(NR_ROUTE_OP_FAIL, program.ops[0].opcode);
+}
+
+void test_parse_url_segments(void) {
+    nr_parsed_url_t parsed_url;
+    nr_parse_url("/news/2024//story/?id=1&x=2", &parsed_url);
+    TEST_ASSERT_EQUAL(17, parsed_url.path_len);
+    TEST_ASSERT_EQUAL_STRING("id=1&x=2", parsed_url.query);
+    TEST_ASSERT_FALSE(parsed_url.too_many_segments);
+    TEST_ASSERT_EQUAL(4, parsed_url.num_segments);
+    TEST_ASSERT_EQUAL_STRING_LEN("news", parsed_url.segments[0].start, 4);
+    TEST_ASSERT_EQUAL(4, parsed_url.segments[1].len);
+    TEST_ASSERT_EQUAL(0, parsed_url.segments[2].len);
+    TEST_ASSERT_EQUAL_STRING_LEN("story", parsed_url.segments[3].start, 5);
+
+    nr_parse_url("/", &parsed_url);
+    TEST_ASSERT_EQUAL(0, parsed_url.num_segments);
+    TEST_ASSERT_EQUAL_STRING("", parsed_url.query);
+}
+
+void test_parse_url_segment_hashes_match_literal_ops(void) {
+    nr_route_program_t program;
+    nr_parsed_url_t parsed_url;
+    nr_compile_route_pattern("/news/:id/story", &program);
+    nr_parse_url("/news/42/story", &parsed_url);
+
+    TEST_ASSERT_EQUAL_UINT32(nr_hash_bytes("news", 4), parsed_url.segments[0].hash);
+    TEST_ASSERT_EQUAL_UINT32(nr_hash_bytes("42", 2), parsed_url.segments[1].hash);
+    TEST_ASSERT_EQUAL_UINT32(parsed_url.segments[0].hash, program.ops[0].hash);
+    TEST_ASSERT_EQUAL_UINT32(parsed_url.segments[2].hash, program.ops[2].hash);
+    TEST_ASSERT_EQUAL_UINT32(0, program.ops[1].hash); // Placeholders carry no hash
+}
+
+void test_match_route_program_agrees_with_string_matcher(void) {
+    static const char *const patterns[] = {
+        "/", "/*", "*", "/foo/bar", "/foo/bar/", "/foo/*", "/foo/:id", "/foo/:year/:month",
+        "/blog/:splat", "/foo/*/baz", "/foo*", "/a//b", "", "/:a/:b/c", "/docs/*x",
+        "/*.css", "/foo/*.css", "/*.min.js", "/*.", "/foo/*.css/x",
+    };
+    static const char *const urls[] = {
+        "/", "", "/foo", "/foo/", "/foo/bar", "/foo/bar/", "/foo/bar/baz", "/foo/123/baz",
+        "/foo//bar", "/a//b", "/a/b", "/blog/2023/10/my-post", "/x/y/c", "/x//c", "foo/bar", "/foo*",
+        "/a.css", "/.css", "/foo/b.css", "/foo/bar/b.css", "/foo/.css", "/foo//b.css", "/x.min.js", "/x.js", "/a.",
+    };
+
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        nr_route_program_t program;
+        nr_compile_route_pattern(patterns[p], &program);
+        for (size_t u = 0; u < sizeof(urls) / sizeof(urls[0]); u++) {
+            nr_matched_params_t expected_params;
+            nr_matched_params_t actual_params;
+            nr_parsed_url_t parsed_url;
+            char normalized[NR_MAX_ROUTE_LEN + 1];
+
+            nr_parse_url(urls[u], &parsed_url);
+            memcpy(normalized, parsed_url.path, parsed_url.path_len);
+            normalized[parsed_url.path_len] = '\0';
+
+            bool expected = nr_match_path_pattern(normalized, patterns[p], &expected_params);
+            bool actual = nr_match_route_program(&program, patterns[p], &parsed_url, &actual_params);
+            TEST_ASSERT_EQUAL(expected, actual);
+            if (expected) {
+                TEST_ASSERT_EQUAL(expected_params.num_params, actual_params.num_params);
+                for (uint8_t i = 0; i < expected_params.num_params; i++) {
+                    TEST_ASSERT_EQUAL_STRING(expected_params.params[i].key, actual_params.params[i].key);
+                    TEST_ASSERT_EQUAL_STRING(expected_params.params[i].value, actual_params.params[i].value);
+                }
+            }
+        }
+    }
+}
+
+void test_nanorouter_match_compiled_rule_with_query(void) {
+    nr_matched_params_t matched_params;
+    nr_route_program_t program;
+    nr_parsed_url_t parsed_url;
+    redirect_rule_t rule = create_test_rule("/blog/:year/:month/:splat", "/newpath", 200, false);
+    add_rule_query_param(&rule, "author", "", true);
+    nr_compile_route_pattern(rule.from_route, &program);
+
+    const char *url = "/blog/2023/10/my-post?author=john";
+    nr_parse_url(url, &parsed_url);
+    TEST_ASSERT_TRUE(nanorouter_match_compiled_rule(&rule, &program, url, &parsed_url, &matched_params));
+    TEST_ASSERT_EQUAL(4, matched_params.num_params);
+    TEST_ASSERT_EQUAL_STRING("my-post", find_matched_param(&matched_params, "splat"));
+    TEST_ASSERT_EQUAL_STRING("john", find_matched_param(&matched_params, "author"));
+
+    url = "/blog/2023/10/my-post";
+    nr_parse_url(url, &parsed_url);
+    TEST_ASSERT_FALSE(nanorouter_match_compiled_rule(&rule, &program, url, &parsed_url, &matched_params));
+}
+
+void test_route_program_compare_specificity(void) {
+    nr_route_program_t literal, param, splat, any, root, deeper;
+    nr_compile_route_pattern("/blog/featured", &literal);
+    nr_compile_route_pattern("/blog/:slug/edit", &param);
+    nr_compile_route_pattern("/blog/*", &splat);
+    nr_compile_route_pattern("/*", &any);
+    nr_compile_route_pattern("/", &root);
+    nr_compile_route_pattern("/blog/:year/*", &deeper);
+
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&literal, &param) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&param, &splat) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&deeper, &splat) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&splat, &any) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&root, &any) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&any, &literal) > 0);
+    TEST_ASSERT_EQUAL(0, nr_route_program_compare_specificity(&splat, &splat));
+
+    // An extension splat sits between a placeholder and a plain splat
+    nr_route_program_t suffix;
+    nr_compile_route_pattern("/blog/*.html", &suffix);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&param, &suffix) < 0);
+    TEST_ASSERT_TRUE(nr_route_program_compare_specificity(&suffix, &splat) < 0);
+}
+
+void test_route_programs_overlap_agrees_with_matcher(void) {
+    static const char *const patterns[] = {
+        "/", "/*", "/foo/bar", "/foo/*", "/foo/:id", "/foo/:year/:month", "/:a/bar", "/foo/:id/baz",
+        "/a//b", "/:a/:b/c", "/bar/*", "/*.css", "/foo/*.css", "/*.min.css",
+    };
+    static const char *const urls[] = {
+        "/", "/foo", "/foo/bar", "/foo/bar/baz", "/foo/123/baz", "/foo//bar", "/a//b", "/a/b",
+        "/x/y/c", "/x/bar", "/bar/x", "/a.css", "/foo/a.css", "/foo/a.min.css", "/bar/x.css",
+    };
+
+    for (size_t a = 0; a < sizeof(patterns) / sizeof(patterns[0]); a++) {
+        for (size_t b = 0; b < sizeof(patterns) / sizeof(patterns[0]); b++) {
+            nr_route_program_t program_a, program_b;
+            nr_compile_route_pattern(patterns[a], &program_a);
+            nr_compile_route_pattern(patterns[b], &program_b);
+            bool overlap = nr_route_programs_overlap(&program_a, patterns[a], &program_b, patterns[b]);
+
+            // Any URL matching both patterns proves an overlap
+            for (size_t u = 0; u < sizeof(urls) / sizeof(urls[0]); u++) {
+                nr_matched_params_t params;
+                if (nr_match_path_pattern(urls[u], patterns[a], &params) && nr_match_path_pattern(urls[u], patterns[b], &params)) {
+                    TEST_ASSERT_TRUE_MESSAGE(overlap, urls[u]);
+                }
+            }
+        }
+    }
+
+    nr_route_program_t literal, other;
+    nr_compile_route_pattern("/foo/bar", &literal);
+    nr_compile_route_pattern("/bar/*", &other);
+    TEST_ASSERT_FALSE(nr_route_programs_overlap(&literal, "/foo/bar", &other, "/bar/*"));
+    nr_compile_route_pattern("/foo/bar/baz", &other);
+    TEST_ASSERT_FALSE(nr_route_programs_overlap(&literal, "/foo/bar", &other, "/foo/bar/baz"));
+
+    nr_route_program_t css, js;
+    nr_compile_route_pattern("/*.css", &css);
+    nr_compile_route_pattern("/*.js", &js);
+    TEST_ASSERT_FALSE(nr_route_programs_overlap(&css, "/*.css", &js, "/*.js"));
+}
+
+void test_match_compiled_pattern_captures_spans(void) {
+    nr_capture_spans_t captures;
+    nr_route_program_t program;
+    nr_parsed_url_t parsed_url;
+    redirect_rule_t rule = create_test_rule("/news/:year/story/*", "/newpath", 301, false);
+    add_rule_query_param(&rule, "id", "", true);
+    nr_compile_route_pattern(rule.from_route, &program);
+
+    const char *url = "/news/2024/story/a/b?tag=x&id=42";
+    nr_parse_url(url, &parsed_url);
+    TEST_ASSERT_TRUE(nr_match_compiled_pattern(rule.from_route, &program, rule.query_params, rule.num_query_params, &parsed_url, &captures));
+    TEST_ASSERT_EQUAL(3, captures.num_spans);
+
+    const nr_capture_span_t *year = nr_capture_spans_find(&captures, "year", 4);
+    TEST_ASSERT_NOT_NULL(year);
+    TEST_ASSERT_EQUAL(6, year->offset);
+    TEST_ASSERT_EQUAL(4, year->len);
+    TEST_ASSERT_EQUAL_PTR(rule.from_route + 7, year->key); // Names are not copied either
+
+    const nr_capture_span_t *splat = nr_capture_spans_find(&captures, "*", 1);
+    TEST_ASSERT_NOT_NULL(splat);
+    TEST_ASSERT_EQUAL(17, splat->offset);
+    TEST_ASSERT_EQUAL(3, splat->len);
+
+    const nr_capture_span_t *id = nr_capture_spans_find(&captures, "id", 2);
+    TEST_ASSERT_NOT_NULL(id);
+    TEST_ASSERT_EQUAL_STRING("42", url + id->offset);
+    TEST_ASSERT_NULL(nr_capture_spans_find(&captures, "tag", 3));
+
+    // The verdict alone needs no storage
+    TEST_ASSERT_TRUE(nr_match_compiled_pattern(rule.from_route, &program, rule.query_params, rule.num_query_params, &parsed_url, NULL));
+    nr_parse_url("/news/2024/story/a/b?tag=x", &parsed_url);
+    TEST_ASSERT_FALSE(nr_match_compiled_pattern(rule.from_route, &program, rule.query_params, rule.num_query_params, &parsed_url, NULL));
+}
+
+void test_match_compiled_pattern_spans_agree_with_copies(void) {
+    static const char *const patterns[] = {
+        "/", "/*", "/foo/:id", "/foo/:year/:month", "/blog/:splat", "/:a/:b/c", "/foo/*",
+    };
+    static const char *const urls[] = {
+        "/", "/foo/bar", "/foo/bar/baz", "/Foo/123/Baz", "/blog/2023/10/my-post", "/x/y/c",
+        "/1/2/3/4/5/6/7/8/9/10/11/12/13/14/15/16/17/18/19/20/21/22/23/24/25/26/27/28/29/30/31/32/33",
+    };
+
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        nr_route_program_t program;
+        nr_compile_route_pattern(patterns[p], &program);
+        for (size_t u = 0; u < sizeof(urls) / sizeof(urls[0]); u++) {
+            for (int fold = 0; fold < 2; fold++) {
+                nr_parsed_url_t parsed_url;
+                char folded_path[NR_MAX_ROUTE_LEN + 1];
+                nr_parse_url(urls[u], &parsed_url);
+                if (fold) {
+                    nr_fold_parsed_url(&parsed_url, folded_path);
+                }
+
+                redirect_rule_t rule = create_test_rule(patterns[p], "/", 301, false);
+                nr_matched_params_t expected;
+                nr_capture_spans_t actual;
+                char folded_url[NR_MAX_ROUTE_LEN + 1];
+                memcpy(folded_url, parsed_url.path, parsed_url.path_len);
+                folded_url[parsed_url.path_len] = '\0';
+
+                bool expected_result = nanorouter_match_rule(&rule, folded_url, &expected);
+                bool actual_result = nr_match_compiled_pattern(patterns[p], &program, NULL, 0, &parsed_url, &actual);
+                TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, urls[u]);
+                if (!expected_result) {
+                    continue;
+                }
+                TEST_ASSERT_EQUAL(expected.num_params, actual.num_spans);
+                for (uint8_t i = 0; i < actual.num_spans; i++) {
+                    const nr_capture_span_t *span = &actual.spans[i];
+                    TEST_ASSERT_EQUAL(strlen(expected.params[i].key), span->key_len);
+                    TEST_ASSERT_EQUAL_INT(0, strncmp(expected.params[i].key, span->key, span->key_len));
+                    // Values come from the URL as written, even when the path was folded
+                    TEST_ASSERT_EQUAL(strlen(expected.params[i].value), span->len);
+                    TEST_ASSERT_EQUAL_INT(0, strncasecmp(expected.params[i].value, urls[u] + span->offset, span->len));
+                }
+            }
+        }
+    }
+}
+
+void test_parse_url_n_stops_at_length(void) {
+    // A slice of a receive buffer: nothing after the length is read
+    const char *buffer = "/blog/hello?ref=feed HTTP/1.1";
+    nr_parsed_url_t parsed_url;
+    nr_parse_url_n(buffer, strlen("/blog/hello?ref=feed"), &parsed_url);
+    TEST_ASSERT_EQUAL(11, parsed_url.path_len);
+    TEST_ASSERT_EQUAL(8, parsed_url.query_len);
+    TEST_ASSERT_EQUAL_STRING_LEN("ref=feed", parsed_url.query, parsed_url.query_len);
+    TEST_ASSERT_EQUAL(2, parsed_url.num_segments);
+
+    // A '?' past the end does not start a query string
+    nr_parse_url_n("/a/b/?x=1", 5, &parsed_url);
+    TEST_ASSERT_EQUAL(4, parsed_url.path_len);
+    TEST_ASSERT_EQUAL(0, parsed_url.query_len);
+    TEST_ASSERT_EQUAL(2, parsed_url.num_segments);
+}
+
+void test_parse_url_long_path_not_truncated(void) {
+    char url[NR_MAX_ROUTE_LEN * 2 + 1];
+    memset(url, 'a', sizeof(url) - 1);
+    url[0] = '/';
+    memcpy(url + NR_MAX_ROUTE_LEN + 4, "/end", 4);
+    url[sizeof(url) - 1] = '\0';
+
+    nr_parsed_url_t parsed_url;
+    nr_parse_url(url, &parsed_url);
+    TEST_ASSERT_EQUAL(NR_MAX_ROUTE_LEN * 2, parsed_url.path_len);
+    TEST_ASSERT_EQUAL(2, parsed_url.num_segments);
+
+    // Segments past NR_MAX_ROUTE_LEN take part in the match, and splats capture all of the rest
+    nr_route_program_t program;
+    nr_capture_spans_t captures;
+    nr_compile_route_pattern("/:page/*", &program);
+    TEST_ASSERT_TRUE(nr_match_compiled_pattern("/:page/*", &program, NULL, 0, &parsed_url, &captures));
+    TEST_ASSERT_EQUAL(2, captures.num_spans);
+    TEST_ASSERT_EQUAL(NR_MAX_ROUTE_LEN + 3, captures.spans[0].len);
+    TEST_ASSERT_EQUAL(NR_MAX_ROUTE_LEN * 2 - (NR_MAX_ROUTE_LEN + 5), captures.spans[1].len);
+
+    // Case folding needs a bounded buffer and reports paths that do not fit
+    char folded_path[NR_MAX_ROUTE_LEN + 1];
+    TEST_ASSERT_FALSE(nr_fold_parsed_url(&parsed_url, folded_path));
+    TEST_ASSERT_EQUAL_PTR(url, parsed_url.path);
+}
+
+void test_nanorouter_match_rule_n(void) {
+    redirect_rule_t rule = create_test_rule("/item/:slug", "/", 301, false);
+    add_rule_query_param(&rule, "id", "", true);
+
+    // The query value ends where the slice ends, not at the buffer's NUL
+    const char *buffer = "/item/lamp?id=42 HTTP/1.1";
+    nr_matched_params_t params;
+    TEST_ASSERT_TRUE(nanorouter_match_rule_n(&rule, buffer, strlen("/item/lamp?id=42"), &params));
+    TEST_ASSERT_EQUAL(2, params.num_params);
+    TEST_ASSERT_EQUAL_STRING("lamp", params.params[0].value);
+    TEST_ASSERT_EQUAL_STRING("42", params.params[1].value);
+
+    // Cut before the query: the required parameter is missing
+    TEST_ASSERT_FALSE(nanorouter_match_rule_n(&rule, buffer, strlen("/item/lamp"), &params));
+}
+
 // --- Test Runner ---
 int test_matcher(void) {
     UNITY_BEGIN();
@@ -262,6 +619,7 @@ int test_matcher(void) {
     RUN_TEST(test_match_path_placeholder_multiple_segments);
     RUN_TEST(test_match_path_splat_placeholder_named);
     RUN_TEST(test_match_path_unnamed_splat_wildcard);
+    RUN_TEST(test_match_path_extension_splat);
     RUN_TEST(test_match_path_no_match);
     RUN_TEST(test_match_path_trailing_slash_normalization);
     RUN_TEST(test_match_path_root_wildcard);
@@ -286,5 +644,19 @@ int test_matcher(void) {
     RUN_TEST(test_nanorouter_match_rule_no_match_path);
     RUN_TEST(test_nanorouter_match_rule_no_match_query);
 
+    // Compiled Route Program Tests
+    RUN_TEST(test_compile_route_pattern_ops);
+    RUN_TEST(test_parse_url_segments);
+    RUN_TEST(test_parse_url_segment_hashes_match_literal_ops);
+    RUN_TEST(test_match_route_program_agrees_with_string_matcher);
+    RUN_TEST(test_nanorouter_match_compiled_rule_with_query);
+    RUN_TEST(test_route_program_compare_specificity);
+    RUN_TEST(test_route_programs_overlap_agrees_with_matcher);
+    RUN_TEST(test_match_compiled_pattern_captures_spans);
+    RUN_TEST(test_match_compiled_pattern_spans_agree_with_copies);
+    RUN_TEST(test_parse_url_n_stops_at_length);
+    RUN_TEST(test_parse_url_long_path_not_truncated);
+    RUN_TEST(test_nanorouter_match_rule_n);
+
     return UNITY_END();
 }
@@ -11,6 +11,23 @@
 #include "test_string_utils_edge_cases.h"
 #include "test_condition_matching_edge_cases.h"
 #include "test_nanorouter_redirect_rule_parser_edge_cases.h"
+#include "test_nanorouter_redirect_trie.h"
+#include "test_nanorouter_redirect_hash.h"
+#include "test_nanorouter_redirect_mph.h"
+#include "test_nanorouter_redirect_dfa.h"
+#include "test_nanorouter_redirect_bitset.h"
+#include "test_nanorouter_redirect_prefilter.h"
+#include "test_nanorouter_redirect_host.h"
+#include "test_nanorouter_redirect_phases.h"
+#include "test_nanorouter_redirect_order.h"
+#include "test_nanorouter_redirect_case.h"
+#include "test_nanorouter_request.h"
+#include "test_nanorouter_route_template.h"
+#include "test_nanorouter_redirect_chain.h"
+#include "test_nanorouter_redirect_not_found.h"
+#include "test_nanorouter_extension_index.h"
+#include "test_nanorouter_redirect_batch.h"
+#include "test_nanorouter_decision_cache.h"
 #include <string.h> // For strncpy
 #include <stdlib.h> // For free
 #include <stdbool.h> // For bool type
@@ -28,6 +45,23 @@ int main(void) {
         test_rule_parser_redirect_rules() | // Run the redirect rule parser tests
         test_matcher() |  // Run the matcher tests
         test_nanorouter_redirect_middleware() | // Run the redirect middleware tests
+        test_nanorouter_redirect_trie() | // Run the redirect trie engine tests
+        test_nanorouter_redirect_hash() | // Run the redirect hash engine tests
+        test_nanorouter_redirect_mph() | // Run the static perfect-hash engine tests
+        test_nanorouter_redirect_dfa() | // Run the redirect automaton engine tests
+        test_nanorouter_redirect_bitset() | // Run the redirect bitset engine tests
+        test_nanorouter_redirect_prefilter() | // Run the redirect prefilter engine tests
+        test_nanorouter_redirect_host() | // Run the host-dispatched redirect tests
+        test_nanorouter_redirect_phases() | // Run the forced/fallback pass tests
+        test_nanorouter_redirect_order() | // Run the specificity order tests
+        test_nanorouter_redirect_case() | // Run the case-insensitive matching tests
+        test_nanorouter_request() | // Run the shared request tests
+        test_nanorouter_route_template() | // Run the to_route template tests
+        test_nanorouter_redirect_chain() | // Run the rewrite chain resolution tests
+        test_nanorouter_redirect_not_found() | // Run the path-scoped 404 lookup tests
+        test_nanorouter_extension_index() | // Run the file extension index tests
+        test_nanorouter_redirect_batch() | // Run the batch request tests
+        test_nanorouter_decision_cache() | // Run the decision cache tests
         test_header_rule_parser() | // Run the header rule parser tests
         test_headers_edge_cases() | // Run header parsing edge case tests
         test_nanorouter_headers_middleware() | // Run the headers middleware tests
@@ -0,0 +1,294 @@
+#include "test_nanorouter_decision_cache.h"
+
+#include "unity.h"
+#include "nanorouter_decision_cache.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_headers_middleware.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *const DECISION_TEST_REDIRECTS =
+    "https://www.example.com/* https://example.com/:splat 301!\n"
+    "/old /new 301\n"
+    "/news/:year/:slug /blog/:year/:slug 301\n"
+    "/search q=:q /find/:q 302\n"
+    "/store /store/de 302 Country=de\n"
+    "/store /store/en 302 Language=en\n"
+    "/*.php /index.html 410\n";
+
+static const char *const DECISION_TEST_URLS[] = {
+    "/old", "/news/2024/hello", "/search?q=shoes", "/search", "/store", "/a.php", "/missing", "/",
+};
+
+#define DECISION_TEST_NUM_URLS (sizeof(DECISION_TEST_URLS) / sizeof(DECISION_TEST_URLS[0]))
+
+static nanorouter_request_context_t decision_test_context(const char *domain, const char *country, const char *language) {
+    nanorouter_request_context_t context;
+    memset(&context, 0, sizeof(context));
+    strncpy(context.domain, domain, NR_MAX_DOMAIN_LEN);
+    strncpy(context.country, country, NR_MAX_COUNTRY_LEN);
+    strncpy(context.language, language, NR_MAX_LANGUAGE_LEN);
+    strncpy(context.scheme, "https", NR_MAX_SCHEME_LEN);
+    return context;
+}
+
+static void decision_test_assert_stats(nr_decision_cache_t *cache, uint32_t expected_hits, uint32_t expected_lookups) {
+    uint32_t hits;
+    uint32_t lookups;
+    nr_decision_cache_stats(cache, &hits, &lookups);
+    TEST_ASSERT_EQUAL_UINT32(expected_hits, hits);
+    TEST_ASSERT_EQUAL_UINT32(expected_lookups, lookups);
+}
+
+void test_decision_key(void) {
+    nanorouter_request_context_t de = decision_test_context("example.com", "de", "");
+    nanorouter_request_context_t us = decision_test_context("example.com", "us", "");
+    nr_decision_key_t a;
+    nr_decision_key_t b;
+
+    TEST_ASSERT_TRUE(nr_decision_key_init(&a, "/store", 6, &de));
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/store", 6, &de));
+    TEST_ASSERT_EQUAL(a.len, b.len);
+    TEST_ASSERT_EQUAL_UINT32(a.hash, b.hash);
+    TEST_ASSERT_EQUAL_MEMORY(a.bytes, b.bytes, a.len);
+
+    // Every field of the context is part of the key
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/store", 6, &us));
+    TEST_ASSERT_FALSE(a.len == b.len && memcmp(a.bytes, b.bytes, a.len) == 0);
+    us = decision_test_context("example.com", "de", "");
+    strncpy(us.scheme, "http", NR_MAX_SCHEME_LEN);
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/store", 6, &us));
+    TEST_ASSERT_FALSE(a.len == b.len && memcmp(a.bytes, b.bytes, a.len) == 0);
+
+    // A URL can't pass for a shorter one followed by context fields
+    nanorouter_request_context_t empty = decision_test_context("", "", "");
+    memset(empty.scheme, 0, sizeof(empty.scheme));
+    TEST_ASSERT_TRUE(nr_decision_key_init(&a, "/a", 2, &empty));
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/a\0\0", 4, NULL));
+    TEST_ASSERT_FALSE(a.len == b.len && memcmp(a.bytes, b.bytes, a.len) == 0);
+
+    // A NULL context is keyed like an empty one
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/a", 2, NULL));
+    TEST_ASSERT_EQUAL(a.len, b.len);
+    TEST_ASSERT_EQUAL_MEMORY(a.bytes, b.bytes, a.len);
+
+    char long_url[NR_DECISION_CACHE_KEY_LEN];
+    memset(long_url, 'a', sizeof(long_url));
+    long_url[0] = '/';
+    TEST_ASSERT_FALSE(nr_decision_key_init(&a, long_url, sizeof(long_url), NULL));
+    TEST_ASSERT_FALSE(nr_decision_key_init(&a, long_url, NR_DECISION_CACHE_KEY_LEN - 5, NULL));
+    TEST_ASSERT_TRUE(nr_decision_key_init(&a, long_url, NR_DECISION_CACHE_KEY_LEN - 6, NULL));
+    TEST_ASSERT_FALSE(nr_decision_key_init(&a, long_url, NR_DECISION_CACHE_KEY_LEN - 6, &de));
+    TEST_ASSERT_FALSE(nr_decision_key_init(NULL, "/a", 2, NULL));
+    TEST_ASSERT_FALSE(nr_decision_key_init(&a, NULL, 0, NULL));
+}
+
+void test_decision_cache_redirects(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(DECISION_TEST_REDIRECTS);
+    nr_decision_cache_t *cache = nr_decision_cache_create(64, sizeof(nanorouter_redirect_response_t));
+    TEST_ASSERT_NOT_NULL(cache);
+    const nanorouter_request_context_t contexts[] = {
+        decision_test_context("example.com", "de", ""),
+        decision_test_context("example.com", "us", "en"),
+        decision_test_context("www.example.com", "us", ""),
+    };
+
+    // The first round fills the cache and the second is served from it; both match the uncached results
+    for (int round = 0; round < 2; round++) {
+        for (size_t c = 0; c < 3; c++) {
+            for (size_t i = 0; i < DECISION_TEST_NUM_URLS; i++) {
+                nanorouter_redirect_response_t expected;
+                nanorouter_redirect_response_t cached;
+                bool expected_applied = nanorouter_process_redirect_request(DECISION_TEST_URLS[i], list, &expected, &contexts[c]);
+                strcpy(cached.new_url, "/stale");
+                cached.status_code = 200;
+                TEST_ASSERT_EQUAL_MESSAGE(expected_applied,
+                    nanorouter_process_redirect_request_cached(DECISION_TEST_URLS[i], list, &cached, &contexts[c], cache), DECISION_TEST_URLS[i]);
+                TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, cached.status_code, DECISION_TEST_URLS[i]);
+                TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, cached.new_url, DECISION_TEST_URLS[i]);
+            }
+        }
+    }
+    uint32_t hits;
+    uint32_t lookups;
+    nr_decision_cache_stats(cache, &hits, &lookups);
+    TEST_ASSERT_EQUAL_UINT32(3 * DECISION_TEST_NUM_URLS * 2, lookups);
+    TEST_ASSERT_TRUE(hits > 0 && hits <= 3 * DECISION_TEST_NUM_URLS);
+
+    // Without a cache, or with a NULL URL, the request is simply decided
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/old", list, &response, NULL, NULL));
+    TEST_ASSERT_EQUAL_STRING("/new", response.new_url);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_cached(NULL, list, &response, NULL, cache));
+    TEST_ASSERT_EQUAL(0, response.status_code);
+
+    nr_decision_cache_free(cache);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_decision_cache_context(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(DECISION_TEST_REDIRECTS);
+    nr_decision_cache_t *cache = nr_decision_cache_create(1024, sizeof(nanorouter_redirect_response_t));
+    TEST_ASSERT_NOT_NULL(cache);
+    nanorouter_request_context_t de = decision_test_context("example.com", "de", "");
+    nanorouter_request_context_t en = decision_test_context("example.com", "us", "en");
+    nanorouter_redirect_response_t response;
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/store", list, &response, &de, cache));
+    TEST_ASSERT_EQUAL_STRING("/store/de", response.new_url);
+    decision_test_assert_stats(cache, 0, 1);
+
+    // The same URL from another country is its own entry
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/store", list, &response, &en, cache));
+    TEST_ASSERT_EQUAL_STRING("/store/en", response.new_url);
+    decision_test_assert_stats(cache, 0, 2);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/store", list, &response, &de, cache));
+    TEST_ASSERT_EQUAL_STRING("/store/de", response.new_url);
+    TEST_ASSERT_EQUAL(302, response.status_code);
+    decision_test_assert_stats(cache, 1, 3);
+
+    // Misses are cached too, and reset the response
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_cached("/missing", list, &response, &de, cache));
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_cached("/missing", list, &response, &de, cache));
+    TEST_ASSERT_EQUAL_STRING("", response.new_url);
+    TEST_ASSERT_EQUAL(0, response.status_code);
+    decision_test_assert_stats(cache, 2, 5);
+
+    nr_decision_cache_free(cache);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_decision_cache_generation(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(DECISION_TEST_REDIRECTS);
+    nr_decision_cache_t *cache = nr_decision_cache_create(1024, sizeof(nanorouter_redirect_response_t));
+    TEST_ASSERT_NOT_NULL(cache);
+    nanorouter_redirect_response_t response;
+
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_cached("/gone", list, &response, NULL, cache));
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_cached("/gone", list, &response, NULL, cache));
+    decision_test_assert_stats(cache, 1, 2);
+
+    // Adding a rule renews the list's generation, so the cached miss is stale
+    uint32_t generation = list->generation;
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/gone /here 301\n", list));
+    TEST_ASSERT_TRUE(list->generation != generation);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/gone", list, &response, NULL, cache));
+    TEST_ASSERT_EQUAL_STRING("/here", response.new_url);
+    decision_test_assert_stats(cache, 1, 3);
+
+    // So does reordering
+    generation = list->generation;
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    TEST_ASSERT_TRUE(list->generation != generation);
+
+    // A reloaded list never sees the old list's entries, even with the same rules
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/old", list, &response, NULL, cache));
+    nanorouter_redirect_rule_list_t *reloaded = redirect_engine_test_load_rules(DECISION_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(reloaded->generation != list->generation);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/old", reloaded, &response, NULL, cache));
+    TEST_ASSERT_EQUAL_STRING("/new", response.new_url);
+    decision_test_assert_stats(cache, 1, 5);
+
+    nanorouter_redirect_rule_list_free(reloaded);
+    nr_decision_cache_free(cache);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_decision_cache_headers(void) {
+    nanorouter_header_rule_list_t *rules = nanorouter_header_rule_list_create();
+    TEST_ASSERT_NOT_NULL(rules);
+    TEST_ASSERT_TRUE(nanorouter_parse_headers_file(
+        "/*\n  X-Frame-Options: DENY\n/*.css\n  Cache-Control: max-age=3600\n  X-Tag: css\n", rules));
+    nanorouter_redirect_rule_list_t *redirects = redirect_engine_test_load_rules(DECISION_TEST_REDIRECTS);
+
+    // One cache serves both middleware
+    nr_decision_cache_t *cache = nr_decision_cache_create(256, sizeof(nanorouter_header_response_t));
+    TEST_ASSERT_NOT_NULL(cache);
+
+    static const char *const urls[] = { "/site.css", "/index.html", "/site.css", "/old" };
+    for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++) {
+        nanorouter_header_response_t expected;
+        nanorouter_header_response_t cached;
+        bool expected_applied = nanorouter_process_header_request(urls[i], rules, &expected, NULL);
+        TEST_ASSERT_EQUAL_MESSAGE(expected_applied, nanorouter_process_header_request_cached(urls[i], rules, &cached, NULL, cache), urls[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(expected.num_headers, cached.num_headers, urls[i]);
+        for (uint8_t h = 0; h < expected.num_headers; h++) {
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.headers[h].key, cached.headers[h].key, urls[i]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.headers[h].value, cached.headers[h].value, urls[i]);
+        }
+    }
+    decision_test_assert_stats(cache, 1, 4);
+
+    // The header decision for "/old" is not mistaken for the redirect one, or the other way round
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_cached("/old", redirects, &response, NULL, cache));
+    TEST_ASSERT_EQUAL_STRING("/new", response.new_url);
+    nanorouter_header_response_t headers;
+    TEST_ASSERT_TRUE(nanorouter_process_header_request_cached("/old", rules, &headers, NULL, cache));
+    TEST_ASSERT_EQUAL(1, headers.num_headers);
+    TEST_ASSERT_EQUAL_STRING("X-Frame-Options", headers.headers[0].key);
+
+    nr_decision_cache_free(cache);
+    nanorouter_redirect_rule_list_free(redirects);
+    nanorouter_header_rule_list_free(rules);
+}
+
+void test_decision_cache_entries(void) {
+    TEST_ASSERT_TRUE(nr_decision_cache_create(0, 16) == NULL);
+    TEST_ASSERT_TRUE(nr_decision_cache_create(1, (size_t)UINT16_MAX + 1) == NULL);
+    nr_decision_cache_free(NULL);
+
+    // A single entry: every key lands on it, and the newest decision wins
+    nr_decision_cache_t *cache = nr_decision_cache_create(1, 8);
+    TEST_ASSERT_NOT_NULL(cache);
+    uint32_t generation = nr_decision_cache_next_generation();
+    TEST_ASSERT_TRUE(generation != 0);
+    nr_decision_key_t a;
+    nr_decision_key_t b;
+    TEST_ASSERT_TRUE(nr_decision_key_init(&a, "/a", 2, NULL));
+    TEST_ASSERT_TRUE(nr_decision_key_init(&b, "/b", 2, NULL));
+
+    char value[8];
+    size_t value_len = sizeof(value);
+    bool applied = false;
+    nr_decision_cache_store(cache, &a, generation, "1234", 4, true);
+    TEST_ASSERT_TRUE(nr_decision_cache_lookup(cache, &a, generation, value, &value_len, &applied));
+    TEST_ASSERT_EQUAL(4, value_len);
+    TEST_ASSERT_EQUAL_MEMORY("1234", value, 4);
+    TEST_ASSERT_TRUE(applied);
+
+    value_len = sizeof(value);
+    TEST_ASSERT_FALSE(nr_decision_cache_lookup(cache, &a, generation + 1, value, &value_len, &applied));
+    TEST_ASSERT_FALSE(nr_decision_cache_lookup(cache, &b, generation, value, &value_len, &applied));
+
+    nr_decision_cache_store(cache, &b, generation, "", 0, false);
+    TEST_ASSERT_FALSE(nr_decision_cache_lookup(cache, &a, generation, value, &value_len, &applied));
+    TEST_ASSERT_TRUE(nr_decision_cache_lookup(cache, &b, generation, value, &value_len, &applied));
+    TEST_ASSERT_EQUAL(0, value_len);
+    TEST_ASSERT_FALSE(applied);
+
+    // Values over the cache's limit are not stored, and lookups with too small a buffer miss
+    nr_decision_cache_store(cache, &a, generation, "123456789", 9, true);
+    value_len = sizeof(value);
+    TEST_ASSERT_FALSE(nr_decision_cache_lookup(cache, &a, generation, value, &value_len, &applied));
+    nr_decision_cache_store(cache, &a, generation, "1234", 4, true);
+    value_len = 2;
+    TEST_ASSERT_FALSE(nr_decision_cache_lookup(cache, &a, generation, value, &value_len, &applied));
+    decision_test_assert_stats(cache, 2, 7);
+
+    nr_decision_cache_free(cache);
+}
+
+int test_nanorouter_decision_cache(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decision_key);
+    RUN_TEST(test_decision_cache_redirects);
+    RUN_TEST(test_decision_cache_context);
+    RUN_TEST(test_decision_cache_generation);
+    RUN_TEST(test_decision_cache_headers);
+    RUN_TEST(test_decision_cache_entries);
+    return UNITY_END();
+}
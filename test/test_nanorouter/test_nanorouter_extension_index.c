@@ -0,0 +1,269 @@
+#include "test_nanorouter_extension_index.h"
+
+#include "unity.h"
+#include "nanorouter_extension_index.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_header_rule_parser.h"
+#include "nanorouter_headers_middleware.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Suffix rules as found in docs/samples/*/_headers, between two catch-all rules
+static const char *const EXTENSION_TEST_HEADERS =
+    "/*\n"
+    "  X-Tag: root\n"
+    "/*.css\n"
+    "  X-Tag: css\n"
+    "/assets/*.js\n"
+    "  X-Tag: assets-js\n"
+    "/*.js\n"
+    "  X-Tag: js\n"
+    "/test-suite/tests/*.jldt\n"
+    "  Content-Type: application/jldTest+json\n"
+    "/test-suite/tests/*.jldte\n"
+    "  Content-Type: application/jldTest\n"
+    "/*\n"
+    "  X-Tag: last\n";
+
+static const char *const EXTENSION_TEST_REDIRECTS =
+    "/pizero/index.html /pizero/ 301\n"
+    "/pizero/*.html /pizero/:splat 301\n"
+    "/*.php /index.html 410\n"
+    "/legacy/* /old/:splat 302\n"
+    "/*.html /:splat 301\n"
+    "/assets/*.min.js /assets/:splat 200\n";
+
+static const char *const EXTENSION_TEST_URLS[] = {
+    "/pizero/index.html", "/pizero/setup.html", "/pizero/a/b.html", "/pizero/.html", "/legacy/x.php", "/legacy/x.html",
+    "/about.html", "/about.htm", "/assets/app.min.js", "/assets/app.js", "/x.php?id=1", "/", "/html", "/a.b/c",
+};
+
+static void extension_test_assert_header(const char *url, const char *key, const char *expected_value) {
+    nanorouter_header_rule_list_t *rules = nanorouter_header_rule_list_create();
+    TEST_ASSERT_NOT_NULL(rules);
+    TEST_ASSERT_TRUE(nanorouter_parse_headers_file(EXTENSION_TEST_HEADERS, rules));
+
+    nanorouter_header_response_t response = {0};
+    nanorouter_process_header_request(url, rules, &response, NULL);
+    const char *value = NULL;
+    for (uint8_t i = 0; i < response.num_headers; i++) {
+        if (strcmp(response.headers[i].key, key) == 0) {
+            value = response.headers[i].value;
+        }
+    }
+    if (expected_value == NULL) {
+        TEST_ASSERT_TRUE_MESSAGE(value == NULL, url);
+    } else {
+        TEST_ASSERT_TRUE_MESSAGE(value != NULL, url);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_value, value, url);
+    }
+    nanorouter_header_rule_list_free(rules);
+}
+
+static void extension_test_assert_redirect(nanorouter_redirect_rule_list_t *list, const char *url, const char *expected_url, int expected_status) {
+    nanorouter_redirect_response_t response;
+    bool applied = nanorouter_process_redirect_request(url, list, &response, NULL);
+    if (expected_url == NULL) {
+        TEST_ASSERT_FALSE_MESSAGE(applied, url);
+        return;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(applied, url);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_url, response.new_url, url);
+    TEST_ASSERT_EQUAL_MESSAGE(expected_status, response.status_code, url);
+}
+
+void test_extension_of_routes_and_paths(void) {
+    nr_route_program_t program;
+    size_t len = 0;
+
+    nr_compile_route_pattern("/assets/*.min.js", &program);
+    const char *extension = nr_route_program_extension(&program, "/assets/*.min.js", &len);
+    TEST_ASSERT_NOT_NULL(extension);
+    TEST_ASSERT_EQUAL_STRING_LEN(".js", extension, len);
+    TEST_ASSERT_EQUAL(3, len);
+
+    // Only a trailing extension splat has an extension
+    nr_compile_route_pattern("/assets/*", &program);
+    TEST_ASSERT_NULL(nr_route_program_extension(&program, "/assets/*", &len));
+    nr_compile_route_pattern("/style.css", &program);
+    TEST_ASSERT_NULL(nr_route_program_extension(&program, "/style.css", &len));
+    TEST_ASSERT_NULL(nr_route_program_extension(NULL, "/style.css", &len));
+
+    extension = nr_url_path_extension("/assets/js/app.min.js", 21, &len);
+    TEST_ASSERT_NOT_NULL(extension);
+    TEST_ASSERT_EQUAL_STRING_LEN(".js", extension, len);
+    // The path is a span; nothing past path_len is looked at
+    extension = nr_url_path_extension("/a.css/b.html", 6, &len);
+    TEST_ASSERT_NOT_NULL(extension);
+    TEST_ASSERT_EQUAL_STRING_LEN(".css", extension, len);
+    TEST_ASSERT_NULL(nr_url_path_extension("/a.b/c", 6, &len));
+    TEST_ASSERT_NULL(nr_url_path_extension("/", 1, &len));
+    TEST_ASSERT_NULL(nr_url_path_extension(NULL, 0, &len));
+}
+
+void test_extension_index_lookup(void) {
+    nr_extension_index_t *index = nr_extension_index_create();
+    TEST_ASSERT_NOT_NULL(index);
+
+    // Enough extensions to grow the table a few times, each with rules in insertion order
+    static int rules[64];
+    char extensions[32][8];
+    for (int i = 0; i < 32; i++) {
+        snprintf(extensions[i], sizeof(extensions[i]), ".e%d", i);
+        TEST_ASSERT_TRUE(nr_extension_index_add(index, extensions[i], strlen(extensions[i]), &rules[i]));
+    }
+    for (int i = 0; i < 32; i++) {
+        TEST_ASSERT_TRUE(nr_extension_index_add(index, extensions[i], strlen(extensions[i]), &rules[32 + i]));
+    }
+
+    for (int i = 0; i < 32; i++) {
+        size_t num_rules = 0;
+        const void *const *found = nr_extension_index_lookup(index, extensions[i], strlen(extensions[i]), &num_rules);
+        TEST_ASSERT_NOT_NULL(found);
+        TEST_ASSERT_EQUAL(2, num_rules);
+        TEST_ASSERT_EQUAL_PTR(&rules[i], found[0]);
+        TEST_ASSERT_EQUAL_PTR(&rules[32 + i], found[1]);
+    }
+
+    size_t num_rules = 1;
+    TEST_ASSERT_NULL(nr_extension_index_lookup(index, ".e", 2, &num_rules));
+    TEST_ASSERT_EQUAL(0, num_rules);
+    TEST_ASSERT_NULL(nr_extension_index_lookup(index, NULL, 0, &num_rules));
+    TEST_ASSERT_NULL(nr_extension_index_lookup(NULL, ".e1", 3, &num_rules));
+    nr_extension_index_free(index);
+}
+
+void test_extension_index_remove_last(void) {
+    nr_extension_index_t *index = nr_extension_index_create();
+    TEST_ASSERT_NOT_NULL(index);
+    static int rules[3];
+    TEST_ASSERT_TRUE(nr_extension_index_add(index, ".js", 3, &rules[0]));
+    TEST_ASSERT_TRUE(nr_extension_index_add(index, ".js", 3, &rules[1]));
+    TEST_ASSERT_TRUE(nr_extension_index_add(index, ".css", 4, &rules[2]));
+
+    // Only the last rule filed under an extension can be taken back
+    TEST_ASSERT_FALSE(nr_extension_index_remove_last(index, ".js", 3, &rules[0]));
+    TEST_ASSERT_FALSE(nr_extension_index_remove_last(index, ".html", 5, &rules[1]));
+    TEST_ASSERT_TRUE(nr_extension_index_remove_last(index, ".js", 3, &rules[1]));
+    TEST_ASSERT_TRUE(nr_extension_index_remove_last(index, ".css", 4, &rules[2]));
+    TEST_ASSERT_FALSE(nr_extension_index_remove_last(index, ".css", 4, &rules[2]));
+
+    size_t num_rules = 0;
+    const void *const *found = nr_extension_index_lookup(index, ".js", 3, &num_rules);
+    TEST_ASSERT_EQUAL(1, num_rules);
+    TEST_ASSERT_EQUAL_PTR(&rules[0], found[0]);
+    nr_extension_index_lookup(index, ".css", 4, &num_rules);
+    TEST_ASSERT_EQUAL(0, num_rules);
+
+    // An emptied extension takes rules again
+    TEST_ASSERT_TRUE(nr_extension_index_add(index, ".css", 4, &rules[1]));
+    found = nr_extension_index_lookup(index, ".css", 4, &num_rules);
+    TEST_ASSERT_EQUAL(1, num_rules);
+    TEST_ASSERT_EQUAL_PTR(&rules[1], found[0]);
+    nr_extension_index_free(index);
+}
+
+void test_extension_header_rules(void) {
+    nanorouter_header_rule_list_t *rules = nanorouter_header_rule_list_create();
+    TEST_ASSERT_NOT_NULL(rules);
+    TEST_ASSERT_TRUE(nanorouter_parse_headers_file(EXTENSION_TEST_HEADERS, rules));
+    TEST_ASSERT_NOT_NULL(rules->extensions);
+    static const bool expected[] = { false, true, true, true, true, true, false };
+    size_t i = 0;
+    for (const nanorouter_header_rule_node_t *node = rules->head; node != NULL; node = node->next, i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], node->by_extension, node->rule.from_route);
+    }
+    TEST_ASSERT_EQUAL(7, i);
+    nanorouter_header_rule_list_free(rules);
+
+    // Values merge in file order, suffix rules included
+    extension_test_assert_header("/style.css", "X-Tag", "root,css,last");
+    extension_test_assert_header("/assets/app.js", "X-Tag", "root,assets-js,js,last");
+    extension_test_assert_header("/lib/app.js", "X-Tag", "root,js,last");
+    extension_test_assert_header("/style.css.map", "X-Tag", "root,last");
+    extension_test_assert_header("/assets/", "X-Tag", "root,last");
+
+    // Extensions are told apart by their whole text
+    extension_test_assert_header("/test-suite/tests/a.jldt", "Content-Type", "application/jldTest+json");
+    extension_test_assert_header("/test-suite/tests/a.jldte", "Content-Type", "application/jldTest");
+    extension_test_assert_header("/test-suite/a.jldt", "Content-Type", NULL);
+}
+
+void test_extension_redirect_rules(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(EXTENSION_TEST_REDIRECTS, list));
+    TEST_ASSERT_NOT_NULL(list->extensions);
+    static const bool expected[] = { false, true, true, false, true, true };
+    size_t i = 0;
+    for (const nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next, i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], node->by_extension, node->rule.from_route);
+    }
+
+    extension_test_assert_redirect(list, "/pizero/index.html", "/pizero/", 301);
+    extension_test_assert_redirect(list, "/pizero/setup.html", "/pizero/setup", 301);
+    extension_test_assert_redirect(list, "/about.html", "/about", 301);
+    extension_test_assert_redirect(list, "/x.php?id=1", "/index.html?id=1", 410);
+    extension_test_assert_redirect(list, "/assets/app.min.js", "/assets/app", 200);
+    // File order decides between a suffix rule and the others
+    extension_test_assert_redirect(list, "/legacy/x.php", "/index.html", 410);
+    extension_test_assert_redirect(list, "/legacy/x.html", "/old/x.html", 302);
+    extension_test_assert_redirect(list, "/about.htm", NULL, 0);
+    extension_test_assert_redirect(list, "/assets/app.js", NULL, 0);
+
+    // Specificity order puts the deeper suffix rule first, and the index follows the new order
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    extension_test_assert_redirect(list, "/legacy/x.php", "/old/x.php", 302);
+    extension_test_assert_redirect(list, "/pizero/setup.html", "/pizero/setup", 301);
+    nanorouter_redirect_rule_list_free(list);
+
+    // A forced suffix rule is only looked at in the forced pass
+    list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/*.php /index.html 301!\n/*.php /gone.html 410\n", list));
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/a.php", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/index.html", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/a.php", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/gone.html", response.new_url);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_extension_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+
+    nanorouter_redirect_rule_list_t *linear = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(EXTENSION_TEST_REDIRECTS, linear));
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = nanorouter_redirect_rule_list_create();
+        TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(EXTENSION_TEST_REDIRECTS, indexed));
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+
+        for (size_t u = 0; u < sizeof(EXTENSION_TEST_URLS) / sizeof(EXTENSION_TEST_URLS[0]); u++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(EXTENSION_TEST_URLS[u], linear, &expected, NULL);
+            bool actual_result = nanorouter_process_redirect_request(EXTENSION_TEST_URLS[u], indexed, &actual, NULL);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, EXTENSION_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, actual.status_code, EXTENSION_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, EXTENSION_TEST_URLS[u]);
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+int test_nanorouter_extension_index(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_extension_of_routes_and_paths);
+    RUN_TEST(test_extension_index_lookup);
+    RUN_TEST(test_extension_index_remove_last);
+    RUN_TEST(test_extension_header_rules);
+    RUN_TEST(test_extension_redirect_rules);
+    RUN_TEST(test_extension_engines_agree);
+    return UNITY_END();
+}
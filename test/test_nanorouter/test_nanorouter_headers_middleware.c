@@ -219,6 +219,34 @@ void test_nanorouter_process_header_request_no_duplicate_values_from_different_r
     nanorouter_header_rule_list_free(rules);
 }
 
+void test_nanorouter_process_header_request_parsed_matches_string_entry(void) {
+    nanorouter_header_rule_list_t *rules = nanorouter_header_rule_list_create();
+    TEST_ASSERT_NOT_NULL(rules);
+
+    header_rule_t rule1 = {
+        .from_route = "/assets/:file",
+        .headers = {{"Cache-Control", "max-age=3600"}},
+        .num_headers = 1
+    };
+    nanorouter_header_rule_list_add_rule(rules, &rule1);
+
+    nr_parsed_url_t parsed_url;
+    nr_parse_url("/assets/app.js?v=2", &parsed_url);
+
+    nanorouter_header_response_t response = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_header_request_parsed(&parsed_url, rules, &response, NULL));
+    nanorouter_header_response_t expected_response = {
+        .headers = {{"Cache-Control", "max-age=3600"}},
+        .num_headers = 1
+    };
+    assert_header_response_equal(&expected_response, &response);
+
+    nr_parse_url("/static/app.js", &parsed_url);
+    TEST_ASSERT_FALSE(nanorouter_process_header_request_parsed(&parsed_url, rules, &response, NULL));
+    TEST_ASSERT_EQUAL_UINT8(0, response.num_headers);
+
+    nanorouter_header_rule_list_free(rules);
+}
 
 int test_nanorouter_headers_middleware(void) {
     UNITY_BEGIN();
@@ -229,6 +257,7 @@ int test_nanorouter_headers_middleware(void) {
     RUN_TEST(test_nanorouter_process_header_request_multi_value_headers);
     RUN_TEST(test_nanorouter_process_header_request_ignored_headers);
     RUN_TEST(test_nanorouter_process_header_request_no_duplicate_values_from_different_rules);
+    RUN_TEST(test_nanorouter_process_header_request_parsed_matches_string_entry);
     return UNITY_END();
 }
 
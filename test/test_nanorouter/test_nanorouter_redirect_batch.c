@@ -0,0 +1,123 @@
+#include "test_nanorouter_redirect_batch.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Every lookup stage: host-wide redirect, host rule, literal, pattern, query, condition, suffix and 404 prefix
+static const char *const BATCH_TEST_REDIRECTS =
+    "https://www.example.com/* https://example.com/:splat 301!\n"
+    "https://shop.example.com/cart /cart 302\n"
+    "/old /new 301\n"
+    "/news/:year/:slug /blog/:year/:slug 301\n"
+    "/search q=:q /find/:q 302\n"
+    "/store /store/de 302 Country=de\n"
+    "/*.php /index.html 410\n"
+    "/docs/* /docs/404.html 404\n";
+
+static const char *const BATCH_TEST_URLS[] = {
+    "/old", "/news/2024/hello", "/search?q=shoes", "/search", "/store", "/a.php", "/docs/x/y", "/missing",
+    "/cart", "/old?x=1", "/news/2024", "/store?x=1", "/index.php?id=2", "/docs", "/", "/OLD",
+    "/news/2023/bye/", "/x/y.php", "/cart?a=b", "/docs/a",
+};
+
+#define BATCH_TEST_NUM_URLS (sizeof(BATCH_TEST_URLS) / sizeof(BATCH_TEST_URLS[0]))
+
+// Gives each URL one of a few hosts and countries
+static void batch_test_set_contexts(nanorouter_request_context_t *contexts, size_t num_contexts) {
+    static const char *const domains[] = { "example.com", "www.example.com", "shop.example.com" };
+    static const char *const countries[] = { "de", "us" };
+    memset(contexts, 0, num_contexts * sizeof(nanorouter_request_context_t));
+    for (size_t i = 0; i < num_contexts; i++) {
+        strncpy(contexts[i].domain, domains[i % 3], NR_MAX_DOMAIN_LEN);
+        strncpy(contexts[i].country, countries[i % 2], NR_MAX_COUNTRY_LEN);
+        strncpy(contexts[i].scheme, "https", NR_MAX_SCHEME_LEN);
+    }
+}
+
+static void batch_test_assert_matches_single(nanorouter_redirect_rule_list_t *list, const nanorouter_request_context_t *contexts) {
+    nanorouter_redirect_response_t results[BATCH_TEST_NUM_URLS];
+    size_t applied = nanorouter_process_redirect_batch(BATCH_TEST_URLS, BATCH_TEST_NUM_URLS, list, contexts, results);
+
+    size_t expected_applied = 0;
+    for (size_t i = 0; i < BATCH_TEST_NUM_URLS; i++) {
+        nanorouter_redirect_response_t expected;
+        if (nanorouter_process_redirect_request(BATCH_TEST_URLS[i], list, &expected, contexts != NULL ? &contexts[i] : NULL)) {
+            expected_applied++;
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, results[i].status_code, BATCH_TEST_URLS[i]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, results[i].new_url, BATCH_TEST_URLS[i]);
+    }
+    TEST_ASSERT_EQUAL(expected_applied, applied);
+}
+
+void test_batch_matches_single_requests(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_LINEAR, NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+    nanorouter_request_context_t contexts[BATCH_TEST_NUM_URLS];
+    batch_test_set_contexts(contexts, BATCH_TEST_NUM_URLS);
+
+    // More URLs than NR_REDIRECT_BATCH_SIZE, so the last group is a partial one
+    TEST_ASSERT_TRUE(BATCH_TEST_NUM_URLS > NR_REDIRECT_BATCH_SIZE);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(BATCH_TEST_REDIRECTS);
+        if (engines[e] != NR_REDIRECT_ENGINE_LINEAR) {
+            TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, engines[e]));
+        }
+        batch_test_assert_matches_single(list, contexts);
+        batch_test_assert_matches_single(list, NULL);
+        nanorouter_redirect_rule_list_free(list);
+    }
+
+    // Case-insensitive lists fold each request into its own scratch
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_case_insensitive(list, true));
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(BATCH_TEST_REDIRECTS, list));
+    batch_test_assert_matches_single(list, contexts);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_batch_results(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(BATCH_TEST_REDIRECTS);
+    nanorouter_request_context_t contexts[3];
+    batch_test_set_contexts(contexts, 3);
+
+    // Results left over from an earlier batch are overwritten, matched or not
+    const char *urls[] = { "/news/2024/hello", NULL, "/missing" };
+    nanorouter_redirect_response_t results[3];
+    for (size_t i = 0; i < 3; i++) {
+        strcpy(results[i].new_url, "/stale");
+        results[i].status_code = 200;
+    }
+    TEST_ASSERT_EQUAL(1, nanorouter_process_redirect_batch(urls, 3, list, contexts, results));
+    TEST_ASSERT_EQUAL_STRING("/blog/2024/hello", results[0].new_url);
+    TEST_ASSERT_EQUAL(301, results[0].status_code);
+    TEST_ASSERT_EQUAL_STRING("", results[1].new_url);
+    TEST_ASSERT_EQUAL(0, results[1].status_code);
+    TEST_ASSERT_EQUAL_STRING("", results[2].new_url);
+    TEST_ASSERT_EQUAL(0, results[2].status_code);
+
+    // The host-wide redirect is decided per request, from that request's context
+    urls[1] = "/a/b";
+    TEST_ASSERT_EQUAL(2, nanorouter_process_redirect_batch(urls, 3, list, contexts, results));
+    TEST_ASSERT_EQUAL_STRING("https://example.com/a/b", results[1].new_url);
+
+    TEST_ASSERT_EQUAL(0, nanorouter_process_redirect_batch(urls, 0, list, contexts, results));
+    TEST_ASSERT_EQUAL(0, nanorouter_process_redirect_batch(NULL, 3, list, contexts, results));
+    TEST_ASSERT_EQUAL(0, nanorouter_process_redirect_batch(urls, 3, NULL, contexts, results));
+    TEST_ASSERT_EQUAL(0, nanorouter_process_redirect_batch(urls, 3, list, contexts, NULL));
+    nanorouter_redirect_rule_list_free(list);
+}
+
+int test_nanorouter_redirect_batch(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_matches_single_requests);
+    RUN_TEST(test_batch_results);
+    return UNITY_END();
+}
@@ -0,0 +1,41 @@
+#include "test_nanorouter_redirect_bitset.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "test_redirect_engine_helpers.h"
+
+void test_redirect_bitset_compile_sets_engine(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_BITSET));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_BITSET, list->engine);
+    TEST_ASSERT_NOT_NULL(list->bitset);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_DFA));
+    TEST_ASSERT_NULL(list->bitset);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_bitset_matches_linear_engine(void) {
+    redirect_engine_test_assert_matches_linear(REDIRECT_ENGINE_TEST_REDIRECTS, NR_REDIRECT_ENGINE_BITSET,
+                                               REDIRECT_ENGINE_TEST_URLS, REDIRECT_ENGINE_TEST_NUM_URLS);
+}
+
+void test_redirect_bitset_spans_several_words(void) {
+    // 201 rules, so candidates fall into four 64-bit words
+    redirect_engine_test_assert_generated_rules(NR_REDIRECT_ENGINE_BITSET);
+}
+
+void test_redirect_bitset_deep_url_falls_back(void) {
+    redirect_engine_test_assert_deep_url_falls_back(NR_REDIRECT_ENGINE_BITSET);
+}
+
+int test_nanorouter_redirect_bitset(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_bitset_compile_sets_engine);
+    RUN_TEST(test_redirect_bitset_matches_linear_engine);
+    RUN_TEST(test_redirect_bitset_spans_several_words);
+    RUN_TEST(test_redirect_bitset_deep_url_falls_back);
+    return UNITY_END();
+}
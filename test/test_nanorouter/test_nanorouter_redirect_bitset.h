@@ -0,0 +1,3 @@
+#pragma once
+
+int test_nanorouter_redirect_bitset(void);
@@ -0,0 +1,131 @@
+#include "test_nanorouter_redirect_case.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include <string.h>
+
+static const char *const CASE_TEST_REDIRECTS =
+    "/Blog/:Slug /articles/:Slug 301\n"
+    "/OLD/* /new/:splat 301\n"
+    "/About-Us /about 301\n"
+    "https://Shop.Example.com/Cart /basket 302\n"
+    "/* /index.html 200\n";
+
+static const char *const CASE_TEST_URLS[] = {
+    "/", "/blog/Hello-World", "/BLOG/Hello", "/old/Some/Path", "/about-us", "/ABOUT-US",
+    "/about-us/more", "/Blog", "/cart", "/Blog/x?Ref=ABC",
+};
+
+static nanorouter_redirect_rule_list_t* case_test_load_rules(bool case_insensitive) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_case_insensitive(list, case_insensitive));
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(CASE_TEST_REDIRECTS, list));
+    return list;
+}
+
+static void case_test_expect(nanorouter_redirect_rule_list_t *list, const char *url, const char *expected_url) {
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE_MESSAGE(nanorouter_process_redirect_request(url, list, &response, NULL), url);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_url, response.new_url, url);
+}
+
+void test_fold_route_pattern_keeps_placeholder_names(void) {
+    char pattern[] = "/Blog/:Slug/Edit/*";
+    nr_fold_route_pattern(pattern);
+    TEST_ASSERT_EQUAL_STRING("/blog/:Slug/edit/*", pattern);
+
+    char absolute[] = "https://Shop.Example.com/:Item";
+    nr_fold_route_pattern(absolute);
+    TEST_ASSERT_EQUAL_STRING("https://shop.example.com/:Item", absolute);
+}
+
+void test_redirect_case_sensitive_by_default(void) {
+    nanorouter_redirect_rule_list_t *list = case_test_load_rules(false);
+    case_test_expect(list, "/Blog/Hello", "/articles/Hello");
+    case_test_expect(list, "/blog/Hello", "/index.html");
+    case_test_expect(list, "/about-us", "/index.html");
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_case_insensitive_matching(void) {
+    nanorouter_redirect_rule_list_t *list = case_test_load_rules(true);
+    TEST_ASSERT_EQUAL_STRING("/blog/:Slug", list->head->rule.from_route);
+
+    // Captures keep the casing of the request
+    case_test_expect(list, "/blog/Hello-World", "/articles/Hello-World");
+    case_test_expect(list, "/BLOG/Hello", "/articles/Hello");
+    case_test_expect(list, "/old/Some/Path", "/new/Some/Path");
+    case_test_expect(list, "/about-us", "/about");
+    case_test_expect(list, "/ABOUT-US/", "/about");
+    case_test_expect(list, "/Blog/x?Ref=ABC", "/articles/x?Ref=ABC");
+    case_test_expect(list, "/unknown", "/index.html");
+
+    nanorouter_request_context_t context = {0};
+    strncpy(context.domain, "shop.example.COM", NR_MAX_DOMAIN_LEN);
+    strncpy(context.scheme, "https", NR_MAX_SCHEME_LEN);
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/CART", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/basket", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_case_insensitive_parsed_url_is_not_modified(void) {
+    nanorouter_redirect_rule_list_t *list = case_test_load_rules(true);
+    const char *url = "/About-Us";
+    nr_parsed_url_t parsed_url;
+    nr_parse_url(url, &parsed_url);
+
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_parsed(&parsed_url, list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/about", response.new_url);
+    TEST_ASSERT_EQUAL_PTR(url, parsed_url.path);
+    TEST_ASSERT_EQUAL_PTR(url + 1, parsed_url.segments[0].start);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_case_mode_set_before_loading(void) {
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_set_case_insensitive(NULL, true));
+
+    nanorouter_redirect_rule_list_t *list = case_test_load_rules(false);
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_set_case_insensitive(list, true));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_case_insensitive(list, false));
+    TEST_ASSERT_FALSE(list->case_insensitive);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_case_insensitive_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+
+    nanorouter_redirect_rule_list_t *linear = case_test_load_rules(true);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = case_test_load_rules(true);
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+        for (size_t u = 0; u < sizeof(CASE_TEST_URLS) / sizeof(CASE_TEST_URLS[0]); u++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(CASE_TEST_URLS[u], linear, &expected, NULL);
+            bool actual_result = nanorouter_process_redirect_request(CASE_TEST_URLS[u], indexed, &actual, NULL);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, CASE_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, CASE_TEST_URLS[u]);
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+int test_nanorouter_redirect_case(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fold_route_pattern_keeps_placeholder_names);
+    RUN_TEST(test_redirect_case_sensitive_by_default);
+    RUN_TEST(test_redirect_case_insensitive_matching);
+    RUN_TEST(test_redirect_case_insensitive_parsed_url_is_not_modified);
+    RUN_TEST(test_redirect_case_mode_set_before_loading);
+    RUN_TEST(test_redirect_case_insensitive_engines_agree);
+    return UNITY_END();
+}
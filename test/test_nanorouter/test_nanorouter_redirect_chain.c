@@ -0,0 +1,442 @@
+#include "test_nanorouter_redirect_chain.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_chain.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+
+// Returns the rule at a position of the list
+static nanorouter_redirect_rule_t* chain_test_rule(nanorouter_redirect_rule_list_t *list, size_t index) {
+    nanorouter_redirect_rule_t *node = list->head;
+    while (index-- > 0) {
+        node = node->next;
+    }
+    return node;
+}
+
+// Follows rewrites the way a server does without resolution: one request per hop
+static int chain_test_follow(const char *url, nanorouter_redirect_rule_list_t *list, char *target) {
+    char current[NR_REDIRECT_MAX_URL_LEN + 1];
+    strcpy(current, url);
+    int status_code = 0;
+    for (int hop = 0; hop <= NR_MAX_REWRITE_HOPS; hop++) {
+        nanorouter_redirect_response_t response;
+        if (!nanorouter_process_redirect_request(current, list, &response, NULL)) {
+            break;
+        }
+        status_code = response.status_code;
+        bool same = strcmp(response.new_url, current) == 0;
+        strcpy(current, response.new_url);
+        if (same || status_code != 200 || current[0] != '/') {
+            break;
+        }
+    }
+    strcpy(target, current);
+    return status_code;
+}
+
+typedef struct {
+    int num_cycles;
+    size_t num_rules;
+    char first[NR_MAX_ROUTE_LEN + 1];
+    char second[NR_MAX_ROUTE_LEN + 1];
+} chain_test_cycles_t;
+
+static void chain_test_on_cycle(const redirect_rule_t *const *rules, size_t num_rules, void *user_data) {
+    chain_test_cycles_t *cycles = (chain_test_cycles_t *)user_data;
+    cycles->num_cycles++;
+    cycles->num_rules = num_rules;
+    strcpy(cycles->first, rules[0]->from_route);
+    strcpy(cycles->second, num_rules > 1 ? rules[1]->from_route : "");
+}
+
+void test_resolve_literal_rewrite_chain(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/old /new 200\n"
+        "/new /index.html 200\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(list, NULL, NULL));
+
+    const nr_redirect_chain_t *chain = chain_test_rule(list, 0)->chain;
+    TEST_ASSERT_NOT_NULL(chain);
+    TEST_ASSERT_EQUAL_STRING("/index.html", chain->to_route);
+    TEST_ASSERT_EQUAL_UINT16(200, chain->status_code);
+    TEST_ASSERT_EQUAL_UINT8(1, chain->num_hops);
+    TEST_ASSERT_EQUAL_PTR(chain_test_rule(list, 1), chain->final_rule);
+    TEST_ASSERT_NULL(chain_test_rule(list, 1)->chain); // Nothing rewrites /index.html
+
+    // One lookup gives the final target, with the request's query passed through
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/old?ref=mail", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/index.html?ref=mail", response.new_url);
+    TEST_ASSERT_EQUAL_INT(200, response.status_code);
+
+    // Adding a rule drops the resolution
+    redirect_rule_t rule;
+    TEST_ASSERT_TRUE(nr_parse_redirect_rule("/extra /index.html 200", strlen("/extra /index.html 200"), &rule));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_add_rule(list, &rule));
+    TEST_ASSERT_NULL(chain_test_rule(list, 0)->chain);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/old", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/new", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_resolve_placeholder_rewrite_chain(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/blog/:year/:slug /posts/:year/:slug 200\n"
+        "/posts/* /content/:splat 200\n"
+        "/content/:y/:s /render/:s/:y 200\n"
+        "/go/:id /items/:id 200\n"
+        "/items/:id /v2/items/:id 301\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(list, NULL, NULL));
+
+    const nr_redirect_chain_t *chain = chain_test_rule(list, 0)->chain;
+    TEST_ASSERT_NOT_NULL(chain);
+    TEST_ASSERT_EQUAL_STRING("/render/:slug/:year", chain->to_route);
+    TEST_ASSERT_EQUAL_UINT8(2, chain->num_hops);
+
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/blog/2024/hello", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/render/hello/2024", response.new_url);
+    TEST_ASSERT_EQUAL_INT(200, response.status_code);
+
+    // A redirect ends the chain with its own status
+    chain = chain_test_rule(list, 3)->chain;
+    TEST_ASSERT_NOT_NULL(chain);
+    TEST_ASSERT_EQUAL_STRING("/v2/items/:id", chain->to_route);
+    TEST_ASSERT_EQUAL_UINT16(301, chain->status_code);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/go/42", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/v2/items/42", response.new_url);
+    TEST_ASSERT_EQUAL_INT(301, response.status_code);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_resolve_rewrite_cycles(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/c /a 200\n"
+        "/a /b 200\n"
+        "/b /a 200\n"
+        "/app /index.html 200\n"
+        "/* /index.html 200\n");
+    chain_test_cycles_t cycles;
+    memset(&cycles, 0, sizeof(cycles));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(list, chain_test_on_cycle, &cycles));
+
+    // Reported once, from the rule of the cycle listed first
+    TEST_ASSERT_EQUAL_INT(1, cycles.num_cycles);
+    TEST_ASSERT_EQUAL_size_t(2, cycles.num_rules);
+    TEST_ASSERT_EQUAL_STRING("/a", cycles.first);
+    TEST_ASSERT_EQUAL_STRING("/b", cycles.second);
+    TEST_ASSERT_NULL(chain_test_rule(list, 0)->chain);
+    TEST_ASSERT_NULL(chain_test_rule(list, 1)->chain);
+    TEST_ASSERT_NULL(chain_test_rule(list, 2)->chain);
+
+    // A target that rewrites to itself is served as it is
+    TEST_ASSERT_NULL(chain_test_rule(list, 3)->chain);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_resolve_leaves_request_dependent_chains(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/x /y 200\n"
+        "/y /au 302 Country=au\n"
+        "/y /z 200\n"
+        "/p/:id /q/:id 200\n"
+        "/q/special /s 200\n"
+        "/q/:id /r/:id 200\n"
+        "/f /g 200\n"
+        "/g page=:page /h/:page 200\n"
+        "/g /i 200\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(list, NULL, NULL));
+    TEST_ASSERT_NULL(chain_test_rule(list, 0)->chain); // A condition decides
+    TEST_ASSERT_NULL(chain_test_rule(list, 3)->chain); // The value of :id decides
+    TEST_ASSERT_NULL(chain_test_rule(list, 6)->chain); // The query decides
+
+    nanorouter_request_context_t context;
+    memset(&context, 0, sizeof(context));
+    strcpy(context.country, "au");
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/x", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/y", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_resolve_follows_the_rules_the_passes_pick(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/r /s 200!\n"
+        "/s /t 200\n"
+        "/u /v 200!\n"
+        "/v /w 200!\n"
+        "/p /q 200\n"
+        "/q /x 200\n"
+        "/q /y 200!\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(list, NULL, NULL));
+
+    // A static file at /s would shadow the unforced rule, so the forced pass answers /r with /s
+    TEST_ASSERT_NULL(chain_test_rule(list, 0)->chain);
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/r", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/s", response.new_url);
+    TEST_ASSERT_NOT_NULL(chain_test_rule(list, 2)->chain);
+    TEST_ASSERT_EQUAL_STRING("/w", chain_test_rule(list, 2)->chain->to_route);
+
+    // The forced rule listed below answers /q first in the forced pass
+    TEST_ASSERT_NULL(chain_test_rule(list, 4)->chain);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_resolved_chains_match_followed_requests(void) {
+    const char *redirects =
+        "/shop/:category/:item /store/:category/:item 200\n"
+        "/store/* /catalog/:splat 200\n"
+        "/catalog/:c/:i /view/:c/:i 200\n"
+        "/view/:c/:i /render/:c/:i 200\n"
+        "/docs/* /guide/:splat 200\n"
+        "/guide/* https://docs.example.com/:splat 200\n"
+        "/promo /sale 200\n"
+        "/sale /shop/deals/today 200\n"
+        "/legacy/:id /shop/old/:id 200\n";
+    nanorouter_redirect_rule_list_t *resolved = redirect_engine_test_load_rules(redirects);
+    nanorouter_redirect_rule_list_t *followed = redirect_engine_test_load_rules(redirects);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_resolve_rewrites(resolved, NULL, NULL));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(resolved, NR_REDIRECT_ENGINE_TRIE));
+
+    const char *urls[] = {
+        "/shop/books/dune",
+        "/shop/books/dune?ref=home",
+        "/docs/setup/wifi",
+        "/promo",
+        "/promo?utm=mail",
+        "/legacy/7",
+        "/view/plain/text",
+        "/unknown"
+    };
+    for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++) {
+        char expected[NR_REDIRECT_MAX_URL_LEN + 1];
+        int expected_status = chain_test_follow(urls[i], followed, expected);
+        nanorouter_redirect_response_t response;
+        nanorouter_process_redirect_request(urls[i], resolved, &response, NULL);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, expected_status != 0 ? response.new_url : urls[i], urls[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(expected_status, response.status_code, urls[i]);
+    }
+
+    // Every rewrite that reaches another rule was resolved
+    TEST_ASSERT_NOT_NULL(chain_test_rule(resolved, 0)->chain);
+    TEST_ASSERT_NOT_NULL(chain_test_rule(resolved, 4)->chain);
+    TEST_ASSERT_NOT_NULL(chain_test_rule(resolved, 6)->chain);
+    TEST_ASSERT_NOT_NULL(chain_test_rule(resolved, 8)->chain);
+
+    nanorouter_redirect_rule_list_free(resolved);
+    nanorouter_redirect_rule_list_free(followed);
+}
+
+// Follows redirects the way a browser does: one request per hop
+static int chain_test_browse(const char *url, nanorouter_redirect_rule_list_t *list, char *location) {
+    char current[NR_REDIRECT_MAX_URL_LEN + 1];
+    strcpy(current, url);
+    int status_code = 0;
+    bool permanent = true;
+    bool keeps_method = true;
+    for (int hop = 0; hop <= NR_MAX_REWRITE_HOPS; hop++) {
+        nanorouter_redirect_response_t response;
+        if (!nanorouter_process_redirect_request(current, list, &response, NULL) ||
+            (response.status_code != 301 && response.status_code != 302 && response.status_code != 307 && response.status_code != 308)) {
+            break;
+        }
+        // One redirect doing the same is permanent, or keeps the method, only if every hop does
+        permanent = permanent && (response.status_code == 301 || response.status_code == 308);
+        keeps_method = keeps_method && (response.status_code == 307 || response.status_code == 308);
+        status_code = keeps_method ? (permanent ? 308 : 307) : (permanent ? 301 : 302);
+        strcpy(current, response.new_url);
+        if (current[0] != '/') {
+            break;
+        }
+    }
+    strcpy(location, current);
+    return status_code;
+}
+
+static void chain_test_on_collapse(const redirect_rule_t *const *rules, size_t num_rules, void *user_data) {
+    chain_test_cycles_t *collapsed = (chain_test_cycles_t *)user_data;
+    collapsed->num_cycles++;
+    collapsed->num_rules = num_rules;
+    strcpy(collapsed->first, rules[0]->to_route);
+    strcpy(collapsed->second, rules[num_rules - 1]->from_route);
+}
+
+void test_collapse_redirect_chain(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/a /b 301\n"
+        "/b /c 301\n"
+        "/old/:slug /new/:slug 301\n"
+        "/new/:page /blog/:page 301\n");
+    chain_test_cycles_t collapsed;
+    memset(&collapsed, 0, sizeof(collapsed));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_collapse_redirects(list, chain_test_on_collapse, NULL, &collapsed));
+
+    // Reported with the rule as it was written
+    TEST_ASSERT_EQUAL_INT(2, collapsed.num_cycles);
+    TEST_ASSERT_EQUAL_size_t(2, collapsed.num_rules);
+    TEST_ASSERT_EQUAL_STRING("/new/:slug", collapsed.first);
+    TEST_ASSERT_EQUAL_STRING("/new/:page", collapsed.second);
+
+    TEST_ASSERT_EQUAL_STRING("/c", chain_test_rule(list, 0)->rule.to_route);
+    TEST_ASSERT_EQUAL_UINT16(301, chain_test_rule(list, 0)->rule.status_code);
+    TEST_ASSERT_EQUAL_STRING("/c", chain_test_rule(list, 1)->rule.to_route);
+    TEST_ASSERT_EQUAL_STRING("/blog/:slug", chain_test_rule(list, 2)->rule.to_route);
+
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/old/hello?x=1", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/blog/hello?x=1", response.new_url);
+    TEST_ASSERT_EQUAL_INT(301, response.status_code);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_collapse_redirect_status_codes(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/x /y 301\n"
+        "/y /z 302\n"
+        "/p /q 308\n"
+        "/q /r 308\n"
+        "/m /n 308\n"
+        "/n /o 301\n"
+        "/t1 /t2 307\n"
+        "/t2 /t3 308\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_collapse_redirects(list, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_UINT16(302, chain_test_rule(list, 0)->rule.status_code); // Temporary anywhere
+    TEST_ASSERT_EQUAL_UINT16(308, chain_test_rule(list, 2)->rule.status_code);
+    TEST_ASSERT_EQUAL_UINT16(301, chain_test_rule(list, 4)->rule.status_code); // The 301 may change the method
+    TEST_ASSERT_EQUAL_UINT16(307, chain_test_rule(list, 6)->rule.status_code);
+    TEST_ASSERT_EQUAL_STRING("/t3", chain_test_rule(list, 6)->rule.to_route);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_collapse_stops_where_the_request_decides(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/s /t 301\n"
+        "/t /u 302 Country=au\n"
+        "/t /v 301\n"
+        "/g /h 301\n"
+        "/h /index.html 200\n"
+        "/l1 /l2 301\n"
+        "/l2 /l1 301\n"
+        "/e /f 301\n"
+        "/f https://example.com/f 302\n");
+    chain_test_cycles_t cycles;
+    memset(&cycles, 0, sizeof(cycles));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_collapse_redirects(list, NULL, chain_test_on_cycle, &cycles));
+
+    TEST_ASSERT_EQUAL_STRING("/t", chain_test_rule(list, 0)->rule.to_route); // A condition decides
+    TEST_ASSERT_EQUAL_STRING("/h", chain_test_rule(list, 3)->rule.to_route); // Served by a rewrite
+    TEST_ASSERT_EQUAL_STRING("/l2", chain_test_rule(list, 5)->rule.to_route);
+    TEST_ASSERT_EQUAL_INT(1, cycles.num_cycles);
+    TEST_ASSERT_EQUAL_STRING("/l1", cycles.first);
+
+    // Another site ends the chain but is still reached in one hop
+    TEST_ASSERT_EQUAL_STRING("https://example.com/f", chain_test_rule(list, 7)->rule.to_route);
+    TEST_ASSERT_EQUAL_UINT16(302, chain_test_rule(list, 7)->rule.status_code);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_collapse_follows_the_rules_the_passes_pick(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/a /b 301!\n"
+        "/b /c 301\n"
+        "/d /e 301!\n"
+        "/e /f 301!\n"
+        "/g /h 301\n"
+        "/h /i 302\n"
+        "/h /j 301!\n"
+        "/k /l 301\n"
+        "/l /m 302\n"
+        "/l /n 301! Country=au\n");
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_collapse_redirects(list, NULL, NULL, NULL));
+
+    // The forced pass answers /a before the static-file lookup, which a file at /b would win
+    TEST_ASSERT_EQUAL_STRING("/b", chain_test_rule(list, 0)->rule.to_route);
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/a", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/b", response.new_url);
+    TEST_ASSERT_EQUAL_STRING("/f", chain_test_rule(list, 2)->rule.to_route);
+
+    // A forced rule listed below, even one that depends on the request, answers the target first in the forced pass
+    TEST_ASSERT_EQUAL_STRING("/h", chain_test_rule(list, 4)->rule.to_route);
+    TEST_ASSERT_EQUAL_STRING("/l", chain_test_rule(list, 7)->rule.to_route);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_collapsed_redirects_match_browsed_requests(void) {
+    // Moves from several migrations, as in docs/samples/zachleat.com/_redirects
+    const char *redirects =
+        "/feed/ /web/feed/ 301!\n"
+        "/web/feed/ /web/feed.xml 301\n"
+        "/résumé/ /resume/ 301!\n"
+        "/resume/ /about/resume/ 301!\n"
+        "/blog/:year/:slug /archive/:year/:slug 301\n"
+        "/archive/* /posts/:splat 301\n"
+        "/about/* /about/index.html 200\n";
+    nanorouter_redirect_rule_list_t *collapsed = redirect_engine_test_load_rules(redirects);
+    nanorouter_redirect_rule_list_t *browsed = redirect_engine_test_load_rules(redirects);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_collapse_redirects(collapsed, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL_STRING("/web/feed/", chain_test_rule(collapsed, 0)->rule.to_route); // A static file may shadow the unforced hop
+    TEST_ASSERT_EQUAL_STRING("/about/resume/", chain_test_rule(collapsed, 2)->rule.to_route);
+    TEST_ASSERT_EQUAL_STRING("/posts/:year/:slug", chain_test_rule(collapsed, 4)->rule.to_route);
+
+    const char *urls[] = {
+        "/feed/",
+        "/feed?format=rss",
+        "/résumé/",
+        "/resume/",
+        "/blog/2019/hello",
+        "/blog/2019/hello/world?page=2",
+        "/archive/a/b",
+        "/about/me"
+    };
+    for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++) {
+        char expected[NR_REDIRECT_MAX_URL_LEN + 1];
+        int expected_status = chain_test_browse(urls[i], browsed, expected);
+        if (strncmp(urls[i], "/feed", strlen("/feed")) == 0) {
+            // Left as it was, so the browser ends up where it did
+            char location[NR_REDIRECT_MAX_URL_LEN + 1];
+            TEST_ASSERT_EQUAL_MESSAGE(expected_status, chain_test_browse(urls[i], collapsed, location), urls[i]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, location, urls[i]);
+            continue;
+        }
+        nanorouter_redirect_response_t response;
+        nanorouter_process_redirect_request(urls[i], collapsed, &response, NULL);
+        if (expected_status == 0) {
+            TEST_ASSERT_FALSE_MESSAGE(response.status_code >= 301 && response.status_code <= 308, urls[i]);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, response.new_url, urls[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(expected_status, response.status_code, urls[i]);
+    }
+
+    nanorouter_redirect_rule_list_free(collapsed);
+    nanorouter_redirect_rule_list_free(browsed);
+}
+
+int test_nanorouter_redirect_chain(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_resolve_literal_rewrite_chain);
+    RUN_TEST(test_resolve_placeholder_rewrite_chain);
+    RUN_TEST(test_resolve_rewrite_cycles);
+    RUN_TEST(test_resolve_leaves_request_dependent_chains);
+    RUN_TEST(test_resolve_follows_the_rules_the_passes_pick);
+    RUN_TEST(test_resolved_chains_match_followed_requests);
+    RUN_TEST(test_collapse_redirect_chain);
+    RUN_TEST(test_collapse_redirect_status_codes);
+    RUN_TEST(test_collapse_stops_where_the_request_decides);
+    RUN_TEST(test_collapse_follows_the_rules_the_passes_pick);
+    RUN_TEST(test_collapsed_redirects_match_browsed_requests);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+#include "test_nanorouter_redirect_dfa.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_dfa.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+void test_redirect_dfa_compile_sets_engine(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_DFA));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_DFA, list->engine);
+    TEST_ASSERT_NOT_NULL(list->dfa);
+    TEST_ASSERT_TRUE(nr_redirect_dfa_num_states(list->dfa) > 1);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_LINEAR));
+    TEST_ASSERT_NULL(list->dfa);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_dfa_empty_list(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_DFA));
+    TEST_ASSERT_EQUAL(1, nr_redirect_dfa_num_states(list->dfa));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request("/anything", list, &response, &context));
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_dfa_matches_linear_engine(void) {
+    redirect_engine_test_assert_matches_linear(REDIRECT_ENGINE_TEST_REDIRECTS, NR_REDIRECT_ENGINE_DFA,
+                                               REDIRECT_ENGINE_TEST_URLS, REDIRECT_ENGINE_TEST_NUM_URLS);
+}
+
+void test_redirect_dfa_first_match_wins(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_DFA));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    // Placeholder rule listed before the more specific literal one
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/api/v2/users/me", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/v/v2/u/me", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/he/news/latest", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/he/blog", response.new_url);
+
+    // Path accepted for several rules, the query decides between them
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store?id=42", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/42?id=42", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/shop", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/a//b", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/empty-segment", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_dfa_generated_rules_match_linear(void) {
+    nanorouter_redirect_rule_list_t *linear = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(linear);
+
+    // Every combination of literal, placeholder and splat over two segments
+    static const char *const parts[] = { "a", "b", ":p", "*" };
+    char line[64];
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            snprintf(line, sizeof(line), "/%s/%s /to/%zu/%zu 301\n", parts[i], parts[j], i, j);
+            TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(line, linear));
+        }
+        snprintf(line, sizeof(line), "/%s /to/%zu 302\n", parts[i], i);
+        TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(line, linear));
+    }
+    nanorouter_redirect_rule_list_t *dfa = redirect_engine_test_compiled_copy(linear, NR_REDIRECT_ENGINE_DFA);
+
+    static const char *const urls[] = {
+        "/", "/a", "/b", "/c", "/a/a", "/a/b", "/b/a", "/c/d", "/a/b/c", "/c/b/a", "/a//", "//a",
+    };
+    redirect_engine_test_assert_same_results(linear, dfa, urls, sizeof(urls) / sizeof(urls[0]));
+
+    nanorouter_redirect_rule_list_free(linear);
+    nanorouter_redirect_rule_list_free(dfa);
+}
+
+int test_nanorouter_redirect_dfa(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_dfa_compile_sets_engine);
+    RUN_TEST(test_redirect_dfa_empty_list);
+    RUN_TEST(test_redirect_dfa_matches_linear_engine);
+    RUN_TEST(test_redirect_dfa_first_match_wins);
+    RUN_TEST(test_redirect_dfa_generated_rules_match_linear);
+    return UNITY_END();
+}
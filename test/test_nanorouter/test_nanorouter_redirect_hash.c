@@ -0,0 +1,160 @@
+#include "test_nanorouter_redirect_hash.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_rule_parser.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Mostly literal moves, as produced by site migrations, with a few patterns mixed in
+static const char *const HASH_TEST_REDIRECTS =
+    "# Old blog posts\n"
+    "/2019/hello-world /posts/hello-world 301\n"
+    "/2019/second-post /posts/second-post 301\n"
+    "/about/ /about-us 301\n"
+    "/old/:page /new/:page 302\n"
+    "/2020/third-post /posts/third-post 301\n"
+    "/old/contact /contact 301\n"
+    "/store id=:id /products/:id 301\n"
+    "/store /shop 301\n"
+    "/store /unreachable 302\n"
+    "\n"
+    "/feed/* /rss/:splat 302\n"
+    "/feed /rss.xml 301\n"
+    "/es/home /es 302 Language=es\n"
+    "/es/home /en 302\n"
+    "/missing-target\n"
+    "/ /home 200\n"
+    "/* /404.html 404\n";
+
+// URLs exercised against both engines with HASH_TEST_REDIRECTS
+static const char *const HASH_TEST_URLS[] = {
+    "/", "", "/2019/hello-world", "/2019/hello-world/", "/2019/second-post?x=1", "/2020/third-post",
+    "/about", "/about/", "/old/contact", "/old/faq", "/store", "/store?id=7", "/feed", "/feed/atom",
+    "/es/home", "/es/home/", "/2019", "/2019/hello-world/extra", "/missing", "//2019/hello-world",
+};
+
+static nanorouter_redirect_rule_list_t* hash_test_load_rules(void) {
+    return redirect_engine_test_load_rules(HASH_TEST_REDIRECTS);
+}
+
+void test_parse_redirects_file_skips_invalid_lines(void) {
+    nanorouter_redirect_rule_list_t *list = hash_test_load_rules();
+    TEST_ASSERT_EQUAL(15, list->count);
+    TEST_ASSERT_EQUAL_STRING("/2019/hello-world", list->head->rule.from_route);
+    TEST_ASSERT_EQUAL_STRING("/posts/hello-world", list->head->rule.to_route);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_parse_redirects_file_null_args(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_FALSE(nanorouter_parse_redirects_file(NULL, list));
+    TEST_ASSERT_FALSE(nanorouter_parse_redirects_file("/a /b 301", NULL));
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("", list));
+    TEST_ASSERT_EQUAL(0, list->count);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_hash_compile_sets_engine(void) {
+    nanorouter_redirect_rule_list_t *list = hash_test_load_rules();
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_HASH));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_HASH, list->engine);
+    TEST_ASSERT_NOT_NULL(list->hash);
+    TEST_ASSERT_NULL(list->trie);
+
+    // Switching engines releases the previous index
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_TRIE));
+    TEST_ASSERT_NULL(list->hash);
+    TEST_ASSERT_NOT_NULL(list->trie);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_hash_matches_linear_engine(void) {
+    redirect_engine_test_assert_matches_linear(REDIRECT_ENGINE_TEST_REDIRECTS, NR_REDIRECT_ENGINE_HASH,
+                                               REDIRECT_ENGINE_TEST_URLS, REDIRECT_ENGINE_TEST_NUM_URLS);
+
+    // Literal duplicates, trailing slashes and literal rules behind patterns, which only the hash slots group
+    redirect_engine_test_assert_matches_linear(HASH_TEST_REDIRECTS, NR_REDIRECT_ENGINE_HASH,
+                                               HASH_TEST_URLS, sizeof(HASH_TEST_URLS) / sizeof(HASH_TEST_URLS[0]));
+}
+
+void test_redirect_hash_keeps_file_order(void) {
+    nanorouter_redirect_rule_list_t *list = hash_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_HASH));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    // The placeholder rule comes before the literal one
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/old/contact", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/new/contact", response.new_url);
+    TEST_ASSERT_EQUAL(302, response.status_code);
+
+    // Literal duplicates are confirmed in order, including their query parameters
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store?id=7", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/products/7?id=7", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/shop", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/es/home", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/en", response.new_url);
+    strcpy(context.language, "es");
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/es/home", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/es", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/about", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/about-us", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/home", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_hash_many_literal_rules(void) {
+    nanorouter_redirect_rule_list_t *linear = nanorouter_redirect_rule_list_create();
+    nanorouter_redirect_rule_list_t *hash = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(linear);
+    TEST_ASSERT_NOT_NULL(hash);
+
+    char line[64];
+    for (int i = 0; i < 500; i++) {
+        redirect_rule_t rule;
+        snprintf(line, sizeof(line), "/legacy/page-%d /pages/%d 301", i, i);
+        TEST_ASSERT_TRUE(nr_parse_redirect_rule(line, strlen(line), &rule));
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_add_rule(linear, &rule));
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_add_rule(hash, &rule));
+    }
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(hash, NR_REDIRECT_ENGINE_HASH));
+
+    nanorouter_request_context_t context = {0};
+    char url[64];
+    for (int i = 0; i < 510; i += 3) {
+        nanorouter_redirect_response_t expected;
+        nanorouter_redirect_response_t actual;
+        snprintf(url, sizeof(url), "/legacy/page-%d", i);
+        bool expected_result = nanorouter_process_redirect_request(url, linear, &expected, &context);
+        TEST_ASSERT_EQUAL(expected_result, nanorouter_process_redirect_request(url, hash, &actual, &context));
+        TEST_ASSERT_EQUAL_STRING(expected.new_url, actual.new_url);
+        TEST_ASSERT_EQUAL(i < 500 ? 301 : 0, actual.status_code);
+    }
+
+    nanorouter_redirect_rule_list_free(linear);
+    nanorouter_redirect_rule_list_free(hash);
+}
+
+int test_nanorouter_redirect_hash(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_redirects_file_skips_invalid_lines);
+    RUN_TEST(test_parse_redirects_file_null_args);
+    RUN_TEST(test_redirect_hash_compile_sets_engine);
+    RUN_TEST(test_redirect_hash_matches_linear_engine);
+    RUN_TEST(test_redirect_hash_keeps_file_order);
+    RUN_TEST(test_redirect_hash_many_literal_rules);
+    return UNITY_END();
+}
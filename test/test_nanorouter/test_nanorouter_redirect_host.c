@@ -0,0 +1,336 @@
+#include "test_nanorouter_redirect_host.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_host.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Domain-level rules from docs/redirects.md mixed with path rules, in file order
+static const char *const HOST_TEST_REDIRECTS =
+    "/pricing /plans 301\n"
+    "http://blog.yoursite.com/* https://www.yoursite.com/blog/:splat 301!\n"
+    "https://blog.yoursite.com/* https://www.yoursite.com/blog/:splat 302!\n"
+    "/about /about-us 301\n"
+    "https://shop.yoursite.com/cart https://www.yoursite.com/basket 301\n"
+    "https://shop.yoursite.com/item id=:id https://www.yoursite.com/items/:id 301\n"
+    "https://shop.yoursite.com /home 200\n"
+    "http://de.yoursite.com/* /de/:splat 302 Country=de\n"
+    "/* /404.html 404\n";
+
+static const char *const HOST_TEST_URLS[] = {
+    "/", "", "/pricing", "/about", "/post/hello", "/cart", "/cart/", "/item?id=7", "/item",
+    "/unknown", "http://blog.yoursite.com/post", "/a/b/c",
+};
+
+static void host_test_set_context(nanorouter_request_context_t *context, const char *domain, const char *scheme) {
+    memset(context, 0, sizeof(*context));
+    strncpy(context->domain, domain, NR_MAX_DOMAIN_LEN);
+    strncpy(context->scheme, scheme, NR_MAX_SCHEME_LEN);
+}
+
+static void host_test_assert_redirect(nanorouter_redirect_rule_list_t *list, const char *url, const nanorouter_request_context_t *context,
+                                      const char *expected_url, int expected_status) {
+    nanorouter_redirect_response_t response;
+    bool applied = nanorouter_process_redirect_request(url, list, &response, context);
+    if (expected_url == NULL) {
+        TEST_ASSERT_FALSE_MESSAGE(applied, url);
+        return;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(applied, url);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_url, response.new_url, url);
+    TEST_ASSERT_EQUAL_MESSAGE(expected_status, response.status_code, url);
+}
+
+void test_redirect_host_split_route(void) {
+    bool https = false;
+    size_t host_offset = 0;
+    size_t host_len = 0;
+    size_t path_offset = 0;
+
+    TEST_ASSERT_TRUE(nr_redirect_route_split_host("http://blog.yoursite.com/*", &https, &host_offset, &host_len, &path_offset));
+    TEST_ASSERT_FALSE(https);
+    TEST_ASSERT_EQUAL(7, host_offset);
+    TEST_ASSERT_EQUAL(17, host_len);
+    TEST_ASSERT_EQUAL(24, path_offset);
+
+    TEST_ASSERT_TRUE(nr_redirect_route_split_host("HTTPS://Shop.Example", &https, &host_offset, &host_len, &path_offset));
+    TEST_ASSERT_TRUE(https);
+    TEST_ASSERT_EQUAL(12, host_len);
+    TEST_ASSERT_EQUAL(20, path_offset);
+
+    TEST_ASSERT_FALSE(nr_redirect_route_split_host("/blog/*", NULL, NULL, NULL, NULL));
+    TEST_ASSERT_FALSE(nr_redirect_route_split_host("http:///path", NULL, NULL, NULL, NULL));
+    TEST_ASSERT_FALSE(nr_redirect_route_split_host("ftp://example.com/", NULL, NULL, NULL, NULL));
+    TEST_ASSERT_FALSE(nr_redirect_route_split_host(NULL, NULL, NULL, NULL, NULL));
+}
+
+void test_redirect_host_remove_last(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "https://shop.yoursite.com/cart /basket 301\n"
+        "https://shop.yoursite.com/item /items 301\n"
+        "/about /about-us 301\n");
+    const nanorouter_redirect_rule_t *cart = list->head;
+    const nanorouter_redirect_rule_t *item = cart->next;
+
+    // Only the last rule filed under a host can be taken back
+    TEST_ASSERT_FALSE(nr_redirect_host_table_remove_last(list->hosts, cart));
+    TEST_ASSERT_FALSE(nr_redirect_host_table_remove_last(list->hosts, item->next));
+    TEST_ASSERT_TRUE(nr_redirect_host_table_remove_last(list->hosts, item));
+    TEST_ASSERT_FALSE(nr_redirect_host_table_remove_last(list->hosts, item));
+
+    size_t num_rules = 0;
+    const nr_redirect_host_rule_t *rules = nr_redirect_host_table_lookup(list->hosts, "shop.yoursite.com", 17, &num_rules);
+    TEST_ASSERT_EQUAL(1, num_rules);
+    TEST_ASSERT_EQUAL_PTR(cart, rules[0].node);
+
+    TEST_ASSERT_TRUE(nr_redirect_host_table_remove_last(list->hosts, cart));
+    nr_redirect_host_table_lookup(list->hosts, "shop.yoursite.com", 17, &num_rules);
+    TEST_ASSERT_EQUAL(0, num_rules);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_dispatch_by_domain(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    nanorouter_request_context_t context;
+
+    host_test_set_context(&context, "blog.yoursite.com", "http");
+    host_test_assert_redirect(list, "/post/hello", &context, "https://www.yoursite.com/blog/post/hello", 301);
+    host_test_assert_redirect(list, "/", &context, "https://www.yoursite.com/blog/", 301);
+
+    // Host names are case-insensitive
+    host_test_set_context(&context, "Blog.YourSite.COM", "http");
+    host_test_assert_redirect(list, "/post/hello", &context, "https://www.yoursite.com/blog/post/hello", 301);
+
+    // Other hosts only see the path rules
+    host_test_set_context(&context, "www.yoursite.com", "http");
+    host_test_assert_redirect(list, "/post/hello", &context, "/404.html", 404);
+    host_test_assert_redirect(list, "/about", &context, "/about-us", 301);
+
+    // Without a domain the host rules cannot apply
+    host_test_assert_redirect(list, "/post/hello", NULL, "/404.html", 404);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_file_order(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    nanorouter_request_context_t context;
+    host_test_set_context(&context, "blog.yoursite.com", "https");
+
+    // A path rule above the host rules still wins, one below loses to them
+    host_test_assert_redirect(list, "/pricing", &context, "/plans", 301);
+    host_test_assert_redirect(list, "/about", &context, "https://www.yoursite.com/blog/about", 302);
+
+    // Host rules that do not match fall through to the later path rules
+    host_test_set_context(&context, "shop.yoursite.com", "https");
+    host_test_assert_redirect(list, "/about", &context, "/about-us", 301);
+    host_test_assert_redirect(list, "/cart", &context, "https://www.yoursite.com/basket", 301);
+    host_test_assert_redirect(list, "/", &context, "/home", 200);
+    host_test_assert_redirect(list, "/item?id=7", &context, "https://www.yoursite.com/items/7?id=7", 301);
+    host_test_assert_redirect(list, "/item", &context, "/404.html", 404);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_scheme_and_conditions(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    nanorouter_request_context_t context;
+
+    host_test_set_context(&context, "blog.yoursite.com", "https");
+    host_test_assert_redirect(list, "/post", &context, "https://www.yoursite.com/blog/post", 302);
+    host_test_set_context(&context, "blog.yoursite.com", "HTTP");
+    host_test_assert_redirect(list, "/post", &context, "https://www.yoursite.com/blog/post", 301);
+    // Unknown scheme: host rules are skipped
+    host_test_set_context(&context, "blog.yoursite.com", "");
+    host_test_assert_redirect(list, "/post", &context, "/404.html", 404);
+
+    // https-only rules are skipped for plain http requests
+    host_test_set_context(&context, "shop.yoursite.com", "http");
+    host_test_assert_redirect(list, "/cart", &context, "/404.html", 404);
+
+    host_test_set_context(&context, "de.yoursite.com", "http");
+    host_test_assert_redirect(list, "/kontakt", &context, "/404.html", 404);
+    strncpy(context.country, "de", NR_MAX_COUNTRY_LEN);
+    host_test_assert_redirect(list, "/kontakt", &context, "/de/kontakt", 302);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_absolute_request_url(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    nanorouter_request_context_t context = {0};
+
+    // A full request URL carries its own host and matches the full from_route
+    host_test_assert_redirect(list, "http://blog.yoursite.com/post", &context, "https://www.yoursite.com/blog/post", 301);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_deep_url(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    nanorouter_request_context_t context;
+    host_test_set_context(&context, "blog.yoursite.com", "http");
+
+    // More segments than NR_MAX_PATH_SEGMENTS take the string matcher
+    char url[NR_MAX_ROUTE_LEN + 1] = {0};
+    for (size_t i = 0; i < NR_MAX_PATH_SEGMENTS + 2; i++) {
+        strcat(url, "/a");
+    }
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request(url, list, &response, &context));
+    TEST_ASSERT_EQUAL(301, response.status_code);
+    TEST_ASSERT_EQUAL_STRING_LEN("https://www.yoursite.com/blog/a/a/a", response.new_url, 35);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+    static const char *const domains[] = { "", "blog.yoursite.com", "shop.yoursite.com", "www.yoursite.com" };
+    static const char *const schemes[] = { "", "http", "https" };
+
+    nanorouter_redirect_rule_list_t *linear = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_load_rules(HOST_TEST_REDIRECTS);
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+
+        for (size_t d = 0; d < sizeof(domains) / sizeof(domains[0]); d++) {
+            for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); s++) {
+                nanorouter_request_context_t context;
+                host_test_set_context(&context, domains[d], schemes[s]);
+                for (size_t u = 0; u < sizeof(HOST_TEST_URLS) / sizeof(HOST_TEST_URLS[0]); u++) {
+                    nanorouter_redirect_response_t expected;
+                    nanorouter_redirect_response_t actual;
+                    bool expected_result = nanorouter_process_redirect_request(HOST_TEST_URLS[u], linear, &expected, &context);
+                    bool actual_result = nanorouter_process_redirect_request(HOST_TEST_URLS[u], indexed, &actual, &context);
+                    TEST_ASSERT_EQUAL(expected_result, actual_result);
+                    TEST_ASSERT_EQUAL(expected.status_code, actual.status_code);
+                    TEST_ASSERT_EQUAL_STRING(expected.new_url, actual.new_url);
+                }
+            }
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+// Blanket http to https and www to apex redirects at the top of the file
+static const char *const CANONICAL_TEST_REDIRECTS =
+    "http://example.com/* https://example.com/:splat 301!\n"
+    "https://www.example.com/* https://example.com/:splat 301!\n"
+    "http://www.example.com/* https://example.com/:splat 308!\n"
+    "/old /new 301\n"
+    "https://example.com/legacy /modern 302\n"
+    "http://shop.example.com/* https://shop.example.com/:splat 301 Country=de\n"
+    "/* /index.html 200\n";
+
+static const char *const CANONICAL_TEST_URLS[] = {
+    "/", "", "/old", "/a/b/", "/a/b?x=1&&y=2", "/?q", "/legacy", "/https://example.com/old", "http://example.com/old",
+};
+
+void test_redirect_host_canonical_rules(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(CANONICAL_TEST_REDIRECTS);
+    size_t num_rules = 0;
+    const nr_redirect_host_rule_t *host_rules = nr_redirect_host_table_lookup(list->hosts, "www.example.com", 15, &num_rules);
+    TEST_ASSERT_EQUAL(2, num_rules);
+    TEST_ASSERT_TRUE(host_rules[0].canonical);
+    TEST_ASSERT_TRUE(host_rules[1].canonical);
+    host_rules = nr_redirect_host_table_lookup(list->hosts, "example.com", 11, &num_rules);
+    TEST_ASSERT_EQUAL(2, num_rules);
+    TEST_ASSERT_TRUE(host_rules[0].canonical);
+    TEST_ASSERT_FALSE(host_rules[1].canonical); // One path only
+    host_rules = nr_redirect_host_table_lookup(list->hosts, "shop.example.com", 16, &num_rules);
+    TEST_ASSERT_EQUAL(1, num_rules);
+    TEST_ASSERT_FALSE(host_rules[0].canonical); // Has a condition
+    TEST_ASSERT_EQUAL(3, list->first_path_index);
+
+    nanorouter_request_context_t context;
+    host_test_set_context(&context, "www.example.com", "https");
+    host_test_assert_redirect(list, "/a/b/", &context, "https://example.com/a/b", 301);
+    host_test_assert_redirect(list, "/a/b?x=1&&y=2", &context, "https://example.com/a/b?x=1&y=2", 301);
+    host_test_assert_redirect(list, "/", &context, "https://example.com/", 301);
+    host_test_set_context(&context, "WWW.Example.com", "http");
+    host_test_assert_redirect(list, "/old", &context, "https://example.com/old", 308);
+    host_test_set_context(&context, "example.com", "http");
+    host_test_assert_redirect(list, "/old?x=1", &context, "https://example.com/old?x=1", 301);
+
+    // The canonical host goes on to the path rules
+    host_test_set_context(&context, "example.com", "https");
+    host_test_assert_redirect(list, "/old", &context, "/new", 301);
+    host_test_assert_redirect(list, "/legacy", &context, "/modern", 302);
+
+    // The forced rules are decided in the forced pass, and left out of the fallback one
+    nanorouter_redirect_response_t response;
+    host_test_set_context(&context, "www.example.com", "https");
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/x", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("https://example.com/x", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/x", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/index.html", response.new_url);
+
+    // Without a scheme, the http to https redirect must not answer the https request it sends the client to
+    host_test_set_context(&context, "example.com", "");
+    host_test_assert_redirect(list, "/foo", &context, "/index.html", 200);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/foo", list, &response, &context));
+
+    nanorouter_redirect_rule_list_free(list);
+
+    // A path rule above the host-wide redirect still wins
+    host_test_set_context(&context, "www.example.com", "https");
+    list = redirect_engine_test_load_rules("/old /new 301\nhttps://www.example.com/* https://example.com/:splat 301!\n");
+    TEST_ASSERT_EQUAL(0, list->first_path_index);
+    host_test_assert_redirect(list, "/old", &context, "/new", 301);
+    host_test_assert_redirect(list, "/other", &context, "https://example.com/other", 301);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_host_canonical_matches_matcher(void) {
+    static const char *const domains[] = { "", "example.com", "www.example.com", "shop.example.com", "other.com" };
+    static const char *const schemes[] = { "", "http", "https" };
+
+    // A path rule on top keeps every request in the matcher
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), "/never/matched /x 301\n%s", CANONICAL_TEST_REDIRECTS);
+    nanorouter_redirect_rule_list_t *matched = redirect_engine_test_load_rules(buffer);
+    nanorouter_redirect_rule_list_t *canonical = redirect_engine_test_load_rules(CANONICAL_TEST_REDIRECTS);
+    TEST_ASSERT_EQUAL(0, matched->first_path_index);
+
+    for (size_t d = 0; d < sizeof(domains) / sizeof(domains[0]); d++) {
+        for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); s++) {
+            nanorouter_request_context_t context;
+            host_test_set_context(&context, domains[d], schemes[s]);
+            for (size_t u = 0; u < sizeof(CANONICAL_TEST_URLS) / sizeof(CANONICAL_TEST_URLS[0]); u++) {
+                nanorouter_redirect_response_t expected;
+                nanorouter_redirect_response_t actual;
+                bool expected_result = nanorouter_process_redirect_request(CANONICAL_TEST_URLS[u], matched, &expected, &context);
+                bool actual_result = nanorouter_process_redirect_request(CANONICAL_TEST_URLS[u], canonical, &actual, &context);
+                TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, CANONICAL_TEST_URLS[u]);
+                TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, actual.status_code, CANONICAL_TEST_URLS[u]);
+                TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, CANONICAL_TEST_URLS[u]);
+            }
+        }
+    }
+
+    nanorouter_redirect_rule_list_free(canonical);
+    nanorouter_redirect_rule_list_free(matched);
+}
+
+int test_nanorouter_redirect_host(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_host_split_route);
+    RUN_TEST(test_redirect_host_remove_last);
+    RUN_TEST(test_redirect_host_dispatch_by_domain);
+    RUN_TEST(test_redirect_host_file_order);
+    RUN_TEST(test_redirect_host_scheme_and_conditions);
+    RUN_TEST(test_redirect_host_absolute_request_url);
+    RUN_TEST(test_redirect_host_deep_url);
+    RUN_TEST(test_redirect_host_engines_agree);
+    RUN_TEST(test_redirect_host_canonical_rules);
+    RUN_TEST(test_redirect_host_canonical_matches_matcher);
+    return UNITY_END();
+}
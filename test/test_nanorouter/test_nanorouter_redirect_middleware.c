@@ -441,6 +441,58 @@ void test_nanorouter_process_redirect_request_to_route_with_query() {
     nanorouter_redirect_rule_list_free(list);
 }
 
+void test_nanorouter_process_redirect_request_parsed() {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    redirect_rule_t rule1 = create_test_rule("/blog/:slug", "/posts/:slug", 301, false);
+    nanorouter_redirect_rule_list_add_rule(list, &rule1);
+
+    // One parse can be shared with the header middleware
+    nr_parsed_url_t parsed_url;
+    nr_parse_url("/blog/hello?ref=feed", &parsed_url);
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_parsed(&parsed_url, list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/posts/hello?ref=feed", response.new_url);
+    TEST_ASSERT_EQUAL(301, response.status_code);
+
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_parsed(NULL, list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_nanorouter_process_redirect_request_n() {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    redirect_rule_t rule1 = create_test_rule("/blog/:slug", "/posts/:slug", 301, false);
+    redirect_rule_t rule2 = create_test_rule("/:page/secret", "/found", 302, false);
+    nanorouter_redirect_rule_list_add_rule(list, &rule1);
+    nanorouter_redirect_rule_list_add_rule(list, &rule2);
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    // The URL is a slice of a request line, matched in place
+    const char *request_line = "GET /blog/hello?ref=feed HTTP/1.1\r\n";
+    const char *url = request_line + 4;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_n(url, strlen("/blog/hello?ref=feed"), list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/posts/hello?ref=feed", response.new_url);
+    TEST_ASSERT_EQUAL(301, response.status_code);
+
+    // A path longer than NR_MAX_ROUTE_LEN is matched whole, not cut before its last segment
+    char long_url[NR_MAX_ROUTE_LEN + 8];
+    memset(long_url, 'a', sizeof(long_url));
+    long_url[0] = '/';
+    memcpy(long_url + NR_MAX_ROUTE_LEN, "/secret", 7);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_n(long_url, sizeof(long_url) - 1, list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/found", response.new_url);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_n(long_url, NR_MAX_ROUTE_LEN, list, &response, &context));
+
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_n(NULL, 0, list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
 
 // --- Main Test Runner for this module ---
 int test_nanorouter_redirect_middleware() {
@@ -481,6 +533,8 @@ int test_nanorouter_redirect_middleware() {
     RUN_TEST(test_nanorouter_process_redirect_request_empty_request_url);
     RUN_TEST(test_nanorouter_process_redirect_request_placeholder_not_found);
     RUN_TEST(test_nanorouter_process_redirect_request_to_route_with_query);
+    RUN_TEST(test_nanorouter_process_redirect_request_parsed);
+    RUN_TEST(test_nanorouter_process_redirect_request_n);
 
     return UNITY_END();
 }
@@ -0,0 +1,152 @@
+#include "test_nanorouter_redirect_mph.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_mph.h"
+#include "test_redirect_mph_table.h" // Generated from test_redirect_mph_table._redirects
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Same content as test_redirect_mph_table._redirects
+static const char *const MPH_TEST_REDIRECTS =
+    "# Static redirect set used by test_nanorouter_redirect_mph.c\n"
+    "/blog/2000/post-0 /posts/post-0 301\n"
+    "/blog/2001/post-1 /posts/post-1 301\n"
+    "/blog/2002/post-2 /posts/post-2 301\n"
+    "/blog/2003/post-3 /posts/post-3 301\n"
+    "/blog/2004/post-4 /posts/post-4 301\n"
+    "/blog/2005/post-5 /posts/post-5 301\n"
+    "/blog/2000/post-6 /posts/post-6 301\n"
+    "/blog/2001/post-7 /posts/post-7 301\n"
+    "/blog/2002/post-8 /posts/post-8 301\n"
+    "/blog/2003/post-9 /posts/post-9 301\n"
+    "/blog/2004/post-10 /posts/post-10 301\n"
+    "/blog/2005/post-11 /posts/post-11 301\n"
+    "/blog/2000/post-12 /posts/post-12 301\n"
+    "/blog/2001/post-13 /posts/post-13 301\n"
+    "/blog/2002/post-14 /posts/post-14 301\n"
+    "/blog/2003/post-15 /posts/post-15 301\n"
+    "/blog/2004/post-16 /posts/post-16 301\n"
+    "/blog/2005/post-17 /posts/post-17 301\n"
+    "/blog/2000/post-18 /posts/post-18 301\n"
+    "/blog/2001/post-19 /posts/post-19 301\n"
+    "/blog/2002/post-20 /posts/post-20 301\n"
+    "/blog/2003/post-21 /posts/post-21 301\n"
+    "/blog/2004/post-22 /posts/post-22 301\n"
+    "/blog/2005/post-23 /posts/post-23 301\n"
+    "/old/:page /new/:page 302\n"
+    "/old/contact /contact 301\n"
+    "/store id=:id /products/:id 301\n"
+    "/store /shop 301\n"
+    "/feed/* /rss/:splat 302\n"
+    "/feed /rss.xml 301\n"
+    "/es/home /es 302 Language=es\n"
+    "/es/home /en 302\n"
+    "/about/ /about-us 301\n"
+    "/ /home 200\n"
+    "/* /404.html 404\n";
+
+// URLs exercised against both engines
+static const char *const MPH_TEST_URLS[] = {
+    "/", "", "/blog/2000/post-0", "/blog/2000/post-0/", "/blog/2003/post-21?x=1", "/blog/2001/post-0",
+    "/about", "/about/", "/old/contact", "/old/faq", "/store", "/store?id=7", "/feed", "/feed/atom",
+    "/es/home", "/blog", "/blog/2000", "/missing", "//blog/2000/post-0",
+};
+
+static nanorouter_redirect_rule_list_t* mph_test_load_rules(void) {
+    return redirect_engine_test_load_rules(MPH_TEST_REDIRECTS);
+}
+
+void test_redirect_mph_table_is_perfect(void) {
+    const nr_redirect_mph_table_t *table = &test_redirect_mph_table;
+    TEST_ASSERT_EQUAL(30, table->num_entries);
+
+    // Every key sits in the slot it hashes to: no collisions, one probe per lookup
+    for (uint32_t i = 0; i < table->num_entries; i++) {
+        const nr_redirect_mph_entry_t *entry = &table->entries[i];
+        TEST_ASSERT_EQUAL(i, nr_redirect_mph_slot(table, entry->key, entry->key_len));
+        TEST_ASSERT_EQUAL_PTR(entry, nr_redirect_mph_lookup(table, entry->key, entry->key_len));
+    }
+}
+
+void test_redirect_mph_lookup_rejects_unknown_keys(void) {
+    const nr_redirect_mph_table_t *table = &test_redirect_mph_table;
+    TEST_ASSERT_NULL(nr_redirect_mph_lookup(table, "blog/2000/post-1", 16));
+    TEST_ASSERT_NULL(nr_redirect_mph_lookup(table, "stor", 4));
+    TEST_ASSERT_NULL(nr_redirect_mph_lookup(table, "old/:page", 9));
+    TEST_ASSERT_NULL(nr_redirect_mph_lookup(NULL, "store", 5));
+
+    const nr_redirect_mph_entry_t *entry = nr_redirect_mph_lookup(table, "store", 5);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL(2, entry->num_rules);
+}
+
+void test_redirect_mph_compile_static(void) {
+    nanorouter_redirect_rule_list_t *list = mph_test_load_rules();
+
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_STATIC_HASH));
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_compile_static(list, NULL));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile_static(list, &test_redirect_mph_table));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_STATIC_HASH, list->engine);
+    TEST_ASSERT_NOT_NULL(list->hash);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_mph_rejects_other_rule_set(void) {
+    nanorouter_redirect_rule_list_t *list = mph_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/extra /page 301", list));
+
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_compile_static(list, &test_redirect_mph_table));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_LINEAR, list->engine);
+    TEST_ASSERT_NULL(list->hash);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_mph_matches_linear_engine(void) {
+    nanorouter_redirect_rule_list_t *linear = mph_test_load_rules();
+    nanorouter_redirect_rule_list_t *mph = mph_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile_static(mph, &test_redirect_mph_table));
+
+    redirect_engine_test_assert_same_results(linear, mph, MPH_TEST_URLS, sizeof(MPH_TEST_URLS) / sizeof(MPH_TEST_URLS[0]));
+
+    nanorouter_redirect_rule_list_free(linear);
+    nanorouter_redirect_rule_list_free(mph);
+}
+
+void test_redirect_mph_batch_matches_single_requests(void) {
+    nanorouter_redirect_rule_list_t *list = mph_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile_static(list, &test_redirect_mph_table));
+
+    // The batch prefetches each URL's table entry before matching its group
+    const size_t num_urls = sizeof(MPH_TEST_URLS) / sizeof(MPH_TEST_URLS[0]);
+    nanorouter_redirect_response_t results[sizeof(MPH_TEST_URLS) / sizeof(MPH_TEST_URLS[0])];
+    size_t applied = nanorouter_process_redirect_batch(MPH_TEST_URLS, num_urls, list, NULL, results);
+
+    size_t expected_applied = 0;
+    for (size_t i = 0; i < num_urls; i++) {
+        nanorouter_redirect_response_t expected;
+        if (nanorouter_process_redirect_request(MPH_TEST_URLS[i], list, &expected, NULL)) {
+            expected_applied++;
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, results[i].status_code, MPH_TEST_URLS[i]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, results[i].new_url, MPH_TEST_URLS[i]);
+    }
+    TEST_ASSERT_EQUAL(expected_applied, applied);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+int test_nanorouter_redirect_mph(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_mph_table_is_perfect);
+    RUN_TEST(test_redirect_mph_lookup_rejects_unknown_keys);
+    RUN_TEST(test_redirect_mph_compile_static);
+    RUN_TEST(test_redirect_mph_rejects_other_rule_set);
+    RUN_TEST(test_redirect_mph_matches_linear_engine);
+    RUN_TEST(test_redirect_mph_batch_matches_single_requests);
+    return UNITY_END();
+}
@@ -0,0 +1,216 @@
+#include "test_nanorouter_redirect_not_found.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_not_found.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Per-locale 404 pages from docs/redirects.md, after a few ordinary rules
+static const char *const NOT_FOUND_TEST_REDIRECTS =
+    "/en/old /en/new 301\n"
+    "/en/blog/:slug /en/posts/:slug 200\n"
+    "/en/* /en/404.html 404\n"
+    "/de/* /de/404.html 404\n"
+    "/docs/v1/:rest /docs/v1/404.html 404\n"
+    "/docs/* /docs/404.html 404\n"
+    "/de/seite /de/page 301\n"
+    "/* /404.html 404\n";
+
+static const char *const NOT_FOUND_TEST_URLS[] = {
+    "/", "", "/en", "/en/", "/en/old", "/en/missing", "/en/blog/hello", "/en/blog", "/de/seite", "/de/a/b/c",
+    "/docs", "/docs/v1", "/docs/v1/x", "/docs/v2/x/y", "/fr/x", "/en/missing?page=2",
+};
+
+static void not_found_test_assert_redirect(nanorouter_redirect_rule_list_t *list, const char *url, const nanorouter_request_context_t *context,
+                                           const char *expected_url, int expected_status) {
+    nanorouter_redirect_response_t response;
+    bool applied = nanorouter_process_redirect_request(url, list, &response, context);
+    if (expected_url == NULL) {
+        TEST_ASSERT_FALSE_MESSAGE(applied, url);
+        return;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(applied, url);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_url, response.new_url, url);
+    TEST_ASSERT_EQUAL_MESSAGE(expected_status, response.status_code, url);
+}
+
+void test_not_found_prefix_rules(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/en/* /en/404.html 404\n"
+        "/docs/:rest /docs/404.html 404\n"
+        "/* /404.html 404\n"
+        "/en/* /en/index.html 301\n"
+        "/en/missing /en/404.html 404\n"
+        "/en/:lang/* /en/404.html 404\n"
+        "https://blog.example.com/* /blog/404.html 404\n");
+
+    // Only 404 rules made of literal segments and a trailing splat are filed by prefix
+    static const bool expected[] = { true, true, true, false, false, false, false };
+    size_t i = 0;
+    for (const nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next, i++) {
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], nr_redirect_rule_is_not_found_prefix(node), node->rule.from_route);
+        TEST_ASSERT_EQUAL_MESSAGE(expected[i], node->not_found_prefix, node->rule.from_route);
+    }
+    TEST_ASSERT_EQUAL(7, i);
+    TEST_ASSERT_NOT_NULL(list->not_found);
+    TEST_ASSERT_FALSE(nr_redirect_rule_is_not_found_prefix(NULL));
+
+    nanorouter_redirect_rule_list_free(list);
+
+    // A list without such rules has no map
+    list = redirect_engine_test_load_rules("/en/old /en/new 301\n/en/* /en/index.html 200\n");
+    TEST_ASSERT_NULL(list->not_found);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_remove_last(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/en/* /en/404.html 404\n"
+        "/en/* /en/other.html 404\n"
+        "/en/old /en/new 301\n");
+    const nanorouter_redirect_rule_t *first = list->head;
+    const nanorouter_redirect_rule_t *second = first->next;
+
+    // Only the last rule filed under a prefix can be taken back
+    TEST_ASSERT_FALSE(nr_redirect_not_found_map_remove_last(list->not_found, first));
+    TEST_ASSERT_FALSE(nr_redirect_not_found_map_remove_last(list->not_found, second->next));
+    TEST_ASSERT_TRUE(nr_redirect_not_found_map_remove_last(list->not_found, second));
+    TEST_ASSERT_FALSE(nr_redirect_not_found_map_remove_last(list->not_found, second));
+    not_found_test_assert_redirect(list, "/en/missing", NULL, "/en/404.html", 404);
+
+    TEST_ASSERT_TRUE(nr_redirect_not_found_map_remove_last(list->not_found, first));
+    TEST_ASSERT_FALSE(nr_redirect_not_found_map_remove_last(NULL, first));
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_locale_pages(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(NOT_FOUND_TEST_REDIRECTS);
+
+    not_found_test_assert_redirect(list, "/en/missing", NULL, "/en/404.html", 404);
+    not_found_test_assert_redirect(list, "/en/a/b/c", NULL, "/en/404.html", 404);
+    not_found_test_assert_redirect(list, "/de/a/b/c", NULL, "/de/404.html", 404);
+    not_found_test_assert_redirect(list, "/docs/v1/x", NULL, "/docs/v1/404.html", 404);
+    not_found_test_assert_redirect(list, "/docs/v2/x", NULL, "/docs/404.html", 404);
+    not_found_test_assert_redirect(list, "/docs/v1", NULL, "/docs/404.html", 404);
+    not_found_test_assert_redirect(list, "/fr/x", NULL, "/404.html", 404);
+    // A splat needs a segment, so the bare prefix falls through to the root page
+    not_found_test_assert_redirect(list, "/en", NULL, "/404.html", 404);
+    not_found_test_assert_redirect(list, "/", NULL, "/404.html", 404);
+    // The request query is passed through, as for any rule
+    not_found_test_assert_redirect(list, "/en/missing?page=2", NULL, "/en/404.html?page=2", 404);
+
+    // Earlier rules still win over the 404 pages
+    not_found_test_assert_redirect(list, "/en/old", NULL, "/en/new", 301);
+    not_found_test_assert_redirect(list, "/en/blog/hello", NULL, "/en/posts/hello", 200);
+    // Later ones do not
+    not_found_test_assert_redirect(list, "/de/seite", NULL, "/de/404.html", 404);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_file_order(void) {
+    // The shallower rule comes first, so it wins even where the deeper one matches
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/en/* /en/404.html 404\n"
+        "/en/blog/* /en/blog/404.html 404\n");
+    not_found_test_assert_redirect(list, "/en/blog/x", NULL, "/en/404.html", 404);
+
+    // Specificity order moves the deeper rule first, and the map follows the new order
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    not_found_test_assert_redirect(list, "/en/blog/x", NULL, "/en/blog/404.html", 404);
+    not_found_test_assert_redirect(list, "/en/x", NULL, "/en/404.html", 404);
+    nanorouter_redirect_rule_list_free(list);
+
+    // Rules under one prefix keep their order, so conditions are tried in turn
+    list = redirect_engine_test_load_rules(
+        "/en/* /en/404-de.html 404 Country=de\n"
+        "/en/* /en/404.html 404\n"
+        "/en/* /en/unreachable.html 404\n");
+    nanorouter_request_context_t context;
+    memset(&context, 0, sizeof(context));
+    strncpy(context.country, "de", sizeof(context.country) - 1);
+    not_found_test_assert_redirect(list, "/en/x", &context, "/en/404-de.html", 404);
+    strncpy(context.country, "us", sizeof(context.country) - 1);
+    not_found_test_assert_redirect(list, "/en/x", &context, "/en/404.html", 404);
+    not_found_test_assert_redirect(list, "/en/x", NULL, "/en/404.html", 404);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_phases(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(
+        "/members/* /login.html 404!\n"
+        "/members/* /members/404.html 404\n"
+        "/* /404.html 404\n");
+    nanorouter_redirect_response_t response;
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/members/x", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/login.html", response.new_url);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/other", list, &response, NULL));
+
+    // The fallback pass skips the forced rule and finds the next one under the prefix
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/members/x", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/members/404.html", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/other", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/404.html", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_case_and_depth(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_case_insensitive(list, true));
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/EN/Docs/* /en/404.html 404\n/a/* /a/404.html 404\n", list));
+
+    not_found_test_assert_redirect(list, "/en/DOCS/x", NULL, "/en/404.html", 404);
+    not_found_test_assert_redirect(list, "/En/x", NULL, NULL, 0);
+
+    // More segments than NR_MAX_PATH_SEGMENTS still find their prefix
+    char url[NR_MAX_ROUTE_LEN + 1] = {0};
+    for (size_t i = 0; i < NR_MAX_PATH_SEGMENTS + 2; i++) {
+        strcat(url, "/a");
+    }
+    not_found_test_assert_redirect(list, url, NULL, "/a/404.html", 404);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_not_found_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+
+    nanorouter_redirect_rule_list_t *linear = redirect_engine_test_load_rules(NOT_FOUND_TEST_REDIRECTS);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_load_rules(NOT_FOUND_TEST_REDIRECTS);
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+
+        for (size_t u = 0; u < sizeof(NOT_FOUND_TEST_URLS) / sizeof(NOT_FOUND_TEST_URLS[0]); u++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(NOT_FOUND_TEST_URLS[u], linear, &expected, NULL);
+            bool actual_result = nanorouter_process_redirect_request(NOT_FOUND_TEST_URLS[u], indexed, &actual, NULL);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, NOT_FOUND_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, actual.status_code, NOT_FOUND_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, NOT_FOUND_TEST_URLS[u]);
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+int test_nanorouter_redirect_not_found(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_not_found_prefix_rules);
+    RUN_TEST(test_not_found_remove_last);
+    RUN_TEST(test_not_found_locale_pages);
+    RUN_TEST(test_not_found_file_order);
+    RUN_TEST(test_not_found_phases);
+    RUN_TEST(test_not_found_case_and_depth);
+    RUN_TEST(test_not_found_engines_agree);
+    return UNITY_END();
+}
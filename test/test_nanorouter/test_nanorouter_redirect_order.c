@@ -0,0 +1,166 @@
+#include "test_nanorouter_redirect_order.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+
+// Written the way people often write them: catch-all first, specific rules later
+static const char *const ORDER_TEST_REDIRECTS =
+    "/* /index.html 200\n"
+    "/docs/* /manual/:splat 301\n"
+    "/blog/* /blog-index 301\n"
+    "/blog/featured /featured 302\n"
+    "/blog/:year/archive /archive/:year 301\n"
+    "/:lang/blog/* /:lang/blog-home 302\n"
+    "/about /about-us 301\n"
+    "/search /results 302\n"
+    "/search id=:id /results/:id 301\n"
+    "http://blog.example.com/* https://example.com/blog/:splat 301\n";
+
+static const char *const ORDER_TEST_URLS[] = {
+    "/", "/other", "/docs/intro", "/blog/featured", "/blog/2024/archive", "/blog/x", "/en/blog/x",
+    "/about", "/search", "/search?id=5", "/blog/2024/archive/extra", "/blog",
+};
+
+static void order_test_count_warning(const redirect_rule_t *earlier, const redirect_rule_t *later, void *user_data) {
+    (void)earlier;
+    (void)later;
+    (*(int *)user_data)++;
+}
+
+static void order_test_expect(nanorouter_redirect_rule_list_t *list, const char *url, const char *expected_url) {
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE_MESSAGE(nanorouter_process_redirect_request(url, list, &response, NULL), url);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_url, response.new_url, url);
+}
+
+void test_redirect_order_file_order_is_default(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ORDER_FILE, list->order);
+    order_test_expect(list, "/blog/featured", "/index.html");
+    order_test_expect(list, "/about", "/index.html");
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_order_most_specific_wins(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ORDER_SPECIFICITY, list->order);
+
+    order_test_expect(list, "/blog/featured", "/featured");
+    order_test_expect(list, "/blog/2024/archive", "/archive/2024");
+    order_test_expect(list, "/blog/x", "/blog-index");
+    order_test_expect(list, "/en/blog/x", "/en/blog-home");
+    order_test_expect(list, "/docs/intro", "/manual/intro");
+    order_test_expect(list, "/about", "/about-us");
+    order_test_expect(list, "/other", "/index.html");
+    order_test_expect(list, "/", "/index.html");
+
+    // Same shape: the rule with a query parameter is more specific
+    order_test_expect(list, "/search?id=5", "/results/5?id=5");
+    order_test_expect(list, "/search", "/results");
+
+    // A rule for the request's host beats rules for every host
+    nanorouter_request_context_t context = {0};
+    strncpy(context.domain, "blog.example.com", NR_MAX_DOMAIN_LEN);
+    strncpy(context.scheme, "http", NR_MAX_SCHEME_LEN);
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/about", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("https://example.com/blog/about", response.new_url);
+
+    // Indexes follow the new order, file positions are kept
+    TEST_ASSERT_EQUAL_STRING("http://blog.example.com/*", list->head->rule.from_route);
+    TEST_ASSERT_EQUAL(0, list->head->index);
+    TEST_ASSERT_EQUAL(9, list->head->file_index);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_order_warns_about_changed_winners(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+    int warnings = 0;
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, order_test_count_warning, &warnings));
+    // The host rule against the 9 rules before it, "/*" against the 8 path rules
+    // after it, "/blog/*" against "/blog/featured" and "/blog/:year/archive",
+    // "/search" against its query variant. Reordered pairs that never match the
+    // same URL ("/docs/*" and "/about") are not reported.
+    TEST_ASSERT_EQUAL(20, warnings);
+
+    // Back to file order: nothing changes compared with file order
+    warnings = 0;
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_FILE, order_test_count_warning, &warnings));
+    TEST_ASSERT_EQUAL(0, warnings);
+    order_test_expect(list, "/blog/featured", "/index.html");
+    nanorouter_redirect_rule_list_free(list);
+
+    // A file already written most specific first gets no warnings
+    list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/blog/featured /featured 302\n/blog/* /blog-index 301\n/* /index.html 200\n", list));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, order_test_count_warning, &warnings));
+    TEST_ASSERT_EQUAL(0, warnings);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_order_add_rule_restores_file_order(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/contact /contact-us 301\n", list));
+
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ORDER_FILE, list->order);
+    TEST_ASSERT_EQUAL_STRING("/*", list->head->rule.from_route);
+    order_test_expect(list, "/blog/featured", "/index.html");
+
+    size_t position = 0;
+    for (const nanorouter_redirect_rule_t *current = list->head; current != NULL; current = current->next, position++) {
+        TEST_ASSERT_EQUAL(position, current->index);
+        TEST_ASSERT_EQUAL(position, current->file_index);
+    }
+    TEST_ASSERT_EQUAL(11, position);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_order_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+
+    nanorouter_redirect_rule_list_t *linear = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(linear, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_load_rules(ORDER_TEST_REDIRECTS);
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(indexed, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+        for (size_t u = 0; u < sizeof(ORDER_TEST_URLS) / sizeof(ORDER_TEST_URLS[0]); u++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(ORDER_TEST_URLS[u], linear, &expected, NULL);
+            bool actual_result = nanorouter_process_redirect_request(ORDER_TEST_URLS[u], indexed, &actual, NULL);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, ORDER_TEST_URLS[u]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, ORDER_TEST_URLS[u]);
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+void test_redirect_order_null_and_empty(void) {
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_set_order(NULL, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_set_order(list, NR_REDIRECT_ORDER_SPECIFICITY, NULL, NULL));
+    TEST_ASSERT_NULL(list->head);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+int test_nanorouter_redirect_order(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_order_file_order_is_default);
+    RUN_TEST(test_redirect_order_most_specific_wins);
+    RUN_TEST(test_redirect_order_warns_about_changed_winners);
+    RUN_TEST(test_redirect_order_add_rule_restores_file_order);
+    RUN_TEST(test_redirect_order_engines_agree);
+    RUN_TEST(test_redirect_order_null_and_empty);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+#include "test_nanorouter_redirect_phases.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Forced and shadowable rules interleaved, in file order
+static const char *const PHASES_TEST_REDIRECTS =
+    "/app/* /index.html 200\n"
+    "/old-blog/* /blog/:splat 301!\n"
+    "/docs/:page /manual/:page 302\n"
+    "/docs/legacy /manual/archive 301!\n"
+    "http://blog.example.com/* https://www.example.com/blog/:splat 301!\n"
+    "https://shop.example.com/* /shop/:splat 200\n"
+    "/maintenance /down.html 503! Country=nz\n"
+    "/* /404.html 404\n";
+
+static const char *const PHASES_TEST_URLS[] = {
+    "/", "/app/settings", "/old-blog/2024/post", "/docs/intro", "/docs/legacy", "/maintenance",
+    "/unknown", "/old-blog", "/docs/legacy?x=1",
+};
+
+void test_redirect_phases_forced_rules_kept_apart(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(PHASES_TEST_REDIRECTS);
+    TEST_ASSERT_EQUAL(8, list->count);
+    TEST_ASSERT_EQUAL(4, list->num_forced_rules);
+    TEST_ASSERT_EQUAL_STRING("/old-blog/*", list->forced_rules[0]->rule.from_route);
+    TEST_ASSERT_EQUAL_STRING("/maintenance", list->forced_rules[3]->rule.from_route);
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_phases_forced_pass(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(PHASES_TEST_REDIRECTS);
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/old-blog/2024/post", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/2024/post", response.new_url);
+    TEST_ASSERT_EQUAL(301, response.status_code);
+
+    // A forced rule wins over the earlier unforced "/docs/:page"
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/docs/legacy", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/manual/archive", response.new_url);
+
+    // Unforced rules are not part of this pass
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/app/settings", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("", response.new_url);
+    TEST_ASSERT_EQUAL(0, response.status_code);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/unknown", list, &response, &context));
+
+    // Conditions and host rules still apply
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/maintenance", list, &response, &context));
+    strncpy(context.country, "nz", NR_MAX_COUNTRY_LEN);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/maintenance", list, &response, &context));
+    TEST_ASSERT_EQUAL(503, response.status_code);
+    strncpy(context.domain, "blog.example.com", NR_MAX_DOMAIN_LEN);
+    strncpy(context.scheme, "http", NR_MAX_SCHEME_LEN);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_forced("/post", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("https://www.example.com/blog/post", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_phases_fallback_pass(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(PHASES_TEST_REDIRECTS);
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/app/settings", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/index.html", response.new_url);
+    TEST_ASSERT_EQUAL(200, response.status_code);
+
+    // Forced rules were handled by the first pass
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/old-blog/2024/post", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/404.html", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/docs/legacy", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/manual/legacy", response.new_url);
+
+    strncpy(context.domain, "shop.example.com", NR_MAX_DOMAIN_LEN);
+    strncpy(context.scheme, "https", NR_MAX_SCHEME_LEN);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_fallback("/cart", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/shop/cart", response.new_url);
+
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_fallback(NULL, list, &response, &context));
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_forced("/", NULL, &response, &context));
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_phases_engines_agree(void) {
+    static const nanorouter_redirect_engine_t engines[] = {
+        NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_HASH, NR_REDIRECT_ENGINE_DFA,
+        NR_REDIRECT_ENGINE_BITSET, NR_REDIRECT_ENGINE_PREFILTER,
+    };
+    nanorouter_request_context_t context = {0};
+    strncpy(context.domain, "blog.example.com", NR_MAX_DOMAIN_LEN);
+
+    nanorouter_redirect_rule_list_t *linear = redirect_engine_test_load_rules(PHASES_TEST_REDIRECTS);
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_load_rules(PHASES_TEST_REDIRECTS);
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(indexed, engines[e]));
+        for (size_t u = 0; u < sizeof(PHASES_TEST_URLS) / sizeof(PHASES_TEST_URLS[0]); u++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request_forced(PHASES_TEST_URLS[u], linear, &expected, &context);
+            bool actual_result = nanorouter_process_redirect_request_forced(PHASES_TEST_URLS[u], indexed, &actual, &context);
+            TEST_ASSERT_EQUAL(expected_result, actual_result);
+            TEST_ASSERT_EQUAL_STRING(expected.new_url, actual.new_url);
+
+            expected_result = nanorouter_process_redirect_request_fallback(PHASES_TEST_URLS[u], linear, &expected, &context);
+            actual_result = nanorouter_process_redirect_request_fallback(PHASES_TEST_URLS[u], indexed, &actual, &context);
+            TEST_ASSERT_EQUAL(expected_result, actual_result);
+            TEST_ASSERT_EQUAL(expected.status_code, actual.status_code);
+            TEST_ASSERT_EQUAL_STRING(expected.new_url, actual.new_url);
+        }
+        nanorouter_redirect_rule_list_free(indexed);
+    }
+    nanorouter_redirect_rule_list_free(linear);
+}
+
+int test_nanorouter_redirect_phases(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_phases_forced_rules_kept_apart);
+    RUN_TEST(test_redirect_phases_forced_pass);
+    RUN_TEST(test_redirect_phases_fallback_pass);
+    RUN_TEST(test_redirect_phases_engines_agree);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+#include "test_nanorouter_redirect_prefilter.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_prefilter.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+void test_redirect_prefilter_compile_sets_engine(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_PREFILTER));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_PREFILTER, list->engine);
+    TEST_ASSERT_NOT_NULL(list->prefilter);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_DFA));
+    TEST_ASSERT_NULL(list->prefilter);
+
+#if defined(__AVX2__)
+    TEST_ASSERT_EQUAL_STRING("avx2", nr_redirect_prefilter_kernel());
+#elif defined(__SSE2__)
+    TEST_ASSERT_EQUAL_STRING("sse2", nr_redirect_prefilter_kernel());
+#else
+    TEST_ASSERT_EQUAL_STRING("scalar", nr_redirect_prefilter_kernel());
+#endif
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_prefilter_matches_linear_engine(void) {
+    redirect_engine_test_assert_matches_linear(REDIRECT_ENGINE_TEST_REDIRECTS, NR_REDIRECT_ENGINE_PREFILTER,
+                                               REDIRECT_ENGINE_TEST_URLS, REDIRECT_ENGINE_TEST_NUM_URLS);
+}
+
+void test_redirect_prefilter_spans_several_blocks(void) {
+    // 201 rules: 26 blocks of 8 lanes, the last one padded
+    redirect_engine_test_assert_generated_rules(NR_REDIRECT_ENGINE_PREFILTER);
+}
+
+void test_redirect_prefilter_padding_lanes_never_match(void) {
+    // 9 rules: one full block, then one rule and 7 padding lanes
+    static const char *const redirects =
+        "/one /1 301\n"
+        "/two /2 301\n"
+        "/three /3 301\n"
+        "/four /4 301\n"
+        "/five /5 301\n"
+        "/six /6 301\n"
+        "/seven /7 301\n"
+        "/eight /8 301\n"
+        "/nine/:id /9/:id 301\n";
+    static const char *const urls[] = {
+        "/", "", "/one", "/eight", "/nine", "/nine/x", "/nine/x/y", "/ten", "/ten/x",
+    };
+    redirect_engine_test_assert_matches_linear(redirects, NR_REDIRECT_ENGINE_PREFILTER, urls, sizeof(urls) / sizeof(urls[0]));
+
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(redirects);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_PREFILTER));
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/nine/x", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/9/x", response.new_url);
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request("/", list, &response, NULL));
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request("/ten/x", list, &response, NULL));
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_prefilter_deep_url_falls_back(void) {
+    redirect_engine_test_assert_deep_url_falls_back(NR_REDIRECT_ENGINE_PREFILTER);
+}
+
+int test_nanorouter_redirect_prefilter(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_prefilter_compile_sets_engine);
+    RUN_TEST(test_redirect_prefilter_matches_linear_engine);
+    RUN_TEST(test_redirect_prefilter_spans_several_blocks);
+    RUN_TEST(test_redirect_prefilter_padding_lanes_never_match);
+    RUN_TEST(test_redirect_prefilter_deep_url_falls_back);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include "test_nanorouter_redirect_trie.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_redirect_rule_parser.h"
+#include "test_redirect_engine_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static nanorouter_redirect_rule_list_t* trie_test_load_rules(void) {
+    return redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+}
+
+void test_redirect_trie_compile_sets_engine(void) {
+    nanorouter_redirect_rule_list_t *list = trie_test_load_rules();
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_LINEAR, list->engine);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_TRIE));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_TRIE, list->engine);
+    TEST_ASSERT_NOT_NULL(list->trie);
+
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_LINEAR));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_LINEAR, list->engine);
+    TEST_ASSERT_NULL(list->trie);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_trie_compile_null_list(void) {
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_compile(NULL, NR_REDIRECT_ENGINE_TRIE));
+}
+
+void test_redirect_trie_matches_linear_engine(void) {
+    redirect_engine_test_assert_matches_linear(REDIRECT_ENGINE_TEST_REDIRECTS, NR_REDIRECT_ENGINE_TRIE,
+                                               REDIRECT_ENGINE_TEST_URLS, REDIRECT_ENGINE_TEST_NUM_URLS);
+}
+
+void test_redirect_trie_first_match_wins(void) {
+    nanorouter_redirect_rule_list_t *list = trie_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_TRIE));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/news/latest", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/latest-news", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/news/2024/hello", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/2024/hello", response.new_url);
+    TEST_ASSERT_EQUAL(301, response.status_code);
+
+    // A trailing placeholder captures the rest of the path
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/news/2024/hello/extra", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/2024/hello/extra", response.new_url);
+    TEST_ASSERT_EQUAL(301, response.status_code);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/news/2024", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/2024", response.new_url);
+    TEST_ASSERT_EQUAL(302, response.status_code);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/nothing/here", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/404.html", response.new_url);
+    TEST_ASSERT_EQUAL(404, response.status_code);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_trie_confirms_query_and_conditions(void) {
+    nanorouter_redirect_rule_list_t *list = trie_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_TRIE));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store?id=42", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/blog/42?id=42", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/store", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/shop", response.new_url);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/israel/haifa", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/israel/en/haifa", response.new_url);
+    strcpy(context.language, "he");
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/israel/haifa", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/israel/he/haifa", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_trie_deep_url_falls_back(void) {
+    redirect_engine_test_assert_deep_url_falls_back(NR_REDIRECT_ENGINE_TRIE);
+}
+
+void test_redirect_trie_add_rule_drops_index(void) {
+    nanorouter_redirect_rule_list_t *list = trie_test_load_rules();
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, NR_REDIRECT_ENGINE_TRIE));
+
+    redirect_rule_t rule;
+    const char *line = "/late /added 301";
+    TEST_ASSERT_TRUE(nr_parse_redirect_rule(line, strlen(line), &rule));
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_add_rule(list, &rule));
+    TEST_ASSERT_EQUAL(NR_REDIRECT_ENGINE_LINEAR, list->engine);
+    TEST_ASSERT_NULL(list->trie);
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/late", list, &response, &context));
+    TEST_ASSERT_EQUAL_STRING("/404.html", response.new_url); // "/*" still comes first
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+int test_nanorouter_redirect_trie(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_redirect_trie_compile_sets_engine);
+    RUN_TEST(test_redirect_trie_compile_null_list);
+    RUN_TEST(test_redirect_trie_matches_linear_engine);
+    RUN_TEST(test_redirect_trie_first_match_wins);
+    RUN_TEST(test_redirect_trie_confirms_query_and_conditions);
+    RUN_TEST(test_redirect_trie_deep_url_falls_back);
+    RUN_TEST(test_redirect_trie_add_rule_drops_index);
+    return UNITY_END();
+}
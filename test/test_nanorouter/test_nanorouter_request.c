@@ -0,0 +1,226 @@
+#include "test_nanorouter_request.h"
+
+#include "unity.h"
+#include "nanorouter_redirect_middleware.h"
+#include "nanorouter_headers_middleware.h"
+#include "test_redirect_engine_helpers.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *const REQUEST_TEST_REDIRECTS =
+    "/search q=:q /find/:q 302\n"
+    "/search flag /flagged 302\n"
+    "/item id=:id sort=asc /items/:id/asc 301\n"
+    "/item id=:id /items/:id 301\n"
+    "/welcome /fr/welcome 302 Language=fr\n"
+    "/welcome /en/welcome 302 Language=en,de\n"
+    "/blog/:slug /posts/:slug 301\n";
+
+static const char *const REQUEST_TEST_HEADERS =
+    "/blog/*\n"
+    "  Cache-Control: max-age=60\n";
+
+static const char *const REQUEST_TEST_URLS[] = {
+    "/search?q=cats", "/search?x=1&&q=dogs&q=birds", "/search?flag", "/search?flag=", "/search",
+    "/item?id=7", "/item?sort=asc&id=8", "/item?sort=desc&id=9", "/item?id", "/welcome",
+    "/blog/hello?id=3", "/unknown?q=1",
+};
+
+void test_parse_language_tags(void) {
+    nr_language_tags_t language_tags;
+    nr_parse_language_tags(" en-US, en;q=0.9,,fr;q=0.8 ", &language_tags);
+    TEST_ASSERT_TRUE(language_tags.parsed);
+    TEST_ASSERT_EQUAL_UINT8(3, language_tags.num_tags);
+    TEST_ASSERT_EQUAL_STRING("en-US", language_tags.tags[0]);
+    TEST_ASSERT_EQUAL_STRING("en", language_tags.tags[1]);
+    TEST_ASSERT_EQUAL_STRING("fr", language_tags.tags[2]);
+
+    nr_parse_language_tags(NULL, &language_tags);
+    TEST_ASSERT_EQUAL_UINT8(0, language_tags.num_tags);
+}
+
+void test_parse_query_pairs(void) {
+    const char *query = "a=1&&flag&b=x=y&=z";
+    nr_query_pairs_t query_pairs;
+    nr_parse_query_pairs(query, strlen(query), &query_pairs);
+    TEST_ASSERT_TRUE(query_pairs.parsed);
+    TEST_ASSERT_FALSE(query_pairs.too_many);
+    TEST_ASSERT_EQUAL_UINT8(4, query_pairs.num_pairs);
+    TEST_ASSERT_EQUAL_STRING_LEN("a", query_pairs.pairs[0].key, query_pairs.pairs[0].key_len);
+    TEST_ASSERT_EQUAL_STRING_LEN("1", query_pairs.pairs[0].value, query_pairs.pairs[0].value_len);
+    TEST_ASSERT_EQUAL_STRING_LEN("flag", query_pairs.pairs[1].key, query_pairs.pairs[1].key_len);
+    TEST_ASSERT_NULL(query_pairs.pairs[1].value);
+    TEST_ASSERT_EQUAL_STRING_LEN("x=y", query_pairs.pairs[2].value, query_pairs.pairs[2].value_len);
+    TEST_ASSERT_EQUAL_UINT16(0, query_pairs.pairs[3].key_len);
+
+    TEST_ASSERT_EQUAL_PTR(&query_pairs.pairs[2], nr_query_pairs_find(&query_pairs, "b", 1));
+    TEST_ASSERT_EQUAL_PTR(&query_pairs.pairs[3], nr_query_pairs_find(&query_pairs, "", 0));
+    TEST_ASSERT_NULL(nr_query_pairs_find(&query_pairs, "c", 1));
+    TEST_ASSERT_NULL(nr_query_pairs_find(&query_pairs, "fla", 3));
+    TEST_ASSERT_TRUE((query_pairs.key_mask & nr_query_key_bit("flag", 4)) != 0);
+}
+
+void test_query_pairs_repeated_keys(void) {
+    const char *query = "q=1&x=2&q=3&q";
+    nr_query_pairs_t query_pairs;
+    nr_parse_query_pairs(query, strlen(query), &query_pairs);
+    TEST_ASSERT_EQUAL_UINT8(4, query_pairs.num_pairs);
+
+    // Repeats of a key are chained in URL order
+    const nr_query_pair_t *pair = nr_query_pairs_find(&query_pairs, "q", 1);
+    TEST_ASSERT_EQUAL_PTR(&query_pairs.pairs[0], pair);
+    TEST_ASSERT_EQUAL_UINT8(3, pair->next);
+    pair = &query_pairs.pairs[pair->next - 1];
+    TEST_ASSERT_EQUAL_STRING_LEN("3", pair->value, pair->value_len);
+    pair = &query_pairs.pairs[pair->next - 1];
+    TEST_ASSERT_NULL(pair->value);
+    TEST_ASSERT_EQUAL_UINT8(0, pair->next);
+
+    TEST_ASSERT_EQUAL_UINT32(nr_query_key_bit("q", 1) | nr_query_key_bit("x", 1), query_pairs.key_mask);
+}
+
+void test_request_rejects_missing_query_keys(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(
+        "/v1/user/info id=:id /api/users/:id 200\n"
+        "/v1/user/info name=:name /api/users/by-name/:name 200\n"
+        "/v1/* /api/:splat 200\n", list));
+    TEST_ASSERT_EQUAL_UINT32(nr_query_key_bit("id", 2), list->head->query_key_mask);
+    TEST_ASSERT_EQUAL_UINT32(0, list->head->next->next->query_key_mask);
+
+    const nanorouter_redirect_engine_t engines[] = { NR_REDIRECT_ENGINE_LINEAR, NR_REDIRECT_ENGINE_TRIE, NR_REDIRECT_ENGINE_BITSET };
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, engines[e]));
+        nanorouter_redirect_response_t response;
+
+        TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/v1/user/info?name=ada", list, &response, NULL));
+        TEST_ASSERT_EQUAL_STRING("/api/users/by-name/ada?name=ada", response.new_url);
+        TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/v1/user/info?lang=en&id=42", list, &response, NULL));
+        TEST_ASSERT_EQUAL_STRING("/api/users/42?lang=en&id=42", response.new_url);
+        TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/v1/user/info?ids=42", list, &response, NULL));
+        TEST_ASSERT_EQUAL_STRING("/api/user/info?ids=42", response.new_url);
+        TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/v1/user/info", list, &response, NULL));
+        TEST_ASSERT_EQUAL_STRING("/api/user/info", response.new_url);
+    }
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_request_parses_lazily(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REQUEST_TEST_REDIRECTS);
+    nanorouter_request_context_t context = {0};
+    strcpy(context.language, "de-AT,es;q=0.5");
+    nanorouter_redirect_response_t response;
+
+    // Without a query, rules with query parameters are turned away before anything is split
+    const char *url = "/blog/hello";
+    nr_request_t request;
+    nr_request_init(&request, url, strlen(url), &context);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_shared(&request, list, &response));
+    TEST_ASSERT_EQUAL_STRING("/posts/hello", response.new_url);
+    TEST_ASSERT_FALSE(request.query_pairs.parsed);
+    TEST_ASSERT_FALSE(request.language_tags.parsed);
+
+    // The first rule with a query parameter splits the query, once
+    url = "/item?sort=asc&id=8";
+    nr_request_init(&request, url, strlen(url), &context);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_shared(&request, list, &response));
+    TEST_ASSERT_EQUAL_STRING("/items/8/asc?sort=asc&id=8", response.new_url);
+    TEST_ASSERT_TRUE(request.query_pairs.parsed);
+    TEST_ASSERT_EQUAL_UINT8(2, request.query_pairs.num_pairs);
+    TEST_ASSERT_FALSE(request.language_tags.parsed);
+
+    // Language conditions split the language value, once for both rules
+    url = "/welcome";
+    nr_request_init(&request, url, strlen(url), &context);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_shared(&request, list, &response));
+    TEST_ASSERT_EQUAL_STRING("/en/welcome", response.new_url);
+    TEST_ASSERT_TRUE(request.language_tags.parsed);
+    TEST_ASSERT_EQUAL_UINT8(2, request.language_tags.num_tags);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_request_agrees_with_string_entry(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REQUEST_TEST_REDIRECTS);
+    const char *languages[] = { "", "fr-CA", "en;q=0.8, de", "es" };
+
+    for (size_t l = 0; l < sizeof(languages) / sizeof(languages[0]); l++) {
+        nanorouter_request_context_t context = {0};
+        strcpy(context.language, languages[l]);
+        for (size_t u = 0; u < sizeof(REQUEST_TEST_URLS) / sizeof(REQUEST_TEST_URLS[0]); u++) {
+            const char *url = REQUEST_TEST_URLS[u];
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(url, list, &expected, &context);
+
+            nr_request_t request;
+            nr_request_init(&request, url, strlen(url), &context);
+            bool actual_result = nanorouter_process_redirect_request_shared(&request, list, &actual);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, url);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, url);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, actual.status_code, url);
+        }
+    }
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_request_with_many_query_pairs(void) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REQUEST_TEST_REDIRECTS);
+
+    // More pairs than the table holds: rules scan the query string instead
+    char url[NR_MAX_QUERY_PAIRS * 8 + 32] = "/search?";
+    for (int i = 0; i < NR_MAX_QUERY_PAIRS; i++) {
+        char pair[8];
+        snprintf(pair, sizeof(pair), "p%d=%d&", i, i);
+        strcat(url, pair);
+    }
+    strcat(url, "q=last");
+
+    nr_request_t request;
+    nr_request_init(&request, url, strlen(url), NULL);
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_shared(&request, list, &response));
+    TEST_ASSERT_TRUE(request.query_pairs.too_many);
+    TEST_ASSERT_EQUAL_INT(0, strncmp("/find/last?", response.new_url, 11));
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_request_shared_by_both_middlewares(void) {
+    nanorouter_redirect_rule_list_t *redirects = redirect_engine_test_load_rules(REQUEST_TEST_REDIRECTS);
+    nanorouter_header_rule_list_t *headers = nanorouter_header_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_headers_file(REQUEST_TEST_HEADERS, headers));
+
+    // A slice of the receive buffer, parsed once for both
+    const char *request_line = "GET /blog/hello HTTP/1.1";
+    nr_request_t request;
+    nr_request_init(&request, request_line + 4, strlen("/blog/hello"), NULL);
+
+    nanorouter_header_response_t header_response = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_header_request_shared(&request, headers, &header_response));
+    TEST_ASSERT_EQUAL_UINT8(1, header_response.num_headers);
+    TEST_ASSERT_EQUAL_STRING("Cache-Control", header_response.headers[0].key);
+
+    nanorouter_redirect_response_t redirect_response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request_shared(&request, redirects, &redirect_response));
+    TEST_ASSERT_EQUAL_STRING("/posts/hello", redirect_response.new_url);
+
+    TEST_ASSERT_FALSE(nanorouter_process_redirect_request_shared(NULL, redirects, &redirect_response));
+    TEST_ASSERT_FALSE(nanorouter_process_header_request_shared(NULL, headers, &header_response));
+
+    nanorouter_header_rule_list_free(headers);
+    nanorouter_redirect_rule_list_free(redirects);
+}
+
+int test_nanorouter_request(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_language_tags);
+    RUN_TEST(test_parse_query_pairs);
+    RUN_TEST(test_query_pairs_repeated_keys);
+    RUN_TEST(test_request_parses_lazily);
+    RUN_TEST(test_request_agrees_with_string_entry);
+    RUN_TEST(test_request_with_many_query_pairs);
+    RUN_TEST(test_request_rejects_missing_query_keys);
+    RUN_TEST(test_request_shared_by_both_middlewares);
+    return UNITY_END();
+}
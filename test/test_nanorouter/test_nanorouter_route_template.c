@@ -0,0 +1,208 @@
+#include "test_nanorouter_route_template.h"
+
+#include "unity.h"
+#include "nanorouter_route_template.h"
+#include "nanorouter_redirect_middleware.h"
+#include <string.h>
+
+// Compiles a from_route/to_route pair and matches url, leaving the captures in *captures
+static void template_test_match(const char *from_route, const char *to_route, const char *url,
+                                nr_route_program_t *program, nr_route_template_t *route_template,
+                                nr_parsed_url_t *parsed_url, nr_capture_spans_t *captures) {
+    nr_compile_route_pattern(from_route, program);
+    TEST_ASSERT_TRUE(nr_compile_route_template(to_route, from_route, program, NULL, 0, route_template));
+    nr_parse_url(url, parsed_url);
+    captures->num_spans = 0;
+    TEST_ASSERT_TRUE(nr_match_compiled_pattern(from_route, program, NULL, 0, parsed_url, captures));
+}
+
+void test_compile_route_template_parts(void) {
+    const char *from_route = "/blog/:year/*";
+    const char *to_route = "https://example.com/:year/posts/:splat?src=:missing";
+    nr_route_program_t program;
+    nr_compile_route_pattern(from_route, &program);
+    nr_route_template_t route_template;
+    TEST_ASSERT_TRUE(nr_compile_route_template(to_route, from_route, &program, NULL, 0, &route_template));
+
+    TEST_ASSERT_EQUAL_UINT8(6, route_template.num_parts);
+    TEST_ASSERT_TRUE(route_template.has_query);
+    TEST_ASSERT_EQUAL_UINT8(NR_TEMPLATE_PART_LITERAL, route_template.parts[0].kind);
+    TEST_ASSERT_EQUAL_STRING_LEN("https://example.com/", to_route + route_template.parts[0].offset, route_template.parts[0].len);
+    TEST_ASSERT_EQUAL_UINT8(NR_TEMPLATE_PART_PLACEHOLDER, route_template.parts[1].kind);
+    TEST_ASSERT_EQUAL_UINT8(0, route_template.parts[1].capture);
+    TEST_ASSERT_EQUAL_UINT8(NR_TEMPLATE_PART_SPLAT, route_template.parts[3].kind);
+    TEST_ASSERT_EQUAL_UINT8(1, route_template.parts[3].capture);
+    TEST_ASSERT_EQUAL_UINT8(NR_TEMPLATE_NO_CAPTURE, route_template.parts[5].capture);
+    TEST_ASSERT_EQUAL_UINT16(strlen("https://example.com/") + strlen("/posts/") + strlen("?src="), route_template.literal_len);
+
+    // Query placeholders are captured after the path
+    redirect_rule_t rule;
+    TEST_ASSERT_TRUE(nr_parse_redirect_rule("/item id=:id /items/:id 301", strlen("/item id=:id /items/:id 301"), &rule));
+    nr_compile_route_pattern(rule.from_route, &program);
+    TEST_ASSERT_TRUE(nr_compile_route_template(rule.to_route, rule.from_route, &program, rule.query_params, rule.num_query_params, &route_template));
+    TEST_ASSERT_FALSE(route_template.has_query);
+    TEST_ASSERT_EQUAL_UINT8(2, route_template.num_parts);
+    TEST_ASSERT_EQUAL_UINT8(0, route_template.parts[1].capture);
+}
+
+void test_render_route_template(void) {
+    nr_route_program_t program;
+    nr_route_template_t route_template;
+    nr_parsed_url_t parsed_url;
+    nr_capture_spans_t captures;
+    char buffer[NR_REDIRECT_MAX_URL_LEN + 1];
+
+    const char *url = "/blog/2024/hello/world";
+    template_test_match("/blog/:year/*", "https://example.com/:year/posts/:splat?src=:missing", url,
+                        &program, &route_template, &parsed_url, &captures);
+    const char *expected = "https://example.com/2024/posts/hello/world?src=:missing";
+    size_t len = nr_render_route_template(&route_template, "https://example.com/:year/posts/:splat?src=:missing", url, &captures, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING(expected, buffer);
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), len);
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), nr_route_template_length(&route_template, "https://example.com/:year/posts/:splat?src=:missing", &captures));
+
+    // Cut at the buffer, always terminated
+    char small[12];
+    len = nr_render_route_template(&route_template, "https://example.com/:year/posts/:splat?src=:missing", url, &captures, small, sizeof(small));
+    TEST_ASSERT_EQUAL_size_t(sizeof(small) - 1, len);
+    TEST_ASSERT_EQUAL_STRING("https://exa", small);
+
+    // A placeholder used twice reads the same capture
+    url = "/u/ada";
+    template_test_match("/u/:name", "/people/:name/:name", url, &program, &route_template, &parsed_url, &captures);
+    nr_render_route_template(&route_template, "/people/:name/:name", url, &captures, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("/people/ada/ada", buffer);
+}
+
+void test_route_template_in_middleware(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(
+        "/find q=:q /search/:q 302\n"
+        "/docs/* https://docs.example.com/:splat 301\n", list));
+    nanorouter_redirect_response_t response;
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/docs/a/b?v=2", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("https://docs.example.com/a/b?v=2", response.new_url);
+    TEST_ASSERT_EQUAL_INT(301, response.status_code);
+
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/find?q=cats&page=2", list, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/search/cats?q=cats&page=2", response.new_url);
+
+    // A to_route with more parts than a template holds is refused
+    redirect_rule_t rule;
+    memset(&rule, 0, sizeof(rule));
+    strcpy(rule.from_route, "/many");
+    for (int i = 0; i < NR_MAX_TEMPLATE_PARTS / 2 + 1; i++) {
+        strcat(rule.to_route, "/*");
+    }
+    rule.status_code = 301;
+    TEST_ASSERT_FALSE(nanorouter_redirect_rule_list_add_rule(list, &rule));
+    TEST_ASSERT_EQUAL_size_t(2, list->count);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_route_template_absolute_to_route(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/blog/:slug https://www.example.com/posts/:slug/:missing 301\n", list));
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/blog/hello", list, &response, &context));
+    // The scheme's ':' is not a placeholder; unknown placeholders are kept as written
+    TEST_ASSERT_EQUAL_STRING("https://www.example.com/posts/hello/:missing", response.new_url);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_match_render_full_length(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/api/* https://backend.internal.example.com/v2/:splat 200!\n", list));
+
+    // Target well past NR_REDIRECT_MAX_URL_LEN
+    char url[NR_REDIRECT_MAX_URL_LEN * 2];
+    strcpy(url, "/api/reports/2024?");
+    while (strlen(url) < NR_REDIRECT_MAX_URL_LEN + 40) {
+        strcat(url, "field=value&");
+    }
+    strcat(url, "last=1");
+
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request(url, list, &response, NULL));
+    TEST_ASSERT_EQUAL_size_t(NR_REDIRECT_MAX_URL_LEN, strlen(response.new_url));
+
+    nanorouter_redirect_match_t match;
+    TEST_ASSERT_TRUE(nanorouter_match_redirect_request_n(url, strlen(url), list, NULL, &match));
+    TEST_ASSERT_EQUAL_INT(200, match.status_code);
+    size_t len = nanorouter_redirect_match_render(&match, NULL, 0);
+    TEST_ASSERT_TRUE(len > NR_REDIRECT_MAX_URL_LEN);
+
+    char full[NR_REDIRECT_MAX_URL_LEN * 3];
+    TEST_ASSERT_EQUAL_size_t(len, nanorouter_redirect_match_render(&match, full, len + 1));
+    TEST_ASSERT_EQUAL_size_t(len, strlen(full));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(full, response.new_url, NR_REDIRECT_MAX_URL_LEN));
+    TEST_ASSERT_EQUAL_STRING("&last=1", full + len - 7);
+
+    // A short buffer is cut and terminated, like new_url
+    char cut[16];
+    TEST_ASSERT_EQUAL_size_t(len, nanorouter_redirect_match_render(&match, cut, sizeof(cut)));
+    TEST_ASSERT_EQUAL_STRING_LEN(full, cut, sizeof(cut) - 1);
+    TEST_ASSERT_EQUAL_INT('\0', cut[sizeof(cut) - 1]);
+
+    TEST_ASSERT_FALSE(nanorouter_match_redirect_request_n("/other", 6, list, NULL, &match));
+    nanorouter_redirect_rule_list_free(list);
+}
+
+void test_redirect_match_iovec(void) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(
+        "/blog/:year/:slug /posts/:year/:slug?archive 301\n"
+        "/docs/* https://docs.example.com/:splat 302\n", list));
+
+    const char *url = "/docs/guide/start?lang=en&&v=2";
+    nanorouter_redirect_match_t match;
+    TEST_ASSERT_TRUE(nanorouter_match_redirect_request_n(url, strlen(url), list, NULL, &match));
+
+    // Literal, splat, then the query pairs with their separators
+    nr_iovec_t iov[8];
+    size_t num_iov = nanorouter_redirect_match_iovec(&match, iov, 8);
+    TEST_ASSERT_EQUAL_size_t(6, num_iov);
+    char joined[NR_REDIRECT_MAX_URL_LEN + 1] = "";
+    for (size_t i = 0; i < num_iov; i++) {
+        strncat(joined, (const char *)iov[i].iov_base, iov[i].iov_len);
+    }
+    TEST_ASSERT_EQUAL_STRING("https://docs.example.com/guide/start?lang=en&v=2", joined);
+    // Captured values are spans of the request URL, not copies
+    TEST_ASSERT_EQUAL_PTR(url + strlen("/docs/"), iov[1].iov_base);
+    TEST_ASSERT_EQUAL_PTR(url + strlen("/docs/guide/start?"), iov[3].iov_base);
+
+    // Pieces past max_iov are counted only
+    TEST_ASSERT_EQUAL_size_t(num_iov, nanorouter_redirect_match_iovec(&match, iov, 2));
+    TEST_ASSERT_EQUAL_size_t(num_iov, nanorouter_redirect_match_iovec(&match, NULL, 0));
+
+    // A to_route with its own query drops the request's
+    url = "/blog/2024/hello?utm=x";
+    nr_request_t request;
+    nr_request_init(&request, url, strlen(url), NULL);
+    TEST_ASSERT_TRUE(nanorouter_match_redirect_request_shared(&request, list, &match));
+    num_iov = nanorouter_redirect_match_iovec(&match, iov, 8);
+    TEST_ASSERT_EQUAL_size_t(5, num_iov);
+    char rendered[NR_REDIRECT_MAX_URL_LEN + 1];
+    nanorouter_redirect_match_render(&match, rendered, sizeof(rendered));
+    TEST_ASSERT_EQUAL_STRING("/posts/2024/hello?archive", rendered);
+
+    nanorouter_redirect_rule_list_free(list);
+}
+
+int test_nanorouter_route_template(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_route_template_parts);
+    RUN_TEST(test_render_route_template);
+    RUN_TEST(test_route_template_in_middleware);
+    RUN_TEST(test_route_template_absolute_to_route);
+    RUN_TEST(test_redirect_match_render_full_length);
+    RUN_TEST(test_redirect_match_iovec);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+#include "test_redirect_engine_helpers.h"
+
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+const char *const REDIRECT_ENGINE_TEST_REDIRECTS =
+    "/news/latest /blog/latest-news 301\n"
+    "/news/:year/:slug /blog/:year/:slug 301\n"
+    "/news/* /blog/:splat 302\n"
+    "/:lang/news/latest /:lang/blog 302\n"
+    "/store id=:id /blog/:id 301\n"
+    "/store /shop 301\n"
+    "/israel/* /israel/he/:splat 302 Language=he\n"
+    "/israel/* /israel/en/:splat 302\n"
+    "/api/:version/users/:id /v/:version/u/:id 200\n"
+    "/api/v2/users/me /me 200\n"
+    "/docs/:rest /documentation/:rest 301\n"
+    "/a//b /empty-segment 301\n"
+    "/bad*pattern /never 301\n"
+    "/ /home 200\n"
+    "/* /404.html 404\n";
+
+const char *const REDIRECT_ENGINE_TEST_URLS[] = {
+    "/", "", "/news/latest", "/news/latest/", "/news/2024/hello", "/news/2024/hello/extra",
+    "/news", "/news/", "/he/news/latest", "/news/news/latest", "/store", "/store?id=42", "/store?x=1",
+    "/israel/tel-aviv", "/api/v1/users/7", "/api/v1/users/7/posts", "/api/v2/users/me", "/api/v2/users/you",
+    "/api//users/7", "/docs/a/b/c", "/docs", "/a//b", "/a/b", "/bad*pattern", "/unknown/path?q=1",
+    "//news/latest", "/news//latest",
+};
+
+const size_t REDIRECT_ENGINE_TEST_NUM_URLS = sizeof(REDIRECT_ENGINE_TEST_URLS) / sizeof(REDIRECT_ENGINE_TEST_URLS[0]);
+
+nanorouter_redirect_rule_list_t* redirect_engine_test_load_rules(const char *content) {
+    nanorouter_redirect_rule_list_t *list = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(content, list));
+    return list;
+}
+
+nanorouter_redirect_rule_list_t* redirect_engine_test_compiled_copy(const nanorouter_redirect_rule_list_t *list, nanorouter_redirect_engine_t engine) {
+    nanorouter_redirect_rule_list_t *copy = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(copy);
+    for (const nanorouter_redirect_rule_t *node = list->head; node != NULL; node = node->next) {
+        TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_add_rule(copy, &node->rule));
+    }
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(copy, engine));
+    return copy;
+}
+
+void redirect_engine_test_assert_same_results(nanorouter_redirect_rule_list_t *linear, nanorouter_redirect_rule_list_t *indexed,
+                                              const char *const *urls, size_t num_urls) {
+    // No context, then the languages the test rule sets have conditions for
+    static const char *const languages[] = { NULL, "he", "he-IL,en;q=0.5", "es" };
+    for (size_t c = 0; c < sizeof(languages) / sizeof(languages[0]); c++) {
+        nanorouter_request_context_t context = {0};
+        if (languages[c] != NULL) {
+            strcpy(context.language, languages[c]);
+        }
+        for (size_t i = 0; i < num_urls; i++) {
+            nanorouter_redirect_response_t expected;
+            nanorouter_redirect_response_t actual;
+            bool expected_result = nanorouter_process_redirect_request(urls[i], linear, &expected, languages[c] != NULL ? &context : NULL);
+            bool actual_result = nanorouter_process_redirect_request(urls[i], indexed, &actual, languages[c] != NULL ? &context : NULL);
+
+            TEST_ASSERT_EQUAL_MESSAGE(expected_result, actual_result, urls[i]);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.status_code, actual.status_code, urls[i]);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected.new_url, actual.new_url, urls[i]);
+        }
+    }
+}
+
+void redirect_engine_test_assert_matches_linear(const char *content, nanorouter_redirect_engine_t engine,
+                                                const char *const *urls, size_t num_urls) {
+    nanorouter_redirect_rule_list_t *linear = redirect_engine_test_load_rules(content);
+    nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_compiled_copy(linear, engine);
+    TEST_ASSERT_EQUAL(engine, indexed->engine);
+
+    redirect_engine_test_assert_same_results(linear, indexed, urls, num_urls);
+
+    nanorouter_redirect_rule_list_free(linear);
+    nanorouter_redirect_rule_list_free(indexed);
+}
+
+void redirect_engine_test_assert_generated_rules(nanorouter_redirect_engine_t engine) {
+    nanorouter_redirect_rule_list_t *linear = nanorouter_redirect_rule_list_create();
+    TEST_ASSERT_NOT_NULL(linear);
+
+    // 200 rules, the last of each 50 a splat, then a placeholder rule behind all of them
+    char line[64];
+    for (int i = 0; i < 200; i++) {
+        if (i % 50 == 49) {
+            snprintf(line, sizeof(line), "/section-%d/* /archive/%d/:splat 302\n", i / 50, i);
+        } else {
+            snprintf(line, sizeof(line), "/section-%d/page-%d /pages/%d 301\n", i / 50, i, i);
+        }
+        TEST_ASSERT_TRUE(nanorouter_parse_redirects_file(line, linear));
+    }
+    TEST_ASSERT_TRUE(nanorouter_parse_redirects_file("/:any/page-7 /late 301\n", linear));
+    nanorouter_redirect_rule_list_t *indexed = redirect_engine_test_compiled_copy(linear, engine);
+
+    static const char *const urls[] = {
+        "/section-0/page-0", "/section-0/page-7", "/section-1/page-70", "/section-3/page-199",
+        "/section-3/page-150", "/section-2/other", "/section-9/page-7", "/section-0/page-60",
+        "/section-1", "/section-1/page-70/extra",
+    };
+    redirect_engine_test_assert_same_results(linear, indexed, urls, sizeof(urls) / sizeof(urls[0]));
+
+    nanorouter_redirect_response_t response;
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/section-3/page-150", indexed, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/pages/150", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/section-2/other", indexed, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/archive/149/other", response.new_url);
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request("/section-9/page-7", indexed, &response, NULL));
+    TEST_ASSERT_EQUAL_STRING("/late", response.new_url);
+
+    nanorouter_redirect_rule_list_free(linear);
+    nanorouter_redirect_rule_list_free(indexed);
+}
+
+void redirect_engine_test_assert_deep_url_falls_back(nanorouter_redirect_engine_t engine) {
+    nanorouter_redirect_rule_list_t *list = redirect_engine_test_load_rules(REDIRECT_ENGINE_TEST_REDIRECTS);
+    TEST_ASSERT_TRUE(nanorouter_redirect_rule_list_compile(list, engine));
+
+    char deep_url[NR_MAX_PATH_SEGMENTS * 2 + 8] = "/israel";
+    for (int i = 0; i < NR_MAX_PATH_SEGMENTS; i++) {
+        strcat(deep_url, "/a");
+    }
+
+    nanorouter_redirect_response_t response;
+    nanorouter_request_context_t context = {0};
+    TEST_ASSERT_TRUE(nanorouter_process_redirect_request(deep_url, list, &response, &context));
+    TEST_ASSERT_EQUAL(302, response.status_code);
+
+    nanorouter_redirect_rule_list_free(list);
+}
@@ -0,0 +1,51 @@
+#ifndef TEST_REDIRECT_ENGINE_HELPERS_H
+#define TEST_REDIRECT_ENGINE_HELPERS_H
+
+#include <stddef.h>
+#include "nanorouter_redirect_middleware.h"
+
+// Helpers shared by the lookup engine tests, which all check an engine against the linear one.
+
+// Literals, placeholders, splats, query parameters and conditions, in file order
+extern const char *const REDIRECT_ENGINE_TEST_REDIRECTS;
+
+// URLs exercised against every engine with REDIRECT_ENGINE_TEST_REDIRECTS
+extern const char *const REDIRECT_ENGINE_TEST_URLS[];
+extern const size_t REDIRECT_ENGINE_TEST_NUM_URLS;
+
+/**
+ * @brief Creates a list holding the rules of a _redirects file content.
+ */
+nanorouter_redirect_rule_list_t* redirect_engine_test_load_rules(const char *content);
+
+/**
+ * @brief Creates a list with the same rules as another one, compiled for an engine.
+ */
+nanorouter_redirect_rule_list_t* redirect_engine_test_compiled_copy(const nanorouter_redirect_rule_list_t *list, nanorouter_redirect_engine_t engine);
+
+/**
+ * @brief Checks that two lists give the same response for every URL, with and without language conditions met.
+ */
+void redirect_engine_test_assert_same_results(nanorouter_redirect_rule_list_t *linear, nanorouter_redirect_rule_list_t *indexed,
+                                              const char *const *urls, size_t num_urls);
+
+/**
+ * @brief Loads content, compiles a copy for engine and checks it against the linear engine.
+ */
+void redirect_engine_test_assert_matches_linear(const char *content, nanorouter_redirect_engine_t engine,
+                                                const char *const *urls, size_t num_urls);
+
+/**
+ * @brief Checks an engine against the linear one on 201 generated rules in four sections.
+ *
+ * Big enough to span several candidate words or lane blocks, with a
+ * placeholder rule at the end that must lose to none of the others.
+ */
+void redirect_engine_test_assert_generated_rules(nanorouter_redirect_engine_t engine);
+
+/**
+ * @brief Checks that a URL deeper than NR_MAX_PATH_SEGMENTS still matches once compiled for engine.
+ */
+void redirect_engine_test_assert_deep_url_falls_back(nanorouter_redirect_engine_t engine);
+
+#endif // TEST_REDIRECT_ENGINE_HELPERS_H
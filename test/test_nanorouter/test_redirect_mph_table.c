@@ -0,0 +1,54 @@
+// Generated by scripts/generate_redirect_mph.py, do not edit.
+#include "test_redirect_mph_table.h"
+
+static const uint32_t test_redirect_mph_table_seeds[8] = {
+    24u, 166u, 40u, 100u, 0u, 5u, 26u, 43u,
+};
+
+static const nr_redirect_mph_entry_t test_redirect_mph_table_entries[30] = {
+    { "store", 5, 0, 2 },
+    { "blog/2003/post-21", 17, 2, 1 },
+    { "blog/2001/post-1", 16, 3, 1 },
+    { "blog/2001/post-7", 16, 4, 1 },
+    { "about", 5, 5, 1 },
+    { "blog/2002/post-2", 16, 6, 1 },
+    { "blog/2003/post-9", 16, 7, 1 },
+    { "blog/2000/post-6", 16, 8, 1 },
+    { "blog/2004/post-16", 17, 9, 1 },
+    { "es/home", 7, 10, 2 },
+    { "blog/2000/post-0", 16, 12, 1 },
+    { "", 0, 13, 1 },
+    { "blog/2004/post-4", 16, 14, 1 },
+    { "blog/2004/post-22", 17, 15, 1 },
+    { "blog/2005/post-23", 17, 16, 1 },
+    { "blog/2002/post-14", 17, 17, 1 },
+    { "old/contact", 11, 18, 1 },
+    { "blog/2002/post-8", 16, 19, 1 },
+    { "feed", 4, 20, 1 },
+    { "blog/2000/post-18", 17, 21, 1 },
+    { "blog/2001/post-19", 17, 22, 1 },
+    { "blog/2003/post-3", 16, 23, 1 },
+    { "blog/2002/post-20", 17, 24, 1 },
+    { "blog/2001/post-13", 17, 25, 1 },
+    { "blog/2005/post-17", 17, 26, 1 },
+    { "blog/2004/post-10", 17, 27, 1 },
+    { "blog/2000/post-12", 17, 28, 1 },
+    { "blog/2005/post-11", 17, 29, 1 },
+    { "blog/2005/post-5", 16, 30, 1 },
+    { "blog/2003/post-15", 17, 31, 1 },
+};
+
+static const uint16_t test_redirect_mph_table_rule_indices[32] = {
+    26, 27, 21, 1, 7, 32, 2, 9, 6, 16, 30, 31, 0, 33, 4, 22,
+    23, 14, 25, 8, 29, 18, 19, 3, 20, 13, 17, 10, 12, 11, 5, 15,
+};
+
+const nr_redirect_mph_table_t test_redirect_mph_table = {
+    .seeds = test_redirect_mph_table_seeds,
+    .num_buckets = 8,
+    .entries = test_redirect_mph_table_entries,
+    .num_entries = 30,
+    .rule_indices = test_redirect_mph_table_rule_indices,
+    .num_rule_indices = 32,
+    .num_rules = 35,
+};
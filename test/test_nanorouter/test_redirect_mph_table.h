@@ -0,0 +1,9 @@
+// Generated by scripts/generate_redirect_mph.py, do not edit.
+#ifndef TEST_REDIRECT_MPH_TABLE_H
+#define TEST_REDIRECT_MPH_TABLE_H
+
+#include "nanorouter_redirect_mph.h"
+
+extern const nr_redirect_mph_table_t test_redirect_mph_table;
+
+#endif // TEST_REDIRECT_MPH_TABLE_H